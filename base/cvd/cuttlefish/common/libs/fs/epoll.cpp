@@ -18,10 +18,11 @@
 
 #include <sys/epoll.h>
 
+#include <chrono>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <optional>
-#include <set>
 #include <shared_mutex>
 #include <string>
 
@@ -58,7 +59,7 @@ Result<void> Epoll::Add(SharedFD fd, uint32_t events) {
   std::lock_guard lock(watched_mutex_);
   CF_EXPECT(epoll_fd_->IsOpen(), "Empty Epoll instance");
 
-  if (watched_.count(fd) != 0) {
+  if (IsWatched(fd)) {
     return CF_ERRNO("Watched set already contains fd");
   }
   epoll_event event;
@@ -71,7 +72,7 @@ Result<void> Epoll::Add(SharedFD fd, uint32_t events) {
   } else if (success != 0) {
     return CF_ERRNO("epoll_ctl: Add failed");
   }
-  watched_.insert(fd);
+  watched_[fd->fd_] = fd;
   return {};
 }
 
@@ -82,13 +83,13 @@ Result<void> Epoll::AddOrModify(SharedFD fd, uint32_t events) {
   epoll_event event;
   event.events = events;
   event.data.fd = fd->fd_;
-  int operation = watched_.count(fd) == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+  int operation = IsWatched(fd) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
   int success = epoll_ctl(epoll_fd_->fd_, operation, fd->fd_, &event);
   if (success != 0) {
     std::string operation_str = operation == EPOLL_CTL_ADD ? "add" : "modify";
     return CF_ERRNO("epoll_ctl: Operation " << operation_str << " failed");
   }
-  watched_.insert(fd);
+  watched_[fd->fd_] = fd;
   return {};
 }
 
@@ -96,7 +97,7 @@ Result<void> Epoll::Modify(SharedFD fd, uint32_t events) {
   std::shared_lock lock(watched_mutex_);
   CF_EXPECT(epoll_fd_->IsOpen(), "Empty Epoll instance");
 
-  if (watched_.count(fd) == 0) {
+  if (!IsWatched(fd)) {
     return CF_ERR("Watched set did not contain fd");
   }
   epoll_event event;
@@ -113,22 +114,33 @@ Result<void> Epoll::Delete(SharedFD fd) {
   std::lock_guard lock(watched_mutex_);
   CF_EXPECT(epoll_fd_->IsOpen(), "Empty Epoll instance");
 
-  if (watched_.count(fd) == 0) {
+  if (!IsWatched(fd)) {
     return CF_ERR("Watched set did not contain fd");
   }
   int success = epoll_ctl(epoll_fd_->fd_, EPOLL_CTL_DEL, fd->fd_, nullptr);
   if (success != 0) {
     return CF_ERRNO("epoll_ctl: Delete failed");
   }
-  watched_.erase(fd);
+  watched_.erase(fd->fd_);
   return {};
 }
 
+bool Epoll::IsWatched(const SharedFD& fd) const {
+  auto watched = watched_.find(fd->fd_);
+  return watched != watched_.end() && watched->second == fd;
+}
+
 Result<std::optional<EpollEvent>> Epoll::Wait() {
+  return CF_EXPECT(Wait(std::chrono::milliseconds(-1)));
+}
+
+Result<std::optional<EpollEvent>> Epoll::Wait(
+    std::chrono::milliseconds timeout) {
   epoll_event event;
   int success;
   CF_EXPECT(epoll_fd_->IsOpen(), "Empty Epoll instance");
-  success = TEMP_FAILURE_RETRY(epoll_wait(epoll_fd_->fd_, &event, 1, -1));
+  success = TEMP_FAILURE_RETRY(
+      epoll_wait(epoll_fd_->fd_, &event, 1, timeout.count()));
   if (success == -1) {
     return CF_ERRNO("epoll_wait failed");
   } else if (success == 0) {
@@ -136,22 +148,17 @@ Result<std::optional<EpollEvent>> Epoll::Wait() {
   } else if (success != 1) {
     return CF_ERR("epoll_wait returned an unexpected value");
   }
-  EpollEvent ret;
-  ret.events = event.events;
   std::shared_lock lock(watched_mutex_);
-  for (const auto& watched : watched_) {
-    if (watched->fd_ == event.data.fd) {
-      ret.fd = watched;
-      break;
-    }
-  }
-  if (!ret.fd->IsOpen()) {
+  auto watched = watched_.find(event.data.fd);
+  if (watched == watched_.end()) {
     // Couldn't find the matching SharedFD to the file descriptor. We probably
     // lost the race to lock watched_mutex_ against a delete call. Treat this
     // as a spurious wakeup.
     return {};
   }
-  return ret;
+  // Not default constructed first, a closed SharedFD costs an allocation and
+  // system calls on every event.
+  return EpollEvent{.fd = watched->second, .events = event.events};
 }
 
 }  // namespace cuttlefish
@@ -18,8 +18,9 @@
 
 #include <sys/epoll.h>
 
+#include <chrono>
+#include <map>
 #include <optional>
-#include <set>
 #include <shared_mutex>
 
 #include "cuttlefish/common/libs/fs/shared_fd.h"
@@ -44,17 +45,24 @@ class Epoll {
   Result<void> AddOrModify(SharedFD fd, uint32_t events);
   Result<void> Delete(SharedFD fd);
   Result<std::optional<EpollEvent>> Wait();
+  // Returns an empty optional if no event arrives before the timeout.
+  Result<std::optional<EpollEvent>> Wait(std::chrono::milliseconds timeout);
 
  private:
   Epoll(SharedFD);
+  // Whether this SharedFD was added. Requires watched_mutex_.
+  bool IsWatched(const SharedFD& fd) const;
 
   SharedFD epoll_fd_;
   /**
    * This read-write mutex is read-locked when interacting with it as a const
-   * std::set, and write-locked when interacting with it as a std::set.
+   * std::map, and write-locked when interacting with it as a std::map.
    */
   std::shared_mutex watched_mutex_;
-  std::set<SharedFD> watched_;
+  // By file descriptor number, to find the SharedFD of an event. An entry may
+  // hold a SharedFD closed without being deleted, whose number was reused by
+  // another one since. Adding that other one replaces the entry.
+  std::map<int, SharedFD> watched_;
 };
 
 }  // namespace cuttlefish
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/common/libs/fs/epoll.h"
+
+#include <sys/epoll.h>
+
+#include <chrono>
+#include <optional>
+
+#include "gtest/gtest.h"
+
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+class EpollTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    Result<Epoll> epoll = Epoll::Create();
+    ASSERT_THAT(epoll, IsOk());
+    epoll_ = std::move(*epoll);
+    ASSERT_TRUE(SharedFD::Pipe(&read_end_, &write_end_));
+  }
+
+  // The event that is ready now, if any.
+  std::optional<EpollEvent> Poll() {
+    Result<std::optional<EpollEvent>> event =
+        epoll_.Wait(std::chrono::milliseconds(0));
+    EXPECT_THAT(event, IsOk());
+    return event.ok() ? *event : std::nullopt;
+  }
+
+  Epoll epoll_;
+  SharedFD read_end_;
+  SharedFD write_end_;
+};
+
+}  // namespace
+
+TEST_F(EpollTest, EventHasTheAddedSharedFD) {
+  ASSERT_THAT(epoll_.Add(read_end_, EPOLLIN), IsOk());
+  EXPECT_EQ(Poll(), std::nullopt);
+
+  ASSERT_EQ(write_end_->Write("x", 1), 1);
+  std::optional<EpollEvent> event = Poll();
+  ASSERT_TRUE(event.has_value());
+  EXPECT_EQ(event->fd, read_end_);
+  EXPECT_EQ(event->events, EPOLLIN);
+}
+
+TEST_F(EpollTest, AddTwiceFails) {
+  ASSERT_THAT(epoll_.Add(read_end_, EPOLLIN), IsOk());
+  EXPECT_THAT(epoll_.Add(read_end_, EPOLLIN), IsError());
+}
+
+TEST_F(EpollTest, ModifyChangesTheEvents) {
+  ASSERT_THAT(epoll_.Add(write_end_, EPOLLIN), IsOk());
+  EXPECT_EQ(Poll(), std::nullopt);
+
+  ASSERT_THAT(epoll_.Modify(write_end_, EPOLLOUT), IsOk());
+  std::optional<EpollEvent> event = Poll();
+  ASSERT_TRUE(event.has_value());
+  EXPECT_EQ(event->fd, write_end_);
+  EXPECT_EQ(event->events, EPOLLOUT);
+}
+
+TEST_F(EpollTest, AddOrModify) {
+  ASSERT_THAT(epoll_.AddOrModify(write_end_, EPOLLIN), IsOk());
+  EXPECT_EQ(Poll(), std::nullopt);
+
+  ASSERT_THAT(epoll_.AddOrModify(write_end_, EPOLLOUT), IsOk());
+  std::optional<EpollEvent> event = Poll();
+  ASSERT_TRUE(event.has_value());
+  EXPECT_EQ(event->fd, write_end_);
+}
+
+TEST_F(EpollTest, DeleteStopsTheEvents) {
+  ASSERT_THAT(epoll_.Add(read_end_, EPOLLIN), IsOk());
+  ASSERT_EQ(write_end_->Write("x", 1), 1);
+  ASSERT_THAT(epoll_.Delete(read_end_), IsOk());
+  EXPECT_EQ(Poll(), std::nullopt);
+  EXPECT_THAT(epoll_.Delete(read_end_), IsError());
+}
+
+TEST_F(EpollTest, UnwatchedFdFails) {
+  EXPECT_THAT(epoll_.Modify(read_end_, EPOLLIN), IsError());
+  EXPECT_THAT(epoll_.Delete(read_end_), IsError());
+}
+
+TEST_F(EpollTest, WatchesSeveralFds) {
+  ASSERT_THAT(epoll_.Add(read_end_, EPOLLIN), IsOk());
+  ASSERT_THAT(epoll_.Add(write_end_, EPOLLOUT), IsOk());
+  std::optional<EpollEvent> event = Poll();
+  ASSERT_TRUE(event.has_value());
+  EXPECT_EQ(event->fd, write_end_);
+
+  ASSERT_THAT(epoll_.Delete(write_end_), IsOk());
+  ASSERT_EQ(write_end_->Write("x", 1), 1);
+  event = Poll();
+  ASSERT_TRUE(event.has_value());
+  EXPECT_EQ(event->fd, read_end_);
+}
+
+// A descriptor closed without being deleted leaves its entry behind. The
+// next descriptor, which takes the same lowest free number, can be added.
+TEST_F(EpollTest, ReusedDescriptorNumber) {
+  SharedFD closed = SharedFD::Event();
+  ASSERT_TRUE(closed->IsOpen());
+  ASSERT_THAT(epoll_.Add(closed, EPOLLIN), IsOk());
+  closed->Close();
+
+  SharedFD reused = SharedFD::Event();
+  ASSERT_TRUE(reused->IsOpen());
+  ASSERT_THAT(epoll_.Add(reused, EPOLLIN), IsOk());
+  ASSERT_EQ(reused->EventfdWrite(1), 0);
+  std::optional<EpollEvent> event = Poll();
+  ASSERT_TRUE(event.has_value());
+  EXPECT_EQ(event->fd, reused);
+  EXPECT_THAT(epoll_.Modify(reused, EPOLLIN), IsOk());
+  EXPECT_THAT(epoll_.Delete(reused), IsOk());
+  EXPECT_THAT(epoll_.Delete(closed), IsError());
+}
+
+}  // namespace cuttlefish
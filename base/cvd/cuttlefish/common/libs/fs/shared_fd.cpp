@@ -15,6 +15,10 @@
  */
 #include "cuttlefish/common/libs/fs/shared_fd.h"
 
+#ifdef __linux__
+#include <linux/fs.h>
+#endif
+
 #include <arpa/inet.h>
 #include <errno.h>
 #include <fcntl.h>
@@ -22,6 +26,7 @@
 #include <netinet/in.h>
 #include <poll.h>
 #include <sys/file.h>
+#include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <sys/sendfile.h>
 #include <sys/stat.h>
@@ -200,18 +205,19 @@ bool FileInstance::SendFile(FileInstance& in, off_t* offset, size_t count) {
 
 
 void FileInstance::Close() {
-  std::stringstream message;
   if (fd_ == -1) {
     errno_ = EBADF;
   } else if (close(fd_) == -1) {
     errno_ = errno;
     if (!identity_.empty()) {
+      std::stringstream message;
       message << __FUNCTION__ << ": " << identity_ << " failed (" << StrError() << ")";
       std::string message_str = message.str();
       Log(message_str.c_str());
     }
   } else {
     if (!identity_.empty()) {
+      std::stringstream message;
       message << __FUNCTION__ << ": " << identity_ << "succeeded";
       std::string message_str = message.str();
       Log(message_str.c_str());
@@ -435,6 +441,16 @@ SharedFD SharedFD::Event(int initval, int flags) {
   return std::shared_ptr<FileInstance>(new FileInstance(fd, errno));
 }
 
+SharedFD SharedFD::PidFdOpen(pid_t pid) {
+  // There is no glibc wrapper for pidfd_open, nor a syscall number in older
+  // headers. It's the same on every architecture.
+#ifndef SYS_pidfd_open
+  constexpr int SYS_pidfd_open = 434;
+#endif
+  int fd = syscall(SYS_pidfd_open, pid, 0);  // Always CLOEXEC
+  return std::shared_ptr<FileInstance>(new FileInstance(fd, errno));
+}
+
 SharedFD SharedFD::ShmOpen(const std::string& name, int oflag, int mode) {
   errno = 0;
   int fd = shm_open(name.c_str(), oflag, mode);
@@ -884,6 +900,43 @@ int FileInstance::Fcntl(int command, int value) {
   return TEMP_FAILURE_RETRY(fcntl(fd_, command, value));
 }
 
+#ifdef __linux__
+int FileInstance::Fallocate(int mode, off_t offset, off_t length) {
+  LocalErrno record_errno(errno_);
+
+  return TEMP_FAILURE_RETRY(fallocate(fd_, mode, offset, length));
+}
+
+ssize_t FileInstance::CopyFileRange(FileInstance& in, off_t* in_offset,
+                                    off_t* offset, size_t length) {
+  LocalErrno record_errno(errno_);
+  loff_t in_pos = in_offset ? *in_offset : 0;
+  loff_t out_pos = offset ? *offset : 0;
+  ssize_t copied = TEMP_FAILURE_RETRY(
+      copy_file_range(in.fd_, in_offset ? &in_pos : nullptr, fd_,
+                      offset ? &out_pos : nullptr, length, 0));
+  if (in_offset) {
+    *in_offset = in_pos;
+  }
+  if (offset) {
+    *offset = out_pos;
+  }
+  return copied;
+}
+
+ssize_t FileInstance::Splice(FileInstance& in, size_t length,
+                             unsigned int flags) {
+  LocalErrno record_errno(errno_);
+  return TEMP_FAILURE_RETRY(
+      splice(in.fd_, nullptr, fd_, nullptr, length, flags));
+}
+
+int FileInstance::Clone(FileInstance& src) {
+  LocalErrno record_errno(errno_);
+  return TEMP_FAILURE_RETRY(ioctl(fd_, FICLONE, src.fd_));
+}
+#endif
+
 int FileInstance::Fsync() {
   LocalErrno record_errno(errno_);
 
@@ -952,6 +1005,15 @@ ssize_t FileInstance::RecvMsg(struct msghdr* msg, int flags) {
   return TEMP_FAILURE_RETRY(recvmsg(fd_, msg, flags));
 }
 
+#ifdef __linux__
+int FileInstance::RecvMMsg(struct mmsghdr* msgs, unsigned int vlen,
+                           int flags) {
+  LocalErrno record_errno(errno_);
+
+  return TEMP_FAILURE_RETRY(recvmmsg(fd_, msgs, vlen, flags, nullptr));
+}
+#endif
+
 ssize_t FileInstance::Read(void* buf, size_t count) {
   LocalErrno record_errno(errno_);
 
@@ -984,6 +1046,15 @@ ssize_t FileInstance::SendMsg(const struct msghdr* msg, int flags) {
   return TEMP_FAILURE_RETRY(sendmsg(fd_, msg, flags));
 }
 
+#ifdef __linux__
+int FileInstance::SendMMsg(struct mmsghdr* msgs, unsigned int vlen,
+                           int flags) {
+  LocalErrno record_errno(errno_);
+
+  return TEMP_FAILURE_RETRY(sendmmsg(fd_, msgs, vlen, flags));
+}
+#endif
+
 int FileInstance::Shutdown(int how) {
   LocalErrno record_errno(errno_);
 
@@ -1094,7 +1165,14 @@ void FileInstance::InotifyRmWatch(int watch) {
 }
 
 FileInstance::FileInstance(int fd, int in_errno)
-    : fd_(fd), errno_(in_errno), is_regular_file_(IsRegularFile(fd_)) {
+    : fd_(fd),
+      errno_(in_errno),
+      is_regular_file_(fd != -1 && IsRegularFile(fd)) {
+  // Every moved from SharedFD gets a closed instance, which has nothing to set
+  // up and no identity to log when closed.
+  if (fd == -1) {
+    return;
+  }
   // Ensure every file descriptor managed by a FileInstance has the CLOEXEC
   // flag
   TEMP_FAILURE_RETRY(fcntl(fd, F_SETFD, FD_CLOEXEC));
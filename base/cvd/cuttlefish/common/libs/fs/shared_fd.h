@@ -152,6 +152,9 @@ class SharedFD {
   static bool Pipe(SharedFD* fd0, SharedFD* fd1);
 #ifdef __linux__
   static SharedFD Event(int initval = 0, int flags = 0);
+  // Becomes readable when the process exits. Fails with ENOSYS before Linux
+  // 5.3, and may fail with EPERM or ENOSYS under seccomp.
+  static SharedFD PidFdOpen(pid_t pid);
   static SharedFD ShmOpen(const std::string& name, int oflag, int mode);
 #endif
   static SharedFD MemfdCreate(const std::string& name, unsigned int flags = 0);
@@ -313,6 +316,20 @@ class FileInstance {
   int UNMANAGED_Dup2(int newfd);
   int Fchdir();
   int Fcntl(int command, int value);
+#ifdef __linux__
+  int Fallocate(int mode, off_t offset, off_t length);
+  // Has the semantics of copy_file_range(2), with `in` as the source and this
+  // file as the destination.
+  ssize_t CopyFileRange(FileInstance& in, off_t* in_offset, off_t* offset,
+                        size_t length);
+  // Has the semantics of splice(2) without offsets, moving data from `in` to
+  // this file. One of the two files must be a pipe.
+  ssize_t Splice(FileInstance& in, size_t length, unsigned int flags = 0);
+  // Has the semantics of ioctl(FICLONE), replacing the contents of this file
+  // with extents shared with `src`. Only supported within one filesystem with
+  // reflink support, such as btrfs or XFS.
+  int Clone(FileInstance& src);
+#endif
   int Fsync();
 
   Result<void> Flock(int operation);
@@ -348,6 +365,10 @@ class FileInstance {
   off_t LSeek(off_t offset, int whence);
   ssize_t Recv(void* buf, size_t len, int flags);
   ssize_t RecvMsg(struct msghdr* msg, int flags);
+#ifdef __linux__
+  // Receives up to vlen messages in a single call, see recvmmsg(2).
+  int RecvMMsg(struct mmsghdr* msgs, unsigned int vlen, int flags);
+#endif
   ssize_t Read(void* buf, size_t count);
   ssize_t PRead(void* buf, size_t count, size_t offset);
 #ifdef __linux__
@@ -355,6 +376,10 @@ class FileInstance {
 #endif
   ssize_t Send(const void* buf, size_t len, int flags);
   ssize_t SendMsg(const struct msghdr* msg, int flags);
+#ifdef __linux__
+  // Sends up to vlen messages in a single call, see sendmmsg(2).
+  int SendMMsg(struct mmsghdr* msgs, unsigned int vlen, int flags);
+#endif
 
   template <typename... Args>
   ssize_t SendFileDescriptors(const void* buf, size_t len, Args&&... sent_fds) {
@@ -16,8 +16,15 @@
 
 #include "cuttlefish/common/libs/fs/shared_fd.h"
 
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
 #include <unistd.h>
 
+#include <string>
+#include <vector>
+
+#include "android-base/file.h"
 #include "gtest/gtest.h"
 
 namespace cuttlefish {
@@ -36,4 +43,63 @@ TEST(SendFD, Basic) {
   EXPECT_EQ(0, strcmp(buf, pipe_message));
 }
 
+#ifdef __linux__
+TEST(SendMMsg, ReceivesAllPendingMessages) {
+  SharedFD local;
+  SharedFD remote;
+  ASSERT_TRUE(
+      SharedFD::SocketPair(AF_UNIX, SOCK_SEQPACKET, 0, &local, &remote));
+  std::vector<std::string> sent = {"first", "second", "third"};
+  const int num_sent = sent.size();
+  std::vector<iovec> send_iovecs(sent.size());
+  std::vector<mmsghdr> send_msgs(sent.size());
+  for (size_t i = 0; i < sent.size(); i++) {
+    send_iovecs[i] = {sent[i].data(), sent[i].size()};
+    send_msgs[i].msg_hdr.msg_iov = &send_iovecs[i];
+    send_msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+  ASSERT_EQ(num_sent, local->SendMMsg(send_msgs.data(), num_sent, 0));
+
+  // Room for more messages than were sent, MSG_WAITFORONE returns what is
+  // available instead of waiting for the rest.
+  constexpr unsigned int kMaxMessages = 8;
+  char buffers[kMaxMessages][16];
+  iovec recv_iovecs[kMaxMessages];
+  mmsghdr recv_msgs[kMaxMessages] = {};
+  for (size_t i = 0; i < kMaxMessages; i++) {
+    recv_iovecs[i] = {buffers[i], sizeof(buffers[i])};
+    recv_msgs[i].msg_hdr.msg_iov = &recv_iovecs[i];
+    recv_msgs[i].msg_hdr.msg_iovlen = 1;
+  }
+  ASSERT_EQ(num_sent,
+            remote->RecvMMsg(recv_msgs, kMaxMessages, MSG_WAITFORONE));
+  for (int i = 0; i < num_sent; i++) {
+    EXPECT_EQ(sent[i], std::string(buffers[i], recv_msgs[i].msg_len));
+  }
+}
+
+TEST(FileInstance, CloneSharesTheContents) {
+  TemporaryDir dir;
+  const std::string src_path = std::string(dir.path) + "/src";
+  const std::string dst_path = std::string(dir.path) + "/dst";
+  ASSERT_TRUE(android::base::WriteStringToFile("cloned", src_path));
+  ASSERT_TRUE(android::base::WriteStringToFile("previous contents", dst_path));
+  SharedFD src = SharedFD::Open(src_path, O_RDONLY);
+  SharedFD dst = SharedFD::Open(dst_path, O_WRONLY);
+  ASSERT_TRUE(src->IsOpen()) << src->StrError();
+  ASSERT_TRUE(dst->IsOpen()) << dst->StrError();
+
+  if (dst->Clone(*src) != 0) {
+    const int error = dst->GetErrno();
+    ASSERT_TRUE(error == EOPNOTSUPP || error == ENOTTY || error == EINVAL)
+        << dst->StrError();
+    GTEST_SKIP() << "No reflink support in " << dir.path;
+  }
+
+  std::string contents;
+  ASSERT_TRUE(android::base::ReadFileToString(dst_path, &contents));
+  EXPECT_EQ(contents, "cloned");
+}
+#endif
+
 }  // namespace cuttlefish
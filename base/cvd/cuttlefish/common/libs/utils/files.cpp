@@ -345,6 +345,15 @@ bool Copy(const std::string& from, const std::string& to) {
     return false;
   }
 
+#ifdef __linux__
+  // On filesystems with reflink support the copy shares the data extents of
+  // the source, so it takes constant time and no extra space until either
+  // file is modified.
+  if (fd_to->Clone(*fd_from) == 0) {
+    return true;
+  }
+#endif
+
   off_t farthest_seek = fd_from->LSeek(0, SEEK_END);
   if (farthest_seek == -1) {
     LOG(ERROR) << "Could not lseek in \"" << from
@@ -15,6 +15,9 @@
 
 #include "cuttlefish/common/libs/utils/files.h"
 
+#include <fcntl.h>
+#include <sys/stat.h>
+
 #include <fstream>
 #include <string>
 
@@ -24,6 +27,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+#include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/result/result.h"
 #include "cuttlefish/result/result_matchers.h"
 
@@ -98,6 +102,53 @@ TEST_F(FilesTests, MoveDirectoryContents) {
   EXPECT_THAT(FileExists(dst_dir_ + "/sub_dir/file2.txt"), IsTrue());
 }
 
+TEST_F(FilesTests, CopyFile) {
+  std::string destination = std::string(temp_dir_.path) + "/copy.txt";
+  CreateTempFileWithText(destination, "previous contents");
+
+  EXPECT_TRUE(Copy(src_dir_ + "/file1.txt", destination));
+
+  std::string contents;
+  ASSERT_TRUE(android::base::ReadFileToString(destination, &contents));
+  EXPECT_EQ(contents, "file1");
+}
+
+#ifdef __linux__
+TEST_F(FilesTests, CopyKeepsHolesWhenCloningFails) {
+  // tmpfs has no reflink support, and files cannot be cloned across
+  // filesystems either.
+  if (!DirectoryExists("/dev/shm")) {
+    GTEST_SKIP() << "No /dev/shm";
+  }
+  TemporaryFile source("/dev/shm");
+  const std::string destination = std::string(temp_dir_.path) + "/copy.img";
+  constexpr size_t kSize = 4 << 20;
+  const std::string data(4096, 'x');
+  SharedFD source_fd = SharedFD::Open(source.path, O_RDWR);
+  SharedFD destination_fd =
+      SharedFD::Open(destination, O_WRONLY | O_CREAT, 0644);
+  ASSERT_TRUE(source_fd->IsOpen()) << source_fd->StrError();
+  ASSERT_TRUE(destination_fd->IsOpen()) << destination_fd->StrError();
+  ASSERT_EQ(source_fd->Truncate(kSize), 0) << source_fd->StrError();
+  ASSERT_EQ(source_fd->PWrite(data.data(), data.size(), 0), data.size());
+  ASSERT_EQ(source_fd->PWrite(data.data(), data.size(), kSize - data.size()),
+            data.size());
+  ASSERT_NE(destination_fd->Clone(*source_fd), 0);
+
+  EXPECT_TRUE(Copy(source.path, destination));
+
+  std::string expected(kSize, '\0');
+  expected.replace(0, data.size(), data);
+  expected.replace(kSize - data.size(), data.size(), data);
+  std::string contents;
+  ASSERT_TRUE(android::base::ReadFileToString(destination, &contents));
+  EXPECT_EQ(contents, expected);
+  struct stat st;
+  ASSERT_EQ(stat(destination.c_str(), &st), 0);
+  EXPECT_LT(st.st_blocks * 512, kSize / 2);
+}
+#endif
+
 TEST(FilesTest, PathWithCustomEnv) {
   const std::string env_name = "TEST_PATH";
   const std::string dir1 = "/foo/bar";
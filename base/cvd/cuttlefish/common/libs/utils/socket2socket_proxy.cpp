@@ -16,15 +16,21 @@
 
 #include "cuttlefish/common/libs/utils/socket2socket_proxy.h"
 
+#include <fcntl.h>
 #include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 
+#include <algorithm>
 #include <atomic>
 #include <cstring>
 #include <functional>
-#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <thread>
 #include <utility>
@@ -32,82 +38,354 @@
 
 #include "absl/log/log.h"
 
+#include "cuttlefish/common/libs/fs/epoll.h"
+#include "cuttlefish/posix/strerror.h"
+#include "cuttlefish/result/result.h"
+
 namespace cuttlefish {
 namespace {
 
-class ProxyPair {
+// The most read at once, and so buffered, in each direction of a connection.
+constexpr size_t kChunkSize = 64 * 1024;
+// Bounds the chunks forwarded for one event, so that a busy connection
+// doesn't hold up the others on its loop.
+constexpr int kChunksPerEvent = 16;
+constexpr unsigned int kSpliceFlags = SPLICE_F_MOVE | SPLICE_F_NONBLOCK;
+
+bool WouldBlock(int error) { return error == EAGAIN || error == EWOULDBLOCK; }
+
+// Forwards one way of a connection. The data goes through a pipe with
+// splice(), which keeps it in the kernel, or through a buffer when the
+// source can't be spliced from, like vsock. Only one chunk is read before it
+// is written, which stops reading from the source while the destination is
+// not keeping up.
+class Direction {
  public:
-  ProxyPair() : stop_fd_(SharedFD::Event()) {
-    if (!stop_fd_->IsOpen()) {
-      LOG(FATAL) << "Failed to open eventfd: " << stop_fd_->StrError();
-      return;
+  Direction(std::string label, SharedFD from, SharedFD to)
+      : label_(std::move(label)), from_(std::move(from)), to_(std::move(to)) {
+    if (!SharedFD::Pipe(&pipe_read_, &pipe_write_)) {
+      // Likely out of file descriptors, copying needs none.
+      VLOG(0) << label_ << ": Failed to create pipe: " << StrError(errno);
+    }
+  }
+
+  // Forwards until either end would block, or up to kChunksPerEvent chunks.
+  void Forward() {
+    for (int i = 0; i < kChunksPerEvent && !done_; i++) {
+      // A short read leaves the source empty, waiting for it to be readable
+      // again is cheaper than another read.
+      bool source_empty = false;
+      if (pending_ == 0) {
+        const ssize_t read = Fill();
+        if (read == 0) {
+          VLOG(0) << label_ << ": Reached the end of the input";
+          Stop();
+        } else if (read < 0 && !WouldBlock(read_errno_)) {
+          LOG(ERROR) << label_ << ": Error reading: " << StrError(read_errno_);
+          Stop();
+        }
+        if (read <= 0) {
+          return;
+        }
+        pending_ = read;
+        source_empty = pending_ < kChunkSize;
+      }
+      const ssize_t written = Drain();
+      if (written < 0) {
+        if (!WouldBlock(write_errno_)) {
+          LOG(ERROR) << label_ << ": Error writing: "
+                     << StrError(write_errno_);
+          Stop();
+        }
+        return;
+      }
+      pending_ -= written;
+      if (source_empty && pending_ == 0) {
+        return;
+      }
+    }
+  }
+
+  // Gives up on the data not written yet.
+  void Stop() {
+    if (!done_) {
+      to_->Shutdown(SHUT_WR);
+      done_ = true;
+    }
+  }
+
+  bool WantsRead() const { return !done_ && pending_ == 0; }
+  bool WantsWrite() const { return !done_ && pending_ > 0; }
+  bool Done() const { return done_; }
+
+ private:
+  ssize_t Fill() {
+    if (pipe_write_->IsOpen()) {
+      const ssize_t spliced =
+          pipe_write_->Splice(*from_, kChunkSize, kSpliceFlags);
+      read_errno_ = pipe_write_->GetErrno();
+      if (spliced >= 0 || read_errno_ != EINVAL) {
+        return spliced;
+      }
+      VLOG(0) << label_ << ": Can't splice from the source, copying instead";
+      pipe_read_ = SharedFD();
+      pipe_write_ = SharedFD();
     }
+    buffer_.resize(kChunkSize);
+    offset_ = 0;
+    const ssize_t read = from_->Read(buffer_.data(), buffer_.size());
+    read_errno_ = from_->GetErrno();
+    return read;
   }
 
-  ProxyPair(ProxyPair&& other)
-      : started_(other.started_),
-        stop_fd_(std::move(other.stop_fd_)),
-        c2t_running_(other.c2t_running_.load()),
-        t2c_running_(other.t2c_running_.load()) {
-    if (other.started_) {
-      LOG(FATAL) << "ProxyPair cannot be moved after Start() being executed";
+  ssize_t Drain() {
+    if (pipe_read_->IsOpen()) {
+      const ssize_t spliced = to_->Splice(*pipe_read_, pending_, kSpliceFlags);
+      write_errno_ = to_->GetErrno();
+      if (spliced >= 0 || write_errno_ != EINVAL) {
+        return spliced;
+      }
+      // The data is in the pipe already, move it to the buffer.
+      VLOG(0) << label_ << ": Can't splice to the destination, copying instead";
+      buffer_.resize(kChunkSize);
+      offset_ = 0;
+      if (pipe_read_->Read(buffer_.data(), pending_) !=
+          static_cast<ssize_t>(pending_)) {
+        write_errno_ = pipe_read_->GetErrno();
+        return -1;
+      }
+      pipe_read_ = SharedFD();
+      pipe_write_ = SharedFD();
+    }
+    const ssize_t written = to_->Write(buffer_.data() + offset_, pending_);
+    write_errno_ = to_->GetErrno();
+    if (written > 0) {
+      offset_ += written;
     }
+    return written;
   }
 
-  ~ProxyPair() {
-    if (stop_fd_->IsOpen() && stop_fd_->EventfdWrite(1) != 0) {
-      LOG(ERROR) << "Failed to stop proxy thread: " << stop_fd_->StrError();
+  std::string label_;
+  SharedFD from_;
+  SharedFD to_;
+  // Closed once splice() turned out not to work with the sockets.
+  SharedFD pipe_read_;
+  SharedFD pipe_write_;
+  std::vector<char> buffer_;
+  size_t offset_ = 0;
+  // Read from the source but not written to the destination yet.
+  size_t pending_ = 0;
+  int read_errno_ = 0;
+  int write_errno_ = 0;
+  bool done_ = false;
+};
+
+struct Connection {
+  // An end of the connection, as watched by the loop.
+  struct End {
+    SharedFD fd;
+    uint32_t events = 0;
+    bool watched = false;
+    // Then reported whatever the events requested, until no longer watched.
+    bool hung_up = false;
+  };
+
+  Connection(SharedFD client, SharedFD target)
+      : client{.fd = client},
+        target{.fd = target},
+        c2t("c2t", client, target),
+        t2c("t2c", target, client) {}
+
+  End client;
+  End target;
+  Direction c2t;
+  Direction t2c;
+};
+
+void SetNonBlocking(SharedFD fd) {
+  const int flags = fd->Fcntl(F_GETFL, 0);
+  if (flags < 0 || fd->Fcntl(F_SETFL, flags | O_NONBLOCK) < 0) {
+    LOG(ERROR) << "Failed to make the socket non-blocking: " << fd->StrError();
+  }
+}
+
+}  // namespace
+
+// Forwards the data of many connections on a single thread.
+class ProxyLoop {
+ public:
+  ProxyLoop() : wakeup_fd_(SharedFD::Event()) {
+    if (!wakeup_fd_->IsOpen()) {
+      LOG(FATAL) << "Failed to open eventfd: " << wakeup_fd_->StrError();
+      return;
+    }
+    Result<Epoll> epoll = Epoll::Create();
+    if (!epoll.ok()) {
+      LOG(FATAL) << epoll.error().FormatForEnv();
+      return;
+    }
+    epoll_ = std::move(*epoll);
+    Result<void> added = epoll_.Add(wakeup_fd_, EPOLLIN);
+    if (!added.ok()) {
+      LOG(FATAL) << added.error().FormatForEnv();
+      return;
     }
-    if (c2t_.joinable()) {
-      c2t_.join();
+    thread_ = std::thread(&ProxyLoop::Run, this);
+  }
+
+  ~ProxyLoop() {
+    {
+      std::lock_guard lock(mutex_);
+      stop_ = true;
+      if (wakeup_fd_->EventfdWrite(1) != 0) {
+        LOG(ERROR) << "Failed to stop proxy loop: " << wakeup_fd_->StrError();
+      }
     }
-    if (t2c_.joinable()) {
-      t2c_.join();
+    if (thread_.joinable()) {
+      thread_.join();
     }
   }
 
-  void Start(SharedFD from, SharedFD to) {
-    if (started_) {
-      LOG(FATAL) << "ProxyPair cannot be started second time";
+  void Add(SharedFD client, SharedFD target) {
+    size_++;
+    std::lock_guard lock(mutex_);
+    added_.emplace_back(std::move(client), std::move(target));
+    if (wakeup_fd_->EventfdWrite(1) != 0) {
+      LOG(ERROR) << "Failed to wake up proxy loop: " << wakeup_fd_->StrError();
     }
-    started_ = true;
-    c2t_running_ = true;
-    t2c_running_ = true;
-    c2t_ = std::thread(&ProxyPair::Forward, this, "c2t", from, to, stop_fd_,
-                       std::ref(c2t_running_));
-    t2c_ = std::thread(&ProxyPair::Forward, this, "t2c", to, from, stop_fd_,
-                       std::ref(t2c_running_));
   }
 
-  bool Running() { return c2t_running_ || t2c_running_; }
+  // The number of connections, including those not started yet.
+  size_t Size() const { return size_; }
 
  private:
-  void Forward(const std::string& label, SharedFD from, SharedFD to,
-               SharedFD stop, std::atomic<bool>& running) {
-    VLOG(0) << label << ": Proxy thread started. Starting copying data";
-    auto success = to->CopyAllFrom(*from, &(*stop));
-    if (!success) {
-      if (from->GetErrno()) {
-        LOG(ERROR) << label << ": Error reading: " << from->StrError();
+  void Run() {
+    while (true) {
+      Result<std::optional<EpollEvent>> event = epoll_.Wait();
+      if (!event.ok()) {
+        LOG(ERROR) << "Proxy loop failed: " << event.error().FormatForEnv();
+        return;
+      }
+      if (!event->has_value()) {
+        continue;
+      }
+      if ((*event)->fd == wakeup_fd_) {
+        if (!TakeAdded()) {
+          return;
+        }
+        continue;
       }
-      if (to->GetErrno()) {
-        LOG(ERROR) << label << ": Error writing: " << to->StrError();
+      auto connection = connections_.find((*event)->fd);
+      if (connection != connections_.end()) {
+        // Keeps the connection alive when removed from connections_.
+        std::shared_ptr<Connection> handled = connection->second;
+        Handle(*handled, (*event)->fd, (*event)->events);
       }
     }
-    to->Shutdown(SHUT_WR);
-    running = false;
-    VLOG(0) << label << ": Proxy thread completed";
   }
 
-  bool started_ = false;
-  SharedFD stop_fd_;
-  std::atomic<bool> c2t_running_ = false;
-  std::atomic<bool> t2c_running_ = false;
-  std::thread c2t_;
-  std::thread t2c_;
-};
+  // Starts forwarding the new connections. Returns false if stopped.
+  bool TakeAdded() {
+    std::vector<std::pair<SharedFD, SharedFD>> added;
+    {
+      std::lock_guard lock(mutex_);
+      eventfd_t ignored;
+      wakeup_fd_->EventfdRead(&ignored);
+      if (stop_) {
+        return false;
+      }
+      added.swap(added_);
+    }
+    for (auto& [client, target] : added) {
+      SetNonBlocking(client);
+      SetNonBlocking(target);
+      auto connection = std::make_shared<Connection>(client, target);
+      connections_[client] = connection;
+      connections_[target] = connection;
+      Update(*connection);
+    }
+    VLOG(0) << "Amount of currently tracked proxy connections: "
+            << connections_.size() / 2;
+    return true;
+  }
 
-}  // namespace
+  void Handle(Connection& connection, const SharedFD& fd, uint32_t events) {
+    const bool is_client = fd == connection.client.fd;
+    Direction& from_fd = is_client ? connection.c2t : connection.t2c;
+    Direction& to_fd = is_client ? connection.t2c : connection.c2t;
+    const bool hung_up = events & (EPOLLERR | EPOLLHUP);
+    if (hung_up || (events & EPOLLIN)) {
+      from_fd.Forward();
+    }
+    if (hung_up || (events & EPOLLOUT)) {
+      to_fd.Forward();
+    }
+    if (hung_up) {
+      // Nothing can be written to this end anymore.
+      (is_client ? connection.client : connection.target).hung_up = true;
+      to_fd.Stop();
+    }
+    Update(connection);
+  }
+
+  // Watches for what the directions wait on, or removes the connection once
+  // both are done.
+  void Update(Connection& connection) {
+    if (connection.c2t.Done() && connection.t2c.Done()) {
+      Unwatch(connection.client);
+      Unwatch(connection.target);
+      connections_.erase(connection.client.fd);
+      connections_.erase(connection.target.fd);
+      size_--;
+      return;
+    }
+    Watch(connection.client, (connection.c2t.WantsRead() ? EPOLLIN : 0) |
+                                 (connection.t2c.WantsWrite() ? EPOLLOUT : 0));
+    Watch(connection.target, (connection.t2c.WantsRead() ? EPOLLIN : 0) |
+                                 (connection.c2t.WantsWrite() ? EPOLLOUT : 0));
+  }
+
+  void Watch(Connection::End& end, uint32_t events) {
+    // A hung up fd would be reported until its end of the connection is
+    // read again, if ever.
+    if (end.hung_up && events == 0) {
+      Unwatch(end);
+      return;
+    }
+    if (end.watched && end.events == events) {
+      return;
+    }
+    Result<void> watched = epoll_.AddOrModify(end.fd, events);
+    if (!watched.ok()) {
+      LOG(ERROR) << watched.error().FormatForEnv();
+      return;
+    }
+    end.events = events;
+    end.watched = true;
+  }
+
+  void Unwatch(Connection::End& end) {
+    if (!end.watched) {
+      return;
+    }
+    Result<void> deleted = epoll_.Delete(end.fd);
+    if (!deleted.ok()) {
+      LOG(ERROR) << deleted.error().FormatForEnv();
+    }
+    end.watched = false;
+  }
+
+  SharedFD wakeup_fd_;
+  Epoll epoll_;
+  // Also serializes the uses of wakeup_fd_, which records their errno.
+  std::mutex mutex_;
+  std::vector<std::pair<SharedFD, SharedFD>> added_;
+  bool stop_ = false;
+  std::atomic<size_t> size_ = 0;
+  // Both ends of every connection, only used by the loop thread.
+  std::map<SharedFD, std::shared_ptr<Connection>> connections_;
+  std::thread thread_;
+};
 
 ProxyServer::ProxyServer(SharedFD server,
                          std::function<SharedFD()> clients_factory)
@@ -116,11 +394,15 @@ ProxyServer::ProxyServer(SharedFD server,
     LOG(FATAL) << "Failed to open eventfd: " << stop_fd_->StrError();
     return;
   }
+  const unsigned int loops =
+      std::clamp(std::thread::hardware_concurrency(), 1u, 4u);
+  for (unsigned int i = 0; i < loops; i++) {
+    loops_.emplace_back(std::make_unique<ProxyLoop>());
+  }
   server_ = std::thread([&, server_fd = std::move(server),
                          clients_factory = std::move(clients_factory)]() {
     constexpr ssize_t SERVER = 0;
     constexpr ssize_t STOP = 1;
-    std::list<ProxyPair> watched;
 
     std::vector<PollSharedFd> server_poll = {
         {.fd = server_fd, .events = POLLIN},
@@ -154,25 +436,22 @@ ProxyServer::ProxyServer(SharedFD server,
       }
       auto target = clients_factory();
       if (target->IsOpen()) {
-        VLOG(0) << "Launching proxy threads";
-        watched.push_back(ProxyPair());
-        watched.back().Start(client, target);
-        VLOG(0)
-            << "Proxy is launched. Amount of currently tracked proxy pairs: "
-            << watched.size();
+        // Onto the loop with the fewest connections.
+        auto loop = std::min_element(
+            loops_.begin(), loops_.end(),
+            [](const auto& a, const auto& b) { return a->Size() < b->Size(); });
+        (*loop)->Add(client, target);
       } else {
         LOG(ERROR) << "Cannot connect to the target to setup proxying: "
                    << target->StrError();
       }
-      // Unwatch completed proxy pairs
-      watched.remove_if([](ProxyPair& proxy) { return !proxy.Running(); });
     }
 
-    // Making sure all launched proxy pairs are finished by triggering their
-    // destructor
-    VLOG(0) << "Waiting for proxy threads to turn down";
-    watched.clear();
-    VLOG(0) << "Proxy threads are successfully turned down";
+    // Making sure all the connections are finished by triggering the
+    // destructors of the loops
+    VLOG(0) << "Waiting for proxy loops to turn down";
+    loops_.clear();
+    VLOG(0) << "Proxy loops are successfully turned down";
   });
 }
 
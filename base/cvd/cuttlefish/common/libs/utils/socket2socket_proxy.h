@@ -19,11 +19,14 @@
 #include <functional>
 #include <memory>
 #include <thread>
+#include <vector>
 
 #include "cuttlefish/common/libs/fs/shared_fd.h"
 
 namespace cuttlefish {
 
+class ProxyLoop;
+
 class ProxyServer {
  public:
   ProxyServer(SharedFD server, std::function<SharedFD()> clients_factory);
@@ -32,13 +35,16 @@ class ProxyServer {
 
  private:
   SharedFD stop_fd_;
+  // Each forwards the data of its connections on a thread of its own.
+  std::vector<std::unique_ptr<ProxyLoop>> loops_;
   std::thread server_;
 };
 
 // Executes a TCP proxy
 // Accept() is called on the server in a loop, for every client connection a
 // target connection is created through the conn_factory callback and data is
-// forwarded between the two connections.
+// forwarded between the two connections. A few event loops forward the data
+// of all the connections, with splice() where the sockets support it.
 // This function is meant to execute forever, but will return if the server is
 // closed in another thread. It's recommended the caller disables the default
 // behavior for SIGPIPE before calling this function, otherwise it runs the risk
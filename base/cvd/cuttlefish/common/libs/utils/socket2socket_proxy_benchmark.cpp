@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the throughput of the proxy with 1 to 256 connections sending at
+// once, and the round trip latency of a connection next to 0 to 256 idle
+// ones. The proxy listens on a local socket and connects to socketpairs.
+
+#include <signal.h>
+#include <stddef.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "benchmark/benchmark.h"
+
+#include "cuttlefish/common/libs/fs/shared_buf.h"
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/common/libs/utils/socket2socket_proxy.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr size_t kChunkSize = 64 * 1024;
+constexpr size_t kChunksPerConnection = 16;
+
+class LocalProxy {
+ public:
+  LocalProxy()
+      : name_("socket2socket_proxy_benchmark_" + std::to_string(getpid())) {
+    signal(SIGPIPE, SIG_IGN);
+    SharedFD server =
+        SharedFD::SocketLocalServer(name_, true, SOCK_STREAM, 0666);
+    CHECK(server->IsOpen()) << server->StrError();
+    proxy_ = ProxyAsync(server, [this]() {
+      SharedFD proxied;
+      SharedFD target;
+      const bool created =
+          SharedFD::SocketPair(AF_UNIX, SOCK_STREAM, 0, &proxied, &target);
+      CHECK(created) << "Failed to create socketpair";
+      std::lock_guard lock(mutex_);
+      targets_.push_back(target);
+      targets_cv_.notify_one();
+      return proxied;
+    });
+  }
+
+  // Returns the client and target ends of a new connection.
+  std::pair<SharedFD, SharedFD> Connect() {
+    SharedFD client = SharedFD::SocketLocalClient(name_, true, SOCK_STREAM);
+    CHECK(client->IsOpen()) << client->StrError();
+    std::unique_lock lock(mutex_);
+    targets_cv_.wait(lock, [this]() { return !targets_.empty(); });
+    SharedFD target = targets_.front();
+    targets_.pop_front();
+    return {client, target};
+  }
+
+ private:
+  std::string name_;
+  std::mutex mutex_;
+  std::condition_variable targets_cv_;
+  std::deque<SharedFD> targets_;
+  std::unique_ptr<ProxyServer> proxy_;
+};
+
+void BM_ProxyThroughput(benchmark::State& state) {
+  LocalProxy proxy;
+  std::vector<std::pair<SharedFD, SharedFD>> connections;
+  for (int i = 0; i < state.range(0); i++) {
+    connections.emplace_back(proxy.Connect());
+  }
+  const std::string chunk(kChunkSize, 'x');
+  std::string received(kChunkSize, '\0');
+  for (auto _ : state) {
+    // Chunks go out to every connection in turn, and come back in the same
+    // order, so that all the connections are busy at once.
+    std::thread writer([&connections, &chunk]() {
+      for (size_t i = 0; i < kChunksPerConnection; i++) {
+        for (auto& [client, target] : connections) {
+          const ssize_t written = WriteAll(client, chunk);
+          CHECK(written == ssize_t{kChunkSize}) << client->StrError();
+        }
+      }
+    });
+    for (size_t i = 0; i < kChunksPerConnection; i++) {
+      for (auto& [client, target] : connections) {
+        const ssize_t read = ReadExact(target, &received);
+        CHECK(read == ssize_t{kChunkSize}) << target->StrError();
+      }
+    }
+    writer.join();
+  }
+  state.SetBytesProcessed(state.iterations() * connections.size() *
+                          kChunksPerConnection * kChunkSize);
+}
+BENCHMARK(BM_ProxyThroughput)->Arg(1)->Arg(16)->Arg(256)->UseRealTime();
+
+void BM_ProxyRoundTrip(benchmark::State& state) {
+  LocalProxy proxy;
+  std::vector<std::pair<SharedFD, SharedFD>> idle;
+  for (int i = 0; i < state.range(0); i++) {
+    idle.emplace_back(proxy.Connect());
+  }
+  auto [client, target] = proxy.Connect();
+  std::string message = "x";
+  for (auto _ : state) {
+    const bool sent = WriteAll(client, message) == 1 &&
+                      ReadExact(target, &message) == 1 &&
+                      WriteAll(target, message) == 1 &&
+                      ReadExact(client, &message) == 1;
+    CHECK(sent) << "Round trip failed";
+  }
+}
+BENCHMARK(BM_ProxyRoundTrip)->Arg(0)->Arg(256)->UseRealTime();
+
+}  // namespace
+}  // namespace cuttlefish
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/common/libs/utils/socket2socket_proxy.h"
+
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/common/libs/fs/shared_buf.h"
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+
+namespace cuttlefish {
+namespace {
+
+// Proxies connections to a local server to the other ends of socketpairs.
+class LocalProxy {
+ public:
+  LocalProxy()
+      : name_("socket2socket_proxy_test_" + std::to_string(getpid())) {
+    signal(SIGPIPE, SIG_IGN);
+    SharedFD server =
+        SharedFD::SocketLocalServer(name_, true, SOCK_STREAM, 0666);
+    CHECK(server->IsOpen()) << server->StrError();
+    proxy_ = ProxyAsync(server, [this]() {
+      SharedFD proxied;
+      SharedFD target;
+      CHECK(SharedFD::SocketPair(AF_UNIX, SOCK_STREAM, 0, &proxied, &target));
+      std::lock_guard lock(mutex_);
+      targets_.push_back(target);
+      targets_cv_.notify_one();
+      return proxied;
+    });
+  }
+
+  // Returns the client and target ends of a new connection.
+  std::pair<SharedFD, SharedFD> Connect() {
+    SharedFD client = SharedFD::SocketLocalClient(name_, true, SOCK_STREAM);
+    CHECK(client->IsOpen()) << client->StrError();
+    std::unique_lock lock(mutex_);
+    targets_cv_.wait(lock, [this]() { return !targets_.empty(); });
+    SharedFD target = targets_.front();
+    targets_.pop_front();
+    return {client, target};
+  }
+
+ private:
+  std::string name_;
+  std::mutex mutex_;
+  std::condition_variable targets_cv_;
+  std::deque<SharedFD> targets_;
+  std::unique_ptr<ProxyServer> proxy_;
+};
+
+std::string Pattern(size_t size, size_t seed) {
+  std::string data(size, '\0');
+  for (size_t i = 0; i < size; i++) {
+    data[i] = static_cast<char>((i * 31 + seed) % 251);
+  }
+  return data;
+}
+
+}  // namespace
+
+TEST(Socket2SocketProxy, ForwardsBothWaysUntilClosed) {
+  LocalProxy proxy;
+  auto [client, target] = proxy.Connect();
+
+  ASSERT_EQ(WriteAll(client, "request"), 7);
+  ASSERT_EQ(client->Shutdown(SHUT_WR), 0);
+  std::string request;
+  ASSERT_EQ(ReadAll(target, &request), 7);
+  EXPECT_EQ(request, "request");
+
+  // The other direction is still open after the client shut down its own.
+  ASSERT_EQ(WriteAll(target, "response"), 8);
+  target->Close();
+  std::string response;
+  ASSERT_EQ(ReadAll(client, &response), 8);
+  EXPECT_EQ(response, "response");
+}
+
+TEST(Socket2SocketProxy, ForwardsManyConnections) {
+  constexpr size_t kConnections = 64;
+  constexpr size_t kSize = 1 << 20;
+  LocalProxy proxy;
+  std::vector<std::pair<SharedFD, SharedFD>> connections;
+  for (size_t i = 0; i < kConnections; i++) {
+    connections.emplace_back(proxy.Connect());
+  }
+
+  std::thread writer([&connections]() {
+    for (size_t i = 0; i < connections.size(); i++) {
+      const std::string data = Pattern(kSize, i);
+      CHECK_EQ(WriteAll(connections[i].first, data), ssize_t{kSize});
+      connections[i].first->Shutdown(SHUT_WR);
+    }
+  });
+  for (size_t i = 0; i < connections.size(); i++) {
+    std::string received;
+    ASSERT_EQ(ReadAll(connections[i].second, &received), ssize_t{kSize});
+    EXPECT_EQ(received, Pattern(kSize, i)) << "Connection " << i;
+  }
+  writer.join();
+}
+
+}  // namespace cuttlefish
@@ -52,6 +52,7 @@
 
 #include "cuttlefish/common/libs/utils/contains.h"
 #include "cuttlefish/common/libs/utils/files.h"
+#include "cuttlefish/result/result.h"
 
 extern char** environ;
 
@@ -157,6 +158,26 @@ SubprocessOptions SubprocessOptions::Strace(std::string s) && {
   return std::move(*this);
 }
 
+SubprocessOptions& SubprocessOptions::InCgroup(SharedFD cgroup_procs) & {
+  cgroup_procs_ = std::move(cgroup_procs);
+  return *this;
+}
+SubprocessOptions SubprocessOptions::InCgroup(SharedFD cgroup_procs) && {
+  cgroup_procs_ = std::move(cgroup_procs);
+  return std::move(*this);
+}
+
+SubprocessOptions& SubprocessOptions::CheckPrerequisites(
+    bool check_prerequisites) & {
+  check_prerequisites_ = check_prerequisites;
+  return *this;
+}
+SubprocessOptions SubprocessOptions::CheckPrerequisites(
+    bool check_prerequisites) && {
+  check_prerequisites_ = check_prerequisites;
+  return std::move(*this);
+}
+
 Subprocess::Subprocess(Subprocess&& subprocess)
     : pid_(subprocess.pid_.load()),
       started_(subprocess.started_),
@@ -432,6 +453,13 @@ Command Command::AddPrerequisite(
   return std::move(*this);
 }
 
+Result<void> Command::CheckPrerequisites() const {
+  for (const auto& prerequisite : prerequisites_) {
+    CF_EXPECT(prerequisite());
+  }
+  return {};
+}
+
 Subprocess Command::Start(SubprocessOptions options) const {
   auto cmd = ToCharPointers(command_);
 
@@ -451,12 +479,10 @@ Subprocess Command::Start(SubprocessOptions options) const {
     return Subprocess(-1, {});
   }
 
-  for (auto& prerequisite : prerequisites_) {
-    auto prerequisiteResult = prerequisite();
-
-    if (!prerequisiteResult.ok()) {
-      LOG(ERROR) << "Failed to check prerequisites: "
-                 << prerequisiteResult.error();
+  if (options.CheckPrerequisites()) {
+    Result<void> prerequisites = CheckPrerequisites();
+    if (!prerequisites.ok()) {
+      LOG(ERROR) << "Failed to check prerequisites: " << prerequisites.error();
       return Subprocess(-1, {});
     }
   }
@@ -481,6 +507,13 @@ Subprocess Command::Start(SubprocessOptions options) const {
         exit(-errno);
       }
     }
+    if (options.InCgroup()->IsOpen()) {
+      // "0" stands for the writing process, before it runs anything that
+      // could start processes of its own outside the cgroup.
+      if (options.InCgroup()->Write("0", 1) != 1) {
+        exit(-options.InCgroup()->GetErrno());
+      }
+    }
     for (const auto& entry : inherited_fds_) {
       if (fcntl(entry.second, F_SETFD, 0)) {
         exit(-errno);
@@ -34,6 +34,7 @@
 #include "absl/log/check.h"
 
 #include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
 
@@ -100,7 +101,10 @@ class Subprocess {
 class SubprocessOptions {
  public:
   SubprocessOptions()
-      : verbose_(true), exit_with_parent_(true), in_group_(false) {}
+      : verbose_(true),
+        exit_with_parent_(true),
+        in_group_(false),
+        check_prerequisites_(true) {}
   SubprocessOptions& Verbose(bool verbose) &;
   SubprocessOptions Verbose(bool verbose) &&;
   SubprocessOptions& ExitWithParent(bool exit_with_parent) &;
@@ -113,17 +117,29 @@ class SubprocessOptions {
 
   SubprocessOptions& Strace(std::string strace_output_path) &;
   SubprocessOptions Strace(std::string strace_output_path) &&;
+  // The subprocess moves itself to the cgroup before running the command, by
+  // writing to this open cgroup.procs file.
+  SubprocessOptions& InCgroup(SharedFD cgroup_procs) &;
+  SubprocessOptions InCgroup(SharedFD cgroup_procs) &&;
+  // Whether Command::Start runs the prerequisites of the command first. Only
+  // disable it after they passed through Command::CheckPrerequisites.
+  SubprocessOptions& CheckPrerequisites(bool check_prerequisites) &;
+  SubprocessOptions CheckPrerequisites(bool check_prerequisites) &&;
 
   bool Verbose() const { return verbose_; }
   bool ExitWithParent() const { return exit_with_parent_; }
   bool InGroup() const { return in_group_; }
   const std::string& Strace() const { return strace_; }
+  const SharedFD& InCgroup() const { return cgroup_procs_; }
+  bool CheckPrerequisites() const { return check_prerequisites_; }
 
  private:
   bool verbose_;
   bool exit_with_parent_;
   bool in_group_;
   std::string strace_;
+  SharedFD cgroup_procs_;
+  bool check_prerequisites_;
 };
 
 // An executable command. Multiple subprocesses can be started from the same
@@ -266,6 +282,11 @@ class Command {
 
   Command& AddPrerequisite(const std::function<Result<void>()>& prerequisite) &;
   Command AddPrerequisite(const std::function<Result<void>()>& prerequisite) &&;
+  // Runs the prerequisites. They wait until what the command needs is
+  // available, so running them beforehand on another thread, then starting
+  // with SubprocessOptions::CheckPrerequisites(false), keeps Start from
+  // blocking.
+  Result<void> CheckPrerequisites() const;
 
   // Starts execution of the command. This method can be called multiple times,
   // effectively staring multiple (possibly concurrent) instances.
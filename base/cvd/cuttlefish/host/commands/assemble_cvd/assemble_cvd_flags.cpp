@@ -193,6 +193,11 @@ DEFINE_vec(udp_port_range, CF_DEFAULTS_UDP_PORT_RANGE,
            "The minimum and maximum UDP port numbers to allocate for ICE "
            "candidates as 'min:max'. To use any port just specify '0:0'");
 
+DEFINE_vec(webrtc_video_codecs, CF_DEFAULTS_WEBRTC_VIDEO_CODECS,
+           "The video codecs to offer to webrtc clients, separated by ':' and "
+           "most preferred first. Each client streams with the first one it "
+           "also supports. Supported codecs are VP8, VP9 and AV1.");
+
 DEFINE_vec(
     webrtc_device_id, CF_DEFAULTS_WEBRTC_DEVICE_ID,
     "The for the device to register with the signaling server. Every "
@@ -97,6 +97,8 @@ DECLARE_vec(tcp_port_range);
 
 DECLARE_vec(udp_port_range);
 
+DECLARE_vec(webrtc_video_codecs);
+
 DECLARE_vec(webrtc_device_id);
 
 DECLARE_vec(uuid);
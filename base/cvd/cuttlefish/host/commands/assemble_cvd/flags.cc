@@ -127,6 +127,22 @@ Result<std::pair<uint16_t, uint16_t>> ParsePortRange(const std::string& flag) {
   return port_range;
 }
 
+Result<std::vector<std::string>> ParseVideoCodecs(const std::string& flag) {
+  static const std::set<std::string, std::less<>> kSupportedCodecs = {
+      "AV1",
+      "VP8",
+      "VP9",
+  };
+  std::vector<std::string> codecs =
+      absl::StrSplit(flag, ':', absl::SkipEmpty());
+  CF_EXPECT(!codecs.empty(), "No video codecs given for webrtc");
+  for (const std::string& codec : codecs) {
+    CF_EXPECTF(Contains(kSupportedCodecs, codec),
+               "Unsupported webrtc video codec: '{}'", codec);
+  }
+  return codecs;
+}
+
 std::string StrForInstance(const std::string& prefix, int num) {
   std::ostringstream stream;
   stream << prefix << std::setfill('0') << std::setw(2) << num;
@@ -598,6 +614,8 @@ Result<CuttlefishConfig> InitializeCuttlefishConfiguration(
       CF_EXPECT(GET_FLAG_STR_VALUE(tcp_port_range));
   std::vector<std::string> udp_port_range_vec =
       CF_EXPECT(GET_FLAG_STR_VALUE(udp_port_range));
+  std::vector<std::string> webrtc_video_codecs_vec =
+      CF_EXPECT(GET_FLAG_STR_VALUE(webrtc_video_codecs));
   std::vector<bool> vhost_net_vec = CF_EXPECT(GET_FLAG_BOOL_VALUE(vhost_net));
   std::vector<std::string> vhost_user_vsock_vec =
       CF_EXPECT(GET_FLAG_STR_VALUE(vhost_user_vsock));
@@ -1275,6 +1293,9 @@ Result<CuttlefishConfig> InitializeCuttlefishConfiguration(
         CF_EXPECT(ParsePortRange(udp_port_range_vec[instance_index]));
     instance.set_webrtc_udp_port_range(udp_range);
 
+    instance.set_webrtc_video_codecs(
+        CF_EXPECT(ParseVideoCodecs(webrtc_video_codecs_vec[instance_index])));
+
     // end of streaming, webrtc setup
 
     CF_EXPECT(Contains(num_to_webrtc_device_id_flag_map, num),
@@ -18,57 +18,26 @@
 
 #include <stddef.h>
 
-#include <algorithm>
-#include <chrono>
-#include <iterator>
+#include <optional>
 #include <string>
-#include <string_view>
 #include <utility>
-#include <vector>
 
 #include <fmt/format.h>
-#include "absl/strings/match.h"
-#include "absl/log/check.h"
 #include "absl/log/log.h"
 
-#include "cuttlefish/common/libs/utils/disk_usage.h"
 #include "cuttlefish/common/libs/utils/files.h"
+#include "cuttlefish/host/commands/cvd/cache/cache_index.h"
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
 
 namespace {
 
-Result<std::vector<std::string>> CacheFilesDesc(
-    const std::string& cache_directory) {
-  std::vector<std::string> contents = CF_EXPECTF(
-      DirectoryContentsPaths(cache_directory),
-      "Failure retrieving contents of directory at \"{}\"", cache_directory);
+constexpr size_t kGigabyte = size_t{1} << 30;
 
-  auto not_self_or_parent_directory = [](std::string_view filepath) {
-    return !absl::EndsWith(filepath, ".") && !absl::EndsWith(filepath, "..");
-  };
-  std::vector<std::string> filtered;
-  std::copy_if(contents.begin(), contents.end(), std::back_inserter(filtered),
-               not_self_or_parent_directory);
-
-  using ModTimePair =
-      std::pair<std::string, std::chrono::system_clock::time_point>;
-  std::vector<ModTimePair> to_sort;
-  for (const std::string& filename : filtered) {
-    to_sort.emplace_back(
-        std::pair(filename, CF_EXPECT(FileModificationTime(filename))));
-  }
-  std::sort(to_sort.begin(), to_sort.end(),
-            [](const ModTimePair& a, const ModTimePair& b) {
-              return a.second > b.second;
-            });
-
-  std::vector<std::string> result;
-  for (const ModTimePair& pair : to_sort) {
-    result.emplace_back(pair.first);
-  }
-  return result;
+// Rounds up, matching the whole-gigabyte sizes from `du --block-size=1G`.
+size_t ToGigabytes(const size_t bytes) {
+  return (bytes + kGigabyte - 1) / kGigabyte;
 }
 
 }  // namespace
@@ -82,32 +51,44 @@ Result<void> EmptyCache(const std::string& cache_directory) {
 
 Result<size_t> GetCacheSize(const std::string& cache_directory) {
   CF_EXPECT(EnsureDirectoryExists(cache_directory));
-  return CF_EXPECT(GetDiskUsageGigabytes(cache_directory));
+  std::optional<CacheIndex> index = CF_EXPECT(ReadCacheIndex(cache_directory));
+  if (!index) {
+    index = CF_EXPECT(ScanCache(cache_directory));
+    CF_EXPECT(WriteCacheIndex(cache_directory, *index));
+  }
+  return ToGigabytes(index->total_bytes);
 }
 
 Result<PruneResult> PruneCache(const std::string& cache_directory,
                                const size_t allowed_size_gb) {
   CF_EXPECT(EnsureDirectoryExists(cache_directory));
-  size_t cache_size = CF_EXPECT(GetDiskUsageGigabytes(cache_directory));
+  CacheIndex index = CF_EXPECT(ScanCache(cache_directory));
   PruneResult result{
-      .before = cache_size,
+      .before = ToGigabytes(index.total_bytes),
   };
-  // Descending because elements are removed from the back
-  std::vector<std::string> cache_files =
-      CF_EXPECT(CacheFilesDesc(cache_directory));
-  while (cache_size > allowed_size_gb) {
-    CHECK(!cache_files.empty()) << fmt::format(
-        "Cache size is {} of {}, but there are no more files for pruning.",
-        cache_size, allowed_size_gb);
-
-    std::string next = cache_files.back();
-    cache_files.pop_back();
-    VLOG(0) << fmt::format("Deleting \"{}\" for prune", next);
+  const size_t allowed_bytes = allowed_size_gb * kGigabyte;
+  size_t freed_bytes = 0;
+  // Most recently used first, so the least recently used are at the back
+  while (index.total_bytes > allowed_bytes) {
+    CF_EXPECTF(!index.entries.empty(),
+               "Cache size is {} bytes of {}, but there are no more files for "
+               "pruning.",
+               index.total_bytes, allowed_bytes);
+
+    CacheEntry next = PopLeastRecentlyUsed(index);
+    VLOG(0) << fmt::format("Deleting \"{}\" for prune", next.path);
     // handles removal of non-directory top-level files as well
-    CF_EXPECT(RecursivelyRemoveDirectory(next));
-    cache_size = CF_EXPECT(GetDiskUsageGigabytes(cache_directory));
+    CF_EXPECT(RecursivelyRemoveDirectory(next.path));
+    freed_bytes += next.reclaimable_bytes;
+  }
+  if (freed_bytes > 0) {
+    VLOG(0) << fmt::format(
+        "Prune freed {} bytes on disk, other files remain linked from fetch "
+        "directories",
+        freed_bytes);
   }
-  result.after = cache_size;
+  CF_EXPECT(WriteCacheIndex(cache_directory, index));
+  result.after = ToGigabytes(index.total_bytes);
   return result;
 }
 
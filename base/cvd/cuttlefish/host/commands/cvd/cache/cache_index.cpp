@@ -0,0 +1,327 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/commands/cvd/cache/cache_index.h"
+
+#include <errno.h>
+#include <fts.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+#include "absl/log/log.h"
+#include "absl/strings/match.h"
+#include "android-base/file.h"
+#include "json/json.h"
+
+#include "cuttlefish/common/libs/utils/files.h"
+#include "cuttlefish/common/libs/utils/json.h"
+#include "cuttlefish/posix/rename.h"
+#include "cuttlefish/posix/strerror.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+
+namespace {
+
+constexpr char kIndexFileName[] = ".cache_index.json";
+constexpr int kIndexVersion = 2;
+// Marks inodes linked from more than one entry.
+constexpr size_t kSharedInode = static_cast<size_t>(-1);
+
+struct Inode {
+  size_t entry = 0;
+  // The entries linking a shared inode.
+  std::set<size_t> sharing_entries;
+  size_t bytes = 0;
+  nlink_t links = 0;
+  nlink_t links_seen = 0;
+};
+
+using InodeMap = std::map<std::pair<dev_t, ino_t>, Inode>;
+
+std::chrono::system_clock::time_point ToTimePoint(const struct timespec& ts) {
+  return std::chrono::system_clock::time_point(
+      std::chrono::duration_cast<std::chrono::system_clock::duration>(
+          std::chrono::seconds(ts.tv_sec) +
+          std::chrono::nanoseconds(ts.tv_nsec)));
+}
+
+std::chrono::system_clock::time_point LastUsed(const struct stat& st) {
+#if defined(__APPLE__)
+  const struct timespec& atime = st.st_atimespec;
+  const struct timespec& mtime = st.st_mtimespec;
+  const struct timespec& ctime = st.st_ctimespec;
+#else
+  const struct timespec& atime = st.st_atim;
+  const struct timespec& mtime = st.st_mtim;
+  const struct timespec& ctime = st.st_ctim;
+#endif
+  // Hard linking a cached file into a fetch directory only updates its ctime.
+  auto last_used = std::max(ToTimePoint(mtime), ToTimePoint(ctime));
+  // Walking a directory can update its atime, so only files count reads.
+  if (!S_ISDIR(st.st_mode)) {
+    last_used = std::max(last_used, ToTimePoint(atime));
+  }
+  return last_used;
+}
+
+Result<void> ScanEntry(const size_t entry_id, CacheEntry& entry,
+                       InodeMap& inodes) {
+  std::string root = entry.path;
+  char* const roots[] = {root.data(), nullptr};
+  std::unique_ptr<FTS, int (*)(FTS*)> fts(
+      fts_open(roots, FTS_PHYSICAL | FTS_NOCHDIR | FTS_XDEV, nullptr),
+      fts_close);
+  CF_EXPECTF(fts.get() != nullptr, "fts_open(\"{}\") failed: {}", entry.path,
+             StrError(errno));
+
+  errno = 0;
+  FTSENT* node;
+  while ((node = fts_read(fts.get())) != nullptr) {
+    switch (node->fts_info) {
+      case FTS_DP:
+        // Directories are returned again after their contents.
+        continue;
+      case FTS_NS:
+        // Possibly removed by a concurrent prune or fetch.
+        VLOG(0) << "Skipping \"" << node->fts_path
+                << "\": " << StrError(node->fts_errno);
+        continue;
+      case FTS_DNR:
+      case FTS_ERR:
+        return CF_ERRF("Failed to read \"{}\": {}", node->fts_path,
+                       StrError(node->fts_errno));
+      default:
+        break;
+    }
+    const struct stat& st = *node->fts_statp;
+    entry.last_used = std::max(entry.last_used, LastUsed(st));
+
+    Inode& inode = inodes[{st.st_dev, st.st_ino}];
+    if (inode.links_seen == 0) {
+      inode.entry = entry_id;
+      inode.bytes = static_cast<size_t>(st.st_blocks) * 512;
+      // A directory's link count includes its children's ".." entries.
+      inode.links = S_ISDIR(st.st_mode) ? 1 : st.st_nlink;
+    } else if (inode.entry != entry_id) {
+      if (inode.entry != kSharedInode) {
+        inode.sharing_entries.insert(inode.entry);
+        inode.entry = kSharedInode;
+      }
+      inode.sharing_entries.insert(entry_id);
+    }
+    inode.links_seen++;
+  }
+  CF_EXPECTF(errno == 0, "Failed walking \"{}\": {}", entry.path,
+             StrError(errno));
+  return {};
+}
+
+std::string IndexPath(const std::string& cache_directory) {
+  return fmt::format("{}/{}", cache_directory, kIndexFileName);
+}
+
+Result<std::set<std::string>> EntryPaths(const std::string& cache_directory) {
+  std::set<std::string> paths;
+  for (const std::string& name :
+       CF_EXPECT(DirectoryContents(cache_directory))) {
+    // Includes temporary files left behind while writing the index.
+    if (!absl::StartsWith(name, kIndexFileName)) {
+      paths.emplace(fmt::format("{}/{}", cache_directory, name));
+    }
+  }
+  return paths;
+}
+
+void SortByLastUsed(std::vector<CacheEntry>& entries) {
+  std::sort(entries.begin(), entries.end(),
+            [](const CacheEntry& a, const CacheEntry& b) {
+              return a.last_used > b.last_used;
+            });
+}
+
+Json::Value ToJson(const CacheIndex& index) {
+  Json::Value json(Json::objectValue);
+  json["version"] = kIndexVersion;
+  json["total_bytes"] = Json::UInt64(index.total_bytes);
+  Json::Value& entries = json["entries"] = Json::Value(Json::arrayValue);
+  for (const CacheEntry& entry : index.entries) {
+    Json::Value& json_entry = entries.append(Json::Value(Json::objectValue));
+    json_entry["path"] = entry.path;
+    json_entry["size_bytes"] = Json::UInt64(entry.size_bytes);
+    json_entry["reclaimable_bytes"] = Json::UInt64(entry.reclaimable_bytes);
+    json_entry["last_used_ns"] = Json::Int64(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            entry.last_used.time_since_epoch())
+            .count());
+  }
+  Json::Value& shared = json["shared"] = Json::Value(Json::arrayValue);
+  for (const SharedCacheFiles& files : index.shared) {
+    Json::Value& json_files = shared.append(Json::Value(Json::objectValue));
+    Json::Value& paths = json_files["entry_paths"] =
+        Json::Value(Json::arrayValue);
+    for (const std::string& path : files.entry_paths) {
+      paths.append(path);
+    }
+    json_files["size_bytes"] = Json::UInt64(files.size_bytes);
+    json_files["reclaimable_bytes"] = Json::UInt64(files.reclaimable_bytes);
+  }
+  return json;
+}
+
+Result<CacheIndex> FromJson(const Json::Value& json) {
+  CF_EXPECT_EQ(CF_EXPECT(GetValue<int>(json, {"version"})), kIndexVersion);
+  CF_EXPECT(json["total_bytes"].isUInt64());
+  CF_EXPECT(json["entries"].isArray());
+  CacheIndex index{.total_bytes = json["total_bytes"].asUInt64()};
+  for (const Json::Value& json_entry : json["entries"]) {
+    CF_EXPECT(json_entry["size_bytes"].isUInt64());
+    CF_EXPECT(json_entry["reclaimable_bytes"].isUInt64());
+    CF_EXPECT(json_entry["last_used_ns"].isInt64());
+    index.entries.emplace_back(CacheEntry{
+        .path = CF_EXPECT(GetValue<std::string>(json_entry, {"path"})),
+        .size_bytes = json_entry["size_bytes"].asUInt64(),
+        .reclaimable_bytes = json_entry["reclaimable_bytes"].asUInt64(),
+        .last_used = std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                std::chrono::nanoseconds(
+                    json_entry["last_used_ns"].asInt64()))),
+    });
+  }
+  CF_EXPECT(json["shared"].isArray());
+  for (const Json::Value& json_files : json["shared"]) {
+    CF_EXPECT(json_files["entry_paths"].isArray());
+    CF_EXPECT(json_files["size_bytes"].isUInt64());
+    CF_EXPECT(json_files["reclaimable_bytes"].isUInt64());
+    SharedCacheFiles& files = index.shared.emplace_back(SharedCacheFiles{
+        .size_bytes = json_files["size_bytes"].asUInt64(),
+        .reclaimable_bytes = json_files["reclaimable_bytes"].asUInt64(),
+    });
+    for (const Json::Value& path : json_files["entry_paths"]) {
+      CF_EXPECT(path.isString());
+      files.entry_paths.emplace_back(path.asString());
+    }
+  }
+  return index;
+}
+
+Result<CacheIndex> LoadIndex(const std::string& path) {
+  return CF_EXPECT(FromJson(CF_EXPECT(LoadFromFile(path))));
+}
+
+}  // namespace
+
+Result<CacheIndex> ScanCache(const std::string& cache_directory) {
+  CacheIndex index;
+  InodeMap inodes;
+  for (const std::string& path : CF_EXPECT(EntryPaths(cache_directory))) {
+    index.entries.emplace_back(CacheEntry{.path = path});
+    CF_EXPECTF(ScanEntry(index.entries.size() - 1, index.entries.back(),
+                         inodes),
+               "Failed to measure \"{}\"", path);
+  }
+  std::map<std::set<size_t>, SharedCacheFiles> shared;
+  for (const auto& [_, inode] : inodes) {
+    index.total_bytes += inode.bytes;
+    if (inode.entry == kSharedInode) {
+      SharedCacheFiles& files = shared[inode.sharing_entries];
+      files.size_bytes += inode.bytes;
+      if (inode.links_seen >= inode.links) {
+        files.reclaimable_bytes += inode.bytes;
+      }
+      continue;
+    }
+    CacheEntry& entry = index.entries[inode.entry];
+    entry.size_bytes += inode.bytes;
+    if (inode.links_seen >= inode.links) {
+      entry.reclaimable_bytes += inode.bytes;
+    }
+  }
+  for (auto& [entry_ids, files] : shared) {
+    for (const size_t entry_id : entry_ids) {
+      files.entry_paths.emplace_back(index.entries[entry_id].path);
+    }
+    index.shared.emplace_back(std::move(files));
+  }
+  SortByLastUsed(index.entries);
+  return index;
+}
+
+CacheEntry PopLeastRecentlyUsed(CacheIndex& index) {
+  CacheEntry entry = std::move(index.entries.back());
+  index.entries.pop_back();
+  for (auto it = index.shared.begin(); it != index.shared.end();) {
+    std::erase(it->entry_paths, entry.path);
+    if (!it->entry_paths.empty()) {
+      it++;
+      continue;
+    }
+    entry.size_bytes += it->size_bytes;
+    entry.reclaimable_bytes += it->reclaimable_bytes;
+    it = index.shared.erase(it);
+  }
+  index.total_bytes -= entry.size_bytes;
+  return entry;
+}
+
+Result<void> WriteCacheIndex(const std::string& cache_directory,
+                             const CacheIndex& index) {
+  const std::string path = IndexPath(cache_directory);
+  const std::string temp_path = path + ".tmp";
+  CF_EXPECTF(android::base::WriteStringToFile(ToJson(index).toStyledString(),
+                                              temp_path),
+             "Failed to write \"{}\"", temp_path);
+  CF_EXPECT(Rename(temp_path, path));
+  return {};
+}
+
+Result<std::optional<CacheIndex>> ReadCacheIndex(
+    const std::string& cache_directory) {
+  const std::string path = IndexPath(cache_directory);
+  if (!FileExists(path)) {
+    return std::nullopt;
+  }
+  Result<CacheIndex> index = LoadIndex(path);
+  if (!index.ok()) {
+    LOG(WARNING) << "Ignoring malformed cache index \"" << path
+                 << "\": " << index.error();
+    return std::nullopt;
+  }
+  std::set<std::string> indexed_paths;
+  for (const CacheEntry& entry : index->entries) {
+    indexed_paths.emplace(entry.path);
+  }
+  if (indexed_paths != CF_EXPECT(EntryPaths(cache_directory))) {
+    return std::nullopt;
+  }
+  return *index;
+}
+
+}  // namespace cuttlefish
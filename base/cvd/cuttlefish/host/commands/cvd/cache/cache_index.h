@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+
+// Disk usage of one top-level entry of the cache directory, such as the
+// artifacts of one build.
+struct CacheEntry {
+  std::string path;
+  // Allocated bytes of the files only linked from this entry within the cache.
+  size_t size_bytes = 0;
+  // The part of `size_bytes` that deleting the entry frees on disk, excluding
+  // files still hard linked from fetch directories.
+  size_t reclaimable_bytes = 0;
+  // Most recent access, modification or linking of any file in the entry.
+  std::chrono::system_clock::time_point last_used;
+};
+
+// Files hard linked from more than one entry, grouped by those entries.
+struct SharedCacheFiles {
+  std::vector<std::string> entry_paths;
+  size_t size_bytes = 0;
+  size_t reclaimable_bytes = 0;
+};
+
+struct CacheIndex {
+  // Allocated bytes under the cache directory, counting hard links once.
+  size_t total_bytes = 0;
+  // Sorted by `last_used`, most recent first.
+  std::vector<CacheEntry> entries;
+  // Not part of the size of any entry, until the others linking them are
+  // removed.
+  std::vector<SharedCacheFiles> shared;
+};
+
+// Walks the cache directory once, summing the blocks allocated to each entry.
+Result<CacheIndex> ScanCache(const std::string& cache_directory);
+
+// Removes the least recently used entry from `index` and returns it. Shared
+// files it was the last to link count towards its sizes. Subtracts its size
+// from `total_bytes`.
+CacheEntry PopLeastRecentlyUsed(CacheIndex& index);
+
+// Saves `index` in the cache directory, for `ReadCacheIndex`.
+Result<void> WriteCacheIndex(const std::string& cache_directory,
+                             const CacheIndex& index);
+
+// Returns the last saved index, if it still lists the same entries as the
+// cache directory. Sizes may be outdated if entries changed in place.
+Result<std::optional<CacheIndex>> ReadCacheIndex(
+    const std::string& cache_directory);
+
+}  // namespace cuttlefish
@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/commands/cvd/cache/cache_index.h"
+
+#include <unistd.h>
+
+#include <optional>
+#include <string>
+
+#include "android-base/file.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/common/libs/utils/files.h"
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+class CacheIndexTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    cache_dir_ = std::string(temp_dir_.path) + "/cache";
+    fetch_dir_ = std::string(temp_dir_.path) + "/fetch";
+    ASSERT_THAT(EnsureDirectoryExists(cache_dir_ + "/build_a"), IsOk());
+    ASSERT_THAT(EnsureDirectoryExists(cache_dir_ + "/build_b"), IsOk());
+    ASSERT_THAT(EnsureDirectoryExists(fetch_dir_), IsOk());
+    ASSERT_TRUE(android::base::WriteStringToFile(std::string(1 << 16, 'a'),
+                                                 cache_dir_ + "/build_a/img"));
+    ASSERT_TRUE(android::base::WriteStringToFile(std::string(1 << 16, 'b'),
+                                                 cache_dir_ + "/build_b/img"));
+    // Fetching hard links cache files into the fetch directory.
+    ASSERT_EQ(link((cache_dir_ + "/build_b/img").c_str(),
+                   (fetch_dir_ + "/img").c_str()),
+              0);
+  }
+
+  const CacheEntry* Find(const CacheIndex& index, const std::string& name) {
+    for (const CacheEntry& entry : index.entries) {
+      if (entry.path == cache_dir_ + "/" + name) {
+        return &entry;
+      }
+    }
+    return nullptr;
+  }
+
+  TemporaryDir temp_dir_;
+  std::string cache_dir_;
+  std::string fetch_dir_;
+};
+
+TEST_F(CacheIndexTest, ScanMeasuresEntries) {
+  Result<CacheIndex> index = ScanCache(cache_dir_);
+  ASSERT_THAT(index, IsOk());
+
+  ASSERT_EQ(index->entries.size(), 2);
+  const CacheEntry* build_a = Find(*index, "build_a");
+  const CacheEntry* build_b = Find(*index, "build_b");
+  ASSERT_NE(build_a, nullptr);
+  ASSERT_NE(build_b, nullptr);
+  EXPECT_GE(build_a->size_bytes, 1 << 16);
+  EXPECT_EQ(build_a->reclaimable_bytes, build_a->size_bytes);
+  EXPECT_GE(build_b->size_bytes, 1 << 16);
+  // The hard linked file stays on disk after removing the cache entry.
+  EXPECT_LT(build_b->reclaimable_bytes, 1 << 16);
+  EXPECT_EQ(index->total_bytes, build_a->size_bytes + build_b->size_bytes);
+}
+
+TEST_F(CacheIndexTest, ScanCountsHardLinksOnce) {
+  ASSERT_EQ(link((cache_dir_ + "/build_a/img").c_str(),
+                 (cache_dir_ + "/build_a/img_link").c_str()),
+            0);
+
+  Result<CacheIndex> index = ScanCache(cache_dir_);
+  ASSERT_THAT(index, IsOk());
+
+  const CacheEntry* build_a = Find(*index, "build_a");
+  ASSERT_NE(build_a, nullptr);
+  EXPECT_LT(build_a->size_bytes, 2 << 16);
+  EXPECT_EQ(build_a->reclaimable_bytes, build_a->size_bytes);
+}
+
+TEST_F(CacheIndexTest, SharedFilesCountOnceTheLastLinkIsPopped) {
+  ASSERT_EQ(link((cache_dir_ + "/build_a/img").c_str(),
+                 (cache_dir_ + "/build_b/shared").c_str()),
+            0);
+
+  Result<CacheIndex> index = ScanCache(cache_dir_);
+  ASSERT_THAT(index, IsOk());
+
+  ASSERT_EQ(index->shared.size(), 1);
+  EXPECT_GE(index->shared[0].size_bytes, 1 << 16);
+  EXPECT_EQ(index->shared[0].reclaimable_bytes, index->shared[0].size_bytes);
+  EXPECT_EQ(index->total_bytes, index->entries[0].size_bytes +
+                                    index->entries[1].size_bytes +
+                                    index->shared[0].size_bytes);
+
+  const size_t shared_bytes = index->shared[0].size_bytes;
+  const size_t first_bytes = index->entries.back().size_bytes;
+  const CacheEntry first = PopLeastRecentlyUsed(*index);
+  EXPECT_EQ(first.size_bytes, first_bytes);
+  EXPECT_EQ(index->shared.size(), 1);
+
+  const size_t last_bytes = index->entries.back().size_bytes;
+  const CacheEntry last = PopLeastRecentlyUsed(*index);
+  EXPECT_EQ(last.size_bytes, last_bytes + shared_bytes);
+  EXPECT_TRUE(index->shared.empty());
+  EXPECT_EQ(index->total_bytes, 0);
+}
+
+TEST_F(CacheIndexTest, ReadsWrittenIndex) {
+  Result<CacheIndex> index = ScanCache(cache_dir_);
+  ASSERT_THAT(index, IsOk());
+  ASSERT_THAT(WriteCacheIndex(cache_dir_, *index), IsOk());
+
+  Result<std::optional<CacheIndex>> read = ReadCacheIndex(cache_dir_);
+  ASSERT_THAT(read, IsOk());
+  ASSERT_TRUE(read->has_value());
+  EXPECT_EQ((*read)->total_bytes, index->total_bytes);
+  ASSERT_EQ((*read)->entries.size(), index->entries.size());
+  for (size_t i = 0; i < index->entries.size(); i++) {
+    EXPECT_EQ((*read)->entries[i].path, index->entries[i].path);
+    EXPECT_EQ((*read)->entries[i].size_bytes, index->entries[i].size_bytes);
+    EXPECT_EQ((*read)->entries[i].last_used, index->entries[i].last_used);
+  }
+  EXPECT_EQ((*read)->shared.size(), index->shared.size());
+
+  // The index isn't counted as a cache entry.
+  Result<CacheIndex> rescanned = ScanCache(cache_dir_);
+  ASSERT_THAT(rescanned, IsOk());
+  EXPECT_EQ(rescanned->entries.size(), 2);
+}
+
+TEST_F(CacheIndexTest, IgnoresOutdatedIndex) {
+  Result<CacheIndex> index = ScanCache(cache_dir_);
+  ASSERT_THAT(index, IsOk());
+  ASSERT_THAT(WriteCacheIndex(cache_dir_, *index), IsOk());
+
+  ASSERT_THAT(EnsureDirectoryExists(cache_dir_ + "/build_c"), IsOk());
+
+  Result<std::optional<CacheIndex>> read = ReadCacheIndex(cache_dir_);
+  ASSERT_THAT(read, IsOk());
+  EXPECT_FALSE(read->has_value());
+}
+
+}  // namespace
+}  // namespace cuttlefish
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/commands/cvd/cache/cache.h"
+
+#include <unistd.h>
+
+#include <string>
+
+#include "android-base/file.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/common/libs/utils/files.h"
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+TEST(CacheTest, PrunesEntriesSharingFiles) {
+  TemporaryDir temp_dir;
+  const std::string cache_dir = std::string(temp_dir.path) + "/cache";
+  ASSERT_THAT(EnsureDirectoryExists(cache_dir + "/build_a"), IsOk());
+  ASSERT_THAT(EnsureDirectoryExists(cache_dir + "/build_b"), IsOk());
+  ASSERT_TRUE(android::base::WriteStringToFile(std::string(1 << 16, 'a'),
+                                               cache_dir + "/build_a/img"));
+  ASSERT_EQ(link((cache_dir + "/build_a/img").c_str(),
+                 (cache_dir + "/build_b/img").c_str()),
+            0);
+
+  Result<PruneResult> result = PruneCache(cache_dir, 0);
+
+  ASSERT_THAT(result, IsOk());
+  EXPECT_EQ(result->after, 0);
+  EXPECT_FALSE(DirectoryExists(cache_dir + "/build_a"));
+  EXPECT_FALSE(DirectoryExists(cache_dir + "/build_b"));
+  Result<size_t> size = GetCacheSize(cache_dir);
+  ASSERT_THAT(size, IsOk());
+  EXPECT_EQ(*size, 0);
+}
+
+}  // namespace
+}  // namespace cuttlefish
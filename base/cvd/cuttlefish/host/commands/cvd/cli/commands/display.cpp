@@ -61,6 +61,7 @@ Commands:
     remove              Removes a display from a given device.
     screenshot --display=<id> --screenshot_path=<path>
                         Captures a screenshot of the given display.
+    stats               Prints the frame latencies of the displays.
 )";
 
 Result<Command> BuildCommand(InstanceManager& instance_manager,
@@ -69,6 +69,10 @@ std::vector<Flag> BuildApiFlags::Flags() {
           .Help("Max allowed size(in gigabytes) of the local fetch file cache. "
                 " If the cache grows beyond this size it will be pruned after "
                 "the fetches complete."));
+  flags.emplace_back(
+      GflagsCompatFlag("http2_multiplexing", this->http2_multiplexing)
+          .Help("Whether to multiplex concurrent downloads over shared HTTP/2 "
+                "connections"));
 
   for (Flag flag : this->credential_flags.Flags()) {
     flags.emplace_back(std::move(flag));
@@ -33,6 +33,8 @@ namespace cuttlefish {
  *
  * crosvm has read-only support for Android-Sparse files, but QEMU does not
  * support them.
+ *
+ * The images are converted concurrently.
  */
 Result<void> DeAndroidSparse2(const std::vector<std::string>& image_files);
 
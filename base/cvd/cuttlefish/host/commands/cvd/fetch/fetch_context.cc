@@ -15,15 +15,20 @@
 
 #include "cuttlefish/host/commands/cvd/fetch/fetch_context.h"
 
+#include <stddef.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <iterator>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
 #include <variant>
 #include <vector>
 
+#include "absl/log/log.h"
 #include "absl/strings/match.h"
 #include "absl/strings/strip.h"
 #include "android-base/file.h"
@@ -40,7 +45,10 @@
 #include "cuttlefish/host/libs/web/android_build_api.h"
 #include "cuttlefish/host/libs/web/build_api.h"
 #include "cuttlefish/host/libs/web/build_api_zip.h"
+#include "cuttlefish/host/libs/web/http_client/http_client.h"
 #include "cuttlefish/host/libs/zip/libzip_cc/archive.h"
+#include "cuttlefish/host/libs/zip/parallel_extract.h"
+#include "cuttlefish/host/libs/zip/streaming_extract.h"
 #include "cuttlefish/host/libs/zip/zip_file.h"
 #include "cuttlefish/result/result.h"
 
@@ -60,14 +68,20 @@ Result<void> FetchArtifact::Download() {
 }
 
 Result<void> FetchArtifact::DownloadTo(std::string local_path) {
+  CF_EXPECT(DownloadTo(std::move(local_path), nullptr));
+  return {};
+}
+
+Result<void> FetchArtifact::DownloadTo(
+    std::string local_path, const HttpClient::DataCallback& observer) {
   std::string new_path =
       fmt::format("{}/{}", fetch_build_context_.target_directory_, local_path);
 
   if (downloaded_path_.empty()) {
-    std::string downloaded =
-        CF_EXPECT(fetch_build_context_.fetch_context_.build_api_.DownloadFile(
+    std::string downloaded = CF_EXPECT(
+        fetch_build_context_.fetch_context_.build_api_.DownloadFileWithObserver(
             fetch_build_context_.build_, fetch_build_context_.target_directory_,
-            artifact_name_));
+            artifact_name_, observer));
     size_t size = FileSize(downloaded);
     std::string download_phase = fmt::format("Downloaded '{}'", artifact_name_);
     fetch_build_context_.trace_.CompletePhase(download_phase, size);
@@ -103,22 +117,135 @@ Result<void> FetchArtifact::ExtractAll() {
   return {};
 }
 
+Result<std::string> FetchArtifact::ExtractPath(
+    const std::string& local_path, const std::string& member_name) {
+  CF_EXPECT(!absl::StartsWith(member_name, "."));
+  CF_EXPECT(!absl::StartsWith(member_name, "/"));
+  CF_EXPECT(!absl::StrContains(member_name, "/../"));
+  return fmt::format("{}/{}/{}", fetch_build_context_.target_directory_,
+                     local_path, member_name);
+}
+
 Result<void> FetchArtifact::ExtractAll(const std::string& local_path) {
   ReadableZip* zip = CF_EXPECT(AsZip());
   size_t entries = CF_EXPECT(zip->NumEntries());
+  std::vector<ZipExtraction> extractions;
+  std::vector<ZipExtractionResult> extracted;
   for (uint64_t i = 0; i < entries; i++) {
     std::string member_name = CF_EXPECT(zip->EntryName(i));
-    CF_EXPECT(!absl::StartsWith(member_name, "."));
-    CF_EXPECT(!absl::StartsWith(member_name, "/"));
-    CF_EXPECT(!absl::StrContains(member_name, "/../"));
-    if (!CF_EXPECT(zip->EntryIsDirectory(i))) {
-      std::string extract_path = fmt::format("{}/{}", local_path, member_name);
-      CF_EXPECT(ExtractOneTo(member_name, extract_path));
+    std::string extract_path = CF_EXPECT(ExtractPath(local_path, member_name));
+    if (CF_EXPECT(zip->EntryIsDirectory(i))) {
+      continue;
     }
+    auto streamed = streamed_members_.find(member_name);
+    if (streamed != streamed_members_.end() &&
+        streamed->second.host_path == extract_path) {
+      // The contents were written during the download, but the attributes are
+      // only available from the central directory.
+      CF_EXPECT(ApplyFileAttributes(*zip, member_name, extract_path));
+      extracted.emplace_back(ZipExtractionResult{
+          .zip_path = std::move(member_name),
+          .host_path = std::move(extract_path),
+          .size = streamed->second.size,
+          .duration = streamed->second.duration,
+      });
+      continue;
+    }
+    if (std::string dir = android::base::Dirname(extract_path); !dir.empty()) {
+      CF_EXPECT(EnsureDirectoryExists(dir, kRwxAllMode));
+    }
+    extractions.emplace_back(ZipExtraction{
+        .zip_path = std::move(member_name),
+        .host_path = std::move(extract_path),
+    });
+  }
+
+  // Every additional worker needs its own archive instance. Those are only
+  // cheap for a downloaded file: each instance of a remote artifact would be
+  // another reader with its own requests and buffer, so a remote artifact is
+  // extracted through `zip` alone.
+  ZipOpener open_more;
+  if (!downloaded_path_.empty()) {
+    open_more = [this]() -> Result<ReadableZip> {
+      return CF_EXPECT(ZipOpenRead(downloaded_path_));
+    };
+  }
+  size_t threads = fetch_build_context_.fetch_context_.extract_threads_;
+  std::vector<ZipExtractionResult> remaining =
+      CF_EXPECT(ExtractFilesParallel(*zip, open_more, extractions, threads),
+                "Failed to extract '" << artifact_name_ << "'");
+  VLOG(1) << "Extracted " << remaining.size() << " members of '"
+          << artifact_name_ << "' after " << extracted.size()
+          << " were streamed during the download";
+  extracted.insert(extracted.end(), std::make_move_iterator(remaining.begin()),
+                   std::make_move_iterator(remaining.end()));
+  streamed_members_.clear();
+
+  size_t total_size = 0;
+  for (const ZipExtractionResult& member : extracted) {
+    std::string member_local_path =
+        fmt::format("{}/{}", local_path, member.zip_path);
+    CF_EXPECT(fetch_build_context_.AddFileToConfig(
+        member.host_path, artifact_name_, member_local_path));
+
+    std::string phase = fmt::format("Extracted '{}'", member.zip_path);
+    fetch_build_context_.trace_.AddConcurrentPhase(std::move(phase),
+                                                   member.duration,
+                                                   member.size);
+    total_size += member.size;
+  }
+  std::string phase = fmt::format("Extracted {} members from '{}'",
+                                  extracted.size(), artifact_name_);
+  fetch_build_context_.trace_.CompletePhase(std::move(phase), total_size);
+
+  for (const ZipExtractionResult& member : extracted) {
+    // TODO: b/471069557 - diagnose unused
+    Result<void> unused = fetch_build_context_.DesparseFiles(
+        {fmt::format("{}/{}", local_path, member.zip_path)});
   }
   return {};
 }
 
+Result<void> FetchArtifact::DownloadAndExtractAll() {
+  if (!fetch_build_context_.fetch_context_.stream_extract_ ||
+      !downloaded_path_.empty()) {
+    CF_EXPECT(Download());
+    CF_EXPECT(ExtractAll());
+    return {};
+  }
+
+  // Runs on the extractor thread, so only touches the filesystem.
+  StreamingZipExtractor extractor(
+      [this](std::string_view zip_path) -> std::optional<std::string> {
+        if (zip_path.empty() || absl::EndsWith(zip_path, "/")) {
+          return std::nullopt;
+        }
+        Result<std::string> path = ExtractPath("", std::string(zip_path));
+        if (!path.ok()) {
+          return std::nullopt;
+        }
+        if (std::string dir = android::base::Dirname(*path); !dir.empty()) {
+          if (!EnsureDirectoryExists(dir, kRwxAllMode).ok()) {
+            return std::nullopt;
+          }
+        }
+        return *path;
+      });
+  HttpClient::DataCallback observer = [&extractor](char* data, size_t size) {
+    return extractor.Append(data, size);
+  };
+  Result<void> downloaded = DownloadTo(artifact_name_, observer);
+  std::vector<StreamedZipMember> streamed = extractor.Finish();
+  CF_EXPECT(std::move(downloaded));
+
+  for (StreamedZipMember& member : streamed) {
+    std::string zip_path = member.zip_path;
+    streamed_members_.emplace(std::move(zip_path), std::move(member));
+  }
+  CF_EXPECT(ExtractAll());
+  return {};
+}
+
 Result<void> FetchArtifact::ExtractOne(const std::string& member_name) {
   CF_EXPECT(ExtractOneTo(member_name, member_name));
   return {};
@@ -156,13 +283,13 @@ Result<void> FetchArtifact::DeleteLocalFile() {
     return {};
   }
   CF_EXPECT(RemoveFile(downloaded_path_));
-  std::string_view base_dir =
-      fetch_build_context_.fetch_context_.target_directories_.root;
+  FetchContext& fetch_context = fetch_build_context_.fetch_context_;
+  std::string_view base_dir = fetch_context.target_directories_.root;
   std::string_view config_name = absl::StripPrefix(downloaded_path_, base_dir);
   config_name = absl::StripPrefix(config_name, "/");
-  CF_EXPECT(
-      fetch_build_context_.fetch_context_.fetcher_config_.RemoveFileFromConfig(
-          std::string(config_name)));
+  std::lock_guard lock(fetch_context.fetcher_config_mutex_);
+  CF_EXPECT(fetch_context.fetcher_config_.RemoveFileFromConfig(
+      std::string(config_name)));
   downloaded_path_ = "";
   return {};
 }
@@ -222,6 +349,7 @@ Result<void> FetchBuildContext::AddFileToConfig(std::string file,
       std::move(file), fetch_context_.target_directories_.root,
       std::move(archive_name), std::move(archive_path)));
 
+  std::lock_guard lock(fetch_context_.fetcher_config_mutex_);
   CF_EXPECT(fetch_context_.fetcher_config_.add_cvd_file(
       std::move(config_member), /* override_entry = */ true));
 
@@ -235,18 +363,27 @@ std::ostream& operator<<(std::ostream& out, const FetchBuildContext& context) {
 FetchContext::FetchContext(BuildApi& build_api,
                            const TargetDirectories& target_directories,
                            const Builds& builds, FetcherConfig& fetcher_config,
-                           FetchTracer& tracer)
+                           FetchTracer& tracer, size_t extract_threads,
+                           bool stream_extract)
     : build_api_(build_api),
       target_directories_(target_directories),
       builds_(builds),
       fetcher_config_(fetcher_config),
-      tracer_(tracer) {}
+      tracer_(tracer),
+      extract_threads_(extract_threads),
+      stream_extract_(stream_extract) {}
+
+FetchTracer::Trace FetchContext::NewTrace(std::string_view build_name) {
+  // Builds of different targets are fetched concurrently.
+  return tracer_.NewTrace(
+      fmt::format("{} ({})", build_name, target_directories_.root));
+}
 
 std::optional<FetchBuildContext> FetchContext::DefaultBuild() {
   if (builds_.default_build) {
     return FetchBuildContext(
         *this, *builds_.default_build, target_directories_.root,
-        FileSource::DEFAULT_BUILD, tracer_.NewTrace("Default"));
+        FileSource::DEFAULT_BUILD, NewTrace("Default"));
   } else {
     return {};
   }
@@ -256,7 +393,7 @@ std::optional<FetchBuildContext> FetchContext::SystemBuild() {
   if (builds_.system) {
     return FetchBuildContext(*this, *builds_.system, target_directories_.root,
                              FileSource::SYSTEM_BUILD,
-                             tracer_.NewTrace("System"));
+                             NewTrace("System"));
   } else {
     return {};
   }
@@ -266,7 +403,7 @@ std::optional<FetchBuildContext> FetchContext::KernelBuild() {
   if (builds_.kernel) {
     return FetchBuildContext(*this, *builds_.kernel, target_directories_.root,
                              FileSource::KERNEL_BUILD,
-                             tracer_.NewTrace("Kernel"));
+                             NewTrace("Kernel"));
   } else {
     return {};
   }
@@ -275,7 +412,7 @@ std::optional<FetchBuildContext> FetchContext::KernelBuild() {
 std::optional<FetchBuildContext> FetchContext::BootBuild() {
   if (builds_.boot) {
     return FetchBuildContext(*this, *builds_.boot, target_directories_.root,
-                             FileSource::BOOT_BUILD, tracer_.NewTrace("Boot"));
+                             FileSource::BOOT_BUILD, NewTrace("Boot"));
   } else {
     return {};
   }
@@ -285,7 +422,7 @@ std::optional<FetchBuildContext> FetchContext::BootloaderBuild() {
   if (builds_.bootloader) {
     return FetchBuildContext(
         *this, *builds_.bootloader, target_directories_.root,
-        FileSource::BOOTLOADER_BUILD, tracer_.NewTrace("Bootloader"));
+        FileSource::BOOTLOADER_BUILD, NewTrace("Bootloader"));
   } else {
     return {};
   }
@@ -296,7 +433,7 @@ std::optional<FetchBuildContext> FetchContext::AndroidEfiLoaderBuild() {
     return FetchBuildContext(*this, *builds_.android_efi_loader,
                              target_directories_.root,
                              FileSource::ANDROID_EFI_LOADER_BUILD,
-                             tracer_.NewTrace("Android EFI Loader"));
+                             NewTrace("Android EFI Loader"));
   } else {
     return {};
   }
@@ -306,7 +443,7 @@ std::optional<FetchBuildContext> FetchContext::OtaToolsBuild() {
   if (builds_.otatools) {
     return FetchBuildContext(
         *this, *builds_.otatools, target_directories_.otatools,
-        FileSource::DEFAULT_BUILD, tracer_.NewTrace("OTA Tools"));
+        FileSource::DEFAULT_BUILD, NewTrace("OTA Tools"));
   } else {
     return {};
   }
@@ -316,7 +453,7 @@ std::optional<FetchBuildContext> FetchContext::TestSuitesBuild() {
   if (builds_.test_suites) {
     return FetchBuildContext(
         *this, *builds_.test_suites, target_directories_.test_suites,
-        FileSource::TEST_SUITES_BUILD, tracer_.NewTrace("Test Suites"));
+        FileSource::TEST_SUITES_BUILD, NewTrace("Test Suites"));
   } else {
     return {};
   }
@@ -15,6 +15,10 @@
 
 #pragma once
 
+#include <stddef.h>
+
+#include <map>
+#include <mutex>
 #include <optional>
 #include <ostream>
 #include <string>
@@ -28,7 +32,9 @@
 #include "cuttlefish/host/libs/config/file_source.h"
 #include "cuttlefish/host/libs/web/android_build.h"
 #include "cuttlefish/host/libs/web/build_api.h"
+#include "cuttlefish/host/libs/web/http_client/http_client.h"
 #include "cuttlefish/host/libs/zip/libzip_cc/archive.h"
+#include "cuttlefish/host/libs/zip/streaming_extract.h"
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
@@ -43,6 +49,10 @@ class FetchArtifact {
   Result<void> ExtractAll();
   Result<void> ExtractAll(const std::string& local_path);
 
+  /* Equivalent to `Download()` followed by `ExtractAll()`, but extracts members
+   * while the archive is still downloading when that is enabled. */
+  Result<void> DownloadAndExtractAll();
+
   Result<void> ExtractOne(const std::string& member_name);
   Result<void> ExtractOneTo(const std::string& member_name,
                             const std::string& local_path);
@@ -54,10 +64,17 @@ class FetchArtifact {
 
   FetchArtifact(class FetchBuildContext&, std::string artifact_name);
 
+  Result<void> DownloadTo(std::string local_path,
+                          const HttpClient::DataCallback& observer);
+  Result<std::string> ExtractPath(const std::string& local_path,
+                                  const std::string& member_name);
+
   FetchBuildContext& fetch_build_context_;
   std::string artifact_name_;
   std::string downloaded_path_;
   std::optional<ReadableZip> zip_;
+  // Members written while downloading, keyed by zip path.
+  std::map<std::string, StreamedZipMember> streamed_members_;
 };
 
 /**
@@ -110,11 +127,15 @@ std::ostream& operator<<(std::ostream&, const FetchBuildContext&);
 /**
  * References common state used by most download operations and produces
  * `FetchBuildContext` instances.
+ *
+ * `FetchBuildContext` instances for different builds of the same target may be
+ * used from different threads at once.
  */
 class FetchContext {
  public:
   FetchContext(BuildApi&, const TargetDirectories&, const Builds&,
-               FetcherConfig&, FetchTracer&);
+               FetcherConfig&, FetchTracer&, size_t extract_threads = 0,
+               bool stream_extract = true);
 
   std::optional<FetchBuildContext> DefaultBuild();
   std::optional<FetchBuildContext> SystemBuild();
@@ -129,11 +150,17 @@ class FetchContext {
   friend class FetchArtifact;
   friend class FetchBuildContext;
 
+  FetchTracer::Trace NewTrace(std::string_view build_name);
+
   BuildApi& build_api_;
   const TargetDirectories& target_directories_;
   const Builds& builds_;
   FetcherConfig& fetcher_config_;
+  std::mutex fetcher_config_mutex_;
   FetchTracer& tracer_;
+  // Zero means one thread per CPU.
+  size_t extract_threads_;
+  bool stream_extract_;
 };
 
 }  // namespace cuttlefish
@@ -18,11 +18,12 @@
 #include <stddef.h>
 #include <sys/stat.h>
 
+#include <atomic>
 #include <functional>
-#include <future>
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -40,6 +41,7 @@
 #include "cuttlefish/host/commands/cvd/fetch/downloaders.h"
 #include "cuttlefish/host/commands/cvd/fetch/fetch_context.h"
 #include "cuttlefish/host/commands/cvd/fetch/fetch_cvd_parser.h"
+#include "cuttlefish/host/commands/cvd/fetch/fetch_scheduler.h"
 #include "cuttlefish/host/commands/cvd/fetch/fetch_tracer.h"
 #include "cuttlefish/host/commands/cvd/fetch/host_package.h"
 #include "cuttlefish/host/commands/cvd/fetch/host_tools_target.h"
@@ -220,8 +222,7 @@ Result<void> FetchDefaultTarget(FetchBuildContext& context,
                   << img_zip_artifact_name;
     }
     FetchArtifact img_zip = context.Artifact(img_zip_artifact_name);
-    CF_EXPECT(img_zip.Download());
-    CF_EXPECT(img_zip.ExtractAll());
+    CF_EXPECT(img_zip.DownloadAndExtractAll());
     if (!keep_downloaded_archives) {
       CF_EXPECT(img_zip.DeleteLocalFile());
     }
@@ -353,8 +354,7 @@ Result<void> FetchAndroidEfiLoaderTarget(FetchBuildContext& context) {
 Result<void> FetchOtaToolsTarget(FetchBuildContext& context,
                                  bool keep_downloaded_archives) {
   FetchArtifact otatools = context.Artifact("otatools.zip");
-  CF_EXPECT(otatools.Download());
-  CF_EXPECT(otatools.ExtractAll());
+  CF_EXPECT(otatools.DownloadAndExtractAll());
   if (!keep_downloaded_archives) {
     CF_EXPECT(otatools.DeleteLocalFile());
   }
@@ -366,8 +366,7 @@ Result<void> FetchTestSuitesTarget(FetchBuildContext& context,
   FetchArtifact android_cts = context.Artifact("android-cts.zip");
   // TODO(b/468074996): determine what tradefed actually needs and potentially
   // expose a flag to allow downloading specific parts of the entire zip.
-  CF_EXPECT(android_cts.Download());
-  CF_EXPECT(android_cts.ExtractAll());
+  CF_EXPECT(android_cts.DownloadAndExtractAll());
   if (!keep_downloaded_archives) {
     CF_EXPECT(android_cts.DeleteLocalFile());
   }
@@ -402,48 +401,122 @@ Result<void> FetchChromeOsTarget(
   return {};
 }
 
-Result<void> FetchTarget(FetchContext& fetch_context,
-                         const DownloadFlags& flags,
-                         const bool keep_downloaded_archives) {
-  if (std::optional<FetchBuildContext> context = fetch_context.DefaultBuild()) {
-    bool has_system_build = fetch_context.SystemBuild().has_value();
-    CF_EXPECT(FetchDefaultTarget(*context, keep_downloaded_archives, flags,
-                                 has_system_build));
+using BuildAccessor = std::optional<FetchBuildContext> (FetchContext::*)();
+using BuildFetch = std::function<Result<void>(FetchBuildContext&)>;
+
+/* Adds a job per build of `target` and returns their ids. */
+std::vector<FetchScheduler::JobId> ScheduleTargetFetch(
+    FetchScheduler& scheduler, FetchContext& fetch_context,
+    const Target& target, const bool keep_downloaded_archives) {
+  const Builds& builds = target.builds;
+  const DownloadFlags& flags = target.download_flags;
+  std::vector<FetchScheduler::JobId> jobs;
+  auto schedule = [&](std::string_view name, BuildAccessor accessor,
+                      BuildFetch fetch,
+                      std::vector<FetchScheduler::JobId> dependencies = {}) {
+    std::string job_name =
+        fmt::format("{} fetch to '{}'", name, target.directories.root);
+    auto job = [&fetch_context, accessor,
+                fetch = std::move(fetch)]() -> Result<void> {
+      std::optional<FetchBuildContext> context = (fetch_context.*accessor)();
+      CF_EXPECT(context.has_value());
+      CF_EXPECT(fetch(*context));
+      return {};
+    };
+    jobs.push_back(scheduler.Add(std::move(job_name), std::move(job),
+                                 std::move(dependencies)));
+    return jobs.back();
+  };
+
+  // The builds fetched into the target root share its files, such as the img
+  // zip they download and delete, and each replaces config entries of the
+  // ones before it. They run one after another in this order, so the last
+  // build to provide a file is always the same.
+  std::vector<FetchScheduler::JobId> previous;
+  auto schedule_in_root = [&](std::string_view name, BuildAccessor accessor,
+                              BuildFetch fetch) {
+    previous = {schedule(name, accessor, std::move(fetch), previous)};
+  };
+
+  if (builds.default_build) {
+    bool has_system_build = builds.system.has_value();
+    schedule_in_root(
+        "Default", &FetchContext::DefaultBuild,
+        [keep_downloaded_archives, &flags,
+         has_system_build](FetchBuildContext& context) -> Result<void> {
+          CF_EXPECT(FetchDefaultTarget(context, keep_downloaded_archives,
+                                       flags, has_system_build));
+          return {};
+        });
   }
 
-  if (std::optional<FetchBuildContext> context = fetch_context.SystemBuild()) {
-    CF_EXPECT(FetchSystemTarget(*context, flags.download_img_zip,
-                                keep_downloaded_archives));
+  if (builds.system) {
+    schedule_in_root(
+        "System", &FetchContext::SystemBuild,
+        [keep_downloaded_archives,
+         &flags](FetchBuildContext& context) -> Result<void> {
+          CF_EXPECT(FetchSystemTarget(context, flags.download_img_zip,
+                                      keep_downloaded_archives));
+          return {};
+        });
   }
 
-  if (std::optional<FetchBuildContext> context = fetch_context.KernelBuild()) {
-    CF_EXPECT(FetchKernelTarget(*context));
+  if (builds.kernel) {
+    schedule_in_root("Kernel", &FetchContext::KernelBuild, FetchKernelTarget);
   }
 
-  if (std::optional<FetchBuildContext> context = fetch_context.BootBuild()) {
-    CF_EXPECT(FetchBootTarget(*context, keep_downloaded_archives));
+  if (builds.boot) {
+    schedule_in_root(
+        "Boot", &FetchContext::BootBuild,
+        [keep_downloaded_archives](FetchBuildContext& context) -> Result<void> {
+          CF_EXPECT(FetchBootTarget(context, keep_downloaded_archives));
+          return {};
+        });
   }
 
-  if (std::optional<FetchBuildContext> ctx = fetch_context.BootloaderBuild()) {
-    CF_EXPECT(FetchBootloaderTarget(*ctx));
+  if (builds.bootloader) {
+    schedule_in_root("Bootloader", &FetchContext::BootloaderBuild,
+                     FetchBootloaderTarget);
   }
 
-  if (std::optional<FetchBuildContext> ctx =
-          fetch_context.AndroidEfiLoaderBuild()) {
-    CF_EXPECT(FetchAndroidEfiLoaderTarget(*ctx));
+  if (builds.android_efi_loader) {
+    schedule_in_root("Android EFI loader",
+                     &FetchContext::AndroidEfiLoaderBuild,
+                     FetchAndroidEfiLoaderTarget);
   }
 
-  if (std::optional<FetchBuildContext> ctx = fetch_context.OtaToolsBuild()) {
-    CF_EXPECT(FetchOtaToolsTarget(*ctx, keep_downloaded_archives));
+  // These have their own directories and config entries, so they run
+  // alongside the builds above.
+  if (builds.otatools) {
+    schedule(
+        "OTA tools", &FetchContext::OtaToolsBuild,
+        [keep_downloaded_archives](FetchBuildContext& context) -> Result<void> {
+          CF_EXPECT(FetchOtaToolsTarget(context, keep_downloaded_archives));
+          return {};
+        });
   }
 
-  if (std::optional<FetchBuildContext> ctx = fetch_context.TestSuitesBuild()) {
-    CF_EXPECT(FetchTestSuitesTarget(*ctx, keep_downloaded_archives));
+  if (builds.test_suites) {
+    schedule(
+        "Test suites", &FetchContext::TestSuitesBuild,
+        [keep_downloaded_archives](FetchBuildContext& context) -> Result<void> {
+          CF_EXPECT(FetchTestSuitesTarget(context, keep_downloaded_archives));
+          return {};
+        });
   }
 
-  return {};
+  return jobs;
 }
 
+/* State of a target fetch, kept alive until every scheduled job finished. */
+struct TargetFetch {
+  FetcherConfig config;
+  // Written by the ChromeOS job concurrently with the other jobs, then merged
+  // into `config`.
+  FetcherConfig chrome_os_config;
+  std::unique_ptr<FetchContext> context;
+};
+
 Result<FetchResult> Fetch(const FetchFlags& flags,
                           const std::string& cache_base_path,
                           const HostToolsTarget& host_target,
@@ -469,40 +542,65 @@ Result<FetchResult> Fetch(const FetchFlags& flags,
       downloaders.AndroidBuild(), host_target, fallback_host_build));
   prefetch_trace.CompletePhase("GetBuilds");
 
-  auto host_package_future = std::async(
-      std::launch::async, FetchHostPackage,
-      std::ref(downloaders.AndroidBuild()), std::cref(host_target_build),
-      std::cref(host_target.host_tools_directory),
-      std::cref(flags.keep_downloaded_archives),
-      std::cref(flags.host_substitutions), tracer.NewTrace("Host Package"));
-  size_t count = 1;
+  FetchScheduler scheduler(flags.max_parallel_fetches);
+  scheduler.Add("Host package fetch", [&]() -> Result<void> {
+    CF_EXPECT(FetchHostPackage(
+        downloaders.AndroidBuild(), host_target_build,
+        host_target.host_tools_directory, flags.keep_downloaded_archives,
+        flags.host_substitutions, tracer.NewTrace("Host Package")));
+    return {};
+  });
+
   FetchResult fetch_result;
-  for (const auto& target : targets) {
-    FetcherConfig config;
-    FetchContext fetch_context(downloaders.AndroidBuild(), target.directories,
-                               target.builds, config, tracer);
-    LOG(INFO) << "Starting fetch to \"" << target.directories.root << "\"";
-    CF_EXPECT(FetchTarget(fetch_context, target.download_flags,
-                          flags.keep_downloaded_archives));
+  fetch_result.fetch_artifacts.resize(targets.size());
+  std::vector<TargetFetch> target_fetches(targets.size());
+  std::atomic<size_t> completed_targets = 0;
+  for (size_t i = 0; i < targets.size(); i++) {
+    const Target& target = targets[i];
+    TargetFetch& target_fetch = target_fetches[i];
+    target_fetch.context = std::make_unique<FetchContext>(
+        downloaders.AndroidBuild(), target.directories, target.builds,
+        target_fetch.config, tracer, flags.extract_threads,
+        flags.stream_extract);
+    LOG(INFO) << "Scheduling fetch to \"" << target.directories.root << "\"";
+    std::vector<FetchScheduler::JobId> jobs =
+        ScheduleTargetFetch(scheduler, *target_fetch.context, target,
+                            flags.keep_downloaded_archives);
 
     if (target.builds.chrome_os) {
-      CF_EXPECT(FetchChromeOsTarget(
-          downloaders.Luci(), *target.builds.chrome_os, target.directories,
-          flags.keep_downloaded_archives, config, tracer.NewTrace("ChromeOS")));
+      std::string job_name =
+          fmt::format("ChromeOS fetch to '{}'", target.directories.root);
+      jobs.push_back(scheduler.Add(std::move(job_name), [&]() -> Result<void> {
+        CF_EXPECT(FetchChromeOsTarget(
+            downloaders.Luci(), *target.builds.chrome_os, target.directories,
+            flags.keep_downloaded_archives, target_fetch.chrome_os_config,
+            tracer.NewTrace(fmt::format("ChromeOS ({})",
+                                        target.directories.root))));
+        return {};
+      }));
     }
 
-    const std::string config_path =
-        CF_EXPECT(SaveConfig(config, target.directories.root));
-    fetch_result.fetch_artifacts.emplace_back(FetchArtifacts{
-        .fetcher_config_path = config_path,
-        .builds = target.builds,
-    });
-    LOG(INFO) << "Completed target fetch to '" << target.directories.root
-              << "' (" << count << " out of " << targets.size() << ")";
-    count++;
+    std::string job_name =
+        fmt::format("Saving config of '{}'", target.directories.root);
+    auto save_config = [&, i]() -> Result<void> {
+      for (const auto& [path, file] :
+           target_fetch.chrome_os_config.get_cvd_files()) {
+        CF_EXPECT(target_fetch.config.add_cvd_file(file));
+      }
+      const std::string config_path =
+          CF_EXPECT(SaveConfig(target_fetch.config, target.directories.root));
+      fetch_result.fetch_artifacts[i] = FetchArtifacts{
+          .fetcher_config_path = config_path,
+          .builds = target.builds,
+      };
+      LOG(INFO) << "Completed target fetch to '" << target.directories.root
+                << "' (" << ++completed_targets << " out of " << targets.size()
+                << ")";
+      return {};
+    };
+    scheduler.Add(std::move(job_name), std::move(save_config), jobs);
   }
-  VLOG(0) << "Waiting for host package fetch";
-  CF_EXPECT(host_package_future.get());
+  CF_EXPECT(scheduler.Run());
   VLOG(0) << "Performance stats:\n" << tracer.ToStyledString();
   fetch_result.fetch_size_bytes = tracer.TotalSizeBytes();
 
@@ -56,6 +56,17 @@ std::vector<Flag> GetFlagsVector(FetchFlags& fetch_flags,
   flags.emplace_back(GflagsCompatFlag("keep_downloaded_archives",
                                       fetch_flags.keep_downloaded_archives)
                          .Help("Keep downloaded zip/tar."));
+  flags.emplace_back(
+      GflagsCompatFlag("extract_threads", fetch_flags.extract_threads)
+          .Help("Number of threads extracting zip members concurrently. 0 "
+                "uses one thread per CPU."));
+  flags.emplace_back(
+      GflagsCompatFlag("stream_extract", fetch_flags.stream_extract)
+          .Help("Extract zip members while the archive is still downloading."));
+  flags.emplace_back(
+      GflagsCompatFlag("max_parallel_fetches", fetch_flags.max_parallel_fetches)
+          .Help("Maximum number of builds fetched concurrently, across the "
+                "host package and all targets."));
   flags.emplace_back(
       GflagsCompatFlag("host_package_build", fetch_flags.host_package_build)
           .Help("source for the host cvd tools"));
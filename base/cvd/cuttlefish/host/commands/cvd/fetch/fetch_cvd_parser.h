@@ -15,6 +15,8 @@
 
 #pragma once
 
+#include <stddef.h>
+
 #include <optional>
 #include <string>
 #include <vector>
@@ -28,6 +30,9 @@ namespace cuttlefish {
 inline constexpr char kDefaultBuildString[] = "";
 inline constexpr char kDefaultTargetDirectory[] = "";
 inline constexpr bool kDefaultKeepDownloadedArchives = false;
+inline constexpr size_t kDefaultExtractThreads = 0;
+inline constexpr bool kDefaultStreamExtract = true;
+inline constexpr size_t kDefaultMaxParallelFetches = 4;
 
 inline constexpr char kDefaultBuildTarget[] =
     "aosp_cf_x86_64_only_phone-userdebug";
@@ -36,6 +41,9 @@ struct FetchFlags {
   std::string target_directory = kDefaultTargetDirectory;
   std::optional<BuildString> host_package_build;
   bool keep_downloaded_archives = kDefaultKeepDownloadedArchives;
+  size_t extract_threads = kDefaultExtractThreads;
+  bool stream_extract = kDefaultStreamExtract;
+  size_t max_parallel_fetches = kDefaultMaxParallelFetches;
   bool helpxml = false;
   BuildApiFlags build_api_flags;
   VectorFlags vector_flags;
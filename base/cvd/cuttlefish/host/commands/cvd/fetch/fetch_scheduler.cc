@@ -0,0 +1,136 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/host/commands/cvd/fetch/fetch_scheduler.h"
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/log/log.h"
+
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+
+FetchScheduler::FetchScheduler(size_t max_concurrent_jobs)
+    : max_concurrent_jobs_(std::max<size_t>(max_concurrent_jobs, 1)) {}
+
+FetchScheduler::JobId FetchScheduler::Add(std::string name, Job job,
+                                          std::vector<JobId> dependencies) {
+  JobId id = entries_.size();
+  entries_.emplace_back(Entry{
+      .name = std::move(name),
+      .job = std::move(job),
+      .unfinished_dependencies = dependencies.size(),
+  });
+  for (JobId dependency : dependencies) {
+    entries_[dependency].dependents.push_back(id);
+  }
+  return id;
+}
+
+Result<void> FetchScheduler::Run() {
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::deque<JobId> ready;
+  std::vector<bool> skipped(entries_.size(), false);
+  size_t remaining = entries_.size();
+  std::optional<Result<void>> first_error;
+  std::string failed_job;
+
+  for (JobId id = 0; id < entries_.size(); id++) {
+    if (entries_[id].unfinished_dependencies == 0) {
+      ready.push_back(id);
+    }
+  }
+
+  // Requires `mutex`.
+  std::function<void(JobId)> skip = [&](JobId id) {
+    if (skipped[id]) {
+      return;
+    }
+    LOG(INFO) << "Skipping '" << entries_[id].name << "' after a failure";
+    skipped[id] = true;
+    remaining--;
+    for (JobId dependent : entries_[id].dependents) {
+      skip(dependent);
+    }
+  };
+
+  auto worker = [&]() {
+    std::unique_lock lock(mutex);
+    while (true) {
+      changed.wait(lock, [&]() { return !ready.empty() || remaining == 0; });
+      if (remaining == 0) {
+        return;
+      }
+      JobId id = ready.front();
+      ready.pop_front();
+      Entry& entry = entries_[id];
+
+      lock.unlock();
+      VLOG(0) << "Starting '" << entry.name << "'";
+      Result<void> result = entry.job();
+      lock.lock();
+
+      if (result.ok()) {
+        for (JobId dependent : entry.dependents) {
+          Entry& next = entries_[dependent];
+          if (--next.unfinished_dependencies == 0 && !skipped[dependent]) {
+            ready.push_back(dependent);
+          }
+        }
+      } else {
+        LOG(ERROR) << "'" << entry.name << "' failed: " << result.error();
+        if (!first_error) {
+          first_error = std::move(result);
+          failed_job = entry.name;
+        }
+        for (JobId dependent : entry.dependents) {
+          skip(dependent);
+        }
+      }
+      remaining--;
+      changed.notify_all();
+    }
+  };
+
+  size_t num_workers = std::min(max_concurrent_jobs_, entries_.size());
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < num_workers; i++) {
+    workers.emplace_back(worker);
+  }
+  for (std::thread& thread : workers) {
+    thread.join();
+  }
+  entries_.clear();
+
+  if (first_error) {
+    CF_EXPECTF(std::move(*first_error), "Failed to run '{}'", failed_job);
+  }
+  return {};
+}
+
+}  // namespace cuttlefish
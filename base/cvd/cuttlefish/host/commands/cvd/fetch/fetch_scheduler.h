@@ -0,0 +1,62 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+
+/**
+ * Runs fetch jobs concurrently, with at most a fixed number running at once
+ * across all targets.
+ *
+ * A job only starts once all of its dependencies completed successfully. When
+ * a job fails, the jobs depending on it are skipped, while independent jobs
+ * still run to completion so their partial results are not left half written.
+ */
+class FetchScheduler {
+ public:
+  using JobId = size_t;
+  using Job = std::function<Result<void>()>;
+
+  // Zero means one job at a time.
+  explicit FetchScheduler(size_t max_concurrent_jobs);
+
+  // `dependencies` must have been returned by earlier calls.
+  JobId Add(std::string name, Job job, std::vector<JobId> dependencies = {});
+
+  // Runs every added job and returns the first failure, if any.
+  Result<void> Run();
+
+ private:
+  struct Entry {
+    std::string name;
+    Job job;
+    std::vector<JobId> dependents;
+    size_t unfinished_dependencies = 0;
+  };
+
+  size_t max_concurrent_jobs_;
+  std::vector<Entry> entries_;
+};
+
+}  // namespace cuttlefish
@@ -0,0 +1,101 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/host/commands/cvd/fetch/fetch_scheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+TEST(FetchSchedulerTest, RunsDependenciesFirst) {
+  std::mutex mutex;
+  std::vector<std::string> order;
+  auto record = [&mutex, &order](std::string name) {
+    return [&mutex, &order, name]() -> Result<void> {
+      std::lock_guard lock(mutex);
+      order.push_back(name);
+      return {};
+    };
+  };
+
+  FetchScheduler scheduler(4);
+  FetchScheduler::JobId first = scheduler.Add("first", record("first"));
+  FetchScheduler::JobId second =
+      scheduler.Add("second", record("second"), {first});
+  scheduler.Add("third", record("third"), {first, second});
+
+  EXPECT_THAT(scheduler.Run(), IsOk());
+  EXPECT_THAT(order, testing::ElementsAre("first", "second", "third"));
+}
+
+TEST(FetchSchedulerTest, LimitsConcurrentJobs) {
+  std::atomic_int running = 0;
+  std::atomic_int max_running = 0;
+  auto job = [&running, &max_running]() -> Result<void> {
+    int now = ++running;
+    int seen = max_running;
+    while (now > seen && !max_running.compare_exchange_weak(seen, now)) {
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    running--;
+    return {};
+  };
+
+  FetchScheduler scheduler(2);
+  for (int i = 0; i < 8; i++) {
+    scheduler.Add("job", job);
+  }
+
+  EXPECT_THAT(scheduler.Run(), IsOk());
+  EXPECT_EQ(max_running, 2);
+}
+
+TEST(FetchSchedulerTest, SkipsDependentsOfFailedJobs) {
+  std::atomic_bool dependent_ran = false;
+  std::atomic_bool independent_ran = false;
+
+  FetchScheduler scheduler(1);
+  FetchScheduler::JobId failing =
+      scheduler.Add("failing", []() -> Result<void> { return CF_ERR("oops"); });
+  scheduler.Add("dependent",
+                [&dependent_ran]() -> Result<void> {
+                  dependent_ran = true;
+                  return {};
+                },
+                {failing});
+  scheduler.Add("independent", [&independent_ran]() -> Result<void> {
+    independent_ran = true;
+    return {};
+  });
+
+  EXPECT_THAT(scheduler.Run(), IsError());
+  EXPECT_FALSE(dependent_ran);
+  EXPECT_TRUE(independent_ran);
+}
+
+}  // namespace
+}  // namespace cuttlefish
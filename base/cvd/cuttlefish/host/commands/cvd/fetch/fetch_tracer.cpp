@@ -15,6 +15,9 @@
 
 #include "cuttlefish/host/commands/cvd/fetch/fetch_tracer.h"
 
+#include <stdint.h>
+
+#include <algorithm>
 #include <chrono>
 #include <ctime>
 #include <iomanip>
@@ -35,6 +38,7 @@ struct Phase {
   std::string name;
   std::chrono::milliseconds duration;
   std::optional<size_t> size_bytes;
+  std::vector<Phase> concurrent;
 };
 
 }  // namespace
@@ -45,12 +49,13 @@ struct FetchTracer::TraceImpl {
   std::chrono::steady_clock::time_point phase_start =
       std::chrono::steady_clock::now();
   std::vector<Phase> phases;
+  std::vector<Phase> pending_concurrent;
 };
 
 namespace {
 
 std::chrono::milliseconds FullDuration(const FetchTracer::TraceImpl& trace) {
-  std::chrono::milliseconds total_duration;
+  std::chrono::milliseconds total_duration(0);
   for (const Phase& phase : trace.phases) {
     total_duration += phase.duration;
   }
@@ -91,6 +96,17 @@ std::string FormatDuration(std::chrono::milliseconds duration_ms) {
   }
 }
 
+// Traces run concurrently, so the throughput of each phase tells apart a slow
+// source from a shared bottleneck.
+std::string FormatPhaseSize(size_t size, std::chrono::milliseconds duration) {
+  std::string formatted = FormatByteSize(size);
+  if (duration >= std::chrono::seconds(1)) {
+    uint64_t per_second = size * 1000 / duration.count();
+    formatted += fmt::format(" ({}/s)", FormatByteSize(per_second));
+  }
+  return formatted;
+}
+
 std::string ToStyledString(const FetchTracer::TraceImpl& trace,
                            std::string indent_prefix) {
   std::stringstream ss;
@@ -104,9 +120,21 @@ std::string ToStyledString(const FetchTracer::TraceImpl& trace,
     }
     ss << indent_prefix << phase.name << ": " << FormatDuration(phase.duration);
     if (phase.size_bytes) {
-      ss << ", " << FormatByteSize(*phase.size_bytes);
+      ss << ", " << FormatPhaseSize(*phase.size_bytes, phase.duration);
     }
     ss << '\n';
+    for (const Phase& concurrent : phase.concurrent) {
+      if (concurrent.duration < std::chrono::milliseconds(500)) {
+        continue;
+      }
+      ss << indent_prefix << "  | " << concurrent.name << ": "
+         << FormatDuration(concurrent.duration);
+      if (concurrent.size_bytes) {
+        ss << ", " << FormatPhaseSize(*concurrent.size_bytes,
+                                      concurrent.duration);
+      }
+      ss << '\n';
+    }
   }
   if (omitted_count > 0) {
     ss << indent_prefix;
@@ -127,10 +155,18 @@ void FetchTracer::Trace::CompletePhase(std::string phase_name,
       std::move(phase_name),
       std::chrono::duration_cast<std::chrono::milliseconds>(now -
                                                             impl_.phase_start),
-      size_bytes});
+      size_bytes, std::move(impl_.pending_concurrent)});
+  impl_.pending_concurrent.clear();
   impl_.phase_start = now;
 }
 
+void FetchTracer::Trace::AddConcurrentPhase(std::string phase_name,
+                                            std::chrono::milliseconds duration,
+                                            std::optional<size_t> size_bytes) {
+  impl_.pending_concurrent.push_back(
+      Phase{std::move(phase_name), duration, size_bytes, {}});
+}
+
 FetchTracer::Trace FetchTracer::NewTrace(std::string name) {
   std::lock_guard lock(traces_mtx_);
   auto& ref =
@@ -140,14 +176,30 @@ FetchTracer::Trace FetchTracer::NewTrace(std::string name) {
 
 std::string FetchTracer::ToStyledString() const {
   std::stringstream ss;
+  std::chrono::system_clock::time_point first_start =
+      std::chrono::system_clock::time_point::max();
+  std::chrono::system_clock::time_point last_end =
+      std::chrono::system_clock::time_point::min();
+  std::chrono::milliseconds combined_duration(0);
   for (const auto& [name, trace] : traces_) {
+    std::chrono::milliseconds duration = FullDuration(*trace);
+    first_start = std::min(first_start, trace->trace_start);
+    last_end = std::max(last_end, trace->trace_start + duration);
+    combined_duration += duration;
     std::time_t start_time =
         std::chrono::system_clock::to_time_t(trace->trace_start);
     ss << name << ":\n";
     ss << " started: " << std::put_time(std::localtime(&start_time), "%F %T")
-       << ", duration: " << FormatDuration(FullDuration(*trace)) << '\n';
+       << ", duration: " << FormatDuration(duration) << '\n';
     ss << cuttlefish::ToStyledString(*trace, " - ");
   }
+  if (!traces_.empty()) {
+    auto wall_duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        last_end - first_start);
+    ss << "Total: " << FormatDuration(wall_duration) << " elapsed, "
+       << FormatDuration(combined_duration) << " across " << traces_.size()
+       << " traces\n";
+  }
   return ss.str();
 }
 
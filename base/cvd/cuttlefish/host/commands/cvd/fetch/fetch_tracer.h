@@ -17,6 +17,7 @@
 
 #include <stddef.h>
 
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <optional>
@@ -41,6 +42,12 @@ class FetchTracer {
 
     void CompletePhase(std::string phase_name,
                        std::optional<size_t> size = std::nullopt);
+    // Records an operation that ran concurrently with the current phase, for
+    // example on a worker thread. It is reported as part of the next phase to
+    // complete and doesn't count towards the trace duration.
+    void AddConcurrentPhase(std::string phase_name,
+                            std::chrono::milliseconds duration,
+                            std::optional<size_t> size = std::nullopt);
 
    private:
     TraceImpl& impl_;
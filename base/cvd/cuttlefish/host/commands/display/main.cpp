@@ -21,6 +21,7 @@
 #include <vector>
 
 #include "absl/base/no_destructor.h"
+#include <android-base/file.h>
 #include <android-base/strings.h>
 
 #include "cuttlefish/common/libs/utils/files.h"
@@ -31,6 +32,7 @@
 #include "cuttlefish/host/libs/command_util/util.h"
 #include "cuttlefish/host/libs/config/cuttlefish_config.h"
 #include "cuttlefish/host/libs/config/display.h"
+#include "cuttlefish/host/libs/log_names/log_names.h"
 #include "cuttlefish/host/libs/vm_manager/crosvm_display_controller.h"
 #include "cuttlefish/result/result.h"
 
@@ -53,6 +55,8 @@ Commands:(cvd display help <subcommand> for more information):
     remove: Disconnects and removes displays.
 
     screenshot: Screenshots the contents of a given display.
+
+    stats: Prints the frame latencies of the displays.
 )";
 
 static const char kAddUsage[] =
@@ -87,9 +91,24 @@ static const char kScreenshotUsage[] =
     R"(
 Screenshots the contents of a given display.
 
-Currently supported output formats: jpg, png, webp.
+Currently supported output formats: jpg, png. The command returns once the
+frame is taken, the file appears at the screenshot path once encoded.
 
 usage: cvd display screenshot <display id> <screenshot path>
+
+  --compression_level: the zlib level for png, from 0 to 9, or the quality
+    for jpg, from 1 to 100. Lower png levels are much faster.
+  --all_displays: screenshots every display at once, adding the display id
+    before the extension of the screenshot path.
+)";
+
+static const char kStatsUsage[] =
+    R"(
+Prints the frame latencies of the displays, from the guest committing a frame
+to the frame reaching the encoder, as JSON. They are also left in
+display_stats.json in the logs of the instance.
+
+usage: cvd display stats
 )";
 
 Result<int> GetInstanceNum(std::vector<std::string>& args) {
@@ -112,6 +131,7 @@ Result<int> DoHelp(std::vector<std::string>& args) {
           {"list", kListUsage},
           {"remove", kRemoveUsage},
           {"screenshot", kScreenshotUsage},
+          {"stats", kStatsUsage},
       });
 
   const std::string& subcommand_str = args[0];
@@ -191,6 +211,8 @@ Result<int> DoScreenshot(std::vector<std::string>& args) {
 
   int display_number = 0;
   std::string screenshot_path;
+  int compression_level = -1;
+  bool all_displays = false;
 
   std::vector<std::string> displays;
   const std::vector<Flag> screenshot_flags = {
@@ -198,6 +220,10 @@ Result<int> DoScreenshot(std::vector<std::string>& args) {
           .Help("Display id of a display to screenshot."),
       GflagsCompatFlag("screenshot_path", screenshot_path)
           .Help("Path for the resulting screenshot file."),
+      GflagsCompatFlag("compression_level", compression_level)
+          .Help("PNG zlib level or JPEG quality, the default if negative."),
+      GflagsCompatFlag("all_displays", all_displays)
+          .Help("Screenshot every display."),
   };
   auto parse_res = ConsumeFlags(screenshot_flags, args);
   if (!parse_res.ok()) {
@@ -216,14 +242,51 @@ Result<int> DoScreenshot(std::vector<std::string>& args) {
       display_number);
   extended_action.mutable_screenshot_display()->set_screenshot_path(
       screenshot_path);
+  if (compression_level >= 0) {
+    extended_action.mutable_screenshot_display()->set_compression_level(
+        compression_level);
+  }
+  extended_action.mutable_screenshot_display()->set_all_displays(
+      all_displays);
+
+  if (all_displays) {
+    std::cout << "Requesting to save screenshots for all displays to "
+              << screenshot_path << "." << std::endl;
+  } else {
+    std::cout << "Requesting to save screenshot for display "
+              << display_number << " to " << screenshot_path << "."
+              << std::endl;
+  }
 
-  std::cout << "Requesting to save screenshot for display " << display_number
-            << " to " << screenshot_path << "." << std::endl;
+  auto socket = CF_EXPECT(
+      GetLauncherMonitor(*config, instance_num, /*timeout_seconds=*/5));
+  CF_EXPECT(RunLauncherAction(socket, extended_action, std::nullopt),
+            "Failed to get success response from launcher.");
+  return 0;
+}
+
+Result<int> DoStats(std::vector<std::string>& args) {
+  const int instance_num = CF_EXPECT(GetInstanceNum(args));
+
+  auto config = cuttlefish::CuttlefishConfig::Get();
+  if (!config) {
+    return CF_ERR("Failed to get Cuttlefish config.");
+  }
+
+  run_cvd::ExtendedLauncherAction extended_action;
+  extended_action.mutable_display_stats();
 
   auto socket = CF_EXPECT(
       GetLauncherMonitor(*config, instance_num, /*timeout_seconds=*/5));
   CF_EXPECT(RunLauncherAction(socket, extended_action, std::nullopt),
             "Failed to get success response from launcher.");
+
+  const auto instance = config->ForInstance(instance_num);
+  const std::string path = instance.PerInstanceLogPath(kLogNameDisplayStats);
+  std::string stats;
+  CF_EXPECTF(android::base::ReadFileToString(path, &stats),
+             "Failed to read '{}'", path);
+  std::cout << stats;
   return 0;
 }
 
@@ -237,6 +300,7 @@ int DisplayMain(int argc, char** argv) {
       {"help", DoHelp},              //
       {"remove", DoRemove},          //
       {"screenshot", DoScreenshot},  //
+      {"stats", DoStats},            //
   };
 
   std::vector<std::string> args(argv + 1, argv + argc);
@@ -18,8 +18,11 @@
 
 #include <fcntl.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 #include <sys/types.h>
 
+#include <iterator>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -31,6 +34,7 @@
 
 #include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/common/libs/fs/shared_select.h"
+#include "cuttlefish/host/commands/kernel_log_monitor/pattern_matcher.h"
 #include "cuttlefish/host/libs/config/config_constants.h"
 #include "cuttlefish/host/libs/config/cuttlefish_config.h"
 
@@ -77,6 +81,28 @@ constexpr struct {
     {kHibernationExitMessage, Event::AdbdStarted, kBare},
 };
 
+// Matches the informational patterns followed by the stages, in that order.
+constexpr size_t kPatternCount =
+    std::size(kInformationalPatterns) + std::size(kStageTable);
+static_assert(kPatternCount <= PatternMatcher::kMaxPatterns);
+
+// Reads as much as the default pipe capacity at once.
+constexpr size_t kReadSize = 64 * 1024;
+
+const PatternMatcher& Matcher() {
+  static const PatternMatcher matcher([]() {
+    std::vector<std::string_view> patterns;
+    for (const auto& pattern : kInformationalPatterns) {
+      patterns.push_back(pattern.match);
+    }
+    for (const auto& stage : kStageTable) {
+      patterns.push_back(stage.stage);
+    }
+    return patterns;
+  }());
+  return matcher;
+}
+
 void ProcessSubscriptions(Json::Value message,
                           std::vector<EventCallback>* subscribers) {
   auto active_subscription_count = subscribers->size();
@@ -118,9 +144,8 @@ void KernelLogServer::SubscribeToEvents(EventCallback callback) {
 }
 
 bool KernelLogServer::HandleIncomingMessage() {
-  const size_t buf_len = 256;
-  char buf[buf_len];
-  ssize_t ret = pipe_fd_->Read(buf, buf_len);
+  read_buffer_.resize(kReadSize);
+  ssize_t ret = pipe_fd_->Read(read_buffer_.data(), read_buffer_.size());
   if (ret < 0) {
     LOG(ERROR) << "Could not read kernel logs: " << pipe_fd_->StrError();
     return false;
@@ -129,65 +154,81 @@ bool KernelLogServer::HandleIncomingMessage() {
     return false;
   }
   // Write the log to a file
-  if (log_fd_->Write(buf, ret) < 0) {
+  if (log_fd_->Write(read_buffer_.data(), ret) < 0) {
     LOG(ERROR) << "Could not write kernel log to file: " << log_fd_->StrError();
     return false;
   }
 
   // Detect VIRTUAL_DEVICE_BOOT_*
-  for (ssize_t i = 0; i < ret; i++) {
-    if ('\n' == buf[i]) {
-      for (auto& [match, prefix] : kInformationalPatterns) {
-        auto pos = line_.find(match);
-        if (std::string::npos != pos) {
-          LOG(INFO) << prefix << line_.substr(pos + match.size());
-        }
-      }
-      for (const auto& [stage, event, format] : kStageTable) {
-        auto pos = line_.find(stage);
-        if (std::string::npos != pos) {
-          // Log the stage
-          if (format == kPrefix) {
-            LOG(INFO) << line_.substr(pos);
-          } else {
-            LOG(INFO) << stage;
-          }
-
-          Json::Value message;
-          message["event"] = event;
-          Json::Value metadata;
-
-          if (format == kKeyValuePair) {
-            // Expect space-separated key=value pairs in the log message.
-            const std::vector<std::string> fields =
-                absl::StrSplit(line_.substr(pos + stage.size()), ' ');
-            for (std::string_view field : fields) {
-              field = absl::StripAsciiWhitespace(field);
-              if (field.empty()) {
-                // Expected; absl::StrSplit() always returns at least
-                // one (possibly empty) string.
-                VLOG(0) << "Empty field for line: " << line_;
-                continue;
-              }
-              const std::vector<std::string> keyvalue =
-                  absl::StrSplit(field, '=');
-              if (keyvalue.size() != 2) {
-                LOG(WARNING) << "Field is not in key=value format: " << field;
-                continue;
-              }
-              metadata[keyvalue[0]] = keyvalue[1];
-            }
-          }
-          message["metadata"] = metadata;
-          ProcessSubscriptions(message, &subscribers_);
-        }
-      }
+  std::string_view data(read_buffer_.data(), ret);
+  while (const void* newline = memchr(data.data(), '\n', data.size())) {
+    const size_t length = static_cast<const char*>(newline) - data.data();
+    if (line_.empty()) {
+      HandleLine(data.substr(0, length));
+    } else {
+      line_.append(data.substr(0, length));
+      HandleLine(line_);
       line_.clear();
     }
-    line_.append(1, buf[i]);
+    data.remove_prefix(length + 1);
   }
+  line_.append(data);
 
   return true;
 }
 
+void KernelLogServer::HandleLine(std::string_view line) {
+  const PatternMatcher::Matches matches = Matcher().Match(line);
+  if (!matches.found) {
+    return;
+  }
+  size_t pattern = 0;
+  for (auto& [match, prefix] : kInformationalPatterns) {
+    if (matches.found & (uint64_t{1} << pattern)) {
+      auto pos = matches.first_position[pattern];
+      LOG(INFO) << prefix << line.substr(pos + match.size());
+    }
+    pattern++;
+  }
+  for (const auto& [stage, event, format] : kStageTable) {
+    if (!(matches.found & (uint64_t{1} << pattern++))) {
+      continue;
+    }
+    auto pos = matches.first_position[pattern - 1];
+    // Log the stage
+    if (format == kPrefix) {
+      LOG(INFO) << line.substr(pos);
+    } else {
+      LOG(INFO) << stage;
+    }
+
+    Json::Value message;
+    message["event"] = event;
+    Json::Value metadata;
+
+    if (format == kKeyValuePair) {
+      // Expect space-separated key=value pairs in the log message.
+      const std::vector<std::string> fields =
+          absl::StrSplit(line.substr(pos + stage.size()), ' ');
+      for (std::string_view field : fields) {
+        field = absl::StripAsciiWhitespace(field);
+        if (field.empty()) {
+          // Expected; absl::StrSplit() always returns at least
+          // one (possibly empty) string.
+          VLOG(0) << "Empty field for line: " << line;
+          continue;
+        }
+        const std::vector<std::string> keyvalue = absl::StrSplit(field, '=');
+        if (keyvalue.size() != 2) {
+          LOG(WARNING) << "Field is not in key=value format: " << field;
+          continue;
+        }
+        metadata[keyvalue[0]] = keyvalue[1];
+      }
+    }
+    message["metadata"] = metadata;
+    ProcessSubscriptions(message, &subscribers_);
+  }
+}
+
 }  // namespace cuttlefish::monitor
@@ -19,6 +19,7 @@
 
 #include <functional>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "json/json.h"
@@ -76,9 +77,13 @@ class KernelLogServer {
   // Respond to message from remote client.
   // Returns false, if client disconnected.
   bool HandleIncomingMessage();
+  // Matches the patterns of the kernel log in a line, without its newline.
+  void HandleLine(std::string_view line);
 
   SharedFD pipe_fd_;
   SharedFD log_fd_;
+  std::vector<char> read_buffer_;
+  // The start of a line, until its end is read.
   std::string line_;
   std::vector<EventCallback> subscribers_;
 
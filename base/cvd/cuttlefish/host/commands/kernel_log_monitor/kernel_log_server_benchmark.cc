@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the kernel log throughput of KernelLogServer, from the pipe to the
+// subscribers, over a boot log. The log is the one at $CUTTLEFISH_KERNEL_LOG
+// when set, such as a kernel.log of a previous boot, or a synthetic one with
+// the events of a boot spread over ordinary kernel messages otherwise.
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <sys/ioctl.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+
+#include <fmt/format.h>
+#include "benchmark/benchmark.h"
+#include "json/json.h"
+
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/common/libs/fs/shared_select.h"
+#include "cuttlefish/common/libs/utils/files.h"
+#include "cuttlefish/host/commands/kernel_log_monitor/kernel_log_server.h"
+#include "cuttlefish/host/libs/config/config_constants.h"
+
+namespace cuttlefish::monitor {
+namespace {
+
+constexpr size_t kSyntheticLines = 20000;
+
+std::string SyntheticLog() {
+  const char* const kNoise[] = {
+      "pci 0000:00:01.0: [1af4:1000] type 00 class 0x020000",
+      "virtio_blk virtio2: [vda] 4194304 512-byte logical blocks",
+      "EXT4-fs (vda): mounted filesystem with ordered data mode",
+      "init: Parsing file /system/etc/init/hw/init.rc...",
+      "audit: type=1400 audit(0.0:12): avc: denied { read } for pid=1",
+      "binder: 1234:1234 transaction failed 29189/-22, size 0-0",
+      "logd: logdr: UID=1000 GID=1000 PID=1234 n tail=0 logMask=8",
+  };
+  const std::string kEvents[] = {
+      "U-Boot 2024.01 (Jan 01 2026 - 00:00:00 +0000)",
+      "] Linux version 6.6.0 (build@host) #1 SMP PREEMPT",
+      kBootStartedMessage,
+      kAdbdStartedMessage,
+      std::string(kScreenChangedMessage) + " width=1080 height=2400",
+      std::string(kDisplayPowerModeChangedMessage) + " display_id=0 mode=on",
+      kWifiConnectedMessage,
+      kBootCompletedMessage,
+  };
+  std::mt19937 rng(1);
+  std::string log;
+  double timestamp = 0;
+  for (size_t i = 0; i < kSyntheticLines; i++) {
+    timestamp += 0.0001 * (rng() % 100);
+    const bool event = i % (kSyntheticLines / std::size(kEvents)) == 0;
+    const std::string& message =
+        event ? kEvents[i / (kSyntheticLines / std::size(kEvents))]
+              : std::string(kNoise[rng() % std::size(kNoise)]);
+    log += fmt::format("[{:12.6f}] {}\n", timestamp, message);
+  }
+  return log;
+}
+
+std::string BootLog() {
+  const char* path = getenv("CUTTLEFISH_KERNEL_LOG");
+  if (path == nullptr) {
+    return SyntheticLog();
+  }
+  Result<std::string> log = ReadFileContents(path);
+  return log.ok() ? *log : SyntheticLog();
+}
+
+void BM_KernelLogServer(benchmark::State& state) {
+  const std::string log = BootLog();
+  // Writes in chunks that fit in the pipe, as the VMM does.
+  const size_t chunk = state.range(0);
+  for (auto _ : state) {
+    SharedFD read_end;
+    SharedFD write_end;
+    SharedFD::Pipe(&read_end, &write_end);
+    KernelLogServer server(read_end, "/dev/null");
+    size_t events = 0;
+    server.SubscribeToEvents([&events](Json::Value) {
+      events++;
+      return SubscriptionAction::ContinueSubscription;
+    });
+    SharedFDSet fd_read;
+    fd_read.Set(read_end);
+    for (size_t offset = 0; offset < log.size();) {
+      const size_t size = std::min(chunk, log.size() - offset);
+      offset += write_end->Write(log.data() + offset, size);
+      int available = 0;
+      while (read_end->Ioctl(FIONREAD, &available) == 0 && available > 0) {
+        server.AfterSelect(fd_read);
+      }
+    }
+    benchmark::DoNotOptimize(events);
+  }
+  state.SetBytesProcessed(state.iterations() * log.size());
+}
+BENCHMARK(BM_KernelLogServer)->Arg(256)->Arg(4096)->Arg(65536);
+
+}  // namespace
+}  // namespace cuttlefish::monitor
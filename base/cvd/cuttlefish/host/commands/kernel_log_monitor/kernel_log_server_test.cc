@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/commands/kernel_log_monitor/kernel_log_server.h"
+
+#include <stddef.h>
+#include <sys/ioctl.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "json/json.h"
+
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/common/libs/fs/shared_select.h"
+#include "cuttlefish/host/libs/config/config_constants.h"
+
+namespace cuttlefish::monitor {
+namespace {
+
+// The size of the reads of the server.
+constexpr size_t kReadSize = 64 * 1024;
+
+// Feeds a KernelLogServer through a pipe and records the events it sends.
+class KernelLogServerTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(SharedFD::Pipe(&read_end_, &write_end_));
+    server_ = std::make_unique<KernelLogServer>(read_end_, "/dev/null");
+    server_->SubscribeToEvents([this](Json::Value message) {
+      messages_.push_back(message);
+      return SubscriptionAction::ContinueSubscription;
+    });
+  }
+
+  // Writes the data, then has the server read all of it.
+  void Send(const std::string& data) {
+    ASSERT_EQ(write_end_->Write(data.data(), data.size()), data.size());
+    SharedFDSet fd_read;
+    fd_read.Set(read_end_);
+    int available = 0;
+    while (read_end_->Ioctl(FIONREAD, &available) == 0 && available > 0) {
+      server_->AfterSelect(fd_read);
+    }
+  }
+
+  std::vector<int> Events() const {
+    std::vector<int> events;
+    for (const Json::Value& message : messages_) {
+      events.push_back(message["event"].asInt());
+    }
+    return events;
+  }
+
+  SharedFD read_end_;
+  SharedFD write_end_;
+  std::unique_ptr<KernelLogServer> server_;
+  std::vector<Json::Value> messages_;
+};
+
+}  // namespace
+
+TEST_F(KernelLogServerTest, EventsInOrder) {
+  Send(std::string("[    1.0] ") + kBootStartedMessage + "\n" +
+       "[    2.0] unrelated\n" + "[    3.0] " + kBootCompletedMessage + "\n");
+  EXPECT_EQ(Events(),
+            (std::vector<int>{Event::BootStarted, Event::BootCompleted}));
+}
+
+TEST_F(KernelLogServerTest, SeveralEventsInALine) {
+  Send(std::string(kAdbdStartedMessage) + " " + kBootCompletedMessage + "\n");
+  // In the order of the table of stages rather than of the line.
+  EXPECT_EQ(Events(),
+            (std::vector<int>{Event::BootCompleted, Event::AdbdStarted}));
+}
+
+TEST_F(KernelLogServerTest, LineWithoutNewlineWaitsForIt) {
+  Send(std::string("[    1.0] ") + kBootCompletedMessage);
+  EXPECT_TRUE(Events().empty());
+  Send(" done");
+  EXPECT_TRUE(Events().empty());
+  Send("\n");
+  EXPECT_EQ(Events(), std::vector<int>{Event::BootCompleted});
+}
+
+TEST_F(KernelLogServerTest, MatchSplitAcrossReads) {
+  // Ends the first read in the middle of the stage and of its values.
+  const std::string line = std::string("[    1.0] ") + kScreenChangedMessage +
+                           " width=1080 height=2400\n";
+  for (size_t split : {size_t{12}, line.size() - 8}) {
+    messages_.clear();
+    const std::string filler(kReadSize - split - 1, 'x');
+    const std::string log = filler + "\n" + line;
+    Send(log.substr(0, kReadSize));
+    Send(log.substr(kReadSize));
+    ASSERT_EQ(Events(), std::vector<int>{Event::ScreenChanged})
+        << "Split at " << split;
+    EXPECT_EQ(messages_[0]["metadata"]["width"], "1080");
+    EXPECT_EQ(messages_[0]["metadata"]["height"], "2400");
+  }
+}
+
+TEST_F(KernelLogServerTest, LineLongerThanARead) {
+  const std::string filler(kReadSize - 4, 'x');
+  const std::string log =
+      filler + kBootStartedMessage + filler + kBootCompletedMessage + "\n";
+  for (size_t offset = 0; offset < log.size(); offset += kReadSize) {
+    Send(log.substr(offset, kReadSize));
+  }
+  EXPECT_EQ(Events(),
+            (std::vector<int>{Event::BootStarted, Event::BootCompleted}));
+}
+
+}  // namespace cuttlefish::monitor
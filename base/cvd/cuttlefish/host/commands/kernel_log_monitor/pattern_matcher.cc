@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/commands/kernel_log_monitor/pattern_matcher.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string_view>
+#include <vector>
+
+#include "absl/log/check.h"
+
+namespace cuttlefish::monitor {
+
+PatternMatcher::PatternMatcher(const std::vector<std::string_view>& patterns) {
+  CHECK_LE(patterns.size(), kMaxPatterns);
+  byte_class_.fill(0);
+  for (std::string_view pattern : patterns) {
+    CHECK(!pattern.empty()) << "Empty patterns can't be matched";
+    for (char c : pattern) {
+      uint16_t& byte_class = byte_class_[static_cast<uint8_t>(c)];
+      if (byte_class == 0) {
+        byte_class = ++class_count_;
+      }
+    }
+  }
+  class_count_++;
+
+  // The trie, with 0 as "no transition" as the root is never a target.
+  AddState();
+  for (size_t i = 0; i < patterns.size(); i++) {
+    uint32_t state = 0;
+    for (char c : patterns[i]) {
+      if (next_[Transition(state, c)] == 0) {
+        // Added before indexing, which the new state may reallocate.
+        const uint32_t added = AddState();
+        next_[Transition(state, c)] = added;
+      }
+      state = next_[Transition(state, c)];
+    }
+    outputs_[state] |= uint64_t{1} << i;
+    lengths_[i] = patterns[i].size();
+  }
+
+  // Breadth first, fills the missing transitions from the longest proper
+  // suffix of each state, which is already complete.
+  std::vector<uint32_t> suffix(next_.size() / class_count_, 0);
+  std::vector<uint32_t> queue;
+  for (size_t c = 0; c < class_count_; c++) {
+    if (next_[c] != 0) {
+      queue.push_back(next_[c]);
+    }
+  }
+  for (size_t head = 0; head < queue.size(); head++) {
+    const uint32_t state = queue[head];
+    outputs_[state] |= outputs_[suffix[state]];
+    for (size_t c = 0; c < class_count_; c++) {
+      uint32_t& next = next_[state * class_count_ + c];
+      const uint32_t from_suffix = next_[suffix[state] * class_count_ + c];
+      if (next == 0) {
+        next = from_suffix;
+      } else {
+        suffix[next] = from_suffix;
+        queue.push_back(next);
+      }
+    }
+  }
+}
+
+PatternMatcher::Matches PatternMatcher::Match(std::string_view line) const {
+  Matches matches;
+  uint32_t state = 0;
+  for (size_t i = 0; i < line.size(); i++) {
+    state = next_[Transition(state, line[i])];
+    uint64_t ending = outputs_[state] & ~matches.found;
+    while (ending) {
+      const int pattern = __builtin_ctzll(ending);
+      ending &= ending - 1;
+      matches.first_position[pattern] = i + 1 - lengths_[pattern];
+    }
+    matches.found |= outputs_[state];
+  }
+  return matches;
+}
+
+uint32_t PatternMatcher::AddState() {
+  next_.resize(next_.size() + class_count_, 0);
+  outputs_.push_back(0);
+  return outputs_.size() - 1;
+}
+
+}  // namespace cuttlefish::monitor
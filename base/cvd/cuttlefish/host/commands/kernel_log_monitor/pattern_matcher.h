@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <string_view>
+#include <vector>
+
+namespace cuttlefish::monitor {
+
+// Finds a set of patterns in a line in a single pass, with an Aho-Corasick
+// automaton turned into a DFA. Bytes absent from every pattern share a single
+// class to keep the transition table small.
+class PatternMatcher {
+ public:
+  // Matched patterns are kept in a bitmask.
+  static constexpr size_t kMaxPatterns = 64;
+
+  struct Matches {
+    uint64_t found = 0;  // Bit i is set when pattern i is in the line
+    // The position of the first occurrence of each pattern that was found.
+    std::array<size_t, kMaxPatterns> first_position{};
+  };
+
+  // The patterns must be non-empty, and at most kMaxPatterns of them. They
+  // may overlap, or be the same.
+  explicit PatternMatcher(const std::vector<std::string_view>& patterns);
+
+  Matches Match(std::string_view line) const;
+
+ private:
+  uint32_t AddState();
+
+  size_t Transition(uint32_t state, char c) const {
+    return state * class_count_ + byte_class_[static_cast<uint8_t>(c)];
+  }
+
+  // Up to 256 bytes, and the class of absent bytes.
+  std::array<uint16_t, 256> byte_class_;
+  size_t class_count_ = 0;
+  std::vector<uint32_t> next_;
+  // The patterns ending at each state, as a bitmask.
+  std::vector<uint64_t> outputs_;
+  std::array<size_t, kMaxPatterns> lengths_{};
+};
+
+}  // namespace cuttlefish::monitor
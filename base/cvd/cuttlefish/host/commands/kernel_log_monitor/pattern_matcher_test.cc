@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/commands/kernel_log_monitor/pattern_matcher.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace cuttlefish::monitor {
+namespace {
+
+// Checks the matches of every pattern against std::string::find.
+void ExpectMatchesFind(const std::vector<std::string_view>& patterns,
+                       const std::string& line) {
+  const PatternMatcher::Matches matches = PatternMatcher(patterns).Match(line);
+  for (size_t i = 0; i < patterns.size(); i++) {
+    const size_t position = line.find(patterns[i]);
+    const bool found = matches.found & (uint64_t{1} << i);
+    ASSERT_EQ(found, position != std::string::npos)
+        << "Pattern \"" << patterns[i] << "\" in \"" << line << "\"";
+    if (found) {
+      EXPECT_EQ(matches.first_position[i], position)
+          << "Pattern \"" << patterns[i] << "\" in \"" << line << "\"";
+    }
+  }
+  if (patterns.size() < PatternMatcher::kMaxPatterns) {
+    EXPECT_EQ(matches.found >> patterns.size(), 0);
+  }
+}
+
+}  // namespace
+
+TEST(PatternMatcherTest, NoPatternFound) {
+  PatternMatcher matcher({"abc", "def"});
+  EXPECT_EQ(matcher.Match("").found, 0);
+  EXPECT_EQ(matcher.Match("ab cd ef").found, 0);
+}
+
+TEST(PatternMatcherTest, OverlappingPatterns) {
+  ExpectMatchesFind({"abab", "bab", "aba"}, "xabababx");
+  ExpectMatchesFind({"aaa", "aa"}, "aaaa");
+  ExpectMatchesFind({"abcd", "cdef"}, "abcdef");
+}
+
+TEST(PatternMatcherTest, PatternsThatArePrefixesOfEachOther) {
+  const std::vector<std::string_view> patterns = {"he", "her", "hers"};
+  ExpectMatchesFind(patterns, "hers");
+  ExpectMatchesFind(patterns, "her he");
+  ExpectMatchesFind(patterns, "h he her");
+  ExpectMatchesFind(patterns, "hhers");
+}
+
+TEST(PatternMatcherTest, PatternsThatAreSuffixesOfEachOther) {
+  const std::vector<std::string_view> patterns = {"she", "he", "e"};
+  ExpectMatchesFind(patterns, "she");
+  ExpectMatchesFind(patterns, "e he she");
+  ExpectMatchesFind(patterns, "sshe");
+  // A pattern found inside a longer partial match that fails later.
+  ExpectMatchesFind({"abcx", "bc"}, "abcy");
+}
+
+TEST(PatternMatcherTest, SamePatternTwice) {
+  const PatternMatcher::Matches matches =
+      PatternMatcher({"boot", "boot"}).Match("reboot");
+  EXPECT_EQ(matches.found, 0b11);
+  EXPECT_EQ(matches.first_position[0], 2);
+  EXPECT_EQ(matches.first_position[1], 2);
+}
+
+TEST(PatternMatcherTest, PatternsAtTheEndsOfTheLine) {
+  const std::vector<std::string_view> patterns = {"start", "end"};
+  ExpectMatchesFind(patterns, "start middle end");
+  ExpectMatchesFind(patterns, "end");
+  ExpectMatchesFind(patterns, "star");
+}
+
+TEST(PatternMatcherTest, AllByteValues) {
+  std::string all_bytes;
+  for (int c = 0; c < 256; c++) {
+    all_bytes.push_back(static_cast<char>(c));
+  }
+  const std::string pattern = all_bytes.substr(250) + all_bytes.substr(0, 5);
+  ExpectMatchesFind({all_bytes, pattern, std::string_view("\0", 1)},
+                    all_bytes + pattern);
+}
+
+TEST(PatternMatcherTest, MaxPatterns) {
+  std::vector<std::string> storage;
+  for (size_t i = 0; i < PatternMatcher::kMaxPatterns; i++) {
+    storage.push_back("p" + std::to_string(i) + ";");
+  }
+  const std::vector<std::string_view> patterns(storage.begin(), storage.end());
+  ExpectMatchesFind(patterns, "p63; p0; p1; p10; p9; p11");
+}
+
+// Patterns and lines over a small alphabet, so that they overlap often.
+TEST(PatternMatcherTest, RandomPatternsMatchFind) {
+  std::mt19937 rng(1);
+  const auto random_string = [&rng](size_t min_size, size_t max_size) {
+    std::string s(min_size + rng() % (max_size - min_size + 1), '\0');
+    for (char& c : s) {
+      c = "abc"[rng() % 3];
+    }
+    return s;
+  };
+  for (int i = 0; i < 1000; i++) {
+    std::vector<std::string> storage;
+    for (size_t count = 1 + rng() % 10; count > 0; count--) {
+      storage.push_back(random_string(1, 5));
+    }
+    const std::vector<std::string_view> patterns(storage.begin(),
+                                                 storage.end());
+    ExpectMatchesFind(patterns, random_string(0, 40));
+    if (HasFatalFailure()) {
+      return;
+    }
+  }
+}
+
+}  // namespace cuttlefish::monitor
@@ -244,34 +244,56 @@ Result<SharedFD> DaemonizeLauncher(const CuttlefishConfig& config) {
   }
 }
 
-Result<SharedFD> ProcessLeader(
-    const CuttlefishConfig& config,
-    const CuttlefishConfig::InstanceSpecific& instance,
-    AutoSetup<ValidateTapDevices>::Type& /* dependency */) {
-  if (IsRestoring(config)) {
-    CF_EXPECT(SharedFD::Fifo(RestoreAdbdPipeName(instance), 0600),
-              "Unable to create adbd restore fifo");
-  }
+// Makes the launcher the leader of a process group. Forks it when running as
+// a daemon, so it runs alone.
+class ProcessLeader : public ReturningSetupFeature<SharedFD> {
+ public:
+  INJECT(
+      ProcessLeader(const CuttlefishConfig& config,
+                    const CuttlefishConfig::InstanceSpecific& instance,
+                    AutoSetup<ValidateTapDevices>::Type& validate_tap_devices))
+      : config_(config),
+        instance_(instance),
+        validate_tap_devices_(validate_tap_devices) {}
 
-  // Move to designated cgroup path when running with vcpufreq enabled.
-  if (!instance.vcpu_config_path().empty()) {
-    CF_EXPECT(MoveSelfToCgroup(instance.id()));
-  }
+  std::string Name() const override { return "ProcessLeader"; }
+  bool RunsAlone() const override { return true; }
 
-  /* These two paths result in pretty different process state, but both
-   * achieve the same goal of making the current process the leader of a
-   * process group, and are therefore grouped together. */
-  if (instance.run_as_daemon()) {
-    return CF_EXPECT(DaemonizeLauncher(config), "DaemonizeLauncher failed");
+ private:
+  std::unordered_set<SetupFeature*> Dependencies() const override {
+    return {static_cast<SetupFeature*>(&validate_tap_devices_)};
   }
-  // Make sure the launcher runs in its own process group even when running
-  // in the foreground
-  if (getsid(0) != getpid()) {
-    CF_EXPECTF(setpgid(0, 0) == 0, "Failed to create new process group: {}",
-               StrError(errno));
+
+  Result<SharedFD> Calculate() override {
+    if (IsRestoring(config_)) {
+      CF_EXPECT(SharedFD::Fifo(RestoreAdbdPipeName(instance_), 0600),
+                "Unable to create adbd restore fifo");
+    }
+
+    // Move to designated cgroup path when running with vcpufreq enabled.
+    if (!instance_.vcpu_config_path().empty()) {
+      CF_EXPECT(MoveSelfToCgroup(instance_.id()));
+    }
+
+    /* These two paths result in pretty different process state, but both
+     * achieve the same goal of making the current process the leader of a
+     * process group, and are therefore grouped together. */
+    if (instance_.run_as_daemon()) {
+      return CF_EXPECT(DaemonizeLauncher(config_), "DaemonizeLauncher failed");
+    }
+    // Make sure the launcher runs in its own process group even when running
+    // in the foreground
+    if (getsid(0) != getpid()) {
+      CF_EXPECTF(setpgid(0, 0) == 0, "Failed to create new process group: {}",
+                 StrError(errno));
+    }
+    return {};
   }
-  return {};
-}
+
+  const CuttlefishConfig& config_;
+  const CuttlefishConfig::InstanceSpecific& instance_;
+  AutoSetup<ValidateTapDevices>::Type& validate_tap_devices_;
+};
 
 // Maintains the state of the boot process, once a final state is reached
 // (success or failure) it sends the appropriate exit code to the foreground
@@ -280,7 +302,7 @@ class CvdBootStateMachine : public SetupFeature, public KernelLogPipeConsumer {
  public:
   INJECT(
       CvdBootStateMachine(const CuttlefishConfig& config,
-                          AutoSetup<ProcessLeader>::Type& process_leader,
+                          ProcessLeader& process_leader,
                           KernelLogPipeProvider& kernel_log_pipe_provider,
                           const vm_manager::VmManager& vm_manager,
                           const CuttlefishConfig::InstanceSpecific& instance))
@@ -717,7 +739,7 @@ class CvdBootStateMachine : public SetupFeature, public KernelLogPipeConsumer {
   }
 
   const CuttlefishConfig& config_;
-  AutoSetup<ProcessLeader>::Type& process_leader_;
+  ProcessLeader& process_leader_;
   KernelLogPipeProvider& kernel_log_pipe_provider_;
   const vm_manager::VmManager& vm_manager_;
   const CuttlefishConfig::InstanceSpecific instance_;
@@ -749,7 +771,7 @@ bootStateMachineComponent() {
   return fruit::createComponent()
       .addMultibinding<KernelLogPipeConsumer, CvdBootStateMachine>()
       .addMultibinding<SetupFeature, CvdBootStateMachine>()
-      .install(AutoSetup<ProcessLeader>::Component);
+      .addMultibinding<SetupFeature, ProcessLeader>();
 }
 
 }  // namespace cuttlefish
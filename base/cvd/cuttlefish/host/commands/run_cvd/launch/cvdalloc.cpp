@@ -66,7 +66,12 @@ Result<std::vector<MonitorCommand>> Cvdalloc::Commands() {
   cmd.AddParameter("--id=", instance_.id());
   cmd.AddParameter("--socket=", their_socket_);
   std::vector<MonitorCommand> commands;
-  commands.emplace_back(std::move(cmd));
+  commands.emplace_back(std::move(cmd))
+      .Named(Name())
+      .ReadyWhen([this]() -> Result<void> {
+        CF_EXPECT(WaitForAvailability());
+        return {};
+      });
   return commands;
 }
 
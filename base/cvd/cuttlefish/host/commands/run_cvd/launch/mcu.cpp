@@ -81,7 +81,12 @@ class Mcu : public vm_manager::VmmDependencyCommand {
 
     std::vector<MonitorCommand> commands;
     commands.emplace_back(CF_EXPECT(log_tee_.CreateFullLogTee(command, "mcu")));
-    commands.emplace_back(std::move(command));
+    commands.emplace_back(std::move(command))
+        .Named(Name())
+        .ReadyWhen([this]() -> Result<void> {
+          CF_EXPECT(WaitForAvailability());
+          return {};
+        });
     return commands;
   }
 
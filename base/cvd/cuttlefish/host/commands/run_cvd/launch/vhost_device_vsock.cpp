@@ -59,6 +59,9 @@ class VhostDeviceVsock : public vm_manager::VmmDependencyCommand {
 
   Result<void> WaitForAvailability() override;
 
+  // VmmDependencyCommand
+  bool LaunchedHere() const override;
+
  private:
   std::unordered_set<SetupFeature*> Dependencies() const override { return {}; }
   Result<void> ResultSetup() override { return {}; }
@@ -74,8 +77,7 @@ VhostDeviceVsock::VhostDeviceVsock(
     : log_tee_(log_tee), instance_(instance), cfconfig_(cfconfig) {}
 
 Result<std::vector<MonitorCommand>> VhostDeviceVsock::Commands() {
-  auto instances = cfconfig_.Instances();
-  if (instance_.serial_number() != instances[0].serial_number()) {
+  if (!LaunchedHere()) {
     return {};
   }
 
@@ -106,7 +108,12 @@ Result<std::vector<MonitorCommand>> VhostDeviceVsock::Commands() {
   std::vector<MonitorCommand> commands;
   commands.emplace_back(
       CF_EXPECT(log_tee_.CreateFullLogTee(command, "vhost_device_vsock")));
-  commands.emplace_back(std::move(command));
+  commands.emplace_back(std::move(command))
+      .Named(Name())
+      .ReadyWhen([this]() -> Result<void> {
+        CF_EXPECT(WaitForAvailability());
+        return {};
+      });
   return commands;
 }
 
@@ -114,6 +121,12 @@ std::string VhostDeviceVsock::Name() const { return "VhostDeviceVsock"; }
 
 bool VhostDeviceVsock::Enabled() const { return instance_.vhost_user_vsock(); }
 
+// The launcher of the first instance serves every instance.
+bool VhostDeviceVsock::LaunchedHere() const {
+  return Enabled() && instance_.serial_number() ==
+                          cfconfig_.Instances()[0].serial_number();
+}
+
 Result<void> VhostDeviceVsock::WaitForAvailability() {
   if (Enabled()) {
     CF_EXPECT(WaitForUnixSocket(
@@ -79,18 +79,34 @@ Result<void> WebRtcController::SendStopRecordingCommand() {
 }
 
 Result<void> WebRtcController::SendScreenshotDisplayCommand(
-    int display_number, const std::string& screenshot_path) {
+    int display_number, const std::string& screenshot_path,
+    std::optional<int> compression_level, bool all_displays) {
   CF_EXPECT(command_channel_.has_value(), "Not initialized?");
   WebrtcCommandRequest request;
   auto* screenshot_request = request.mutable_screenshot_display_request();
   screenshot_request->set_display_number(display_number);
   screenshot_request->set_screenshot_path(screenshot_path);
+  if (compression_level.has_value()) {
+    screenshot_request->set_compression_level(*compression_level);
+  }
+  screenshot_request->set_all_displays(all_displays);
   WebrtcCommandResponse response =
       CF_EXPECT(command_channel_->SendCommand(request));
   CF_EXPECT(IsSuccess(response), "Failed to screenshot display.");
   return {};
 }
 
+Result<webrtc::DisplayStatsResponse>
+WebRtcController::SendDisplayStatsCommand() {
+  CF_EXPECT(command_channel_.has_value(), "Not initialized?");
+  WebrtcCommandRequest request;
+  request.mutable_display_stats_request();
+  WebrtcCommandResponse response =
+      CF_EXPECT(command_channel_->SendCommand(request));
+  CF_EXPECT(IsSuccess(response), "Failed to get the display stats.");
+  return response.display_stats();
+}
+
 fruit::Component<WebRtcController> WebRtcControllerComponent() {
   return fruit::createComponent()
       .addMultibinding<SetupFeature, WebRtcController>();
@@ -15,10 +15,14 @@
 
 #pragma once
 
+#include <optional>
+#include <string>
+
 #include "fruit/fruit.h"
 
 #include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/host/frontend/webrtc/webrtc_command_channel.h"
+#include "cuttlefish/host/frontend/webrtc/webrtc_commands.pb.h"
 #include "cuttlefish/host/libs/feature/feature.h"
 #include "cuttlefish/result/result.h"
 
@@ -33,8 +37,10 @@ class WebRtcController : public SetupFeature {
   SharedFD GetClientSocket() const;
   Result<void> SendStartRecordingCommand();
   Result<void> SendStopRecordingCommand();
-  Result<void> SendScreenshotDisplayCommand(int display_number,
-                                            const std::string& screenshot_path);
+  Result<void> SendScreenshotDisplayCommand(
+      int display_number, const std::string& screenshot_path,
+      std::optional<int> compression_level, bool all_displays);
+  Result<webrtc::DisplayStatsResponse> SendDisplayStatsCommand();
 
  protected:
   SharedFD client_socket_;
@@ -93,7 +93,12 @@ Result<std::vector<MonitorCommand>> WmediumdServer::Commands() {
 
   std::vector<MonitorCommand> commands;
   commands.emplace_back(CF_EXPECT(log_tee_.CreateFullLogTee(cmd, "wmediumd")));
-  commands.emplace_back(std::move(cmd));
+  commands.emplace_back(std::move(cmd))
+      .Named(Name())
+      .ReadyWhen([this]() -> Result<void> {
+        CF_EXPECT(WaitForAvailability());
+        return {};
+      });
   return commands;
 }
 
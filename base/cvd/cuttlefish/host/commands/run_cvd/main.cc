@@ -20,6 +20,7 @@
 
 #include <fstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "absl/log/log.h"
@@ -84,6 +85,9 @@
 #include "cuttlefish/host/libs/vm_manager/vm_manager.h"
 #include "cuttlefish/result/result.h"
 
+DEFINE_int32(setup_threads, 1,
+             "How many features are set up at once, 0 for one per core.");
+
 namespace cuttlefish {
 namespace {
 
@@ -126,7 +130,13 @@ class InstanceLifecycle : public LateInjected {
     // One of the setup features can consume most output, so print this early.
     DiagnosticInformation::PrintAll(diagnostics_);
 
-    CF_EXPECT(SetupFeature::RunSetup(setup_features_));
+    SetupFeatureOptions setup_options;
+    setup_options.max_threads = FLAGS_setup_threads > 0
+                                    ? FLAGS_setup_threads
+                                    : std::thread::hardware_concurrency();
+    setup_options.trace_path =
+        config_.ForDefaultInstance().PerInstanceLogPath(kLogNameSetupTrace);
+    CF_EXPECT(SetupFeature::RunSetup(setup_features_, setup_options));
 
     CF_EXPECT(server_loop_.Run());
 
@@ -28,8 +28,10 @@
 #include <utility>
 #include <vector>
 
+#include <json/json.h>
 #include "absl/log/check.h"
 #include "absl/log/log.h"
+#include "android-base/file.h"
 #include "fruit/injector.h"
 #include "gflags/gflags.h"
 
@@ -49,13 +51,32 @@
 #include "cuttlefish/host/libs/config/data_image.h"
 #include "cuttlefish/host/libs/config/vmm_mode.h"
 #include "cuttlefish/host/libs/feature/command_source.h"
+#include "cuttlefish/host/libs/log_names/log_names.h"
+#include "cuttlefish/host/libs/process_monitor/cgroup.h"
 #include "cuttlefish/host/libs/process_monitor/process_monitor.h"
 #include "cuttlefish/posix/strerror.h"
 #include "cuttlefish/result/result.h"
 
+DEFINE_bool(process_cgroups, false,
+            "Run each monitored host process in its own cgroup v2 leaf, for "
+            "resource accounting and limits. The cgroup of run_cvd must be "
+            "delegated, as with `systemd-run --user --scope -p Delegate=yes`.");
+DEFINE_string(process_limits, "",
+              "Limits of monitored host processes with --process_cgroups, as "
+              "<executable>:cpu=<cores>:memory=<MiB>, separated by commas.");
+
 namespace cuttlefish {
 namespace run_cvd_impl {
 
+Result<void> ServerLoopImpl::WriteProcessStatus(
+    ProcessMonitor& process_monitor) {
+  Json::Value status = CF_EXPECT(process_monitor.MonitoredProcessesStatus());
+  std::string path = instance_.PerInstanceLogPath(kLogNameProcessStatus);
+  CF_EXPECTF(android::base::WriteStringToFile(status.toStyledString(), path),
+             "Failed to write '{}': {}", path, StrError(errno));
+  return {};
+}
+
 bool ServerLoopImpl::CreateQcowOverlay(const std::string& crosvm_path,
                                        const std::string& backing_file,
                                        const std::string& output_overlay_path) {
@@ -97,6 +118,11 @@ Result<void> ServerLoopImpl::Run() {
       instance_.restart_subprocesses());
   process_monitor_properties.StraceLogDir(instance_.PerInstanceLogPath(""));
   process_monitor_properties.StraceCommands(config_.straced_host_executables());
+  if (FLAGS_process_cgroups) {
+    process_monitor_properties.CgroupName("cvd-" + instance_.id());
+    process_monitor_properties.Limits(
+        CF_EXPECT(ParseResourceLimits(FLAGS_process_limits)));
+  }
 
   for (auto& command_source : command_sources_) {
     if (command_source->Enabled()) {
@@ -219,6 +245,11 @@ Result<void> ServerLoopImpl::HandleExtended(
       CF_EXPECT(HandleScreenshotDisplay(request));
       return {};
     }
+    case ActionsCase::kDisplayStats: {
+      VLOG(0) << "Run_cvd received display stats request.";
+      CF_EXPECT(HandleDisplayStats());
+      return {};
+    }
     default:
       return CF_ERR("Unsupported ExtendedLauncherAction");
   }
@@ -256,6 +287,11 @@ void ServerLoopImpl::HandleActionWithNoData(const LauncherAction action,
     }
     case LauncherAction::kStatus: {
       // TODO(schuffelen): Return more information on a side channel
+      Result<void> process_status = WriteProcessStatus(process_monitor);
+      if (!process_status.ok()) {
+        LOG(WARNING) << "Failed to write the process status:\n"
+                     << process_status.error().FormatForEnv();
+      }
       auto response = LauncherResponse::kSuccess;
       client->Write(&response, sizeof(response));
       break;
@@ -73,11 +73,13 @@ class ServerLoopImpl : public ServerLoop,
                               ProcessMonitor& process_monitor);
   Result<void> HandleSuspend(ProcessMonitor& process_monitor);
   Result<void> HandleResume(ProcessMonitor& process_monitor);
+  Result<void> WriteProcessStatus(ProcessMonitor& process_monitor);
   Result<void> HandleSnapshotTake(const run_cvd::SnapshotTake& snapshot_take);
   Result<void> HandleStartScreenRecording();
   Result<void> HandleStopScreenRecording();
   Result<void> HandleScreenshotDisplay(
       const run_cvd::ScreenshotDisplay& request);
+  Result<void> HandleDisplayStats();
 
   void HandleActionWithNoData(const LauncherAction action,
                               const SharedFD& client,
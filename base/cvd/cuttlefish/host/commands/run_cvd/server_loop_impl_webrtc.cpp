@@ -16,9 +16,19 @@
 
 #include "cuttlefish/host/commands/run_cvd/server_loop_impl.h"
 
+#include <errno.h>
+
+#include <optional>
+#include <string>
+
+#include <android-base/file.h>
+#include <json/json.h>
 #include "absl/log/log.h"
 
+#include "cuttlefish/host/frontend/webrtc/webrtc_commands.pb.h"
 #include "cuttlefish/host/libs/command_util/runner/run_cvd.pb.h"
+#include "cuttlefish/host/libs/log_names/log_names.h"
+#include "cuttlefish/posix/strerror.h"
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
@@ -43,11 +53,44 @@ Result<void> ServerLoopImpl::HandleStopScreenRecording() {
 Result<void> ServerLoopImpl::HandleScreenshotDisplay(
     const cuttlefish::run_cvd::ScreenshotDisplay& request) {
   LOG(INFO) << "Sending the request to screenshot display to webrtc.";
+  std::optional<int> compression_level;
+  if (request.has_compression_level()) {
+    compression_level = request.compression_level();
+  }
   CF_EXPECT(webrtc_controller_.SendScreenshotDisplayCommand(
-                request.display_number(), request.screenshot_path()),
+                request.display_number(), request.screenshot_path(),
+                compression_level, request.all_displays()),
             "Failed to send start screenshot display command to webrtc.");
   return {};
 }
 
+Result<void> ServerLoopImpl::HandleDisplayStats() {
+  webrtc::DisplayStatsResponse stats =
+      CF_EXPECT(webrtc_controller_.SendDisplayStatsCommand(),
+                "Failed to get the display stats from webrtc.");
+  Json::Value displays(Json::arrayValue);
+  for (const webrtc::DisplayStats& stat : stats.displays()) {
+    Json::Value display;
+    display["display_number"] = stat.display_number();
+    display["frames"] = Json::UInt64(stat.frames());
+    display["total_latency_us"] = Json::Int64(stat.total_latency_us());
+    display["max_latency_us"] = Json::Int64(stat.max_latency_us());
+    Json::Value buckets(Json::arrayValue);
+    for (const webrtc::LatencyHistogramBucket& bucket :
+         stat.commit_to_encoder_latency()) {
+      Json::Value json_bucket;
+      json_bucket["upper_bound_us"] = Json::Int64(bucket.upper_bound_us());
+      json_bucket["count"] = Json::UInt64(bucket.count());
+      buckets.append(json_bucket);
+    }
+    display["commit_to_encoder_latency"] = buckets;
+    displays.append(display);
+  }
+  std::string path = instance_.PerInstanceLogPath(kLogNameDisplayStats);
+  CF_EXPECTF(android::base::WriteStringToFile(displays.toStyledString(), path),
+             "Failed to write '{}': {}", path, StrError(errno));
+  return {};
+}
+
 }  // namespace run_cvd_impl
 }  // namespace cuttlefish
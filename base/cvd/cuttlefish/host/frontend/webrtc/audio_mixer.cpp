@@ -1,7 +1,11 @@
 #include "cuttlefish/host/frontend/webrtc/audio_mixer.h"
 
 #include <algorithm>
+#include <array>
 #include <chrono>
+#include <cstring>
+#include <limits>
+#include <memory>
 #include <vector>
 #include "audio_settings.h"
 
@@ -44,101 +48,55 @@ inline size_t GetFramesCount(size_t buffer_size_bytes, uint8_t channels_count,
   return buffer_size_bits / (channels_count * bits_per_sample);
 }
 
-inline size_t GetFrameCountAfterResampling(uint32_t target_rate,
-                                           uint32_t source_rate,
-                                           size_t source_frames_count) {
-  if (target_rate == source_rate) {
-    return source_frames_count;
+template <class SRC>
+void ConvertToFloat(const uint8_t* src, float* dst, size_t samples_count) {
+  constexpr float kScale =
+      1.0f / (static_cast<float>(std::numeric_limits<SRC>::max()) + 1);
+  auto src_typed = reinterpret_cast<const SRC*>(src);
+  for (size_t i = 0; i < samples_count; ++i) {
+    dst[i] = src_typed[i] * kScale;
   }
-  return source_frames_count * target_rate / source_rate;
 }
 
-template <class DST, class SRC>
-size_t ConvertAudioStream(void* dst, uint8_t dst_channels, uint32_t dst_rate,
-                          const void* src, uint8_t src_channels,
-                          uint32_t src_rate, size_t src_frames_count,
-                          const std::vector<std::vector<float>>& channel_map) {
-  constexpr uint8_t kMaxChannelsCount =
-      GetChannelsCount(AudioChannelsLayout::Surround51);
-
-  CHECK(src_channels <= kMaxChannelsCount);
-  CHECK(channel_map.size() >= dst_channels);
-  CHECK(std::all_of(channel_map.cbegin(), channel_map.cbegin() + dst_channels,
-                    [src_channels](const std::vector<float>& v) {
-                      return v.size() >= src_channels;
-                    }));
-
-  std::array<SRC, kMaxChannelsCount> src_frame_resampled = {};
-
-  const auto factor = static_cast<double>(dst_rate) / src_rate;
-  const auto dst_frames_count =
-      GetFrameCountAfterResampling(dst_rate, src_rate, src_frames_count);
+using ConvertToFloatFn = void(const uint8_t*, float*, size_t);
+// Indexed by the sample size in bytes. 0-byte and 3-bytes samples are not
+// supported.
+constexpr std::array<ConvertToFloatFn*, 5> kConvertToFloatFunctionMap = {
+    nullptr, ConvertToFloat<int8_t>, ConvertToFloat<int16_t>, nullptr,
+    ConvertToFloat<int32_t>};
 
-  auto dst_typed = reinterpret_cast<DST*>(dst);
-  auto src_typed = reinterpret_cast<const SRC*>(src);
+inline int16_t MixSample(int16_t mixed, float sample, float scale) {
+  return static_cast<int16_t>(std::clamp(mixed + sample * scale,
+                                         float{INT16_MIN}, float{INT16_MAX}));
+}
 
-  for (size_t frame_id = 0; frame_id < dst_frames_count; ++frame_id) {
-    const double src_frame_idx_float = frame_id / factor;
-    const size_t src_frame_idx_1 = static_cast<size_t>(src_frame_idx_float);
-    const size_t src_frame_idx_2 =
-        std::min(src_frame_idx_1 + 1, src_frames_count - 1);
-    const float fraction = src_frame_idx_float - src_frame_idx_1;
-
-    // Resample a single frame
-    for (size_t c = 0; c < src_channels; ++c) {
-      const auto sample1 = src_typed[src_frame_idx_1 * src_channels + c];
-      const auto sample2 = src_typed[src_frame_idx_2 * src_channels + c];
-      src_frame_resampled[c] =
-          static_cast<SRC>(sample1 + (sample2 - sample1) * fraction);
+// Adds every channel of the source frames, scaled by the volume, to the same
+// channel of the destination frames, when the destination has it.
+void MixFrames(int16_t* dst, uint8_t dst_channels, const float* src,
+               uint8_t src_channels, size_t frames_count, float volume) {
+  const float scale = volume * (INT16_MAX + 1);
+  if (dst_channels == src_channels) {
+    // Vectorized by the compiler.
+    for (size_t i = 0; i < frames_count * dst_channels; ++i) {
+      dst[i] = MixSample(dst[i], src[i], scale);
     }
-
-    // Mix and apply channel mapping
-    const auto dst_frame_begin = frame_id * dst_channels;
-    for (auto i = 0; i < dst_channels; ++i) {
-      for (auto j = 0; j < src_channels; ++j) {
-        const int64_t value =
-            static_cast<int64_t>(dst_typed[dst_frame_begin + i]) +
-            src_frame_resampled[j] * channel_map[i][j];
-        dst_typed[dst_frame_begin + i] = static_cast<DST>(
-            std::clamp<int64_t>(value, std::numeric_limits<DST>::min(),
-                                std::numeric_limits<DST>::max()));
-      }
+    return;
+  }
+  const uint8_t channels = std::min(dst_channels, src_channels);
+  for (size_t frame_id = 0; frame_id < frames_count; ++frame_id) {
+    for (uint8_t c = 0; c < channels; ++c) {
+      int16_t& mixed = dst[frame_id * dst_channels + c];
+      mixed = MixSample(mixed, src[frame_id * src_channels + c], scale);
     }
   }
-  return dst_frames_count;
 }
-
-using ConvertAudioStreamFn = size_t(void*, uint8_t, uint32_t, const void*,
-                                    uint8_t, uint32_t, size_t,
-                                    const std::vector<std::vector<float>>&);
-/*
- * The kConvertAudioStreamFunctionMap variable is a 2D array of function
- * pointers for converting between different audio sample formats. The rows are
- * indexed by the destination format's size in bytes per sample, while the
- * columns are indexed by the source format's size. This provides an efficient
- * way to look up the correct conversion function based on the source and
- * destination audio formats.
- * 0-byte and 3-bytes samples are not supported.
- */
-constexpr std::array<std::array<ConvertAudioStreamFn*, 5>, 5>
-    kConvertAudioStreamFunctionMap = {
-        {{nullptr, nullptr, nullptr, nullptr, nullptr},
-         {nullptr, ConvertAudioStream<int8_t, int8_t>,
-          ConvertAudioStream<int8_t, int16_t>, nullptr,
-          ConvertAudioStream<int8_t, int32_t>},
-         {nullptr, ConvertAudioStream<int16_t, int8_t>,
-          ConvertAudioStream<int16_t, int16_t>, nullptr,
-          ConvertAudioStream<int16_t, int32_t>},
-         {nullptr, nullptr, nullptr, nullptr, nullptr},
-         {nullptr, ConvertAudioStream<int32_t, int8_t>,
-          ConvertAudioStream<int32_t, int16_t>, nullptr,
-          ConvertAudioStream<int32_t, int32_t>}}};
 }  // namespace
 
 AudioMixer::AudioMixer(std::shared_ptr<webrtc_streaming::AudioSink> audio_sink,
                        const AudioMixerSettings& settings)
     : channels_count_(GetChannelsCount(settings.channels_layout)),
       sample_rate_(settings.sample_rate),
+      resampler_quality_(settings.resampler_quality),
       audio_sink_(std::move(audio_sink)),
       mixed_buffer_(chunk_frames_count_ * frame_size_bytes_) {}
 
@@ -158,7 +116,7 @@ void AudioMixer::Stop() {
 
 void AudioMixer::OnStreamStopped(uint32_t stream_id) {
   std::lock_guard<std::mutex> lock(mutex_);
-  next_frame_.erase(stream_id);
+  streams_.erase(stream_id);
 }
 
 void AudioMixer::OnPlayback(uint32_t stream_id, uint32_t stream_sample_rate,
@@ -167,21 +125,39 @@ void AudioMixer::OnPlayback(uint32_t stream_id, uint32_t stream_sample_rate,
                             const uint8_t* buffer, size_t size) {
   const auto stream_frames_count =
       GetFramesCount(size, stream_channels_count, stream_bits_per_channel);
-  const auto frames_count = GetFrameCountAfterResampling(
-      sample_rate_, stream_sample_rate, stream_frames_count);
+  const auto stream_sample_size_bytes = stream_bits_per_channel / 8;
+  CHECK(stream_sample_size_bytes < kConvertToFloatFunctionMap.size() &&
+        kConvertToFloatFunctionMap[stream_sample_size_bytes])
+      << "Format is not supported";
 
   std::unique_lock<std::mutex> lock(mutex_);
 
-  // As of now we only use direct channel mapping
-  for(size_t i = 0; i < channles_map.size(); ++i) {
-    channles_map[i][i] = volume;
+  const bool need_notify = streams_.empty();  // no active streams
+
+  // If stream was not active it will start from the next 10ms bucket
+  auto [it, inserted] = streams_.try_emplace(stream_id);
+  StreamState& stream = it->second;
+  if (inserted || stream.sample_rate != stream_sample_rate ||
+      stream.channels_count != stream_channels_count) {
+    stream.sample_rate = stream_sample_rate;
+    stream.channels_count = stream_channels_count;
+    stream.resampler = std::make_unique<AudioResampler>(
+        stream_sample_rate, sample_rate_, stream_channels_count,
+        resampler_quality_);
   }
 
-  const bool need_notify = next_frame_.empty();  // no active streams
+  // The whole period is converted, resampled and mixed in turn, each step in
+  // a single pass over buffers kept from the previous periods.
+  stream.samples.resize(stream_frames_count * stream_channels_count);
+  kConvertToFloatFunctionMap[stream_sample_size_bytes](
+      buffer, stream.samples.data(), stream.samples.size());
+  stream.resampled.resize(
+      stream.resampler->MaxOutputFrames(stream_frames_count) *
+      stream_channels_count);
+  const auto frames_count = stream.resampler->Process(
+      stream.samples.data(), stream_frames_count, stream.resampled.data());
 
-  const auto it = next_frame_.find(stream_id);
-  // If stream was not active it will start from the next 10ms bucket
-  const auto next_frame_id = it == next_frame_.end() ? 0 : it->second;
+  const auto next_frame_id = stream.next_frame;
 
   // Resize the buffer to fit extra frames_count samples
   const auto buffer_size = mixed_buffer_.size();
@@ -196,20 +172,14 @@ void AudioMixer::OnPlayback(uint32_t stream_id, uint32_t stream_sample_rate,
               0);
   }
 
-  const auto stream_sample_size_bytes = stream_bits_per_channel / 8;
-  const auto convert_fn =
-      kConvertAudioStreamFunctionMap[sample_size_bytes_]
-                                    [stream_sample_size_bytes];
-  CHECK(convert_fn) << "Format is not supported";
-  const auto filled_frames_count =
-      convert_fn(mixed_buffer_.data() + next_frame_id * frame_size_bytes_,
-                 channels_count_, sample_rate_, buffer, stream_channels_count,
-                 stream_sample_rate, stream_frames_count, channles_map);
-  CHECK(filled_frames_count <= frames_count);
-
-  next_frame_[stream_id] = next_frame_id + filled_frames_count;
+  MixFrames(reinterpret_cast<int16_t*>(mixed_buffer_.data() +
+                                       next_frame_id * frame_size_bytes_),
+            channels_count_, stream.resampled.data(), stream_channels_count,
+            frames_count, volume);
+
+  stream.next_frame = next_frame_id + frames_count;
   last_active_frame_ =
-      std::max(last_active_frame_, next_frame_id + filled_frames_count);
+      std::max(last_active_frame_, next_frame_id + frames_count);
 
   if (need_notify) {
     lock.unlock();
@@ -230,10 +200,10 @@ void AudioMixer::MixerLoop() {
       continue;
     }
 
-    if (next_frame_.empty() && last_active_frame_ == 0) {
+    if (streams_.empty() && last_active_frame_ == 0) {
       // No active streams and nothing to play, block until there is
       mixer_cv_.wait(
-          lock, [&]() { return !next_frame_.empty() || stop_mixer_.load(); });
+          lock, [&]() { return !streams_.empty() || stop_mixer_.load(); });
       if (stop_mixer_.load()) {
         return;
       }
@@ -259,11 +229,11 @@ void AudioMixer::MixerLoop() {
     next_frame_time += kInterval;
 
     // Frame
-    for (auto& [id, frame] : next_frame_) {
-      if (frame > chunk_frames_count_) {
-        frame -= chunk_frames_count_;
+    for (auto& [id, stream] : streams_) {
+      if (stream.next_frame > chunk_frames_count_) {
+        stream.next_frame -= chunk_frames_count_;
       } else {
-        frame = 0;
+        stream.next_frame = 0;
       }
     }
     last_active_frame_ = last_active_frame_ > chunk_frames_count_
@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "cuttlefish/host/frontend/webrtc/libdevice/audio_sink.h"
+#include "cuttlefish/host/frontend/webrtc/audio_resampler.h"
 #include "cuttlefish/host/frontend/webrtc/audio_settings.h"
 
 namespace cuttlefish {
@@ -31,6 +32,17 @@ class AudioMixer {
   void OnStreamStopped(uint32_t stream_id);
 
  private:
+  struct StreamState {
+    // Frame index to put next available data to
+    size_t next_frame = 0;
+    uint32_t sample_rate = 0;
+    uint8_t channels_count = 0;
+    std::unique_ptr<AudioResampler> resampler;
+    // Reused for every period of the stream.
+    std::vector<float> samples;
+    std::vector<float> resampled;
+  };
+
   // The main mixing loop that runs on its own thread.
   void MixerLoop();
 
@@ -40,6 +52,7 @@ class AudioMixer {
   const size_t frame_size_bytes_ = sample_size_bytes_ * channels_count_;
   // Frames count for 10ms at mixer's sample rate
   const size_t chunk_frames_count_ = sample_rate_ / 100;
+  const AudioResamplerQuality resampler_quality_;
 
   std::shared_ptr<webrtc_streaming::AudioSink> audio_sink_;
 
@@ -55,18 +68,7 @@ class AudioMixer {
   // Index of the last frame with available (i.e. not yet played) audio data
   size_t last_active_frame_ = 0;
 
-  // Frame index per stream to put next available data to
-  std::unordered_map<uint32_t, size_t> next_frame_;
-
-  // Used to remap channels and apply volume levels
-  std::vector<std::vector<float>> channles_map = {{
-      {1, 0, 0, 0, 0, 0},
-      {0, 1, 0, 0, 0, 0},
-      {0, 0, 1, 0, 0, 0},
-      {0, 0, 0, 1, 0, 0},
-      {0, 0, 0, 0, 1, 0},
-      {0, 0, 0, 0, 0, 1},
-  }};
+  std::unordered_map<uint32_t, StreamState> streams_;
 
   ////////////////////////////////////////////////////
   ////////////////////////////////////////////////////
@@ -0,0 +1,317 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/frontend/webrtc/audio_resampler.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace cuttlefish {
+namespace {
+
+// Filter length when upsampling. When downsampling the cutoff is lower and the
+// filter longer by the same ratio, to keep the transition band as sharp.
+constexpr size_t kBaseTaps = 32;
+constexpr size_t kMaxTaps = 128;
+// The vector kernels process the taps 8 at a time.
+constexpr size_t kTapsAlignment = 8;
+// Cutoff relative to the lower of the two Nyquist frequencies, the rest is
+// left for the transition band.
+constexpr double kCutoff = 0.92;
+// About 80dB of stopband attenuation.
+constexpr double kKaiserBeta = 8.0;
+
+double BesselI0(double x) {
+  double sum = 1;
+  double term = 1;
+  for (int k = 1; k < 32; k++) {
+    term *= (x / (2 * k)) * (x / (2 * k));
+    sum += term;
+  }
+  return sum;
+}
+
+// Computes the output frames starting at the given input frames with the
+// given phases, and writes them to every out_stride floats of out.
+using FilterKernel = void (*)(const float* input, const float* coefficients,
+                              size_t taps, const uint32_t* inputs,
+                              const uint32_t* phases, size_t num_steps,
+                              float* out, size_t out_stride);
+
+void FilterScalar(const float* input, const float* coefficients, size_t taps,
+                  const uint32_t* inputs, const uint32_t* phases,
+                  size_t num_steps, float* out, size_t out_stride) {
+  for (size_t s = 0; s < num_steps; s++) {
+    const float* x = input + inputs[s];
+    const float* c = coefficients + phases[s] * taps;
+    float sum = 0;
+    for (size_t j = 0; j < taps; j++) {
+      sum += x[j] * c[j];
+    }
+    out[s * out_stride] = sum;
+  }
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("avx2,fma"))) void FilterAvx2(
+    const float* input, const float* coefficients, size_t taps,
+    const uint32_t* inputs, const uint32_t* phases, size_t num_steps,
+    float* out, size_t out_stride) {
+  for (size_t s = 0; s < num_steps; s++) {
+    const float* x = input + inputs[s];
+    const float* c = coefficients + phases[s] * taps;
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t j = 0;
+    for (; j + 16 <= taps; j += 16) {
+      acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + j), _mm256_loadu_ps(c + j),
+                             acc0);
+      acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + j + 8),
+                             _mm256_loadu_ps(c + j + 8), acc1);
+    }
+    if (j < taps) {
+      acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + j), _mm256_loadu_ps(c + j),
+                             acc0);
+    }
+    const __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc),
+                            _mm256_extractf128_ps(acc, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    out[s * out_stride] = _mm_cvtss_f32(sum);
+  }
+}
+
+__attribute__((target("sse2"))) void FilterSse2(
+    const float* input, const float* coefficients, size_t taps,
+    const uint32_t* inputs, const uint32_t* phases, size_t num_steps,
+    float* out, size_t out_stride) {
+  for (size_t s = 0; s < num_steps; s++) {
+    const float* x = input + inputs[s];
+    const float* c = coefficients + phases[s] * taps;
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (size_t j = 0; j < taps; j += 8) {
+      acc0 = _mm_add_ps(acc0,
+                        _mm_mul_ps(_mm_loadu_ps(x + j), _mm_loadu_ps(c + j)));
+      acc1 = _mm_add_ps(
+          acc1, _mm_mul_ps(_mm_loadu_ps(x + j + 4), _mm_loadu_ps(c + j + 4)));
+    }
+    __m128 sum = _mm_add_ps(acc0, acc1);
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    out[s * out_stride] = _mm_cvtss_f32(sum);
+  }
+}
+
+#elif defined(__aarch64__)
+
+void FilterNeon(const float* input, const float* coefficients, size_t taps,
+                const uint32_t* inputs, const uint32_t* phases,
+                size_t num_steps, float* out, size_t out_stride) {
+  for (size_t s = 0; s < num_steps; s++) {
+    const float* x = input + inputs[s];
+    const float* c = coefficients + phases[s] * taps;
+    float32x4_t acc0 = vdupq_n_f32(0);
+    float32x4_t acc1 = vdupq_n_f32(0);
+    for (size_t j = 0; j < taps; j += 8) {
+      acc0 = vfmaq_f32(acc0, vld1q_f32(x + j), vld1q_f32(c + j));
+      acc1 = vfmaq_f32(acc1, vld1q_f32(x + j + 4), vld1q_f32(c + j + 4));
+    }
+    out[s * out_stride] = vaddvq_f32(vaddq_f32(acc0, acc1));
+  }
+}
+
+#endif
+
+FilterKernel SelectFilterKernel() {
+#if defined(__x86_64__) || defined(__i386__)
+  // Whether the CPU features are initialized yet depends on the order of the
+  // static initializers.
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return FilterAvx2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return FilterSse2;
+  }
+#elif defined(__aarch64__)
+  return FilterNeon;
+#endif
+  return FilterScalar;
+}
+
+FilterKernel GetFilterKernel() {
+  static const FilterKernel kernel = SelectFilterKernel();
+  return kernel;
+}
+
+std::shared_ptr<const std::vector<float>> ComputeCoefficients(uint32_t up,
+                                                              uint32_t down,
+                                                              size_t taps) {
+  auto coefficients =
+      std::make_shared<std::vector<float>>(static_cast<size_t>(up) * taps);
+  const double cutoff = kCutoff * std::min(1.0, static_cast<double>(up) / down);
+  const double half_length = taps / 2.0;
+  for (uint32_t phase = 0; phase < up; phase++) {
+    float* c = &(*coefficients)[phase * taps];
+    double sum = 0;
+    for (size_t j = 0; j < taps; j++) {
+      // Distance in input frames from the output frame to the tap.
+      const double t = static_cast<double>(taps / 2 - 1) -
+                       static_cast<double>(j) +
+                       static_cast<double>(phase) / up;
+      const double w = t / half_length;
+      const double window =
+          std::abs(w) < 1 ? BesselI0(kKaiserBeta * std::sqrt(1 - w * w)) /
+                                BesselI0(kKaiserBeta)
+                          : 0;
+      const double x = M_PI * cutoff * t;
+      const double sinc = t == 0 ? 1 : std::sin(x) / x;
+      c[j] = sinc * window;
+      sum += c[j];
+    }
+    // Unity gain at DC for every phase.
+    for (size_t j = 0; j < taps; j++) {
+      c[j] /= sum;
+    }
+  }
+  return coefficients;
+}
+
+std::shared_ptr<const std::vector<float>> GetCoefficients(uint32_t up,
+                                                          uint32_t down,
+                                                          size_t taps) {
+  static std::mutex mutex;
+  static std::map<std::pair<uint32_t, uint32_t>,
+                  std::shared_ptr<const std::vector<float>>>
+      cache;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& coefficients = cache[{up, down}];
+  if (!coefficients) {
+    coefficients = ComputeCoefficients(up, down, taps);
+  }
+  return coefficients;
+}
+
+}  // namespace
+
+AudioResampler::AudioResampler(uint32_t src_rate, uint32_t dst_rate,
+                               size_t channels, AudioResamplerQuality quality)
+    : channels_(channels), history_(channels) {
+  const uint32_t divisor = std::gcd(src_rate, dst_rate);
+  up_ = dst_rate / divisor;
+  down_ = src_rate / divisor;
+  if (quality == AudioResamplerQuality::Polyphase && up_ <= kMaxPhases &&
+      up_ != down_) {
+    size_t taps = kBaseTaps;
+    if (down_ > up_) {
+      taps = std::min<size_t>(kMaxTaps, kBaseTaps * down_ / up_);
+    }
+    taps_ = (taps + kTapsAlignment - 1) / kTapsAlignment * kTapsAlignment;
+
+    coefficients_ = GetCoefficients(up_, down_, taps_);
+    // The first output frame is centered on the first input frame.
+    history_frames_ = taps_ / 2 - 1;
+  } else {
+    // Linear interpolation needs 2 input frames, but keeps as many as it
+    // skips per output frame so that the next one is always in the history.
+    taps_ = std::max<size_t>(2, (down_ + up_ - 1) / up_ + 1);
+  }
+  for (std::vector<float>& history : history_) {
+    history.resize(history_frames_);
+  }
+}
+
+AudioResampler::~AudioResampler() = default;
+
+size_t AudioResampler::MaxOutputFrames(size_t src_frames) const {
+  const uint64_t available = history_frames_ + src_frames;
+  return available * up_ / down_ + 1;
+}
+
+size_t AudioResampler::Process(const float* src, size_t src_frames,
+                               float* dst) {
+  if (up_ == down_) {
+    std::copy(src, src + src_frames * channels_, dst);
+    return src_frames;
+  }
+
+  const size_t available = history_frames_ + src_frames;
+  for (size_t c = 0; c < channels_; c++) {
+    std::vector<float>& history = history_[c];
+    history.resize(available);
+    for (size_t i = 0; i < src_frames; i++) {
+      history[history_frames_ + i] = src[i * channels_ + c];
+    }
+  }
+
+  // The same steps apply to all the channels.
+  step_inputs_.clear();
+  step_phases_.clear();
+  size_t input = 0;
+  uint32_t phase = phase_;
+  while (input + taps_ <= available) {
+    step_inputs_.push_back(input);
+    step_phases_.push_back(phase);
+    phase += down_;
+    input += phase / up_;
+    phase %= up_;
+  }
+  const size_t num_steps = step_inputs_.size();
+
+  const FilterKernel filter_kernel = GetFilterKernel();
+  for (size_t c = 0; c < channels_; c++) {
+    const float* history = history_[c].data();
+    if (coefficients_) {
+      filter_kernel(history, coefficients_->data(), taps_,
+                    step_inputs_.data(), step_phases_.data(), num_steps,
+                    dst + c, channels_);
+    } else {
+      for (size_t s = 0; s < num_steps; s++) {
+        const float* x = history + step_inputs_[s];
+        const float fraction = static_cast<float>(step_phases_[s]) / up_;
+        dst[s * channels_ + c] = x[0] + (x[1] - x[0]) * fraction;
+      }
+    }
+  }
+
+  // Drop the input frames before the next output frame's first tap.
+  for (std::vector<float>& history : history_) {
+    history.erase(history.begin(), history.begin() + input);
+  }
+  history_frames_ = available - input;
+  phase_ = phase;
+  return num_steps;
+}
+
+}  // namespace cuttlefish
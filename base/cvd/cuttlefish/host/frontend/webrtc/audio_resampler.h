@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "cuttlefish/host/frontend/webrtc/audio_settings.h"
+
+namespace cuttlefish {
+
+/**
+ * Converts the sample rate of an interleaved float audio stream, period by
+ * period. The state is kept between calls, so consecutive periods join without
+ * discontinuities and no frames are lost to rounding.
+ *
+ * The polyphase filter is a Kaiser windowed sinc with one set of coefficients
+ * per output phase. The rates' ratio must reduce to at most kMaxPhases phases,
+ * which holds for all the common rates; other rate pairs fall back to linear
+ * interpolation. The coefficients are computed once per rate pair and shared
+ * by all the resamplers.
+ */
+class AudioResampler {
+ public:
+  static constexpr uint32_t kMaxPhases = 1024;
+
+  AudioResampler(uint32_t src_rate, uint32_t dst_rate, size_t channels,
+                 AudioResamplerQuality quality);
+  ~AudioResampler();
+
+  // Upper bound of the frames the next Process() call produces from the given
+  // number of input frames.
+  size_t MaxOutputFrames(size_t src_frames) const;
+
+  // Resamples src_frames interleaved frames into dst, which must have room for
+  // MaxOutputFrames(src_frames) frames. Returns the number of frames written.
+  size_t Process(const float* src, size_t src_frames, float* dst);
+
+ private:
+  const size_t channels_;
+  // The output frames are at every down_ / up_ input frames.
+  uint32_t up_;
+  uint32_t down_;
+  // Input frames needed for an output frame.
+  size_t taps_;
+  // The taps_ coefficients of each of the up_ phases, or null for linear
+  // interpolation.
+  std::shared_ptr<const std::vector<float>> coefficients_;
+  // Per channel, the input frames not fully consumed yet.
+  std::vector<std::vector<float>> history_;
+  size_t history_frames_ = 0;
+  uint32_t phase_ = 0;
+  // For each output frame of the current period, its first input frame in
+  // history_ and its phase.
+  std::vector<uint32_t> step_inputs_;
+  std::vector<uint32_t> step_phases_;
+};
+
+}  // namespace cuttlefish
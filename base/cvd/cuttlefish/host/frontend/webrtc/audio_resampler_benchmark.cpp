@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the resampler throughput on stereo 10ms periods, and its quality:
+// snr_db compares a resampled 1kHz tone with the ideal one, alias_db is the
+// level left of a tone above the output's Nyquist frequency when downsampling.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmath>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "cuttlefish/host/frontend/webrtc/audio_resampler.h"
+#include "cuttlefish/host/frontend/webrtc/audio_settings.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr size_t kChannels = 2;
+// Skips the start of the output, where the filter sees silence before the
+// tone.
+constexpr size_t kSettleFrames = 256;
+
+std::vector<float> Tone(double frequency, uint32_t rate, size_t offset,
+                        size_t frames) {
+  std::vector<float> samples(frames * kChannels);
+  for (size_t i = 0; i < frames; i++) {
+    const float value =
+        0.5 * std::sin(2 * M_PI * frequency * (offset + i) / rate);
+    for (size_t c = 0; c < kChannels; c++) {
+      samples[i * kChannels + c] = value;
+    }
+  }
+  return samples;
+}
+
+// Resamples a second of the tone, in 10ms periods.
+std::vector<float> ResampleTone(double frequency, uint32_t src_rate,
+                                uint32_t dst_rate,
+                                AudioResamplerQuality quality) {
+  AudioResampler resampler(src_rate, dst_rate, kChannels, quality);
+  const size_t period = src_rate / 100;
+  std::vector<float> output;
+  size_t output_frames = 0;
+  for (size_t offset = 0; offset < src_rate; offset += period) {
+    std::vector<float> input = Tone(frequency, src_rate, offset, period);
+    output.resize((output_frames + resampler.MaxOutputFrames(period)) *
+                  kChannels);
+    output_frames += resampler.Process(
+        input.data(), period, output.data() + output_frames * kChannels);
+  }
+  output.resize(output_frames * kChannels);
+  return output;
+}
+
+double SnrDb(uint32_t src_rate, uint32_t dst_rate,
+             AudioResamplerQuality quality) {
+  constexpr double kFrequency = 1000;
+  std::vector<float> output =
+      ResampleTone(kFrequency, src_rate, dst_rate, quality);
+  std::vector<float> ideal =
+      Tone(kFrequency, dst_rate, 0, output.size() / kChannels);
+  double signal = 0;
+  double noise = 0;
+  for (size_t i = kSettleFrames * kChannels; i < output.size(); i++) {
+    signal += ideal[i] * ideal[i];
+    noise += (output[i] - ideal[i]) * (output[i] - ideal[i]);
+  }
+  return 10 * std::log10(signal / noise);
+}
+
+double AliasDb(uint32_t src_rate, uint32_t dst_rate,
+               AudioResamplerQuality quality) {
+  // Between the two Nyquist frequencies, and not a multiple of the output
+  // rate's submultiples, where the aliases would be sampled at their zeros.
+  const double frequency = dst_rate / 2.0 + (src_rate - dst_rate) * 0.15;
+  std::vector<float> output =
+      ResampleTone(frequency, src_rate, dst_rate, quality);
+  double energy = 0;
+  for (size_t i = kSettleFrames * kChannels; i < output.size(); i++) {
+    energy += output[i] * output[i];
+  }
+  // Relative to the tone's energy, 0.5 ^ 2 / 2 per sample.
+  const double samples = output.size() - kSettleFrames * kChannels;
+  return 10 * std::log10(energy / samples / 0.125);
+}
+
+void BM_Resample(benchmark::State& state, uint32_t src_rate,
+                 uint32_t dst_rate, AudioResamplerQuality quality) {
+  const size_t period = src_rate / 100;
+  std::vector<float> input = Tone(1000, src_rate, 0, period);
+  std::vector<float> output;
+  AudioResampler resampler(src_rate, dst_rate, kChannels, quality);
+  for (auto _ : state) {
+    output.resize(resampler.MaxOutputFrames(period) * kChannels);
+    benchmark::DoNotOptimize(
+        resampler.Process(input.data(), period, output.data()));
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * period);
+  state.counters["snr_db"] = SnrDb(src_rate, dst_rate, quality);
+  if (dst_rate < src_rate) {
+    state.counters["alias_db"] = AliasDb(src_rate, dst_rate, quality);
+  }
+}
+
+#define RESAMPLE_BENCHMARKS(src_rate, dst_rate)                    \
+  BENCHMARK_CAPTURE(BM_Resample, polyphase_##src_rate##_##dst_rate, \
+                    src_rate, dst_rate,                              \
+                    AudioResamplerQuality::Polyphase);               \
+  BENCHMARK_CAPTURE(BM_Resample, linear_##src_rate##_##dst_rate,    \
+                    src_rate, dst_rate, AudioResamplerQuality::Linear)
+
+RESAMPLE_BENCHMARKS(44100, 48000);
+RESAMPLE_BENCHMARKS(16000, 48000);
+RESAMPLE_BENCHMARKS(48000, 44100);
+RESAMPLE_BENCHMARKS(48000, 16000);
+
+}  // namespace
+}  // namespace cuttlefish
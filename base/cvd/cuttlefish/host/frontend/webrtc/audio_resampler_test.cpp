@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/frontend/webrtc/audio_resampler.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "cuttlefish/host/frontend/webrtc/audio_settings.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr size_t kChannels = 2;
+
+// Stereo frames of a tone, the right channel in opposite phase.
+std::vector<float> Tone(double frequency, uint32_t rate, size_t frames) {
+  std::vector<float> samples(frames * kChannels);
+  for (size_t i = 0; i < frames; i++) {
+    const float value = 0.5 * std::sin(2 * M_PI * frequency * i / rate);
+    samples[i * kChannels] = value;
+    samples[i * kChannels + 1] = -value;
+  }
+  return samples;
+}
+
+// Resamples the frames in periods of the given sizes, repeated until the
+// input runs out.
+std::vector<float> Resample(AudioResampler& resampler,
+                            const std::vector<float>& input,
+                            const std::vector<size_t>& periods) {
+  std::vector<float> output;
+  const size_t frames = input.size() / kChannels;
+  size_t offset = 0;
+  for (size_t i = 0; offset < frames; i++) {
+    const size_t period =
+        std::min(periods[i % periods.size()], frames - offset);
+    const size_t written = output.size() / kChannels;
+    output.resize((written + resampler.MaxOutputFrames(period)) * kChannels);
+    const size_t produced = resampler.Process(
+        &input[offset * kChannels], period, &output[written * kChannels]);
+    output.resize((written + produced) * kChannels);
+    offset += period;
+  }
+  return output;
+}
+
+// The largest difference between the output and the tone at the output rate,
+// away from the start and the end where the filter sees silence.
+double MaxToneError(const std::vector<float>& output, double frequency,
+                    uint32_t rate) {
+  const size_t frames = output.size() / kChannels;
+  const std::vector<float> expected = Tone(frequency, rate, frames);
+  const size_t margin = 256;
+  double max_error = 0;
+  for (size_t i = margin * kChannels; i + margin * kChannels < output.size();
+       i++) {
+    max_error = std::max<double>(max_error, std::abs(output[i] - expected[i]));
+  }
+  return max_error;
+}
+
+TEST(AudioResamplerTest, SameRateCopies) {
+  AudioResampler resampler(48000, 48000, kChannels,
+                           AudioResamplerQuality::Polyphase);
+  const std::vector<float> input = Tone(1000, 48000, 480);
+
+  EXPECT_EQ(Resample(resampler, input, {480}), input);
+}
+
+TEST(AudioResamplerTest, Upsamples44100To48000) {
+  AudioResampler resampler(44100, 48000, kChannels,
+                           AudioResamplerQuality::Polyphase);
+  const std::vector<float> input = Tone(1000, 44100, 44100);
+
+  const std::vector<float> output = Resample(resampler, input, {441});
+
+  // A second of input, minus the frames the filter still waits for.
+  EXPECT_NEAR(output.size() / kChannels, 48000, 32);
+  EXPECT_LT(MaxToneError(output, 1000, 48000), 1e-3);
+}
+
+TEST(AudioResamplerTest, Downsamples48000To16000) {
+  AudioResampler resampler(48000, 16000, kChannels,
+                           AudioResamplerQuality::Polyphase);
+  const std::vector<float> input = Tone(1000, 48000, 48000);
+
+  const std::vector<float> output = Resample(resampler, input, {480});
+
+  EXPECT_NEAR(output.size() / kChannels, 16000, 32);
+  EXPECT_LT(MaxToneError(output, 1000, 16000), 1e-3);
+}
+
+TEST(AudioResamplerTest, FiltersOutFrequenciesAboveTheOutputNyquist) {
+  AudioResampler resampler(48000, 16000, kChannels,
+                           AudioResamplerQuality::Polyphase);
+  const std::vector<float> input = Tone(12000, 48000, 48000);
+
+  const std::vector<float> output = Resample(resampler, input, {480});
+
+  // The alias would be at 4kHz with the same amplitude.
+  EXPECT_LT(MaxToneError(output, 0, 16000), 1e-3);
+}
+
+TEST(AudioResamplerTest, LinearFollowsTheTone) {
+  AudioResampler resampler(44100, 48000, kChannels,
+                           AudioResamplerQuality::Linear);
+  const std::vector<float> input = Tone(1000, 44100, 44100);
+
+  const std::vector<float> output = Resample(resampler, input, {441});
+
+  EXPECT_NEAR(output.size() / kChannels, 48000, 2);
+  EXPECT_LT(MaxToneError(output, 1000, 48000), 1e-2);
+}
+
+class AudioResamplerPeriodsTest
+    : public ::testing::TestWithParam<AudioResamplerQuality> {};
+
+TEST_P(AudioResamplerPeriodsTest, PeriodBoundariesDontChangeTheOutput) {
+  const std::vector<float> input = Tone(1000, 44100, 4410);
+  for (const auto [src_rate, dst_rate] :
+       {std::pair{44100, 48000}, {48000, 16000}, {48000, 44100}}) {
+    AudioResampler whole(src_rate, dst_rate, kChannels, GetParam());
+    AudioResampler split(src_rate, dst_rate, kChannels, GetParam());
+
+    const std::vector<float> expected = Resample(whole, input, {4410});
+    const std::vector<float> output = Resample(split, input, {1, 7, 100, 0, 3});
+
+    EXPECT_EQ(output, expected) << src_rate << " to " << dst_rate;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Qualities, AudioResamplerPeriodsTest,
+                         ::testing::Values(AudioResamplerQuality::Polyphase,
+                                           AudioResamplerQuality::Linear));
+
+}  // namespace
+}  // namespace cuttlefish
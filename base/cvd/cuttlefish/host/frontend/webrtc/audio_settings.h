@@ -47,9 +47,17 @@ struct AudioStreamSettings {
   std::optional<VolumeControl> master_volume_control;
 };
 
+enum class AudioResamplerQuality {
+  // Windowed sinc polyphase filter.
+  Polyphase,
+  // Linear interpolation, cheaper but with audible aliasing.
+  Linear,
+};
+
 struct AudioMixerSettings {
   AudioChannelsLayout channels_layout = AudioChannelsLayout::Stereo;
   uint32_t sample_rate = 48000;
+  AudioResamplerQuality resampler_quality = AudioResamplerQuality::Polyphase;
 };
 
 static constexpr inline uint8_t GetChannelsCount(AudioChannelsLayout layout) {
@@ -137,6 +137,21 @@ class ConnectionObserverImpl : public webrtc_streaming::ConnectionObserver {
     return {};
   }
 
+  Result<void> OnMultiTouchEvent(
+      const std::string &device_label,
+      const std::vector<webrtc_streaming::TouchPoint> &points,
+      bool down) override {
+    std::vector<MultitouchSlot> slots(points.size());
+    for (size_t i = 0; i < points.size(); i++) {
+      slots[i].id = points[i].id;
+      slots[i].x = points[i].x;
+      slots[i].y = points[i].y;
+    }
+    CF_EXPECT(
+        input_events_sink_->SendMultiTouchEvent(device_label, slots, down));
+    return {};
+  }
+
   Result<void> OnKeyboardEvent(uint16_t code, bool down) override {
     CF_EXPECT(input_events_sink_->SendKeyboardEvent(code, down));
     return {};
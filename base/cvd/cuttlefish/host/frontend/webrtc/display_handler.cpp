@@ -16,22 +16,41 @@
 
 #include "cuttlefish/host/frontend/webrtc/display_handler.h"
 
-#include <libyuv.h>
+#include <stddef.h>
 #include <stdint.h>
 
+#include <algorithm>
 #include <chrono>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <utility>
 
 #include "absl/log/log.h"
-#include "drm/drm_fourcc.h"
 
+#include "cuttlefish/host/frontend/webrtc/incremental_i420_converter.h"
+#include "cuttlefish/host/frontend/webrtc/latency_histogram.h"
 #include "cuttlefish/host/frontend/webrtc/libdevice/streamer.h"
+#include "cuttlefish/host/frontend/webrtc/video_frame_pool.h"
 #include "cuttlefish/host/libs/screen_connector/composition_manager.h"
+#include "cuttlefish/host/libs/screen_connector/frame_damage.h"
 #include "cuttlefish/host/libs/screen_connector/video_frame_buffer.h"
 
 namespace cuttlefish {
+namespace {
+
+// The last frame is sent again so the encoder can refine its quality and
+// clients recover from losses. Both matter less the longer the screen stays
+// still, so the interval doubles with every repeat up to the maximum.
+constexpr std::chrono::milliseconds kMinRepeatingInterval(20);
+constexpr std::chrono::milliseconds kMaxRepeatingInterval(1000);
+constexpr int kMaxRepeatingBackoff = 6;
+// One composed frame held by the encoder and one to compose into.
+constexpr size_t kCompositionPoolSize = 2;
+
+}  // namespace
 
 DisplayHandler::DisplayHandler(
     webrtc_streaming::Streamer& streamer, ScreenshotHandler& screenshot_handler,
@@ -73,8 +92,13 @@ DisplayHandler::DisplayHandler(
             const auto display_number = e.display_number;
             const auto display_id =
                 "display_" + std::to_string(e.display_number);
+            {
+              std::lock_guard<std::mutex> lock(converters_mutex_);
+              converters_.erase(display_number);
+            }
             std::lock_guard<std::mutex> lock(send_mutex_);
             display_sinks_.erase(display_number);
+            composition_pools_.erase(display_number);
             streamer_.RemoveDisplay(display_id);
           } else {
             static_assert(false, "Unhandled display event.");
@@ -97,38 +121,40 @@ DisplayHandler::GenerateProcessedFrameCallback
 DisplayHandler::GetScreenConnectorCallback() {
   // only to tell the producer how to create a ProcessedFrame to cache into the
   // queue
-  auto& composition_manager = composition_manager_;
   DisplayHandler::GenerateProcessedFrameCallback callback =
-      [&composition_manager](
-          uint32_t display_number, uint32_t frame_width, uint32_t frame_height,
-          uint32_t frame_fourcc_format, uint32_t frame_stride_bytes,
-          uint8_t* frame_pixels, WebRtcScProcessedFrame& processed_frame) {
+      [this](uint32_t display_number, uint32_t frame_width,
+             uint32_t frame_height, uint32_t frame_fourcc_format,
+             uint32_t frame_stride_bytes, uint8_t* frame_pixels,
+             const FrameDamage& damage,
+             WebRtcScProcessedFrame& processed_frame) {
+        // Called from the Wayland surface commit.
+        processed_frame.commit_time_ = std::chrono::steady_clock::now();
         processed_frame.display_number_ = display_number;
-        processed_frame.buf_ =
-            std::make_unique<CvdVideoFrameBuffer>(frame_width, frame_height);
-        if (composition_manager.has_value()) {
-          composition_manager.value()->OnFrame(
+        // Blending overlays may change the frame outside the guest's damage.
+        FrameDamage frame_damage = damage;
+        if (composition_manager_.has_value()) {
+          frame_damage = composition_manager_.value()->OnFrame(
               display_number, frame_width, frame_height, frame_fourcc_format,
-              frame_stride_bytes, frame_pixels);
+              frame_stride_bytes, frame_pixels, damage);
         }
-        if (frame_fourcc_format == DRM_FORMAT_ARGB8888 ||
-            frame_fourcc_format == DRM_FORMAT_XRGB8888) {
-          libyuv::ARGBToI420(
-              frame_pixels, frame_stride_bytes, processed_frame.buf_->DataY(),
-              processed_frame.buf_->StrideY(), processed_frame.buf_->DataU(),
-              processed_frame.buf_->StrideU(), processed_frame.buf_->DataV(),
-              processed_frame.buf_->StrideV(), frame_width, frame_height);
-          processed_frame.is_success_ = true;
-        } else if (frame_fourcc_format == DRM_FORMAT_ABGR8888 ||
-                   frame_fourcc_format == DRM_FORMAT_XBGR8888) {
-          libyuv::ABGRToI420(
-              frame_pixels, frame_stride_bytes, processed_frame.buf_->DataY(),
-              processed_frame.buf_->StrideY(), processed_frame.buf_->DataU(),
-              processed_frame.buf_->StrideU(), processed_frame.buf_->DataV(),
-              processed_frame.buf_->StrideV(), frame_width, frame_height);
-          processed_frame.is_success_ = true;
-        } else {
-          processed_frame.is_success_ = false;
+        std::lock_guard<std::mutex> lock(converters_mutex_);
+        IncrementalI420Converter& converter = converters_[display_number];
+        switch (converter.Convert(frame_width, frame_height,
+                                  frame_fourcc_format, frame_stride_bytes,
+                                  frame_pixels, frame_damage)) {
+          case IncrementalI420Converter::Status::kChanged:
+            processed_frame.buf_ = converter.Frame();
+            processed_frame.is_success_ = true;
+            break;
+          case IncrementalI420Converter::Status::kUnchanged:
+            processed_frame.unchanged_ = true;
+            processed_frame.is_success_ = true;
+            break;
+          case IncrementalI420Converter::Status::kUnsupportedFormat:
+            processed_frame.buf_ = std::make_shared<CvdVideoFrameBuffer>(
+                frame_width, frame_height);
+            processed_frame.is_success_ = false;
+            break;
         }
       };
   return callback;
@@ -137,6 +163,10 @@ DisplayHandler::GetScreenConnectorCallback() {
 [[noreturn]] void DisplayHandler::Loop() {
   for (;;) {
     auto processed_frame = screen_connector_.OnNextFrame();
+    if (processed_frame.unchanged_) {
+      // The last buffer is still current, the repeater keeps sending it.
+      continue;
+    }
 
     std::shared_ptr<CvdVideoFrameBuffer> buffer =
         std::move(processed_frame.buf_);
@@ -150,12 +180,37 @@ DisplayHandler::GetScreenConnectorCallback() {
               .buffer = std::static_pointer_cast<VideoFrameBuffer>(buffer),
           });
     }
+    {
+      // The repeater may be waiting for a repeat of the previous buffer, up
+      // to kMaxRepeatingInterval away, rather than kMinRepeatingInterval.
+      std::lock_guard lock(repeater_state_mutex_);
+      new_frame_ = true;
+      repeater_state_condvar_.notify_one();
+    }
     if (processed_frame.is_success_) {
       SendLastFrame(display_number);
+      auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+          std::chrono::steady_clock::now() - processed_frame.commit_time_);
+      std::lock_guard<std::mutex> lock(frame_latencies_mutex_);
+      frame_latencies_[display_number].Record(latency);
     }
   }
 }
 
+std::map<uint32_t, LatencyHistogram> DisplayHandler::FrameLatencies() {
+  std::lock_guard<std::mutex> lock(frame_latencies_mutex_);
+  return frame_latencies_;
+}
+
+std::vector<uint32_t> DisplayHandler::DisplayNumbers() {
+  std::lock_guard<std::mutex> lock(last_buffers_mutex_);
+  std::vector<uint32_t> display_numbers;
+  for (const auto& [display_number, buffer_info] : display_last_buffers_) {
+    display_numbers.push_back(display_number);
+  }
+  return display_numbers;
+}
+
 void DisplayHandler::SendLastFrame(std::optional<uint32_t> display_number) {
   std::map<uint32_t, std::shared_ptr<BufferInfo>> buffers;
   {
@@ -185,11 +240,11 @@ void DisplayHandler::SendLastFrame(std::optional<uint32_t> display_number) {
     // send any frame.
     return;
   }
-  SendBuffers(buffers);
+  SendBuffers(buffers, /*repeat=*/false);
 }
 
 void DisplayHandler::SendBuffers(
-    std::map<uint32_t, std::shared_ptr<BufferInfo>> buffers) {
+    std::map<uint32_t, std::shared_ptr<BufferInfo>> buffers, bool repeat) {
   // SendBuffers can be called from multiple threads simultaneously, locking
   // here avoids injecting frames with the timestamps in the wrong order and
   // protects writing the BufferInfo timestamps.
@@ -201,22 +256,64 @@ void DisplayHandler::SendBuffers(
           .count();
 
   for (const auto& [display_number, buffer_info] : buffers) {
-    screenshot_handler_.OnFrame(display_number, buffer_info->buffer);
+    std::shared_ptr<VideoFrameBuffer> buffer =
+        buffer_info->composed ? buffer_info->composed : buffer_info->buffer;
+    screenshot_handler_.OnFrame(display_number, buffer);
 
     auto it = display_sinks_.find(display_number);
     if (it != display_sinks_.end()) {
-      it->second->OnFrame(buffer_info->buffer, time_stamp_since_epoch);
+      it->second->OnFrame(buffer, time_stamp_since_epoch);
       buffer_info->last_sent_time_stamp = time_stamp;
+      buffer_info->repeats = repeat ? buffer_info->repeats + 1 : 0;
     }
   }
 }
 
+std::optional<std::chrono::system_clock::time_point> DisplayHandler::NextRepeat(
+    uint32_t display_number, const BufferInfo& buffer_info) {
+  if (screenshot_handler_.IsPending(display_number)) {
+    return buffer_info.last_sent_time_stamp;
+  }
+  auto sink_it = display_sinks_.find(display_number);
+  if (sink_it == display_sinks_.end() || !sink_it->second->FrameWanted()) {
+    // New subscribers are sent the last frame when they connect.
+    return std::nullopt;
+  }
+  auto interval = std::min<std::chrono::milliseconds>(
+      kMinRepeatingInterval *
+          (1 << std::min(buffer_info.repeats, kMaxRepeatingBackoff)),
+      kMaxRepeatingInterval);
+  // The encoders drop frames above the rate they asked for, don't make them.
+  const int max_framerate = sink_it->second->MaxFramerate();
+  if (max_framerate > 0) {
+    interval = std::max<std::chrono::milliseconds>(
+        interval, std::chrono::milliseconds(1000 / max_framerate));
+  }
+  return buffer_info.last_sent_time_stamp + interval;
+}
+
+std::shared_ptr<VideoFrameBuffer> DisplayHandler::CompositionBuffer(
+    uint32_t display_number, const BufferInfo& buffer_info) {
+  // The buffers from the converter can't be composed into: the converter
+  // reuses them expecting the pixels it converted last, and would keep the
+  // overlays in the tiles that didn't change since. The last composed buffer
+  // is composed into again once nothing else holds it, which is skipped when
+  // the overlays didn't change.
+  if (buffer_info.composed && buffer_info.composed.use_count() == 1) {
+    return buffer_info.composed;
+  }
+  const int width = buffer_info.buffer->width();
+  const int height = buffer_info.buffer->height();
+  std::shared_ptr<VideoFramePool>& pool = composition_pools_[display_number];
+  if (!pool || pool->width() != width || pool->height() != height) {
+    pool = VideoFramePool::Create(width, height, kCompositionPoolSize);
+  }
+  std::shared_ptr<VideoFramePool::Frame> frame = pool->Acquire();
+  return std::shared_ptr<VideoFrameBuffer>(frame, &frame->buffer);
+}
+
 void DisplayHandler::RepeatFramesPeriodically() {
-  // SendBuffers can be called from multiple threads simultaneously, locking
-  // here avoids injecting frames with the timestamps in the wrong order and
-  // protects writing the BufferInfo timestamps.
-  const std::chrono::milliseconds kRepeatingInterval(20);
-  auto next_send = std::chrono::system_clock::now() + kRepeatingInterval;
+  auto next_send = std::chrono::system_clock::now() + kMinRepeatingInterval;
   while (true) {
     {
       std::unique_lock lock(repeater_state_mutex_);
@@ -224,13 +321,21 @@ void DisplayHandler::RepeatFramesPeriodically() {
         break;
       }
       if (num_active_clients_ > 0) {
-        bool stopped =
-            repeater_state_condvar_.wait_until(lock, next_send, [this]() {
-              // Wait until time interval completes or asked to stop. Continue
-              // waiting even if the number of active clients drops to 0.
-              return repeater_state_ == RepeaterState::STOPPED;
-            });
-        if (stopped || num_active_clients_ == 0) {
+        repeater_state_condvar_.wait_until(lock, next_send, [this]() {
+          // Wait until time interval completes, asked to stop or a frame
+          // arrives. Continue waiting even if the number of active clients
+          // drops to 0.
+          return repeater_state_ == RepeaterState::STOPPED || new_frame_;
+        });
+        if (repeater_state_ == RepeaterState::STOPPED ||
+            num_active_clients_ == 0) {
+          continue;
+        }
+        if (new_frame_) {
+          // The new frame is repeated sooner than the previous one was.
+          new_frame_ = false;
+          lock.unlock();
+          next_send = NextSend();
           continue;
         }
       } else {
@@ -247,31 +352,45 @@ void DisplayHandler::RepeatFramesPeriodically() {
 
     std::map<uint32_t, std::shared_ptr<BufferInfo>> buffers;
     {
+      // The send mutex protects the sinks and the BufferInfo timestamps.
       std::lock_guard last_buffers_lock(last_buffers_mutex_);
+      std::lock_guard send_lock(send_mutex_);
       auto time_stamp = std::chrono::system_clock::now();
 
       for (auto& [display_number, buffer_info] : display_last_buffers_) {
-        if (time_stamp >
-            buffer_info->last_sent_time_stamp + kRepeatingInterval) {
-          if (composition_manager_.has_value()) {
-            composition_manager_.value()->ComposeFrame(
-                display_number, std::static_pointer_cast<CvdVideoFrameBuffer>(
-                                    buffer_info->buffer));
-          }
-          buffers[display_number] = buffer_info;
+        auto next_repeat = NextRepeat(display_number, *buffer_info);
+        if (!next_repeat || time_stamp < *next_repeat) {
+          continue;
+        }
+        if (composition_manager_.has_value()) {
+          std::shared_ptr<VideoFrameBuffer> composed =
+              CompositionBuffer(display_number, *buffer_info);
+          const bool has_overlays =
+              composition_manager_.value()->ComposeFrame(display_number,
+                                                         composed);
+          buffer_info->composed = has_overlays ? std::move(composed) : nullptr;
         }
+        buffers[display_number] = buffer_info;
       }
     }
-    SendBuffers(buffers);
-    {
-      std::lock_guard last_buffers_lock(last_buffers_mutex_);
-      next_send = std::chrono::system_clock::now() + kRepeatingInterval;
-      for (const auto& [_, buffer_info] : display_last_buffers_) {
-        next_send = std::min(
-            next_send, buffer_info->last_sent_time_stamp + kRepeatingInterval);
-      }
+    SendBuffers(buffers, /*repeat=*/true);
+    next_send = NextSend();
+  }
+}
+
+std::chrono::system_clock::time_point DisplayHandler::NextSend() {
+  std::lock_guard last_buffers_lock(last_buffers_mutex_);
+  std::lock_guard send_lock(send_mutex_);
+  // Look again at displays nobody watches now and then, in case a
+  // subscriber showed up without asking for a frame.
+  auto next_send = std::chrono::system_clock::now() + kMaxRepeatingInterval;
+  for (const auto& [display_number, buffer_info] : display_last_buffers_) {
+    auto next_repeat = NextRepeat(display_number, *buffer_info);
+    if (next_repeat) {
+      next_send = std::min(next_send, *next_repeat);
     }
   }
+  return next_send;
 }
 
 void DisplayHandler::AddDisplayClient() {
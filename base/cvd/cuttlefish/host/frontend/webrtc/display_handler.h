@@ -17,14 +17,19 @@
 #pragma once
 
 #include <chrono>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <thread>
+#include <vector>
 
 #include "cuttlefish/host/frontend/webrtc/cvd_video_frame_buffer.h"
+#include "cuttlefish/host/frontend/webrtc/incremental_i420_converter.h"
+#include "cuttlefish/host/frontend/webrtc/latency_histogram.h"
 #include "cuttlefish/host/frontend/webrtc/libdevice/video_sink.h"
 #include "cuttlefish/host/frontend/webrtc/screenshot_handler.h"
+#include "cuttlefish/host/frontend/webrtc/video_frame_pool.h"
 #include "cuttlefish/host/libs/screen_connector/ring_buffer_manager.h"
 #include "cuttlefish/host/libs/screen_connector/screen_connector.h"
 #include "cuttlefish/host/libs/screen_connector/video_frame_buffer.h"
@@ -42,12 +47,21 @@ class CompositionManager;
  */
 struct WebRtcScProcessedFrame : public ScreenConnectorFrameInfo {
   // must support move semantic
-  std::unique_ptr<CvdVideoFrameBuffer> buf_;
+  std::shared_ptr<CvdVideoFrameBuffer> buf_;
+  // The frame is identical to the previous one of the display, buf_ is null.
+  bool unchanged_ = false;
+  // When the guest committed the frame.
+  std::chrono::steady_clock::time_point commit_time_;
   std::unique_ptr<WebRtcScProcessedFrame> Clone() {
-    // copy internal buffer, not move
-    CvdVideoFrameBuffer* new_buffer = new CvdVideoFrameBuffer(*(buf_.get()));
     auto cloned_frame = std::make_unique<WebRtcScProcessedFrame>();
-    cloned_frame->buf_ = std::unique_ptr<CvdVideoFrameBuffer>(new_buffer);
+    cloned_frame->display_number_ = display_number_;
+    cloned_frame->is_success_ = is_success_;
+    cloned_frame->unchanged_ = unchanged_;
+    cloned_frame->commit_time_ = commit_time_;
+    if (buf_) {
+      // copy internal buffer, not move
+      cloned_frame->buf_ = std::make_shared<CvdVideoFrameBuffer>(*buf_);
+    }
     return cloned_frame;
   }
 };
@@ -76,18 +90,39 @@ class DisplayHandler {
   void AddDisplayClient();
   void RemoveDisplayClient();
 
+  // Time from the guest committing a frame to the frame reaching the encoder,
+  // per display.
+  std::map<uint32_t, LatencyHistogram> FrameLatencies();
+  // The displays that produced a frame.
+  std::vector<uint32_t> DisplayNumbers();
+
  private:
   struct BufferInfo {
     std::chrono::system_clock::time_point last_sent_time_stamp;
     std::shared_ptr<VideoFrameBuffer> buffer;
+    // The buffer with the overlays blended in, sent in place of `buffer` once
+    // the repeater composed it.
+    std::shared_ptr<VideoFrameBuffer> composed;
+    // How many times in a row the buffer was sent again by the repeater.
+    int repeats = 0;
   };
   enum class RepeaterState {
     RUNNING,
     STOPPED,
   };
   GenerateProcessedFrameCallback GetScreenConnectorCallback();
-  void SendBuffers(std::map<uint32_t, std::shared_ptr<BufferInfo>> buffers);
+  void SendBuffers(std::map<uint32_t, std::shared_ptr<BufferInfo>> buffers,
+                   bool repeat);
   void RepeatFramesPeriodically();
+  // When the display's last buffer should be sent again, or std::nullopt if
+  // nobody needs it. Requires last_buffers_mutex_ and send_mutex_.
+  std::optional<std::chrono::system_clock::time_point> NextRepeat(
+      uint32_t display_number, const BufferInfo& buffer_info);
+  // When the repeater should look at the displays again.
+  std::chrono::system_clock::time_point NextSend();
+  // The buffer to compose the display's overlays into. Requires send_mutex_.
+  std::shared_ptr<VideoFrameBuffer> CompositionBuffer(
+      uint32_t display_number, const BufferInfo& buffer_info);
 
   std::optional<std::unique_ptr<CompositionManager>> composition_manager_;
   std::map<uint32_t, std::shared_ptr<webrtc_streaming::VideoSink>>
@@ -96,6 +131,12 @@ class DisplayHandler {
   ScreenshotHandler& screenshot_handler_;
   ScreenConnector& screen_connector_;
   std::map<uint32_t, std::shared_ptr<BufferInfo>> display_last_buffers_;
+  // Protected by send_mutex_
+  std::map<uint32_t, std::shared_ptr<VideoFramePool>> composition_pools_;
+  std::map<uint32_t, IncrementalI420Converter> converters_;
+  std::mutex converters_mutex_;
+  std::map<uint32_t, LatencyHistogram> frame_latencies_;
+  std::mutex frame_latencies_mutex_;
   std::mutex last_buffers_mutex_;
   std::mutex send_mutex_;
   std::thread frame_repeater_;
@@ -103,6 +144,9 @@ class DisplayHandler {
   RepeaterState repeater_state_ = RepeaterState::RUNNING;
   // Protected by repeater_state_mutex
   int num_active_clients_ = 0;
+  // Protected by repeater_state_mutex. A frame arrived since the repeater
+  // computed when to repeat.
+  bool new_frame_ = false;
   std::mutex repeater_state_mutex_;
   std::condition_variable repeater_state_condvar_;
 };
@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/frontend/webrtc/incremental_i420_converter.h"
+
+#include <libyuv.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "drm/drm_fourcc.h"
+
+namespace cuttlefish {
+namespace {
+
+// Even, so tiles never split a chroma sample.
+constexpr uint32_t kTileSize = 64;
+constexpr uint32_t kBytesPerPixel = 4;
+// One frame for the encoder, one being sent again by the repeater and one to
+// convert into.
+constexpr size_t kFramePoolSize = 3;
+
+bool IsArgb(uint32_t fourcc_format) {
+  return fourcc_format == DRM_FORMAT_ARGB8888 ||
+         fourcc_format == DRM_FORMAT_XRGB8888;
+}
+
+bool IsAbgr(uint32_t fourcc_format) {
+  return fourcc_format == DRM_FORMAT_ABGR8888 ||
+         fourcc_format == DRM_FORMAT_XBGR8888;
+}
+
+}  // namespace
+
+IncrementalI420Converter::Status IncrementalI420Converter::Convert(
+    uint32_t width, uint32_t height, uint32_t fourcc_format,
+    uint32_t stride_bytes, const uint8_t* pixels, const FrameDamage& damage) {
+  if (!IsArgb(fourcc_format) && !IsAbgr(fourcc_format)) {
+    frame_.reset();
+    return Status::kUnsupportedFormat;
+  }
+  const uint32_t tiles_x = (width + kTileSize - 1) / kTileSize;
+  const uint32_t tiles_y = (height + kTileSize - 1) / kTileSize;
+  if (!frame_ || width != width_ || height != height_ ||
+      fourcc_format != fourcc_format_) {
+    width_ = width;
+    height_ = height;
+    fourcc_format_ = fourcc_format;
+    pool_ = VideoFramePool::Create(width, height, kFramePoolSize);
+    frame_ = pool_->Acquire();
+    generation_++;
+    frame_->generation = generation_;
+    tile_generations_.assign(tiles_x * tiles_y, generation_);
+    previous_pixels_.resize(static_cast<size_t>(width) * height *
+                            kBytesPerPixel);
+    ConvertArea(pixels, stride_bytes, 0, 0, width, height);
+    return Status::kChanged;
+  }
+
+  std::vector<bool> candidates(tiles_x * tiles_y, damage.empty());
+  for (const FrameDamageRect& rect : damage) {
+    const uint32_t right =
+        std::min<uint64_t>(uint64_t{rect.x} + rect.width, width);
+    const uint32_t bottom =
+        std::min<uint64_t>(uint64_t{rect.y} + rect.height, height);
+    if (rect.x >= right || rect.y >= bottom) {
+      continue;
+    }
+    for (uint32_t ty = rect.y / kTileSize; ty <= (bottom - 1) / kTileSize;
+         ty++) {
+      for (uint32_t tx = rect.x / kTileSize; tx <= (right - 1) / kTileSize;
+           tx++) {
+        candidates[ty * tiles_x + tx] = true;
+      }
+    }
+  }
+
+  bool changed = false;
+  for (uint32_t ty = 0; ty < tiles_y; ty++) {
+    for (uint32_t tx = 0; tx < tiles_x; tx++) {
+      const uint32_t tile = ty * tiles_x + tx;
+      if (candidates[tile] && TileChanged(pixels, stride_bytes, tx, ty)) {
+        tile_generations_[tile] = generation_ + 1;
+        changed = true;
+      }
+    }
+  }
+  if (!changed) {
+    return Status::kUnchanged;
+  }
+  generation_++;
+
+  frame_ = pool_->Acquire();
+  const uint64_t frame_generation = frame_->generation;
+  frame_->generation = generation_;
+  for (uint32_t ty = 0; ty < tiles_y; ty++) {
+    const uint32_t y = ty * kTileSize;
+    const uint32_t rows = std::min(kTileSize, height - y);
+    // Adjacent stale tiles are converted together.
+    uint32_t span_start = 0;
+    uint32_t span_tiles = 0;
+    for (uint32_t tx = 0; tx <= tiles_x; tx++) {
+      if (tx < tiles_x &&
+          tile_generations_[ty * tiles_x + tx] > frame_generation) {
+        if (span_tiles == 0) {
+          span_start = tx;
+        }
+        span_tiles++;
+        continue;
+      }
+      if (span_tiles > 0) {
+        const uint32_t x = span_start * kTileSize;
+        const uint32_t columns = std::min(span_tiles * kTileSize, width - x);
+        ConvertArea(pixels, stride_bytes, x, y, columns, rows);
+        span_tiles = 0;
+      }
+    }
+  }
+  return Status::kChanged;
+}
+
+std::shared_ptr<CvdVideoFrameBuffer> IncrementalI420Converter::Frame() const {
+  return std::shared_ptr<CvdVideoFrameBuffer>(frame_, &frame_->buffer);
+}
+
+void IncrementalI420Converter::ConvertArea(const uint8_t* pixels,
+                                           uint32_t stride_bytes, uint32_t x,
+                                           uint32_t y, uint32_t width,
+                                           uint32_t height) {
+  CvdVideoFrameBuffer& frame = frame_->buffer;
+  const uint8_t* src =
+      pixels + static_cast<size_t>(y) * stride_bytes + x * kBytesPerPixel;
+  uint8_t* dst_y = frame.DataY() + y * frame.StrideY() + x;
+  uint8_t* dst_u = frame.DataU() + (y / 2) * frame.StrideU() + x / 2;
+  uint8_t* dst_v = frame.DataV() + (y / 2) * frame.StrideV() + x / 2;
+  if (IsArgb(fourcc_format_)) {
+    libyuv::ARGBToI420(src, stride_bytes, dst_y, frame.StrideY(), dst_u,
+                       frame.StrideU(), dst_v, frame.StrideV(), width, height);
+  } else {
+    libyuv::ABGRToI420(src, stride_bytes, dst_y, frame.StrideY(), dst_u,
+                       frame.StrideU(), dst_v, frame.StrideV(), width, height);
+  }
+
+  const size_t previous_stride = static_cast<size_t>(width_) * kBytesPerPixel;
+  for (uint32_t row = 0; row < height; row++) {
+    memcpy(&previous_pixels_[(y + row) * previous_stride + x * kBytesPerPixel],
+           src + static_cast<size_t>(row) * stride_bytes,
+           width * kBytesPerPixel);
+  }
+}
+
+bool IncrementalI420Converter::TileChanged(const uint8_t* pixels,
+                                           uint32_t stride_bytes,
+                                           uint32_t tile_x,
+                                           uint32_t tile_y) const {
+  const uint32_t x = tile_x * kTileSize;
+  const uint32_t y = tile_y * kTileSize;
+  const size_t row_bytes = std::min(kTileSize, width_ - x) * kBytesPerPixel;
+  const uint32_t rows = std::min(kTileSize, height_ - y);
+  const size_t previous_stride = static_cast<size_t>(width_) * kBytesPerPixel;
+  for (uint32_t row = 0; row < rows; row++) {
+    const uint8_t* current = pixels +
+                             static_cast<size_t>(y + row) * stride_bytes +
+                             x * kBytesPerPixel;
+    const uint8_t* previous =
+        &previous_pixels_[(y + row) * previous_stride + x * kBytesPerPixel];
+    if (memcmp(current, previous, row_bytes) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace cuttlefish
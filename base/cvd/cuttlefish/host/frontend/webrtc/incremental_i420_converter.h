@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "cuttlefish/host/frontend/webrtc/cvd_video_frame_buffer.h"
+#include "cuttlefish/host/frontend/webrtc/video_frame_pool.h"
+#include "cuttlefish/host/libs/screen_connector/frame_damage.h"
+
+namespace cuttlefish {
+
+/**
+ * Keeps an I420 copy of the frames of one display, converting only the parts
+ * of each new RGB frame that changed.
+ *
+ * The frame is split in square tiles. The tiles touched by the damage, or all
+ * of them when the damage is unknown, are compared with the previous frame and
+ * only those that differ are converted. Clients commonly report the whole
+ * surface as damaged, so the comparison is what keeps static content cheap.
+ *
+ * Every changed frame is converted into a buffer from a pool, so frames still
+ * referenced by the encoder are never written. A buffer taken from the pool
+ * already holds an older frame; each tile remembers the last frame it changed
+ * in, and only the tiles that changed since are converted again.
+ */
+class IncrementalI420Converter {
+ public:
+  enum class Status {
+    kChanged,
+    kUnchanged,
+    kUnsupportedFormat,
+  };
+
+  Status Convert(uint32_t width, uint32_t height, uint32_t fourcc_format,
+                 uint32_t stride_bytes, const uint8_t* pixels,
+                 const FrameDamage& damage);
+
+  // Returns the last converted frame, which must exist. The converter doesn't
+  // modify it again.
+  std::shared_ptr<CvdVideoFrameBuffer> Frame() const;
+
+ private:
+  void ConvertArea(const uint8_t* pixels, uint32_t stride_bytes, uint32_t x,
+                   uint32_t y, uint32_t width, uint32_t height);
+  bool TileChanged(const uint8_t* pixels, uint32_t stride_bytes,
+                   uint32_t tile_x, uint32_t tile_y) const;
+
+  uint32_t width_ = 0;
+  uint32_t height_ = 0;
+  uint32_t fourcc_format_ = 0;
+  std::shared_ptr<VideoFramePool> pool_;
+  std::shared_ptr<VideoFramePool::Frame> frame_;
+  // Numbers the changed frames, the generation of the frame in frame_.
+  uint64_t generation_ = 0;
+  // The generation of the last frame each tile changed in.
+  std::vector<uint64_t> tile_generations_;
+  // The RGB pixels of the last frame, without row padding.
+  std::vector<uint8_t> previous_pixels_;
+};
+
+}  // namespace cuttlefish
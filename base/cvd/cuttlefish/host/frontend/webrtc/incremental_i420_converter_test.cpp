@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/frontend/webrtc/incremental_i420_converter.h"
+
+#include <libyuv.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "drm/drm_fourcc.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/host/frontend/webrtc/cvd_video_frame_buffer.h"
+#include "cuttlefish/host/libs/screen_connector/frame_damage.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr uint32_t kWidth = 200;
+constexpr uint32_t kHeight = 130;
+constexpr uint32_t kStride = kWidth * 4;
+
+// ARGB pixels with a different value in every channel of every pixel.
+std::vector<uint8_t> TestPixels() {
+  std::vector<uint8_t> pixels(kStride * kHeight);
+  for (size_t i = 0; i < pixels.size(); i++) {
+    pixels[i] = static_cast<uint8_t>(i * 7 + i / kStride);
+  }
+  return pixels;
+}
+
+void Fill(std::vector<uint8_t>& pixels, uint32_t x, uint32_t y, uint32_t width,
+          uint32_t height, uint8_t value) {
+  for (uint32_t row = y; row < y + height; row++) {
+    for (uint32_t column = x; column < x + width; column++) {
+      for (uint32_t channel = 0; channel < 4; channel++) {
+        pixels[row * kStride + column * 4 + channel] = value + channel;
+      }
+    }
+  }
+}
+
+std::vector<uint8_t> Plane(const uint8_t* data, int stride, int width,
+                           int height) {
+  std::vector<uint8_t> plane;
+  for (int row = 0; row < height; row++) {
+    plane.insert(plane.end(), data + row * stride, data + row * stride + width);
+  }
+  return plane;
+}
+
+// The visible part of the planes of an I420 frame.
+std::vector<std::vector<uint8_t>> Planes(CvdVideoFrameBuffer& frame) {
+  const int chroma_width = (frame.width() + 1) / 2;
+  const int chroma_height = (frame.height() + 1) / 2;
+  return {
+      Plane(frame.DataY(), frame.StrideY(), frame.width(), frame.height()),
+      Plane(frame.DataU(), frame.StrideU(), chroma_width, chroma_height),
+      Plane(frame.DataV(), frame.StrideV(), chroma_width, chroma_height),
+  };
+}
+
+std::vector<std::vector<uint8_t>> FullConversion(
+    const std::vector<uint8_t>& pixels) {
+  CvdVideoFrameBuffer frame(kWidth, kHeight);
+  libyuv::ARGBToI420(pixels.data(), kStride, frame.DataY(), frame.StrideY(),
+                     frame.DataU(), frame.StrideU(), frame.DataV(),
+                     frame.StrideV(), kWidth, kHeight);
+  return Planes(frame);
+}
+
+}  // namespace
+
+TEST(IncrementalI420ConverterTest, FirstFrameIsConvertedWhole) {
+  std::vector<uint8_t> pixels = TestPixels();
+  IncrementalI420Converter converter;
+  ASSERT_EQ(converter.Convert(kWidth, kHeight, DRM_FORMAT_ARGB8888, kStride,
+                              pixels.data(), {}),
+            IncrementalI420Converter::Status::kChanged);
+  EXPECT_EQ(Planes(*converter.Frame()), FullConversion(pixels));
+}
+
+TEST(IncrementalI420ConverterTest, IdenticalFrameIsUnchanged) {
+  std::vector<uint8_t> pixels = TestPixels();
+  IncrementalI420Converter converter;
+  converter.Convert(kWidth, kHeight, DRM_FORMAT_ARGB8888, kStride,
+                    pixels.data(), {});
+  EXPECT_EQ(converter.Convert(kWidth, kHeight, DRM_FORMAT_ARGB8888, kStride,
+                              pixels.data(), {}),
+            IncrementalI420Converter::Status::kUnchanged);
+}
+
+TEST(IncrementalI420ConverterTest, UnsupportedFormat) {
+  std::vector<uint8_t> pixels = TestPixels();
+  IncrementalI420Converter converter;
+  EXPECT_EQ(converter.Convert(kWidth, kHeight, DRM_FORMAT_RGB565, kStride,
+                              pixels.data(), {}),
+            IncrementalI420Converter::Status::kUnsupportedFormat);
+}
+
+// The pool hands back frames holding older contents, only some tiles of
+// which are converted again.
+TEST(IncrementalI420ConverterTest, ReusedFramesMatchFullConversion) {
+  std::vector<uint8_t> pixels = TestPixels();
+  IncrementalI420Converter converter;
+  converter.Convert(kWidth, kHeight, DRM_FORMAT_ARGB8888, kStride,
+                    pixels.data(), {});
+  std::mt19937 rng(1);
+  // Keeps a changing number of frames referenced, as the encoder does, so
+  // frames come back from the pool after different numbers of updates.
+  std::vector<std::shared_ptr<CvdVideoFrameBuffer>> held;
+  for (int i = 0; i < 50; i++) {
+    const uint32_t x = rng() % kWidth;
+    const uint32_t y = rng() % kHeight;
+    const uint32_t width = 1 + rng() % (kWidth - x);
+    const uint32_t height = 1 + rng() % (kHeight - y);
+    Fill(pixels, x, y, width, height, static_cast<uint8_t>(rng()));
+    ASSERT_EQ(converter.Convert(kWidth, kHeight, DRM_FORMAT_ARGB8888, kStride,
+                                pixels.data(), {}),
+              IncrementalI420Converter::Status::kChanged);
+    ASSERT_EQ(Planes(*converter.Frame()), FullConversion(pixels))
+        << "Frame " << i;
+    held.push_back(converter.Frame());
+    if (held.size() > rng() % 4) {
+      held.erase(held.begin());
+    }
+  }
+}
+
+TEST(IncrementalI420ConverterTest, HeldFramesAreNotModified) {
+  std::vector<uint8_t> pixels = TestPixels();
+  IncrementalI420Converter converter;
+  converter.Convert(kWidth, kHeight, DRM_FORMAT_ARGB8888, kStride,
+                    pixels.data(), {});
+  std::shared_ptr<CvdVideoFrameBuffer> held = converter.Frame();
+  const auto held_planes = Planes(*held);
+  for (int i = 0; i < 10; i++) {
+    Fill(pixels, 0, 0, kWidth, kHeight, static_cast<uint8_t>(i * 20));
+    converter.Convert(kWidth, kHeight, DRM_FORMAT_ARGB8888, kStride,
+                      pixels.data(), {});
+  }
+  EXPECT_EQ(Planes(*held), held_planes);
+}
+
+// Each update changes some areas and reports exactly those areas, at odd
+// positions and across tile boundaries.
+TEST(IncrementalI420ConverterTest, DamagedAreasMatchFullConversion) {
+  std::vector<uint8_t> pixels = TestPixels();
+  IncrementalI420Converter converter;
+  converter.Convert(kWidth, kHeight, DRM_FORMAT_ARGB8888, kStride,
+                    pixels.data(), {});
+  std::mt19937 rng(2);
+  for (int i = 0; i < 50; i++) {
+    FrameDamage damage;
+    for (uint32_t rects = 1 + rng() % 3; rects > 0; rects--) {
+      const uint32_t x = rng() % kWidth;
+      const uint32_t y = rng() % kHeight;
+      const uint32_t width = 1 + rng() % (kWidth - x);
+      const uint32_t height = 1 + rng() % (kHeight - y);
+      Fill(pixels, x, y, width, height, static_cast<uint8_t>(rng()));
+      damage.push_back({x, y, width, height});
+    }
+    ASSERT_EQ(converter.Convert(kWidth, kHeight, DRM_FORMAT_ARGB8888, kStride,
+                                pixels.data(), damage),
+              IncrementalI420Converter::Status::kChanged);
+    ASSERT_EQ(Planes(*converter.Frame()), FullConversion(pixels))
+        << "Frame " << i;
+  }
+}
+
+TEST(IncrementalI420ConverterTest, SinglePixelDamage) {
+  std::vector<uint8_t> pixels = TestPixels();
+  IncrementalI420Converter converter;
+  converter.Convert(kWidth, kHeight, DRM_FORMAT_ARGB8888, kStride,
+                    pixels.data(), {});
+  // The corners of the frame, and a pixel next to tile boundaries.
+  for (const auto& [x, y] : {std::pair<uint32_t, uint32_t>{0, 0},
+                             {1, 1},
+                             {kWidth - 1, kHeight - 1},
+                             {63, 64}}) {
+    Fill(pixels, x, y, 1, 1, static_cast<uint8_t>(x + y));
+    ASSERT_EQ(converter.Convert(kWidth, kHeight, DRM_FORMAT_ARGB8888, kStride,
+                                pixels.data(), {{x, y, 1, 1}}),
+              IncrementalI420Converter::Status::kChanged);
+    EXPECT_EQ(Planes(*converter.Frame()), FullConversion(pixels))
+        << "Pixel " << x << "," << y;
+  }
+}
+
+TEST(IncrementalI420ConverterTest, DamageWithoutChangesIsUnchanged) {
+  std::vector<uint8_t> pixels = TestPixels();
+  IncrementalI420Converter converter;
+  converter.Convert(kWidth, kHeight, DRM_FORMAT_ARGB8888, kStride,
+                    pixels.data(), {});
+  EXPECT_EQ(converter.Convert(kWidth, kHeight, DRM_FORMAT_ARGB8888, kStride,
+                              pixels.data(), {{10, 20, 30, 40}}),
+            IncrementalI420Converter::Status::kUnchanged);
+  EXPECT_EQ(Planes(*converter.Frame()), FullConversion(pixels));
+}
+
+// Rectangles reaching past the frame are clipped to it.
+TEST(IncrementalI420ConverterTest, DamagePastTheFrameIsClipped) {
+  std::vector<uint8_t> pixels = TestPixels();
+  IncrementalI420Converter converter;
+  converter.Convert(kWidth, kHeight, DRM_FORMAT_ARGB8888, kStride,
+                    pixels.data(), {});
+  Fill(pixels, kWidth - 10, kHeight - 10, 10, 10, 0x80);
+  EXPECT_EQ(converter.Convert(kWidth, kHeight, DRM_FORMAT_ARGB8888, kStride,
+                              pixels.data(),
+                              {{kWidth - 10, kHeight - 10, 1000, 1000},
+                               {kWidth, 0, 10, 10}}),
+            IncrementalI420Converter::Status::kChanged);
+  EXPECT_EQ(Planes(*converter.Frame()), FullConversion(pixels));
+}
+
+}  // namespace cuttlefish
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/frontend/webrtc/latency_histogram.h"
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace cuttlefish {
+
+void LatencyHistogram::Record(std::chrono::microseconds latency) {
+  latency = std::max(latency, std::chrono::microseconds(0));
+  size_t bucket = 0;
+  while (bucket + 1 < kNumBuckets && latency >= BucketLimit(bucket)) {
+    bucket++;
+  }
+  counts_[bucket]++;
+  count_++;
+  total_ += latency;
+  max_ = std::max(max_, latency);
+}
+
+std::chrono::microseconds LatencyHistogram::BucketLimit(size_t bucket) {
+  if (bucket + 1 >= kNumBuckets) {
+    return std::chrono::microseconds::max();
+  }
+  return std::chrono::milliseconds(1) * (1 << bucket);
+}
+
+}  // namespace cuttlefish
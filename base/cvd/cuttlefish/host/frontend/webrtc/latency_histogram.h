@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <chrono>
+
+namespace cuttlefish {
+
+/**
+ * Counts latencies in buckets whose upper bounds double from 1ms to 512ms,
+ * plus one for anything slower. Not thread safe.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr size_t kNumBuckets = 11;
+
+  void Record(std::chrono::microseconds latency);
+
+  // The exclusive upper bound of the bucket, none for the last one.
+  static std::chrono::microseconds BucketLimit(size_t bucket);
+
+  const std::array<uint64_t, kNumBuckets>& Counts() const { return counts_; }
+  uint64_t Count() const { return count_; }
+  std::chrono::microseconds Total() const { return total_; }
+  std::chrono::microseconds Max() const { return max_; }
+
+ private:
+  std::array<uint64_t, kNumBuckets> counts_ = {};
+  uint64_t count_ = 0;
+  std::chrono::microseconds total_{0};
+  std::chrono::microseconds max_{0};
+};
+
+}  // namespace cuttlefish
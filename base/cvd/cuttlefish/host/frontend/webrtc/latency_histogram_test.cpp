@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/frontend/webrtc/latency_histogram.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+
+#include "gtest/gtest.h"
+
+namespace cuttlefish {
+
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+TEST(LatencyHistogramTest, BucketLimitsDoubleFromOneMillisecond) {
+  EXPECT_EQ(LatencyHistogram::BucketLimit(0), milliseconds(1));
+  EXPECT_EQ(LatencyHistogram::BucketLimit(1), milliseconds(2));
+  EXPECT_EQ(LatencyHistogram::BucketLimit(9), milliseconds(512));
+  EXPECT_EQ(LatencyHistogram::BucketLimit(LatencyHistogram::kNumBuckets - 1),
+            microseconds::max());
+}
+
+TEST(LatencyHistogramTest, RecordsIntoBuckets) {
+  LatencyHistogram histogram;
+  histogram.Record(microseconds(999));
+  histogram.Record(milliseconds(1));
+  histogram.Record(microseconds(1999));
+  histogram.Record(milliseconds(511));
+  histogram.Record(milliseconds(512));
+  histogram.Record(milliseconds(5000));
+
+  const auto& counts = histogram.Counts();
+  EXPECT_EQ(counts[0], 1);
+  EXPECT_EQ(counts[1], 2);
+  EXPECT_EQ(counts[9], 1);
+  EXPECT_EQ(counts[10], 2);
+  uint64_t total = 0;
+  for (size_t i = 0; i < LatencyHistogram::kNumBuckets; i++) {
+    total += counts[i];
+  }
+  EXPECT_EQ(total, 6);
+  EXPECT_EQ(histogram.Count(), 6);
+  EXPECT_EQ(histogram.Max(), milliseconds(5000));
+  EXPECT_EQ(histogram.Total(), microseconds(999 + 1000 + 1999 + 511000 +
+                                            512000 + 5000000));
+}
+
+TEST(LatencyHistogramTest, NegativeLatenciesCountAsZero) {
+  LatencyHistogram histogram;
+  histogram.Record(microseconds(-5));
+  EXPECT_EQ(histogram.Counts()[0], 1);
+  EXPECT_EQ(histogram.Total(), microseconds(0));
+  EXPECT_EQ(histogram.Max(), microseconds(0));
+}
+
+}  // namespace cuttlefish
@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/frontend/webrtc/libcommon/preferred_codecs_encoder_factory.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "api/video_codecs/video_encoder.h"
+
+namespace cuttlefish {
+namespace webrtc_streaming {
+
+PreferredCodecsEncoderFactory::PreferredCodecsEncoderFactory(
+    std::unique_ptr<webrtc::VideoEncoderFactory> inner,
+    std::vector<std::string> codecs)
+    : inner_(std::move(inner)), codecs_(std::move(codecs)) {}
+
+std::vector<webrtc::SdpVideoFormat>
+PreferredCodecsEncoderFactory::GetSupportedFormats() const {
+  std::vector<webrtc::SdpVideoFormat> supported = inner_->GetSupportedFormats();
+  std::vector<webrtc::SdpVideoFormat> ret;
+  for (const std::string& codec : codecs_) {
+    // A codec may have several formats, like the VP9 profiles, and those come
+    // with their scalability modes.
+    for (const webrtc::SdpVideoFormat& format : supported) {
+      if (absl::EqualsIgnoreCase(format.name, codec)) {
+        ret.push_back(format);
+      }
+    }
+  }
+  return ret;
+}
+
+std::unique_ptr<webrtc::VideoEncoder>
+PreferredCodecsEncoderFactory::CreateVideoEncoder(
+    const webrtc::SdpVideoFormat& format) {
+  if (!IsOffered(format)) {
+    return nullptr;
+  }
+  return inner_->CreateVideoEncoder(format);
+}
+
+std::unique_ptr<webrtc::VideoEncoderFactory::EncoderSelectorInterface>
+PreferredCodecsEncoderFactory::GetEncoderSelector() const {
+  return inner_->GetEncoderSelector();
+}
+
+bool PreferredCodecsEncoderFactory::IsOffered(
+    const webrtc::SdpVideoFormat& format) const {
+  for (const std::string& codec : codecs_) {
+    if (absl::EqualsIgnoreCase(format.name, codec)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace webrtc_streaming
+}  // namespace cuttlefish
@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2020 The Android Open Source Project
+ * Copyright (C) 2026 The Android Open Source Project
  *
  * Licensed under the Apache License, Version 2.0 (the "License");
  * you may not use this file except in compliance with the License.
@@ -16,15 +16,24 @@
 
 #pragma once
 
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "api/video_codecs/video_encoder.h"
 #include "api/video_codecs/video_encoder_factory.h"
 
 namespace cuttlefish {
 namespace webrtc_streaming {
 
-class VP8OnlyEncoderFactory : public webrtc::VideoEncoderFactory {
+// Offers only the given codecs, in the given order, out of those supported by
+// the inner factory. The order of the formats is the order of preference in
+// the SDP offer, so each client ends up with the first codec it supports.
+class PreferredCodecsEncoderFactory : public webrtc::VideoEncoderFactory {
  public:
-  VP8OnlyEncoderFactory(std::unique_ptr<webrtc::VideoEncoderFactory> inner);
+  PreferredCodecsEncoderFactory(
+      std::unique_ptr<webrtc::VideoEncoderFactory> inner,
+      std::vector<std::string> codecs);
 
   std::vector<webrtc::SdpVideoFormat> GetSupportedFormats() const override;
 
@@ -34,7 +43,10 @@ class VP8OnlyEncoderFactory : public webrtc::VideoEncoderFactory {
   std::unique_ptr<EncoderSelectorInterface> GetEncoderSelector() const override;
 
  private:
+  bool IsOffered(const webrtc::SdpVideoFormat& format) const;
+
   std::unique_ptr<webrtc::VideoEncoderFactory> inner_;
+  std::vector<std::string> codecs_;
 };
 
 }  // namespace webrtc_streaming
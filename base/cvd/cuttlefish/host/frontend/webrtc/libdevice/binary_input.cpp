@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/frontend/webrtc/libdevice/binary_input.h"
+
+#include <endian.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+
+#include "cuttlefish/host/frontend/webrtc/libdevice/connection_observer.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+namespace webrtc_streaming {
+
+Result<uint8_t> BinaryInputReader::ReadU8() {
+  CF_EXPECT(Check(1));
+  return data_[offset_++];
+}
+
+Result<uint16_t> BinaryInputReader::ReadU16() {
+  CF_EXPECT(Check(2));
+  uint16_t value;
+  memcpy(&value, data_ + offset_, sizeof(value));
+  offset_ += sizeof(value);
+  return le16toh(value);
+}
+
+Result<int32_t> BinaryInputReader::ReadI32() {
+  CF_EXPECT(Check(4));
+  uint32_t value;
+  memcpy(&value, data_ + offset_, sizeof(value));
+  offset_ += sizeof(value);
+  return static_cast<int32_t>(le32toh(value));
+}
+
+Result<void> BinaryInputReader::ReadString(size_t size, std::string& out) {
+  CF_EXPECT(Check(size));
+  out.assign(reinterpret_cast<const char*>(data_ + offset_), size);
+  offset_ += size;
+  return {};
+}
+
+Result<void> BinaryInputReader::Check(size_t size) {
+  CF_EXPECTF(size_ - offset_ >= size,
+             "Binary input message truncated at byte {} of {}", offset_,
+             size_);
+  return {};
+}
+
+Result<void> BinaryInputDecoder::Decode(const uint8_t* data, size_t size,
+                                        ConnectionObserver& observer) {
+  BinaryInputReader reader(data, size);
+  const uint8_t version = CF_EXPECT(reader.ReadU8());
+  CF_EXPECTF(version == kBinaryInputVersion,
+             "Unsupported binary input version {}", version);
+  CF_EXPECT(!reader.AtEnd(), "Binary input message without events");
+  while (!reader.AtEnd()) {
+    const uint8_t event_type = CF_EXPECT(reader.ReadU8());
+    switch (event_type) {
+      case kMultiTouch: {
+        const bool down = CF_EXPECT(reader.ReadU8());
+        const uint8_t label_size = CF_EXPECT(reader.ReadU8());
+        CF_EXPECT(reader.ReadString(label_size, touch_label_));
+        touch_points_.resize(CF_EXPECT(reader.ReadU8()));
+        for (TouchPoint& point : touch_points_) {
+          point.id = CF_EXPECT(reader.ReadI32());
+          point.x = CF_EXPECT(reader.ReadI32());
+          point.y = CF_EXPECT(reader.ReadI32());
+        }
+        CF_EXPECT(
+            observer.OnMultiTouchEvent(touch_label_, touch_points_, down));
+        break;
+      }
+      case kKeyboard: {
+        const uint16_t code = CF_EXPECT(reader.ReadU16());
+        const bool down = CF_EXPECT(reader.ReadU8());
+        CF_EXPECT(observer.OnKeyboardEvent(code, down));
+        break;
+      }
+      case kMouseMove: {
+        const int32_t x = CF_EXPECT(reader.ReadI32());
+        const int32_t y = CF_EXPECT(reader.ReadI32());
+        CF_EXPECT(observer.OnMouseMoveEvent(x, y));
+        break;
+      }
+      case kMouseButton: {
+        const uint8_t button = CF_EXPECT(reader.ReadU8());
+        const bool down = CF_EXPECT(reader.ReadU8());
+        CF_EXPECT(observer.OnMouseButtonEvent(button, down));
+        break;
+      }
+      case kMouseWheel:
+        CF_EXPECT(observer.OnMouseWheelEvent(CF_EXPECT(reader.ReadI32())));
+        break;
+      case kRotaryWheel:
+        CF_EXPECT(observer.OnRotaryWheelEvent(CF_EXPECT(reader.ReadI32())));
+        break;
+      default:
+        return CF_ERRF("Unrecognized binary input event type: {}", event_type);
+    }
+  }
+  return {};
+}
+
+}  // namespace webrtc_streaming
+}  // namespace cuttlefish
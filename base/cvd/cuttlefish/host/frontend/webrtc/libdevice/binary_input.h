@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "cuttlefish/host/frontend/webrtc/libdevice/connection_observer.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+namespace webrtc_streaming {
+
+// Version of the binary messages accepted on the input channel, advertised to
+// clients in the device info.
+constexpr int kBinaryInputVersion = 1;
+
+// Binary input messages start with the protocol version byte, followed by one
+// or more events. Each event is a type byte and its fields, little endian:
+//   kMultiTouch:  u8 down, u8 label size, label, u8 count, count * (i32 id,
+//                 i32 x, i32 y)
+//   kKeyboard:    u16 linux key code, u8 down
+//   kMouseMove:   i32 x, i32 y
+//   kMouseButton: u8 button, u8 down
+//   kMouseWheel:  i32 pixels
+//   kRotaryWheel: i32 pixels
+enum BinaryInputEventType : uint8_t {
+  kMultiTouch = 1,
+  kKeyboard = 2,
+  kMouseMove = 3,
+  kMouseButton = 4,
+  kMouseWheel = 5,
+  kRotaryWheel = 6,
+};
+
+// Reads the fields of a binary input message in order. Fails rather than read
+// past the end of the message.
+class BinaryInputReader {
+ public:
+  BinaryInputReader(const uint8_t* data, size_t size)
+      : data_(data), size_(size) {}
+
+  bool AtEnd() const { return offset_ == size_; }
+
+  Result<uint8_t> ReadU8();
+  Result<uint16_t> ReadU16();
+  Result<int32_t> ReadI32();
+  Result<void> ReadString(size_t size, std::string& out);
+
+ private:
+  Result<void> Check(size_t size);
+
+  const uint8_t* data_;
+  size_t size_;
+  size_t offset_ = 0;
+};
+
+// Forwards the events of binary input messages to a connection observer.
+// Events before a malformed one in the same message are still forwarded.
+class BinaryInputDecoder {
+ public:
+  Result<void> Decode(const uint8_t* data, size_t size,
+                      ConnectionObserver& observer);
+
+ private:
+  // Reused across messages to avoid allocating for every touch event.
+  std::string touch_label_;
+  std::vector<TouchPoint> touch_points_;
+};
+
+}  // namespace webrtc_streaming
+}  // namespace cuttlefish
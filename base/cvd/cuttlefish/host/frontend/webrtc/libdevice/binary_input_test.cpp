@@ -0,0 +1,325 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/frontend/webrtc/libdevice/binary_input.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "json/json.h"
+
+#include "cuttlefish/host/frontend/webrtc/libdevice/connection_observer.h"
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace webrtc_streaming {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Return;
+using ::testing::StrictMock;
+
+class MockConnectionObserver : public ConnectionObserver {
+ public:
+  MOCK_METHOD(void, OnConnected, (), (override));
+  MOCK_METHOD(Result<void>, OnMouseMoveEvent, (int, int), (override));
+  MOCK_METHOD(Result<void>, OnMouseButtonEvent, (int, bool), (override));
+  MOCK_METHOD(Result<void>, OnMouseWheelEvent, (int), (override));
+  MOCK_METHOD(Result<void>, OnGamepadKeyEvent, (int, bool), (override));
+  MOCK_METHOD(Result<void>, OnGamepadMotionEvent, (int, int), (override));
+  MOCK_METHOD(Result<void>, OnTouchEvent, (const std::string&, int, int, bool),
+              (override));
+  MOCK_METHOD(Result<void>, OnMultiTouchEvent,
+              (const std::string&, Json::Value, Json::Value, Json::Value, bool,
+               int),
+              (override));
+  MOCK_METHOD(Result<void>, OnMultiTouchEvent,
+              (const std::string&, const std::vector<TouchPoint>&, bool),
+              (override));
+  MOCK_METHOD(Result<void>, OnKeyboardEvent, (uint16_t, bool), (override));
+  MOCK_METHOD(Result<void>, OnRotaryWheelEvent, (int), (override));
+  MOCK_METHOD(void, OnAdbChannelOpen,
+              (std::function<bool(const uint8_t*, size_t)>), (override));
+  MOCK_METHOD(void, OnAdbMessage, (const uint8_t*, size_t), (override));
+  MOCK_METHOD(void, OnControlChannelOpen,
+              (std::function<bool(const Json::Value)>), (override));
+  MOCK_METHOD(Result<void>, OnLidStateChange, (bool), (override));
+  MOCK_METHOD(void, OnHingeAngleChange, (int), (override));
+  MOCK_METHOD(Result<void>, OnPowerButton, (bool), (override));
+  MOCK_METHOD(Result<void>, OnBackButton, (bool), (override));
+  MOCK_METHOD(Result<void>, OnHomeButton, (bool), (override));
+  MOCK_METHOD(Result<void>, OnMenuButton, (bool), (override));
+  MOCK_METHOD(Result<void>, OnVolumeDownButton, (bool), (override));
+  MOCK_METHOD(Result<void>, OnVolumeUpButton, (bool), (override));
+  MOCK_METHOD(void, OnCustomActionButton,
+              (const std::string&, const std::string&), (override));
+  MOCK_METHOD(void, OnCameraControlMsg, (const Json::Value&), (override));
+  MOCK_METHOD(void, OnDisplayControlMsg, (const Json::Value&), (override));
+  MOCK_METHOD(void, OnDisplayAddMsg, (const Json::Value&), (override));
+  MOCK_METHOD(void, OnDisplayRemoveMsg, (const Json::Value&), (override));
+  MOCK_METHOD(void, OnBluetoothChannelOpen,
+              (std::function<bool(const uint8_t*, size_t)>), (override));
+  MOCK_METHOD(void, OnBluetoothMessage, (const uint8_t*, size_t), (override));
+  MOCK_METHOD(void, OnSensorsChannelOpen,
+              (std::function<bool(const uint8_t*, size_t)>), (override));
+  MOCK_METHOD(void, OnSensorsMessage, (const uint8_t*, size_t), (override));
+  MOCK_METHOD(void, OnSensorsChannelClosed, (), (override));
+  MOCK_METHOD(void, OnLightsChannelOpen,
+              (std::function<bool(const Json::Value&)>), (override));
+  MOCK_METHOD(void, OnLightsChannelClosed, (), (override));
+  MOCK_METHOD(void, OnLocationChannelOpen,
+              (std::function<bool(const uint8_t*, size_t)>), (override));
+  MOCK_METHOD(void, OnLocationMessage, (const uint8_t*, size_t), (override));
+  MOCK_METHOD(void, OnKmlLocationsChannelOpen,
+              (std::function<bool(const uint8_t*, size_t)>), (override));
+  MOCK_METHOD(void, OnGpxLocationsChannelOpen,
+              (std::function<bool(const uint8_t*, size_t)>), (override));
+  MOCK_METHOD(void, OnKmlLocationsMessage, (const uint8_t*, size_t),
+              (override));
+  MOCK_METHOD(void, OnGpxLocationsMessage, (const uint8_t*, size_t),
+              (override));
+  MOCK_METHOD(void, OnCameraData, (const std::vector<char>&), (override));
+};
+
+// Builds binary input messages, little endian like the clients send them.
+class Message {
+ public:
+  Message& U8(uint8_t value) {
+    bytes_.push_back(value);
+    return *this;
+  }
+  Message& U16(uint16_t value) { return U8(value).U8(value >> 8); }
+  Message& I32(int32_t value) {
+    const uint32_t bits = value;
+    return U16(bits).U16(bits >> 16);
+  }
+  Message& String(const std::string& value) {
+    bytes_.insert(bytes_.end(), value.begin(), value.end());
+    return *this;
+  }
+
+  const std::vector<uint8_t>& bytes() const { return bytes_; }
+
+ private:
+  std::vector<uint8_t> bytes_;
+};
+
+// Decodes a copy of `bytes` in a buffer of exactly its size, so that reading
+// past its end is caught by the sanitizers.
+Result<void> Decode(const std::vector<uint8_t>& bytes, size_t size,
+                    ConnectionObserver& observer) {
+  std::unique_ptr<uint8_t[]> data(new uint8_t[size]);
+  std::copy(bytes.begin(), bytes.begin() + size, data.get());
+  BinaryInputDecoder decoder;
+  return decoder.Decode(data.get(), size, observer);
+}
+
+Result<void> Decode(const Message& message, ConnectionObserver& observer) {
+  return Decode(message.bytes(), message.bytes().size(), observer);
+}
+
+MATCHER_P3(TouchPointIs, id, x, y, "") {
+  return arg.id == id && arg.x == x && arg.y == y;
+}
+
+TEST(BinaryInputReaderTest, ReadsLittleEndianFields) {
+  const Message message =
+      Message().U8(7).U16(0x1234).I32(-2).U8(3).String("abc");
+  BinaryInputReader reader(message.bytes().data(), message.bytes().size());
+
+  EXPECT_THAT(reader.ReadU8(), IsOkAndValue(7));
+  EXPECT_THAT(reader.ReadU16(), IsOkAndValue(0x1234));
+  EXPECT_THAT(reader.ReadI32(), IsOkAndValue(-2));
+  Result<uint8_t> label_size = reader.ReadU8();
+  ASSERT_THAT(label_size, IsOk());
+  std::string label;
+  ASSERT_THAT(reader.ReadString(*label_size, label), IsOk());
+  EXPECT_EQ(label, "abc");
+  EXPECT_TRUE(reader.AtEnd());
+}
+
+TEST(BinaryInputReaderTest, FailsPastTheEnd) {
+  const uint8_t data[] = {1, 2, 3};
+
+  BinaryInputReader reader(data, sizeof(data));
+  EXPECT_THAT(reader.ReadI32(), IsError());
+  EXPECT_THAT(reader.ReadU16(), IsOkAndValue(0x0201));
+  EXPECT_THAT(reader.ReadU16(), IsError());
+  EXPECT_THAT(reader.ReadU8(), IsOkAndValue(3));
+  EXPECT_THAT(reader.ReadU8(), IsError());
+  EXPECT_TRUE(reader.AtEnd());
+}
+
+TEST(BinaryInputReaderTest, FailsOnOversizedStrings) {
+  const uint8_t data[] = {'a', 'b'};
+  std::string out;
+
+  BinaryInputReader reader(data, sizeof(data));
+  EXPECT_THAT(reader.ReadString(3, out), IsError());
+  EXPECT_THAT(reader.ReadString(SIZE_MAX, out), IsError());
+  EXPECT_THAT(reader.ReadString(2, out), IsOk());
+  EXPECT_EQ(out, "ab");
+}
+
+TEST(BinaryInputDecoderTest, ForwardsEveryEvent) {
+  const Message message = Message()
+                              .U8(kBinaryInputVersion)
+                              .U8(kMultiTouch)
+                              .U8(1)
+                              .U8(5)
+                              .String("touch")
+                              .U8(2)
+                              .I32(0)
+                              .I32(10)
+                              .I32(20)
+                              .I32(1)
+                              .I32(-30)
+                              .I32(40)
+                              .U8(kKeyboard)
+                              .U16(30)
+                              .U8(0)
+                              .U8(kMouseMove)
+                              .I32(5)
+                              .I32(-6)
+                              .U8(kMouseButton)
+                              .U8(2)
+                              .U8(1)
+                              .U8(kMouseWheel)
+                              .I32(-120)
+                              .U8(kRotaryWheel)
+                              .I32(3);
+  StrictMock<MockConnectionObserver> observer;
+  EXPECT_CALL(observer,
+              OnMultiTouchEvent("touch",
+                                ElementsAre(TouchPointIs(0, 10, 20),
+                                            TouchPointIs(1, -30, 40)),
+                                true))
+      .WillOnce(Return(Result<void>{}));
+  EXPECT_CALL(observer, OnKeyboardEvent(30, false))
+      .WillOnce(Return(Result<void>{}));
+  EXPECT_CALL(observer, OnMouseMoveEvent(5, -6))
+      .WillOnce(Return(Result<void>{}));
+  EXPECT_CALL(observer, OnMouseButtonEvent(2, true))
+      .WillOnce(Return(Result<void>{}));
+  EXPECT_CALL(observer, OnMouseWheelEvent(-120))
+      .WillOnce(Return(Result<void>{}));
+  EXPECT_CALL(observer, OnRotaryWheelEvent(3))
+      .WillOnce(Return(Result<void>{}));
+
+  EXPECT_THAT(Decode(message, observer), IsOk());
+}
+
+TEST(BinaryInputDecoderTest, FailsOnEveryTruncation) {
+  const Message message = Message()
+                              .U8(kBinaryInputVersion)
+                              .U8(kMultiTouch)
+                              .U8(1)
+                              .U8(1)
+                              .String("t")
+                              .U8(1)
+                              .I32(0)
+                              .I32(10)
+                              .I32(20);
+  // No event is complete before the end of the message.
+  StrictMock<MockConnectionObserver> observer;
+
+  for (size_t size = 0; size < message.bytes().size(); size++) {
+    EXPECT_THAT(Decode(message.bytes(), size, observer), IsError())
+        << "Truncated to " << size << " bytes";
+  }
+}
+
+TEST(BinaryInputDecoderTest, FailsOnOversizedLengths) {
+  // A label of 255 bytes, with 1 in the message.
+  const Message long_label = Message()
+                                 .U8(kBinaryInputVersion)
+                                 .U8(kMultiTouch)
+                                 .U8(1)
+                                 .U8(255)
+                                 .String("t");
+  // 255 touch points, with 1 in the message.
+  const Message many_points = Message()
+                                  .U8(kBinaryInputVersion)
+                                  .U8(kMultiTouch)
+                                  .U8(1)
+                                  .U8(1)
+                                  .String("t")
+                                  .U8(255)
+                                  .I32(0)
+                                  .I32(10)
+                                  .I32(20);
+  StrictMock<MockConnectionObserver> observer;
+
+  EXPECT_THAT(Decode(long_label, observer), IsError());
+  EXPECT_THAT(Decode(many_points, observer), IsError());
+}
+
+TEST(BinaryInputDecoderTest, FailsOnMalformedMessages) {
+  StrictMock<MockConnectionObserver> observer;
+
+  EXPECT_THAT(Decode(Message(), observer), IsError());
+  EXPECT_THAT(
+      Decode(Message().U8(kBinaryInputVersion + 1).U8(kMouseWheel).I32(1),
+             observer),
+      IsError());
+  EXPECT_THAT(Decode(Message().U8(kBinaryInputVersion), observer), IsError());
+  EXPECT_THAT(Decode(Message().U8(kBinaryInputVersion).U8(0), observer),
+              IsError());
+  EXPECT_THAT(Decode(Message().U8(kBinaryInputVersion).U8(42), observer),
+              IsError());
+}
+
+TEST(BinaryInputDecoderTest, StopsAtTheFirstMalformedEvent) {
+  const Message message = Message()
+                              .U8(kBinaryInputVersion)
+                              .U8(kMouseWheel)
+                              .I32(1)
+                              .U8(42)
+                              .U8(kMouseWheel)
+                              .I32(2);
+  StrictMock<MockConnectionObserver> observer;
+  EXPECT_CALL(observer, OnMouseWheelEvent(1))
+      .WillOnce(Return(Result<void>{}));
+
+  EXPECT_THAT(Decode(message, observer), IsError());
+}
+
+TEST(BinaryInputDecoderTest, StopsAtTheFirstObserverError) {
+  const Message message = Message()
+                              .U8(kBinaryInputVersion)
+                              .U8(kMouseWheel)
+                              .I32(1)
+                              .U8(kMouseWheel)
+                              .I32(2);
+  StrictMock<MockConnectionObserver> observer;
+  EXPECT_CALL(observer, OnMouseWheelEvent(1))
+      .WillOnce(Return(CF_ERR("injected")));
+
+  EXPECT_THAT(Decode(message, observer), IsError());
+}
+
+}  // namespace
+}  // namespace webrtc_streaming
+}  // namespace cuttlefish
@@ -16,7 +16,11 @@
 
 #pragma once
 
+#include <stdint.h>
+
 #include <functional>
+#include <string>
+#include <vector>
 
 #include "json/json.h"
 
@@ -25,6 +29,12 @@
 namespace cuttlefish {
 namespace webrtc_streaming {
 
+struct TouchPoint {
+  int32_t id;
+  int32_t x;
+  int32_t y;
+};
+
 // The ConnectionObserver is the boundary between device specific code and
 // general WebRTC streaming code. Device specific code should be left to
 // implementations of this class while code that could be shared between any
@@ -55,6 +65,9 @@ class ConnectionObserver {
                                          Json::Value id, Json::Value x,
                                          Json::Value y, bool down,
                                          int size) = 0;
+  virtual Result<void> OnMultiTouchEvent(const std::string& label,
+                                         const std::vector<TouchPoint>& points,
+                                         bool down) = 0;
 
   virtual Result<void> OnKeyboardEvent(uint16_t keycode, bool down) = 0;
 
@@ -16,10 +16,16 @@
 
 #include "cuttlefish/host/frontend/webrtc/libdevice/data_channels.h"
 
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
 #include "absl/log/log.h"
 
 #include "cuttlefish/common/libs/utils/json.h"
 #include "cuttlefish/host/frontend/webrtc/libcommon/utils.h"
+#include "cuttlefish/host/frontend/webrtc/libdevice/binary_input.h"
 #include "cuttlefish/host/frontend/webrtc/libdevice/gamepad.h"
 #include "cuttlefish/host/frontend/webrtc/libdevice/keyboard.h"
 #include "cuttlefish/host/libs/config/cuttlefish_config.h"
@@ -82,9 +88,10 @@ static constexpr auto kCameraDataEof = "EOF";
 class InputChannelHandler : public DataChannelHandler {
  public:
   Result<void> OnMessageInner(const webrtc::DataBuffer &msg) override {
-    // TODO: jemoreira - consider binary protocol to avoid JSON parsing
-    // overhead
-    CF_EXPECT(!msg.binary, "Received invalid (binary) data on input channel");
+    if (msg.binary) {
+      CF_EXPECT(OnBinaryMessage(msg.data.cdata(), msg.size()));
+      return {};
+    }
     auto size = msg.size();
 
     Json::Value evt;
@@ -178,6 +185,14 @@ class InputChannelHandler : public DataChannelHandler {
     }
     return {};
   }
+
+ private:
+  Result<void> OnBinaryMessage(const uint8_t *data, size_t size) {
+    CF_EXPECT(binary_input_.Decode(data, size, *observer()));
+    return {};
+  }
+
+  BinaryInputDecoder binary_input_;
 };
 
 class ControlChannelHandler : public DataChannelHandler {
@@ -21,6 +21,7 @@
 
 #include <api/data_channel_interface.h>
 
+#include "cuttlefish/host/frontend/webrtc/libdevice/binary_input.h"
 #include "cuttlefish/host/frontend/webrtc/libdevice/connection_observer.h"
 
 namespace cuttlefish {
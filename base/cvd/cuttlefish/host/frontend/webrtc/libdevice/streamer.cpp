@@ -39,6 +39,7 @@
 #include "cuttlefish/host/frontend/webrtc/libdevice/audio_track_source_impl.h"
 #include "cuttlefish/host/frontend/webrtc/libdevice/camera_streamer.h"
 #include "cuttlefish/host/frontend/webrtc/libdevice/client_handler.h"
+#include "cuttlefish/host/frontend/webrtc/libdevice/data_channels.h"
 #include "cuttlefish/host/frontend/webrtc/libdevice/server_connection.h"
 #include "cuttlefish/host/frontend/webrtc/libdevice/video_track_source_impl.h"
 #include "cuttlefish/host/frontend/webrtc_operator/constants/signaling_constants.h"
@@ -72,6 +73,7 @@ constexpr auto kControlPanelButtonHingeAngleValue = "hinge_angle_value";
 constexpr auto kCustomControlPanelButtonsField = "custom_control_panel_buttons";
 constexpr auto kMouseEnabled = "mouse_enabled";
 constexpr auto kGamepadEnabled = "gamepad_enabled";
+constexpr auto kBinaryInputVersionField = "binary_input_version";
 
 constexpr int kRegistrationRetries = 3;
 constexpr int kRetryFirstIntervalMs = 1000;
@@ -231,7 +233,8 @@ std::unique_ptr<Streamer> Streamer::Create(
 
   auto result = CreatePeerConnectionFactory(
       impl->network_thread_.get(), impl->worker_thread_.get(),
-      impl->signal_thread_.get(), impl->audio_device_module_->device_module());
+      impl->signal_thread_.get(), impl->audio_device_module_->device_module(),
+      cfg.video_codecs);
 
   if (!result.ok()) {
     LOG(ERROR) << result.error();
@@ -485,6 +488,8 @@ void Streamer::Impl::OnOpen() {
     device_info[kMouseEnabled] = config_.enable_mouse;
     // Add gamepad button conditionally.
     device_info[kGamepadEnabled] = config_.enable_gamepad;
+    // Clients may send binary input messages of this version instead of JSON.
+    device_info[kBinaryInputVersionField] = kBinaryInputVersion;
 
     device_info[kCustomControlPanelButtonsField] = custom_control_panel_buttons;
     register_obj[cuttlefish::webrtc_signaling::kDeviceInfoField] = device_info;
@@ -58,6 +58,8 @@ struct StreamerConfig {
   bool enable_mouse;
   // Whether gamepad is enabled.
   bool enable_gamepad;
+  // The video codecs offered to clients, most preferred first.
+  std::vector<std::string> video_codecs = {"VP8"};
 };
 
 class OperatorObserver {
@@ -28,6 +28,12 @@ class VideoSink {
   virtual ~VideoSink() = default;
   virtual void OnFrame(std::shared_ptr<VideoFrameBuffer> frame,
                        int64_t timestamp_us) = 0;
+  // Whether any consumer, e.g. a client's encoder or a recorder, currently
+  // takes the frames.
+  virtual bool FrameWanted() const = 0;
+  // The lowest of the frame rates the consumers asked for, e.g. after adapting
+  // to the available bandwidth, or std::numeric_limits<int>::max().
+  virtual int MaxFramerate() const = 0;
 };
 
 }  // namespace webrtc_streaming
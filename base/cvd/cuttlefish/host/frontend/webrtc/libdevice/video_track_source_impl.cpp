@@ -63,6 +63,14 @@ void VideoTrackSourceImpl::OnFrame(std::shared_ptr<VideoFrameBuffer> frame,
   broadcaster_.OnFrame(video_frame);
 }
 
+bool VideoTrackSourceImpl::FrameWanted() const {
+  return broadcaster_.frame_wanted();
+}
+
+int VideoTrackSourceImpl::MaxFramerate() const {
+  return broadcaster_.wants().max_framerate_fps;
+}
+
 bool VideoTrackSourceImpl::GetStats(Stats *stats) {
   stats->input_height = height_;
   stats->input_width = width_;
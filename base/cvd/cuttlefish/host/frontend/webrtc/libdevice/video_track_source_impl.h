@@ -29,6 +29,8 @@ class VideoTrackSourceImpl : public webrtc::VideoTrackSource {
   VideoTrackSourceImpl(int width, int height);
 
   void OnFrame(std::shared_ptr<VideoFrameBuffer> frame, int64_t timestamp_us);
+  bool FrameWanted() const;
+  int MaxFramerate() const;
 
   // Returns false if no stats are available, e.g, for a remote source, or a
   // source which has not seen its first frame yet.
@@ -69,6 +71,14 @@ class VideoTrackSourceImplSinkWrapper : public VideoSink {
     track_source_impl_->OnFrame(frame, timestamp_us);
   }
 
+  bool FrameWanted() const override {
+    return track_source_impl_->FrameWanted();
+  }
+
+  int MaxFramerate() const override {
+    return track_source_impl_->MaxFramerate();
+  }
+
  private:
   rtc::scoped_refptr<VideoTrackSourceImpl> track_source_impl_;
 };
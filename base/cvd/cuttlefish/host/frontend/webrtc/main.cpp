@@ -37,6 +37,7 @@
 #include "cuttlefish/host/frontend/webrtc/connection_observer.h"
 #include "cuttlefish/host/frontend/webrtc/display_handler.h"
 #include "cuttlefish/host/frontend/webrtc/kernel_log_events_handler.h"
+#include "cuttlefish/host/frontend/webrtc/latency_histogram.h"
 #include "cuttlefish/host/frontend/webrtc/libdevice/camera_controller.h"
 #include "cuttlefish/host/frontend/webrtc/libdevice/lights_observer.h"
 #include "cuttlefish/host/frontend/webrtc/libdevice/local_recorder.h"
@@ -137,6 +138,26 @@ CreateConfirmationUIComponent(int* frames_fd, bool* frames_are_rgba,
       .bindInstance(*input_connector);
 }
 
+void FillDisplayStats(DisplayHandler& display_handler,
+                      webrtc::DisplayStatsResponse& stats) {
+  for (const auto& [display_number, latencies] :
+       display_handler.FrameLatencies()) {
+    webrtc::DisplayStats& display = *stats.add_displays();
+    display.set_display_number(display_number);
+    for (size_t i = 0; i < LatencyHistogram::kNumBuckets; i++) {
+      webrtc::LatencyHistogramBucket& bucket =
+          *display.add_commit_to_encoder_latency();
+      if (i + 1 < LatencyHistogram::kNumBuckets) {
+        bucket.set_upper_bound_us(LatencyHistogram::BucketLimit(i).count());
+      }
+      bucket.set_count(latencies.Counts()[i]);
+    }
+    display.set_frames(latencies.Count());
+    display.set_total_latency_us(latencies.Total().count());
+    display.set_max_latency_us(latencies.Max().count());
+  }
+}
+
 Result<void> ControlLoop(SharedFD control_socket,
                          DisplayHandler& display_handler,
                          RecordingManager& recording_manager,
@@ -145,6 +166,7 @@ Result<void> ControlLoop(SharedFD control_socket,
   while (true) {
     webrtc::WebrtcCommandRequest request = CF_EXPECT(channel.ReceiveRequest());
 
+    webrtc::WebrtcCommandResponse response;
     Result<void> command_result = {};
     if (request.has_start_recording_request()) {
       LOG(INFO) << "Received command to start recording in main.cpp.";
@@ -154,14 +176,25 @@ Result<void> ControlLoop(SharedFD control_socket,
       recording_manager.Stop();
     } else if (request.has_screenshot_display_request()) {
       const auto& screenshot_request = request.screenshot_display_request();
-      LOG(INFO) << "Received command to screenshot display "
-                << screenshot_request.display_number() << "in main.cpp.";
+      ScreenshotOptions options;
+      if (screenshot_request.has_compression_level()) {
+        options.level = screenshot_request.compression_level();
+      }
 
       display_handler.AddDisplayClient();
 
-      command_result =
-          screenshot_handler.Screenshot(screenshot_request.display_number(),
-                                        screenshot_request.screenshot_path());
+      if (screenshot_request.all_displays()) {
+        LOG(INFO) << "Received command to screenshot all displays in main.cpp.";
+        command_result = screenshot_handler.ScreenshotDisplays(
+            display_handler.DisplayNumbers(),
+            screenshot_request.screenshot_path(), options);
+      } else {
+        LOG(INFO) << "Received command to screenshot display "
+                  << screenshot_request.display_number() << "in main.cpp.";
+        command_result = screenshot_handler.Screenshot(
+            screenshot_request.display_number(),
+            screenshot_request.screenshot_path(), options);
+      }
 
       display_handler.RemoveDisplayClient();
 
@@ -171,11 +204,12 @@ Result<void> ControlLoop(SharedFD control_socket,
                    << screenshot_request.screenshot_path() << ":"
                    << command_result.error().Message();
       }
+    } else if (request.has_display_stats_request()) {
+      FillDisplayStats(display_handler, *response.mutable_display_stats());
     } else {
       LOG(FATAL) << "Unhandled request: " << request.DebugString();
     }
 
-    webrtc::WebrtcCommandResponse response;
     auto* response_status = response.mutable_status();
     if (command_result.ok()) {
       response_status->set_code(google::rpc::Code::OK);
@@ -224,6 +258,18 @@ uint32_t ConvertSampleRate(::cuttlefish::config::Audio_SampleRate rate) {
   return 48000;
 }
 
+AudioResamplerQuality ConvertResampler(
+    ::cuttlefish::config::Audio_Resampler resampler) {
+  using Resampler = ::cuttlefish::config::Audio_Resampler;
+  switch (resampler) {
+    case Resampler::Audio_Resampler_RESAMPLER_LINEAR:
+      return AudioResamplerQuality::Linear;
+    case Resampler::Audio_Resampler_RESAMPLER_POLYPHASE:
+    default:
+      return AudioResamplerQuality::Polyphase;
+  }
+}
+
 cuttlefish::AudioStreamSettings ParseAudioStreamSettings(
     const ::cuttlefish::config::Audio_PCMDevice_Stream& stream,
     AudioStreamSettings::Direction direction) {
@@ -292,6 +338,9 @@ std::shared_ptr<AudioHandler> SetupAudio(
       if (mixer.has_sample_rate()) {
         mixer_settings.sample_rate = ConvertSampleRate(mixer.sample_rate());
       }
+      if (mixer.has_resampler()) {
+        mixer_settings.resampler_quality = ConvertResampler(mixer.resampler());
+      }
     }
   }
 
@@ -406,6 +455,7 @@ int CuttlefishMain() {
   streamer_config.operator_path = cvd_config->sig_server_address();
   streamer_config.enable_mouse = instance.enable_mouse();
   streamer_config.enable_gamepad = instance.enable_gamepad();
+  streamer_config.video_codecs = instance.webrtc_video_codecs();
 
   KernelLogEventsHandler kernel_logs_event_handler(kernel_log_events_client);
 
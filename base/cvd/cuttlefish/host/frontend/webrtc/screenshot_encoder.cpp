@@ -0,0 +1,414 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/frontend/webrtc/screenshot_encoder.h"
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/cleanup/cleanup.h"
+#include "absl/strings/match.h"
+#include "jpeglib.h"
+#include "libyuv.h"
+#include "zlib.h"
+
+#include "cuttlefish/posix/strerror.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr int kBytesPerPixel = 3;
+// Even, so that strips never split a chroma row.
+constexpr int kMinStripRows = 64;
+constexpr int kMaxStrips = 8;
+constexpr int kDefaultPngLevel = 6;
+// Up to this level all the rows use the Sub filter.
+constexpr int kMaxFastPngLevel = 3;
+constexpr int kDefaultJpegQuality = 100;
+// Above this quality the fast DCT loses accuracy.
+constexpr int kMaxFastDctQuality = 90;
+
+enum PngFilter : uint8_t {
+  kNone = 0,
+  kSub,
+  kUp,
+  kAverage,
+  kPaeth,
+  kNumFilters,
+};
+
+uint8_t PaethPredictor(int a, int b, int c) {
+  const int p = a + b - c;
+  const int pa = abs(p - a);
+  const int pb = abs(p - b);
+  const int pc = abs(p - c);
+  if (pa <= pb && pa <= pc) {
+    return a;
+  }
+  return pb <= pc ? b : c;
+}
+
+// prior is the row above, all zeros for the first row of the image.
+void FilterRow(PngFilter filter, const uint8_t* row, const uint8_t* prior,
+               size_t size, uint8_t* out) {
+  constexpr size_t kBpp = kBytesPerPixel;
+  switch (filter) {
+    case kNone:
+      memcpy(out, row, size);
+      break;
+    case kSub:
+      memcpy(out, row, kBpp);
+      for (size_t i = kBpp; i < size; i++) {
+        out[i] = row[i] - row[i - kBpp];
+      }
+      break;
+    case kUp:
+      for (size_t i = 0; i < size; i++) {
+        out[i] = row[i] - prior[i];
+      }
+      break;
+    case kAverage:
+      for (size_t i = 0; i < kBpp; i++) {
+        out[i] = row[i] - (prior[i] >> 1);
+      }
+      for (size_t i = kBpp; i < size; i++) {
+        out[i] = row[i] - ((row[i - kBpp] + prior[i]) >> 1);
+      }
+      break;
+    case kPaeth:
+      for (size_t i = 0; i < kBpp; i++) {
+        out[i] = row[i] - prior[i];
+      }
+      for (size_t i = kBpp; i < size; i++) {
+        out[i] = row[i] - PaethPredictor(row[i - kBpp], prior[i],
+                                         prior[i - kBpp]);
+      }
+      break;
+    case kNumFilters:
+      break;
+  }
+}
+
+// The heuristic libpng uses to pick the filter of a row: the lowest sum of
+// the filtered bytes taken as signed.
+uint64_t FilterCost(const uint8_t* filtered, size_t size) {
+  uint64_t cost = 0;
+  for (size_t i = 0; i < size; i++) {
+    cost += abs(static_cast<int8_t>(filtered[i]));
+  }
+  return cost;
+}
+
+Result<void> ConvertRows(VideoFrameBuffer& frame, int first_row, int rows,
+                         uint8_t* rgb) {
+  const int chroma_row = first_row / 2;
+  const int convert_res = libyuv::I420ToRAW(
+      frame.DataY() + first_row * frame.StrideY(), frame.StrideY(),
+      frame.DataU() + chroma_row * frame.StrideU(), frame.StrideU(),
+      frame.DataV() + chroma_row * frame.StrideV(), frame.StrideV(), rgb,
+      frame.width() * kBytesPerPixel, frame.width(), rows);
+  CF_EXPECT(convert_res == 0, "Failed to convert I420 frame to RGB");
+  return {};
+}
+
+struct PngStrip {
+  // A piece of the raw deflate stream, ending in a sync flush or, for the
+  // last strip, the final block.
+  std::vector<uint8_t> deflated;
+  uLong adler;
+  size_t filtered_size;
+};
+
+Result<PngStrip> EncodePngStrip(VideoFrameBuffer& frame, int first_row,
+                                int end_row, int level) {
+  const size_t row_size = static_cast<size_t>(frame.width()) * kBytesPerPixel;
+  const int rows = end_row - first_row;
+  // The row above the strip is converted too, for the filters using it. It's
+  // converted on its own since it uses another chroma row.
+  std::vector<uint8_t> rgb(row_size * (rows + 1));
+  if (first_row > 0) {
+    CF_EXPECT(ConvertRows(frame, first_row - 1, 1, rgb.data()));
+  }
+  CF_EXPECT(ConvertRows(frame, first_row, rows, rgb.data() + row_size));
+
+  std::vector<uint8_t> filtered((row_size + 1) * rows);
+  std::vector<uint8_t> candidate(row_size);
+  std::vector<uint8_t> best(row_size);
+  for (int r = 0; r < rows; r++) {
+    const uint8_t* row = &rgb[(r + 1) * row_size];
+    const uint8_t* prior = &rgb[r * row_size];
+    uint8_t* out = &filtered[r * (row_size + 1)];
+    if (level == 0) {
+      out[0] = kNone;
+      FilterRow(kNone, row, prior, row_size, out + 1);
+    } else if (level <= kMaxFastPngLevel) {
+      out[0] = kSub;
+      FilterRow(kSub, row, prior, row_size, out + 1);
+    } else {
+      uint64_t best_cost = UINT64_MAX;
+      for (uint8_t filter = kNone; filter < kNumFilters; filter++) {
+        FilterRow(static_cast<PngFilter>(filter), row, prior, row_size,
+                  candidate.data());
+        const uint64_t cost = FilterCost(candidate.data(), row_size);
+        if (cost < best_cost) {
+          best_cost = cost;
+          out[0] = filter;
+          std::swap(candidate, best);
+        }
+      }
+      memcpy(out + 1, best.data(), row_size);
+    }
+  }
+
+  z_stream stream = {};
+  // Raw deflate, the zlib header and checksum are added for the whole image.
+  const int init_res =
+      deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8,
+                   level == 0 ? Z_DEFAULT_STRATEGY : Z_FILTERED);
+  CF_EXPECTF(init_res == Z_OK, "Failed to initialize deflate: {}", init_res);
+  absl::Cleanup end_deflate = [&stream]() { deflateEnd(&stream); };
+
+  const bool last = end_row == frame.height();
+  // The sync flush adds an empty stored block to the bound.
+  constexpr size_t kSyncFlushBytes = 16;
+  PngStrip strip;
+  strip.deflated.resize(deflateBound(&stream, filtered.size()) +
+                        kSyncFlushBytes);
+  stream.next_in = filtered.data();
+  stream.avail_in = filtered.size();
+  stream.next_out = strip.deflated.data();
+  stream.avail_out = strip.deflated.size();
+  // Once flushed, the next strip's stream continues this one since neither
+  // refers to the other's data.
+  const int deflate_res = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+  CF_EXPECTF(deflate_res == (last ? Z_STREAM_END : Z_OK) &&
+                 stream.avail_in == 0 && stream.avail_out > 0,
+             "Failed to deflate rows {} to {}: {}", first_row, end_row,
+             deflate_res);
+  strip.deflated.resize(stream.total_out);
+  strip.adler = adler32(adler32(0, Z_NULL, 0), filtered.data(),
+                        filtered.size());
+  strip.filtered_size = filtered.size();
+  return strip;
+}
+
+void PutBigEndian32(uint32_t value, uint8_t* out) {
+  out[0] = value >> 24;
+  out[1] = value >> 16;
+  out[2] = value >> 8;
+  out[3] = value;
+}
+
+Result<void> WritePngChunk(FILE* file, const char* type, const uint8_t* data,
+                           size_t size) {
+  uint8_t header[8];
+  PutBigEndian32(size, header);
+  memcpy(header + 4, type, 4);
+  uLong crc = crc32(0, header + 4, 4);
+  if (size > 0) {
+    crc = crc32(crc, data, size);
+  }
+  uint8_t trailer[4];
+  PutBigEndian32(crc, trailer);
+  CF_EXPECTF(fwrite(header, 1, sizeof(header), file) == sizeof(header) &&
+                 fwrite(data, 1, size, file) == size &&
+                 fwrite(trailer, 1, sizeof(trailer), file) == sizeof(trailer),
+             "Failed to write the {} chunk: {}", type, StrError(errno));
+  return {};
+}
+
+Result<void> WritePng(VideoFrameBuffer& frame, FILE* file, int level) {
+  CF_EXPECTF(level >= 0 && level <= 9, "Invalid PNG compression level {}",
+             level);
+  const int height = frame.height();
+  // Not bound by the number of cores, so that the image is the same on every
+  // host.
+  const int num_strips = std::clamp<int>(height / kMinStripRows, 1, kMaxStrips);
+  // Rounded up to even rows.
+  const int strip_rows = ((height + num_strips - 1) / num_strips + 1) & ~1;
+
+  // The first strip is encoded on this thread.
+  std::vector<std::future<Result<PngStrip>>> pending;
+  for (int first_row = strip_rows; first_row < height;
+       first_row += strip_rows) {
+    pending.emplace_back(std::async(std::launch::async, EncodePngStrip,
+                                    std::ref(frame), first_row,
+                                    std::min(first_row + strip_rows, height),
+                                    level));
+  }
+  std::vector<PngStrip> strips;
+  strips.emplace_back(CF_EXPECT(
+      EncodePngStrip(frame, 0, std::min(strip_rows, height), level)));
+  for (auto& strip : pending) {
+    strips.emplace_back(CF_EXPECT(strip.get()));
+  }
+
+  // The zlib header: a deflate stream with a 32KiB window, and the level.
+  constexpr uint8_t kCmf = 0x78;
+  const int flevel = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+  uint8_t flg = flevel << 6;
+  flg += (31 - (kCmf * 256 + flg) % 31) % 31;
+  strips.front().deflated.insert(strips.front().deflated.begin(), {kCmf, flg});
+  uLong adler = adler32(0, Z_NULL, 0);
+  for (const PngStrip& strip : strips) {
+    adler = adler32_combine(adler, strip.adler, strip.filtered_size);
+  }
+  std::vector<uint8_t>& last_deflated = strips.back().deflated;
+  last_deflated.resize(last_deflated.size() + 4);
+  PutBigEndian32(adler, &last_deflated[last_deflated.size() - 4]);
+
+  constexpr uint8_t kSignature[] = {0x89, 'P',  'N',  'G',
+                                    '\r', '\n', 0x1a, '\n'};
+  CF_EXPECTF(fwrite(kSignature, 1, sizeof(kSignature), file) ==
+                 sizeof(kSignature),
+             "Failed to write the PNG signature: {}", StrError(errno));
+  uint8_t ihdr[13];
+  PutBigEndian32(frame.width(), ihdr);
+  PutBigEndian32(height, ihdr + 4);
+  ihdr[8] = 8;  // Bit depth
+  ihdr[9] = 2;  // RGB
+  ihdr[10] = 0;  // Deflate
+  ihdr[11] = 0;  // Adaptive filtering
+  ihdr[12] = 0;  // No interlace
+  CF_EXPECT(WritePngChunk(file, "IHDR", ihdr, sizeof(ihdr)));
+  for (const PngStrip& strip : strips) {
+    CF_EXPECT(WritePngChunk(file, "IDAT", strip.deflated.data(),
+                            strip.deflated.size()));
+  }
+  CF_EXPECT(WritePngChunk(file, "IEND", nullptr, 0));
+  return {};
+}
+
+Result<void> WriteJpeg(VideoFrameBuffer& frame, FILE* file, int quality) {
+  CF_EXPECTF(quality >= 1 && quality <= 100, "Invalid JPEG quality {}",
+             quality);
+  // libjpeg uses an MCU size of 16x16 so we require the stride to be a multiple
+  // of 16 bytes and to have at least 16 rows (we'll use the previous rows as
+  // padding if the height is not a multiple of 16).
+  // In practice this restriction will hold most times because the
+  // CvdVideoFrameBuffer aligns its stride to a multiple of 64.
+  CF_EXPECTF(frame.StrideY() % 16 == 0 && frame.height() >= 16,
+             "Frame size not compatible with required MCU size of 16x16: {}x{}",
+             frame.width(), frame.height());
+
+  struct jpeg_compress_struct cinfo;
+  struct jpeg_error_mgr jerr;
+
+  // This actually causes libjpeg to exit on error, but that's better than the
+  // recommended approach of jumping around goto-style. The only function that
+  // could cause this is jpeg_write_raw_data, which is unlikely to fail anyways.
+  cinfo.err = jpeg_std_error(&jerr);
+  jpeg_create_compress(&cinfo);
+  absl::Cleanup destroy_compress = [&cinfo]() {
+    jpeg_destroy_compress(&cinfo);
+  };
+  jpeg_stdio_dest(&cinfo, file);
+
+  cinfo.image_width = frame.width();
+  cinfo.image_height = frame.height();
+  cinfo.input_components = 3;
+  cinfo.in_color_space = JCS_YCbCr;
+  jpeg_set_defaults(&cinfo);
+  jpeg_set_quality(&cinfo, quality, true);
+  if (quality <= kMaxFastDctQuality) {
+    cinfo.dct_method = JDCT_IFAST;
+  }
+  // Frame is already in YCbCr format with the right downsampling.
+  cinfo.raw_data_in = true;
+  jpeg_set_colorspace(&cinfo, JCS_YCbCr);
+  // jpeg_set_defaults should have set these, but libjpeg recommends setting
+  // them manually anyways.
+  cinfo.comp_info[0].h_samp_factor = 2;
+  cinfo.comp_info[0].v_samp_factor = 2;
+  cinfo.comp_info[1].h_samp_factor = 1;
+  cinfo.comp_info[1].v_samp_factor = 1;
+  cinfo.comp_info[2].h_samp_factor = 1;
+  cinfo.comp_info[2].v_samp_factor = 1;
+
+  // libjpeg accepts no less than 16 rows at a time
+  constexpr int kScanRows = 16;
+  JSAMPROW y_rows[kScanRows];
+  JSAMPROW u_rows[kScanRows / 2];
+  JSAMPROW v_rows[kScanRows / 2];
+  JSAMPARRAY rows[]{y_rows, u_rows, v_rows};
+
+  jpeg_start_compress(&cinfo, true);
+
+  while (cinfo.next_scanline < cinfo.image_height) {
+    JDIMENSION row = cinfo.next_scanline;
+    // If the image height is not a multiple of kScanRows it will be padded with
+    // rows from the previous iteration.
+    for (int r = 0; r < kScanRows && r + row < cinfo.image_height; ++r) {
+      int offset = (row + r) * frame.StrideY();
+      y_rows[r] = &frame.DataY()[offset];
+    }
+    for (int r = 0;
+         r < kScanRows / 2 && r + row / 2 < (cinfo.image_height + 1) / 2; ++r) {
+      int offset_u = (row / 2 + r) * frame.StrideU();
+      u_rows[r] = &frame.DataU()[offset_u];
+      int offset_v = (row / 2 + r) * frame.StrideV();
+      v_rows[r] = &frame.DataV()[offset_v];
+    }
+    jpeg_write_raw_data(&cinfo, rows, kScanRows);
+  }
+
+  jpeg_finish_compress(&cinfo);
+
+  return {};
+}
+
+}  // namespace
+
+Result<void> CheckScreenshotPath(const std::string& path) {
+  if (!absl::EndsWith(path, ".jpg") && !absl::EndsWith(path, ".png")) {
+    return CF_ERR("Unsupport file format: " << path);
+  }
+  return {};
+}
+
+Result<void> WriteScreenshot(VideoFrameBuffer& frame, const std::string& path,
+                             const ScreenshotOptions& options) {
+  CF_EXPECT(CheckScreenshotPath(path));
+  const bool jpeg = absl::EndsWith(path, ".jpg");
+  FILE* outfile = fopen(path.c_str(), "wb");
+  CF_EXPECTF(outfile != NULL, "opening {} failed: {}", path, StrError(errno));
+  absl::Cleanup close_file = [outfile]() { fclose(outfile); };
+
+  if (jpeg) {
+    CF_EXPECT(
+        WriteJpeg(frame, outfile, options.level.value_or(kDefaultJpegQuality)));
+  } else {
+    CF_EXPECT(
+        WritePng(frame, outfile, options.level.value_or(kDefaultPngLevel)));
+  }
+  CF_EXPECTF(fflush(outfile) == 0, "Failed to write {}: {}", path,
+             StrError(errno));
+  return {};
+}
+
+}  // namespace cuttlefish
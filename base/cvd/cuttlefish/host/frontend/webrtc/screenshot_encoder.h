@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <optional>
+#include <string>
+
+#include "cuttlefish/host/libs/screen_connector/video_frame_buffer.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+
+struct ScreenshotOptions {
+  // The zlib level for PNG, from 0 (stored) to 9, and the quality for JPEG,
+  // from 1 to 100. The format's default when unset: 6 for PNG, which the
+  // lower levels beat on speed by far, and 100 for JPEG.
+  std::optional<int> level;
+};
+
+/** Fails for paths with the extension of a format that isn't supported. */
+Result<void> CheckScreenshotPath(const std::string& path);
+
+/**
+ * Writes the frame to the path, as a PNG or JPEG image depending on its
+ * extension.
+ *
+ * PNG images are encoded by strips of rows on several threads. Each strip is
+ * converted to RGB, filtered and deflated independently, and the deflate
+ * streams are joined into a single IDAT stream. The lowest levels use the
+ * cheap Sub filter, the others pick the best filter of each row like libpng.
+ */
+Result<void> WriteScreenshot(VideoFrameBuffer& frame, const std::string& path,
+                             const ScreenshotOptions& options);
+
+}  // namespace cuttlefish
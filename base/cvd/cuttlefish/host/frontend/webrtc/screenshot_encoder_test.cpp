@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/frontend/webrtc/screenshot_encoder.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "android-base/file.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "jpeglib.h"
+#include "libyuv.h"
+#include "png.h"
+
+#include "cuttlefish/host/frontend/webrtc/cvd_video_frame_buffer.h"
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+// A frame of random pixels, which no filter predicts.
+CvdVideoFrameBuffer NoiseFrame(int width, int height) {
+  CvdVideoFrameBuffer frame(width, height);
+  std::mt19937 rng(width * height);
+  for (size_t i = 0; i < frame.DataSizeY(); i++) {
+    frame.DataY()[i] = rng();
+  }
+  for (size_t i = 0; i < frame.DataSizeU(); i++) {
+    frame.DataU()[i] = rng();
+  }
+  for (size_t i = 0; i < frame.DataSizeV(); i++) {
+    frame.DataV()[i] = rng();
+  }
+  return frame;
+}
+
+// A frame of smooth gradients, which JPEG keeps close to the original.
+CvdVideoFrameBuffer GradientFrame(int width, int height) {
+  CvdVideoFrameBuffer frame(width, height);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      frame.DataY()[y * frame.StrideY() + x] =
+          16 + (x + y) * 200 / (width + height);
+    }
+  }
+  const int chroma_width = (width + 1) / 2;
+  const int chroma_height = (height + 1) / 2;
+  for (int y = 0; y < chroma_height; y++) {
+    for (int x = 0; x < chroma_width; x++) {
+      frame.DataU()[y * frame.StrideU() + x] = 64 + x * 128 / chroma_width;
+      frame.DataV()[y * frame.StrideV() + x] = 64 + y * 128 / chroma_height;
+    }
+  }
+  return frame;
+}
+
+// The frame's pixels as interleaved Y, Cb and Cr, the chroma upsampled.
+std::vector<uint8_t> ToYCbCr(CvdVideoFrameBuffer& frame) {
+  std::vector<uint8_t> ycbcr;
+  for (int y = 0; y < frame.height(); y++) {
+    for (int x = 0; x < frame.width(); x++) {
+      ycbcr.push_back(frame.DataY()[y * frame.StrideY() + x]);
+      ycbcr.push_back(frame.DataU()[y / 2 * frame.StrideU() + x / 2]);
+      ycbcr.push_back(frame.DataV()[y / 2 * frame.StrideV() + x / 2]);
+    }
+  }
+  return ycbcr;
+}
+
+std::vector<uint8_t> ToRgb(CvdVideoFrameBuffer& frame) {
+  std::vector<uint8_t> rgb(frame.width() * frame.height() * 3);
+  libyuv::I420ToRAW(frame.DataY(), frame.StrideY(), frame.DataU(),
+                    frame.StrideU(), frame.DataV(), frame.StrideV(),
+                    rgb.data(), frame.width() * 3, frame.width(),
+                    frame.height());
+  return rgb;
+}
+
+std::vector<uint8_t> DecodePng(const std::string& path, int width,
+                               int height) {
+  png_image image = {};
+  image.version = PNG_IMAGE_VERSION;
+  if (!png_image_begin_read_from_file(&image, path.c_str())) {
+    ADD_FAILURE() << "Failed to read " << path << ": " << image.message;
+    return {};
+  }
+  EXPECT_EQ(image.width, width);
+  EXPECT_EQ(image.height, height);
+  image.format = PNG_FORMAT_RGB;
+  std::vector<uint8_t> rgb(PNG_IMAGE_SIZE(image));
+  if (!png_image_finish_read(&image, nullptr, rgb.data(), 0, nullptr)) {
+    ADD_FAILURE() << "Failed to decode " << path << ": " << image.message;
+    return {};
+  }
+  return rgb;
+}
+
+// Decodes to YCbCr, the color space the frame is written in.
+std::vector<uint8_t> DecodeJpeg(const std::string& path, int width,
+                                int height) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    ADD_FAILURE() << "Failed to open " << path;
+    return {};
+  }
+  struct jpeg_decompress_struct cinfo;
+  struct jpeg_error_mgr jerr;
+  cinfo.err = jpeg_std_error(&jerr);
+  jpeg_create_decompress(&cinfo);
+  jpeg_stdio_src(&cinfo, file);
+  jpeg_read_header(&cinfo, true);
+  cinfo.out_color_space = JCS_YCbCr;
+  jpeg_start_decompress(&cinfo);
+  EXPECT_EQ(cinfo.output_width, width);
+  EXPECT_EQ(cinfo.output_height, height);
+  std::vector<uint8_t> ycbcr(cinfo.output_width * cinfo.output_height * 3);
+  while (cinfo.output_scanline < cinfo.output_height) {
+    JSAMPROW row = &ycbcr[cinfo.output_scanline * cinfo.output_width * 3];
+    jpeg_read_scanlines(&cinfo, &row, 1);
+  }
+  jpeg_finish_decompress(&cinfo);
+  jpeg_destroy_decompress(&cinfo);
+  fclose(file);
+  return ycbcr;
+}
+
+// Level, width and height. 300 rows are encoded as 4 strips.
+class PngScreenshotTest
+    : public ::testing::TestWithParam<std::tuple<int, int, int>> {};
+
+TEST_P(PngScreenshotTest, DecodesToTheRgbFrame) {
+  const auto [level, width, height] = GetParam();
+  CvdVideoFrameBuffer frame = NoiseFrame(width, height);
+  TemporaryDir dir;
+  const std::string path = std::string(dir.path) + "/screenshot.png";
+
+  ASSERT_THAT(WriteScreenshot(frame, path, {.level = level}), IsOk());
+
+  EXPECT_EQ(DecodePng(path, width, height), ToRgb(frame));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    Levels, PngScreenshotTest,
+    ::testing::Combine(::testing::Range(0, 10), ::testing::Values(200, 37),
+                       ::testing::Values(300, 131, 1)));
+
+TEST(ScreenshotTest, PngRejectsInvalidLevel) {
+  CvdVideoFrameBuffer frame = NoiseFrame(16, 16);
+  TemporaryDir dir;
+  const std::string path = std::string(dir.path) + "/screenshot.png";
+
+  EXPECT_THAT(WriteScreenshot(frame, path, {.level = 10}), IsError());
+}
+
+TEST(ScreenshotTest, JpegDecodesCloseToTheFrame) {
+  constexpr int kWidth = 200;
+  constexpr int kHeight = 150;
+  CvdVideoFrameBuffer frame = GradientFrame(kWidth, kHeight);
+  TemporaryDir dir;
+  const std::string path = std::string(dir.path) + "/screenshot.jpg";
+
+  ASSERT_THAT(WriteScreenshot(frame, path, {}), IsOk());
+
+  const std::vector<uint8_t> decoded = DecodeJpeg(path, kWidth, kHeight);
+  const std::vector<uint8_t> expected = ToYCbCr(frame);
+  ASSERT_EQ(decoded.size(), expected.size());
+  uint64_t total_difference = 0;
+  for (size_t i = 0; i < decoded.size(); i++) {
+    total_difference += abs(decoded[i] - expected[i]);
+  }
+  EXPECT_LT(total_difference / decoded.size(), 2);
+}
+
+TEST(ScreenshotTest, RejectsUnknownExtensions) {
+  CvdVideoFrameBuffer frame = NoiseFrame(16, 16);
+  TemporaryDir dir;
+  const std::string path = std::string(dir.path) + "/screenshot.bmp";
+
+  EXPECT_THAT(WriteScreenshot(frame, path, {}), IsError());
+}
+
+}  // namespace
+}  // namespace cuttlefish
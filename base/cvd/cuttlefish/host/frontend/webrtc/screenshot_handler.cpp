@@ -17,190 +17,155 @@
 #include "cuttlefish/host/frontend/webrtc/screenshot_handler.h"
 
 #include <errno.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
-#include <strings.h>
+#include <unistd.h>
 
+#include <chrono>
+#include <functional>
+#include <future>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
-#include "absl/cleanup/cleanup.h"
-#include "absl/strings/match.h"
-#include "jpeglib.h"
-#include "libyuv.h"
-#include "png.h"
+#include "absl/log/log.h"
+#include "fmt/format.h"
 
+#include "cuttlefish/host/frontend/webrtc/screenshot_encoder.h"
 #include "cuttlefish/posix/strerror.h"
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
 namespace {
 
-Result<void> PngScreenshot(std::shared_ptr<VideoFrameBuffer> frame,
-                           const std::string& screenshot_path) {
-  int width = frame->width();
-  int height = frame->height();
-  std::vector<uint8_t> rgb_frame(width * height * 3, 0);
-  auto convert_res =
-      libyuv::I420ToRAW(frame->DataY(), frame->StrideY(), frame->DataU(),
-                        frame->StrideU(), frame->DataV(), frame->StrideV(),
-                        rgb_frame.data(), frame->width() * 3, width, height);
-  CF_EXPECT(convert_res == 0, "Failed to convert I420 frame to RGB");
-  FILE* outfile = fopen(screenshot_path.c_str(), "wb");
-  CF_EXPECTF(outfile != NULL, "opening {} failed: {}", screenshot_path,
-             StrError(errno));
-  absl::Cleanup close_file = [outfile]() { fclose(outfile); };
-
-  png_structp png_ptr =
-      png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-  CF_EXPECT(png_ptr != nullptr, "Failed to create png write struct");
-  absl::Cleanup free_png_ptr = [&png_ptr]() {
-    png_destroy_write_struct(&png_ptr, (png_infopp)NULL);
-  };
-
-  png_infop info_ptr = png_create_info_struct(png_ptr);
-  CF_EXPECT(info_ptr != nullptr, "Failed to create png info struct");
-  absl::Cleanup free_info_ptr = [png_ptr, info_ptr]() {
-    png_free_data(png_ptr, info_ptr, PNG_FREE_ALL, -1);
-  };
-
-  png_init_io(png_ptr, outfile);
-
-  // Set header info
-  png_set_IHDR(png_ptr, info_ptr, width, height, 8, PNG_COLOR_TYPE_RGB,
-               PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_BASE,
-               PNG_FILTER_TYPE_BASE);
-
-  png_write_info(png_ptr, info_ptr);
-
-  for (int y = 0; y < height; ++y) {
-    png_write_row(png_ptr, rgb_frame.data() + y * width * 3);
+// Adds the display number before the extension: "shot.png" becomes
+// "shot_1.png" for display 1.
+std::string DisplayScreenshotPath(const std::string& screenshot_path,
+                                  uint32_t display_number) {
+  const size_t dot = screenshot_path.rfind('.');
+  const size_t slash = screenshot_path.rfind('/');
+  if (dot == std::string::npos ||
+      (slash != std::string::npos && dot < slash)) {
+    return fmt::format("{}_{}", screenshot_path, display_number);
   }
-
-  // Finalize
-  png_write_end(png_ptr, info_ptr);
-
-  return {};
+  return fmt::format("{}_{}{}", screenshot_path.substr(0, dot), display_number,
+                     screenshot_path.substr(dot));
 }
 
-Result<void> JpegScreenshot(std::shared_ptr<VideoFrameBuffer> frame,
-                            const std::string& screenshot_path) {
-  // libjpeg uses an MCU size of 16x16 so we require the stride to be a multiple
-  // of 16 bytes and to have at least 16 rows (we'll use the previous rows as
-  // padding if the height is not a multiple of 16).
-  // In practice this restriction will hold most times because the
-  // CvdVideoFrameBuffer aligns its stride to a multiple of 64.
-  CF_EXPECTF(frame->StrideY() % 16 == 0 && frame->height() >= 16,
-             "Frame size not compatible with required MCU size of 16x16: {}x{}",
-             frame->width(), frame->height());
-
-  struct jpeg_compress_struct cinfo;
-  struct jpeg_error_mgr jerr;
-  FILE* outfile; /* target file */
-
-  // This actually causes libjpeg to exit on error, but that's better than the
-  // recommended approach of jumping around goto-style. The only function that
-  // could cause this is jpeg_write_raw_data, which is unlikely to fail anyways.
-  cinfo.err = jpeg_std_error(&jerr);
-  jpeg_create_compress(&cinfo);
-  absl::Cleanup destroy_compress = [&cinfo]() {
-    jpeg_destroy_compress(&cinfo);
-  };
-
-  CF_EXPECTF((outfile = fopen(screenshot_path.c_str(), "wb")) != NULL,
-             "Failed to open screenshot destination ({})", screenshot_path);
-  absl::Cleanup close_file = [&outfile]() { fclose(outfile); };
-  jpeg_stdio_dest(&cinfo, outfile);
-
-  cinfo.image_width = frame->width();
-  cinfo.image_height = frame->height();
-  cinfo.input_components = 3;
-  cinfo.in_color_space = JCS_YCbCr;
-  jpeg_set_defaults(&cinfo);
-  const int kJpegQuality = 100;
-  jpeg_set_quality(&cinfo, kJpegQuality, true);
-  // Frame is already in YCbCr format with the right downsampling.
-  cinfo.raw_data_in = true;
-  jpeg_set_colorspace(&cinfo, JCS_YCbCr);
-  // jpeg_set_defaults should have set these, but libjpeg recommends setting
-  // them manually anyways.
-  cinfo.comp_info[0].h_samp_factor = 2;
-  cinfo.comp_info[0].v_samp_factor = 2;
-  cinfo.comp_info[1].h_samp_factor = 1;
-  cinfo.comp_info[1].v_samp_factor = 1;
-  cinfo.comp_info[2].h_samp_factor = 1;
-  cinfo.comp_info[2].v_samp_factor = 1;
-
-  // libjpeg accepts no less than 16 rows at a time
-  constexpr int kScanRows = 16;
-  JSAMPROW y_rows[kScanRows];
-  JSAMPROW u_rows[kScanRows / 2];
-  JSAMPROW v_rows[kScanRows / 2];
-  JSAMPARRAY rows[]{y_rows, u_rows, v_rows};
-
-  jpeg_start_compress(&cinfo, true);
-
-  while (cinfo.next_scanline < cinfo.image_height) {
-    JDIMENSION row = cinfo.next_scanline;
-    // If the image height is not a multiple of kScanRows it will be padded with
-    // rows from the previous iteration.
-    for (int r = 0; r < kScanRows && r + row < cinfo.image_height; ++r) {
-      int offset = (row + r) * frame->StrideY();
-      y_rows[r] = &frame->DataY()[offset];
-    }
-    for (int r = 0;
-         r < kScanRows / 2 && r + row / 2 < (cinfo.image_height + 1) / 2; ++r) {
-      int offset_u = (row / 2 + r) * frame->StrideU();
-      u_rows[r] = &frame->DataU()[offset_u];
-      int offset_v = (row / 2 + r) * frame->StrideV();
-      v_rows[r] = &frame->DataV()[offset_v];
-    }
-    jpeg_write_raw_data(&cinfo, rows, kScanRows);
+// Writes to a hidden file next to `path` and renames it, so that `path` only
+// appears once complete. The hidden file keeps the extension of `path`.
+Result<void> WriteScreenshotAtomically(VideoFrameBuffer& frame,
+                                       const std::string& path,
+                                       uint64_t write_id,
+                                       const ScreenshotOptions& options) {
+  const size_t slash = path.rfind('/');
+  const size_t name = slash == std::string::npos ? 0 : slash + 1;
+  const std::string partial = fmt::format(
+      "{}.{}.{}", path.substr(0, name), write_id, path.substr(name));
+  if (Result<void> written = WriteScreenshot(frame, partial, options);
+      !written.ok()) {
+    unlink(partial.c_str());
+    CF_EXPECT(std::move(written));
   }
-
-  jpeg_finish_compress(&cinfo);
-
+  CF_EXPECTF(rename(partial.c_str(), path.c_str()) == 0,
+             "Failed to rename '{}' to '{}': {}", partial, path,
+             StrError(errno));
   return {};
 }
 
 }  // namespace
 
-Result<void> ScreenshotHandler::Screenshot(uint32_t display_number,
-                                           const std::string& screenshot_path) {
-  SharedFrameFuture frame_future;
+Result<std::vector<ScreenshotHandler::SharedFrame>>
+ScreenshotHandler::TakeFrames(const std::vector<uint32_t>& display_numbers) {
+  std::vector<SharedFrameFuture> frame_futures;
   {
     std::lock_guard<std::mutex> lock(pending_screenshot_displays_mutex_);
 
-    auto [it, inserted] = pending_screenshot_displays_.emplace(
-        display_number, SharedFramePromise{});
-    if (!inserted) {
-      return CF_ERRF("Screenshot already pending for display {}",
-                     display_number);
+    for (uint32_t display_number : display_numbers) {
+      auto [it, inserted] = pending_screenshot_displays_.emplace(
+          display_number, SharedFramePromise{});
+      if (!inserted) {
+        for (size_t i = 0; i < frame_futures.size(); i++) {
+          pending_screenshot_displays_.erase(display_numbers[i]);
+        }
+        return CF_ERRF("Screenshot already pending for display {}",
+                       display_number);
+      }
+      frame_futures.emplace_back(it->second.get_future().share());
     }
-
-    frame_future = it->second.get_future().share();
   }
 
   static constexpr const int kScreenshotTimeoutSeconds = 5;
-  auto result =
-      frame_future.wait_for(std::chrono::seconds(kScreenshotTimeoutSeconds));
-  CF_EXPECT(result == std::future_status::ready,
-            "Failed to get screenshot from webrtc display handler within "
-                << kScreenshotTimeoutSeconds << " seconds.");
-
-  SharedFrame frame = frame_future.get();
-
-  if (absl::EndsWith(screenshot_path, ".jpg")) {
-    CF_EXPECT(JpegScreenshot(frame, screenshot_path));
-  } else if (absl::EndsWith(screenshot_path, ".png")) {
-    CF_EXPECT(PngScreenshot(frame, screenshot_path));
-  } else {
-    return CF_ERR("Unsupport file format: " << screenshot_path);
+  const auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::seconds(kScreenshotTimeoutSeconds);
+  std::vector<SharedFrame> frames;
+  for (size_t i = 0; i < frame_futures.size(); i++) {
+    CF_EXPECTF(
+        frame_futures[i].wait_until(deadline) == std::future_status::ready,
+        "Failed to get screenshot of display {} from webrtc display handler "
+        "within {} seconds.",
+        display_numbers[i], kScreenshotTimeoutSeconds);
+    frames.emplace_back(frame_futures[i].get());
+  }
+  return frames;
+}
+
+Result<void> ScreenshotHandler::Screenshot(uint32_t display_number,
+                                           const std::string& screenshot_path,
+                                           const ScreenshotOptions& options) {
+  CF_EXPECT(CheckScreenshotPath(screenshot_path));
+  std::vector<SharedFrame> frames = CF_EXPECT(TakeFrames({display_number}));
+  WriteInBackground(std::move(frames), {screenshot_path}, options);
+  return {};
+}
+
+Result<void> ScreenshotHandler::ScreenshotDisplays(
+    const std::vector<uint32_t>& display_numbers,
+    const std::string& screenshot_path, const ScreenshotOptions& options) {
+  CF_EXPECT(!display_numbers.empty(), "No display to screenshot");
+  CF_EXPECT(CheckScreenshotPath(screenshot_path));
+  std::vector<SharedFrame> frames = CF_EXPECT(TakeFrames(display_numbers));
+  std::vector<std::string> paths;
+  for (uint32_t display_number : display_numbers) {
+    paths.emplace_back(DisplayScreenshotPath(screenshot_path, display_number));
   }
+  WriteInBackground(std::move(frames), std::move(paths), options);
   return {};
 }
 
+void ScreenshotHandler::WriteInBackground(std::vector<SharedFrame> frames,
+                                          std::vector<std::string> paths,
+                                          const ScreenshotOptions& options) {
+  std::lock_guard<std::mutex> lock(writes_mutex_);
+  std::erase_if(writes_, [](const std::future<void>& write) {
+    return write.wait_for(std::chrono::seconds(0)) ==
+           std::future_status::ready;
+  });
+  const uint64_t write_id = next_write_id_++;
+  auto write_all = [frames = std::move(frames), paths = std::move(paths),
+                    write_id, options]() {
+    // The futures wait for their writes when destroyed, before the frames
+    // are, even if a write fails.
+    std::vector<std::future<Result<void>>> writes;
+    for (size_t i = 0; i < frames.size(); i++) {
+      writes.emplace_back(std::async(std::launch::async,
+                                     WriteScreenshotAtomically,
+                                     std::ref(*frames[i]), std::cref(paths[i]),
+                                     write_id, std::cref(options)));
+    }
+    for (size_t i = 0; i < writes.size(); i++) {
+      Result<void> written = writes[i].get();
+      if (!written.ok()) {
+        LOG(ERROR) << "Failed to write the screenshot " << paths[i] << ":\n"
+                   << written.error().FormatForEnv();
+      }
+    }
+  };
+  writes_.emplace_back(std::async(std::launch::async, std::move(write_all)));
+}
+
 void ScreenshotHandler::OnFrame(uint32_t display_number, SharedFrame& frame) {
   std::lock_guard<std::mutex> lock(pending_screenshot_displays_mutex_);
 
@@ -216,4 +181,9 @@ void ScreenshotHandler::OnFrame(uint32_t display_number, SharedFrame& frame) {
   pending_screenshot_displays_.erase(pending_screenshot_it);
 }
 
+bool ScreenshotHandler::IsPending(uint32_t display_number) {
+  std::lock_guard<std::mutex> lock(pending_screenshot_displays_mutex_);
+  return pending_screenshot_displays_.count(display_number) > 0;
+}
+
 }  // namespace cuttlefish
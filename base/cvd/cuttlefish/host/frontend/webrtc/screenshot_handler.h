@@ -23,7 +23,9 @@
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
+#include "cuttlefish/host/frontend/webrtc/screenshot_encoder.h"
 #include "cuttlefish/host/libs/screen_connector/video_frame_buffer.h"
 #include "cuttlefish/result/result.h"
 
@@ -38,16 +40,42 @@ class ScreenshotHandler {
   using SharedFrameFuture = std::shared_future<SharedFrame>;
   using SharedFramePromise = std::promise<SharedFrame>;
 
+  // Returns once the next frame of the display is taken. The screenshot is
+  // encoded in the background and only appears at screenshot_path once
+  // complete. Failures to write it are logged.
   Result<void> Screenshot(uint32_t display_number,
-                          const std::string& screenshot_path);
+                          const std::string& screenshot_path,
+                          const ScreenshotOptions& options = {});
+  // Screenshots all the displays at once, each to screenshot_path with the
+  // display number added before the extension. The frames are taken at the
+  // same time and encoded in parallel, in the background like Screenshot.
+  Result<void> ScreenshotDisplays(const std::vector<uint32_t>& display_numbers,
+                                  const std::string& screenshot_path,
+                                  const ScreenshotOptions& options = {});
 
   void OnFrame(uint32_t display_number, SharedFrame& frame);
+  // Whether a screenshot of the display is waiting for a frame.
+  bool IsPending(uint32_t display_number);
 
  private:
+  // Waits for the next frame of each of the displays.
+  Result<std::vector<SharedFrame>> TakeFrames(
+      const std::vector<uint32_t>& display_numbers);
+  // Writes each frame to its path, in parallel on other threads.
+  void WriteInBackground(std::vector<SharedFrame> frames,
+                         std::vector<std::string> paths,
+                         const ScreenshotOptions& options);
+
   std::mutex pending_screenshot_displays_mutex_;
   // Promises used to share a frame for a given display from the display handler
   // thread to the snapshot thread for processing.
   std::unordered_map<uint32_t, SharedFramePromise> pending_screenshot_displays_;
+
+  std::mutex writes_mutex_;
+  // Tells apart the partial files of writes to the same path.
+  uint64_t next_write_id_ = 0;
+  // Destroying them waits for the writes in flight.
+  std::vector<std::future<void>> writes_;
 };
 
 }  // namespace cuttlefish
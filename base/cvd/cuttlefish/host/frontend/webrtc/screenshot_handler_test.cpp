@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/frontend/webrtc/screenshot_handler.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "android-base/file.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/common/libs/utils/files.h"
+#include "cuttlefish/host/frontend/webrtc/cvd_video_frame_buffer.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+using testing::UnorderedElementsAre;
+
+// Sends a frame to every screenshot pending on the displays, like the display
+// handler does, until destroyed.
+class FrameSource {
+ public:
+  FrameSource(ScreenshotHandler& handler, std::vector<uint32_t> displays)
+      : thread_([this, &handler, displays]() {
+          while (running_) {
+            for (uint32_t display : displays) {
+              if (handler.IsPending(display)) {
+                ScreenshotHandler::SharedFrame frame =
+                    std::make_shared<CvdVideoFrameBuffer>(16, 16);
+                handler.OnFrame(display, frame);
+              }
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+          }
+        }) {}
+  ~FrameSource() {
+    running_ = false;
+    thread_.join();
+  }
+
+ private:
+  std::atomic_bool running_ = true;
+  std::thread thread_;
+};
+
+TEST(ScreenshotHandlerTest, WritesTheScreenshotOnceComplete) {
+  TemporaryDir dir;
+  const std::string path = std::string(dir.path) + "/shot.png";
+  {
+    ScreenshotHandler handler;
+    FrameSource source(handler, {0});
+
+    EXPECT_THAT(handler.Screenshot(0, path), IsOk());
+  }
+
+  // Destroying the handler waited for the write, which left no partial file.
+  EXPECT_THAT(DirectoryContents(dir.path),
+              IsOkAndValue(UnorderedElementsAre("shot.png")));
+}
+
+TEST(ScreenshotHandlerTest, WritesEveryDisplay) {
+  TemporaryDir dir;
+  {
+    ScreenshotHandler handler;
+    FrameSource source(handler, {0, 1});
+
+    EXPECT_THAT(handler.ScreenshotDisplays(
+                    {0, 1}, std::string(dir.path) + "/shot.jpg"),
+                IsOk());
+  }
+
+  EXPECT_THAT(DirectoryContents(dir.path),
+              IsOkAndValue(UnorderedElementsAre("shot_0.jpg", "shot_1.jpg")));
+}
+
+TEST(ScreenshotHandlerTest, UnsupportedFormatFailsWithoutTakingAFrame) {
+  TemporaryDir dir;
+  ScreenshotHandler handler;
+
+  EXPECT_THAT(handler.Screenshot(0, std::string(dir.path) + "/shot.bmp"),
+              IsError());
+  EXPECT_FALSE(handler.IsPending(0));
+}
+
+}  // namespace
+}  // namespace cuttlefish
@@ -0,0 +1,398 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <aom/aom_decoder.h>
+#include <aom/aomdx.h>
+#include <libyuv/compare.h>
+#include <time.h>
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "absl/strings/str_split.h"
+#include "api/video/i420_buffer.h"
+#include "api/video/video_bitrate_allocation.h"
+#include "api/video/video_frame.h"
+#include "api/video_codecs/builtin_video_encoder_factory.h"
+#include "api/video_codecs/scalability_mode.h"
+#include "api/video_codecs/sdp_video_format.h"
+#include "api/video_codecs/video_codec.h"
+#include "api/video_codecs/video_encoder.h"
+#include "fmt/format.h"
+#include "gflags/gflags.h"
+#include "vpx/vp8dx.h"
+#include "vpx/vpx_decoder.h"
+
+#include "cuttlefish/result/result.h"
+
+constexpr char kUsage[] = R"(
+NAME
+    video_codec_benchmark - compare the webrtc video encoders offline.
+
+SYNOPSIS
+    video_codec_benchmark --input=<frames.yuv> --width=<w> --height=<h>
+
+DESCRIPTION
+    Encodes the same frames with every codec the streamer can offer, at the
+    same target bitrate, and reports the achieved bitrate, the quality of the
+    decoded frames and the encoder CPU usage for each.
+
+    The input holds raw I420 frames back to back. A display recording made
+    with the webrtc local recorder can be converted with:
+
+   $ ffmpeg -i recording.webm -pix_fmt yuv420p -f rawvideo frames.yuv
+)";
+
+DEFINE_string(input, "", "File with raw I420 frames");
+DEFINE_uint32(width, 0, "Width of the frames");
+DEFINE_uint32(height, 0, "Height of the frames");
+DEFINE_uint32(fps, 30, "Frame rate the frames were captured at");
+DEFINE_uint32(bitrate_kbps, 2000, "Target bitrate for all codecs");
+DEFINE_uint32(max_frames, 0, "Stop after this many frames, 0 for all");
+DEFINE_string(codecs, "VP8,VP9,AV1", "Codecs to compare");
+
+namespace cuttlefish {
+namespace {
+
+constexpr int kRtpTicksPerSecond = 90000;
+constexpr int kKeyFrameInterval = 300;
+
+double ProcessCpuSeconds() {
+  timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+Result<std::vector<rtc::scoped_refptr<webrtc::I420Buffer>>> ReadFrames(
+    const std::string& path, int width, int height, size_t max_frames) {
+  std::ifstream input(path, std::ios::binary);
+  CF_EXPECTF(input.good(), "Failed to open '{}'", path);
+  std::vector<rtc::scoped_refptr<webrtc::I420Buffer>> frames;
+  while (max_frames == 0 || frames.size() < max_frames) {
+    rtc::scoped_refptr<webrtc::I420Buffer> frame =
+        webrtc::I420Buffer::Create(width, height);
+    auto read_plane = [&input](uint8_t* data, int stride, int w, int h) {
+      for (int row = 0; row < h; row++) {
+        input.read(reinterpret_cast<char*>(data + row * stride), w);
+      }
+      return input.good();
+    };
+    const int chroma_width = (width + 1) / 2;
+    const int chroma_height = (height + 1) / 2;
+    if (!read_plane(frame->MutableDataY(), frame->StrideY(), width, height) ||
+        !read_plane(frame->MutableDataU(), frame->StrideU(), chroma_width,
+                    chroma_height) ||
+        !read_plane(frame->MutableDataV(), frame->StrideV(), chroma_width,
+                    chroma_height)) {
+      break;
+    }
+    frames.push_back(std::move(frame));
+  }
+  CF_EXPECTF(!frames.empty(), "No complete frames in '{}'", path);
+  return frames;
+}
+
+class EncodedFrames : public webrtc::EncodedImageCallback {
+ public:
+  webrtc::EncodedImageCallback::Result OnEncodedImage(
+      const webrtc::EncodedImage& image,
+      const webrtc::CodecSpecificInfo*) override {
+    frames_.emplace_back(image.data(), image.data() + image.size());
+    return webrtc::EncodedImageCallback::Result(
+        webrtc::EncodedImageCallback::Result::OK);
+  }
+
+  std::vector<std::vector<uint8_t>> TakeFrames() { return std::move(frames_); }
+
+ private:
+  std::vector<std::vector<uint8_t>> frames_;
+};
+
+// Decodes with the reference decoders rather than the webrtc wrappers, which
+// don't include one for AV1.
+class Decoder {
+ public:
+  virtual ~Decoder() = default;
+
+  // Returns the PSNR of the decoded frame against `reference`.
+  virtual Result<double> DecodeAndCompare(
+      const std::vector<uint8_t>& data,
+      const webrtc::I420BufferInterface& reference) = 0;
+};
+
+double Psnr(const uint8_t* const planes[3], const int strides[3],
+            const webrtc::I420BufferInterface& reference) {
+  return libyuv::I420Psnr(planes[0], strides[0], planes[1], strides[1],
+                          planes[2], strides[2], reference.DataY(),
+                          reference.StrideY(), reference.DataU(),
+                          reference.StrideU(), reference.DataV(),
+                          reference.StrideV(), reference.width(),
+                          reference.height());
+}
+
+class VpxDecoder : public Decoder {
+ public:
+  static Result<std::unique_ptr<Decoder>> Create(vpx_codec_iface_t* iface) {
+    std::unique_ptr<VpxDecoder> decoder(new VpxDecoder());
+    CF_EXPECT_EQ(vpx_codec_dec_init(&decoder->context_, iface, nullptr, 0),
+                 VPX_CODEC_OK);
+    decoder->initialized_ = true;
+    return decoder;
+  }
+
+  ~VpxDecoder() override {
+    if (initialized_) {
+      vpx_codec_destroy(&context_);
+    }
+  }
+
+  Result<double> DecodeAndCompare(
+      const std::vector<uint8_t>& data,
+      const webrtc::I420BufferInterface& reference) override {
+    CF_EXPECTF(vpx_codec_decode(&context_, data.data(), data.size(), nullptr,
+                                0) == VPX_CODEC_OK,
+               "Failed to decode: {}", vpx_codec_error(&context_));
+    vpx_codec_iter_t iter = nullptr;
+    vpx_image_t* image = vpx_codec_get_frame(&context_, &iter);
+    CF_EXPECT(image != nullptr, "No decoded frame");
+    CF_EXPECT_EQ(image->fmt, VPX_IMG_FMT_I420);
+    const uint8_t* planes[3] = {image->planes[VPX_PLANE_Y],
+                                image->planes[VPX_PLANE_U],
+                                image->planes[VPX_PLANE_V]};
+    const int strides[3] = {image->stride[VPX_PLANE_Y],
+                            image->stride[VPX_PLANE_U],
+                            image->stride[VPX_PLANE_V]};
+    return Psnr(planes, strides, reference);
+  }
+
+ private:
+  VpxDecoder() = default;
+
+  vpx_codec_ctx_t context_;
+  bool initialized_ = false;
+};
+
+class AomDecoder : public Decoder {
+ public:
+  static Result<std::unique_ptr<Decoder>> Create() {
+    std::unique_ptr<AomDecoder> decoder(new AomDecoder());
+    CF_EXPECT_EQ(aom_codec_dec_init(&decoder->context_, aom_codec_av1_dx(),
+                                    nullptr, 0),
+                 AOM_CODEC_OK);
+    decoder->initialized_ = true;
+    return decoder;
+  }
+
+  ~AomDecoder() override {
+    if (initialized_) {
+      aom_codec_destroy(&context_);
+    }
+  }
+
+  Result<double> DecodeAndCompare(
+      const std::vector<uint8_t>& data,
+      const webrtc::I420BufferInterface& reference) override {
+    CF_EXPECTF(aom_codec_decode(&context_, data.data(), data.size(),
+                                nullptr) == AOM_CODEC_OK,
+               "Failed to decode: {}", aom_codec_error(&context_));
+    aom_codec_iter_t iter = nullptr;
+    aom_image_t* image = aom_codec_get_frame(&context_, &iter);
+    CF_EXPECT(image != nullptr, "No decoded frame");
+    CF_EXPECT_EQ(image->fmt, AOM_IMG_FMT_I420);
+    const uint8_t* planes[3] = {image->planes[AOM_PLANE_Y],
+                                image->planes[AOM_PLANE_U],
+                                image->planes[AOM_PLANE_V]};
+    const int strides[3] = {image->stride[AOM_PLANE_Y],
+                            image->stride[AOM_PLANE_U],
+                            image->stride[AOM_PLANE_V]};
+    return Psnr(planes, strides, reference);
+  }
+
+ private:
+  AomDecoder() = default;
+
+  aom_codec_ctx_t context_;
+  bool initialized_ = false;
+};
+
+Result<std::unique_ptr<Decoder>> CreateDecoder(webrtc::VideoCodecType type) {
+  switch (type) {
+    case webrtc::kVideoCodecVP8:
+      return CF_EXPECT(VpxDecoder::Create(vpx_codec_vp8_dx()));
+    case webrtc::kVideoCodecVP9:
+      return CF_EXPECT(VpxDecoder::Create(vpx_codec_vp9_dx()));
+    case webrtc::kVideoCodecAV1:
+      return CF_EXPECT(AomDecoder::Create());
+    default:
+      return CF_ERRF("No decoder for codec type {}", static_cast<int>(type));
+  }
+}
+
+webrtc::VideoCodec CodecSettings(webrtc::VideoCodecType type, int width,
+                                 int height) {
+  webrtc::VideoCodec codec;
+  codec.codecType = type;
+  codec.width = width;
+  codec.height = height;
+  codec.startBitrate = FLAGS_bitrate_kbps;
+  codec.maxBitrate = FLAGS_bitrate_kbps;
+  codec.minBitrate = 0;
+  codec.maxFramerate = FLAGS_fps;
+  codec.active = true;
+  codec.qpMax = 56;
+  codec.mode = webrtc::VideoCodecMode::kScreensharing;
+  // The streamer sends a single layer to each client.
+  codec.SetScalabilityMode(webrtc::ScalabilityMode::kL1T1);
+  switch (type) {
+    case webrtc::kVideoCodecVP8:
+      *codec.VP8() = webrtc::VideoEncoder::GetDefaultVp8Settings();
+      break;
+    case webrtc::kVideoCodecVP9:
+      *codec.VP9() = webrtc::VideoEncoder::GetDefaultVp9Settings();
+      codec.spatialLayers[0].width = width;
+      codec.spatialLayers[0].height = height;
+      codec.spatialLayers[0].maxFramerate = FLAGS_fps;
+      codec.spatialLayers[0].numberOfTemporalLayers = 1;
+      codec.spatialLayers[0].maxBitrate = FLAGS_bitrate_kbps;
+      codec.spatialLayers[0].targetBitrate = FLAGS_bitrate_kbps;
+      codec.spatialLayers[0].minBitrate = 0;
+      codec.spatialLayers[0].qpMax = codec.qpMax;
+      codec.spatialLayers[0].active = true;
+      break;
+    default:
+      break;
+  }
+  return codec;
+}
+
+struct CodecReport {
+  size_t frames = 0;
+  uint64_t encoded_bytes = 0;
+  double psnr_sum = 0;
+  double cpu_seconds = 0;
+};
+
+Result<CodecReport> BenchmarkCodec(
+    webrtc::VideoEncoderFactory& factory, const std::string& codec_name,
+    const std::vector<rtc::scoped_refptr<webrtc::I420Buffer>>& frames) {
+  const webrtc::SdpVideoFormat format(codec_name);
+  const webrtc::VideoCodecType type =
+      webrtc::PayloadStringToCodecType(codec_name);
+  std::unique_ptr<webrtc::VideoEncoder> encoder =
+      factory.CreateVideoEncoder(format);
+  CF_EXPECTF(encoder.get(), "'{}' is not supported by this build", codec_name);
+  std::unique_ptr<Decoder> decoder = CF_EXPECT(CreateDecoder(type));
+
+  EncodedFrames encoded;
+  CF_EXPECT_EQ(encoder->RegisterEncodeCompleteCallback(&encoded), 0);
+  const int width = frames[0]->width();
+  const int height = frames[0]->height();
+  webrtc::VideoCodec codec = CodecSettings(type, width, height);
+  webrtc::VideoEncoder::Capabilities capabilities(false);
+  webrtc::VideoEncoder::Settings settings(capabilities, 1, 1 << 20);
+  CF_EXPECT_EQ(encoder->InitEncode(&codec, settings), 0,
+               "Failed to initialize the " << codec_name << " encoder");
+  webrtc::VideoBitrateAllocation allocation;
+  allocation.SetBitrate(0, 0, FLAGS_bitrate_kbps * 1000);
+  encoder->SetRates(
+      webrtc::VideoEncoder::RateControlParameters(allocation, FLAGS_fps));
+
+  CodecReport report;
+  for (size_t i = 0; i < frames.size(); i++) {
+    const int64_t timestamp_us = i * 1000000 / FLAGS_fps;
+    webrtc::VideoFrame frame =
+        webrtc::VideoFrame::Builder()
+            .set_video_frame_buffer(frames[i])
+            .set_timestamp_rtp(i * kRtpTicksPerSecond / FLAGS_fps)
+            .set_timestamp_us(timestamp_us)
+            .build();
+    std::vector<webrtc::VideoFrameType> types = {
+        i % kKeyFrameInterval == 0 ? webrtc::VideoFrameType::kVideoFrameKey
+                                   : webrtc::VideoFrameType::kVideoFrameDelta};
+
+    const double cpu_start = ProcessCpuSeconds();
+    CF_EXPECT_EQ(encoder->Encode(frame, &types), 0,
+                 "Failed to encode frame " << i);
+    report.cpu_seconds += ProcessCpuSeconds() - cpu_start;
+
+    // The encoder may drop frames to stay within the bitrate, the client then
+    // keeps showing the previous one.
+    for (const std::vector<uint8_t>& data : encoded.TakeFrames()) {
+      report.encoded_bytes += data.size();
+      report.psnr_sum += CF_EXPECT(decoder->DecodeAndCompare(data, *frames[i]));
+      report.frames++;
+    }
+  }
+  encoder->Release();
+  return report;
+}
+
+Result<void> VideoCodecBenchmarkMain(int argc, char** argv) {
+  ::gflags::SetUsageMessage(kUsage);
+  ::gflags::ParseCommandLineFlags(&argc, &argv, true);
+  CF_EXPECT(!FLAGS_input.empty(), "--input is required");
+  CF_EXPECT(FLAGS_width > 0 && FLAGS_height > 0,
+            "--width and --height are required");
+  CF_EXPECT_GT(FLAGS_fps, 0u);
+
+  const std::vector<rtc::scoped_refptr<webrtc::I420Buffer>> frames =
+      CF_EXPECT(ReadFrames(FLAGS_input, FLAGS_width, FLAGS_height,
+                           FLAGS_max_frames));
+  const double duration_seconds =
+      static_cast<double>(frames.size()) / FLAGS_fps;
+  std::unique_ptr<webrtc::VideoEncoderFactory> factory =
+      webrtc::CreateBuiltinVideoEncoderFactory();
+
+  std::cout << fmt::format("{} frames of {}x{} at {} fps, target {} kbps\n",
+                           frames.size(), FLAGS_width, FLAGS_height,
+                           FLAGS_fps, FLAGS_bitrate_kbps);
+  std::cout << fmt::format("{:<6}{:>10}{:>12}{:>10}{:>16}\n", "codec",
+                           "frames", "kbps", "psnr_db", "cpu_ms/frame");
+  std::vector<std::string> codecs =
+      absl::StrSplit(FLAGS_codecs, ',', absl::SkipEmpty());
+  for (const std::string& codec : codecs) {
+    Result<CodecReport> report = BenchmarkCodec(*factory, codec, frames);
+    if (!report.ok()) {
+      LOG(ERROR) << codec << ": " << report.error();
+      continue;
+    }
+    const double kbps = report->encoded_bytes * 8 / duration_seconds / 1000;
+    const double psnr =
+        report->frames > 0 ? report->psnr_sum / report->frames : 0;
+    const double cpu_ms = report->cpu_seconds * 1000 / frames.size();
+    std::cout << fmt::format("{:<6}{:>10}{:>12.1f}{:>10.2f}{:>16.2f}\n", codec,
+                             report->frames, kbps, psnr, cpu_ms);
+  }
+  return {};
+}
+
+}  // namespace
+}  // namespace cuttlefish
+
+int main(int argc, char** argv) {
+  cuttlefish::Result<void> result =
+      cuttlefish::VideoCodecBenchmarkMain(argc, argv);
+  if (!result.ok()) {
+    LOG(ERROR) << result.error();
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/frontend/webrtc/video_frame_pool.h"
+
+#include <stddef.h>
+
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace cuttlefish {
+
+std::shared_ptr<VideoFramePool> VideoFramePool::Create(int width, int height,
+                                                       size_t size) {
+  return std::shared_ptr<VideoFramePool>(
+      new VideoFramePool(width, height, size));
+}
+
+VideoFramePool::VideoFramePool(int width, int height, size_t size)
+    : width_(width), height_(height), size_(size) {
+  free_frames_.reserve(size);
+  for (size_t i = 0; i < size; i++) {
+    free_frames_.push_back(std::make_unique<Frame>(width, height));
+  }
+}
+
+std::shared_ptr<VideoFramePool::Frame> VideoFramePool::Acquire() {
+  std::unique_ptr<Frame> frame;
+  {
+    std::lock_guard lock(mutex_);
+    if (!free_frames_.empty()) {
+      frame = std::move(free_frames_.back());
+      free_frames_.pop_back();
+    }
+  }
+  if (!frame) {
+    frame = std::make_unique<Frame>(width_, height_);
+  }
+  return std::shared_ptr<Frame>(
+      frame.release(),
+      [pool = shared_from_this()](Frame* frame) { pool->Release(frame); });
+}
+
+void VideoFramePool::Release(Frame* frame) {
+  std::unique_ptr<Frame> owned(frame);
+  std::lock_guard lock(mutex_);
+  if (free_frames_.size() < size_) {
+    free_frames_.push_back(std::move(owned));
+  }
+}
+
+}  // namespace cuttlefish
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "cuttlefish/host/frontend/webrtc/cvd_video_frame_buffer.h"
+
+namespace cuttlefish {
+
+/**
+ * Reference counted I420 buffers of one size, allocated up front.
+ *
+ * A buffer goes back to the pool when its last reference is dropped, which may
+ * happen on any thread, e.g. the encoder's. The pool outlives the buffers it
+ * handed out. If every buffer is in use a new one is allocated, and it's
+ * freed on release if the pool is already full.
+ */
+class VideoFramePool : public std::enable_shared_from_this<VideoFramePool> {
+ public:
+  struct Frame {
+    Frame(int width, int height) : buffer(width, height) {}
+
+    CvdVideoFrameBuffer buffer;
+    // Left to the user to describe the contents. Kept while the frame is in
+    // the pool, 0 for newly allocated frames.
+    uint64_t generation = 0;
+  };
+
+  static std::shared_ptr<VideoFramePool> Create(int width, int height,
+                                                size_t size);
+
+  std::shared_ptr<Frame> Acquire();
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+
+ private:
+  VideoFramePool(int width, int height, size_t size);
+
+  void Release(Frame* frame);
+
+  const int width_;
+  const int height_;
+  const size_t size_;
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<Frame>> free_frames_;
+};
+
+}  // namespace cuttlefish
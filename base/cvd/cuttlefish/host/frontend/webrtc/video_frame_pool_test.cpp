@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/frontend/webrtc/video_frame_pool.h"
+
+#include <memory>
+
+#include "gtest/gtest.h"
+
+namespace cuttlefish {
+
+TEST(VideoFramePoolTest, FramesHaveThePoolSize) {
+  std::shared_ptr<VideoFramePool> pool = VideoFramePool::Create(64, 48, 2);
+  std::shared_ptr<VideoFramePool::Frame> frame = pool->Acquire();
+  ASSERT_NE(frame, nullptr);
+  EXPECT_EQ(frame->buffer.width(), 64);
+  EXPECT_EQ(frame->buffer.height(), 48);
+  EXPECT_EQ(frame->generation, 0);
+}
+
+TEST(VideoFramePoolTest, ReusesReleasedFramesWithTheirGeneration) {
+  std::shared_ptr<VideoFramePool> pool = VideoFramePool::Create(64, 48, 1);
+  std::shared_ptr<VideoFramePool::Frame> frame = pool->Acquire();
+  VideoFramePool::Frame* first = frame.get();
+  frame->generation = 7;
+  frame.reset();
+
+  frame = pool->Acquire();
+  EXPECT_EQ(frame.get(), first);
+  EXPECT_EQ(frame->generation, 7);
+}
+
+TEST(VideoFramePoolTest, AllocatesWhenEveryFrameIsInUse) {
+  std::shared_ptr<VideoFramePool> pool = VideoFramePool::Create(64, 48, 1);
+  std::shared_ptr<VideoFramePool::Frame> first = pool->Acquire();
+  first->generation = 1;
+  std::shared_ptr<VideoFramePool::Frame> second = pool->Acquire();
+  ASSERT_NE(second, nullptr);
+  EXPECT_NE(first.get(), second.get());
+  EXPECT_EQ(second->generation, 0);
+
+  // Only one of them fits back in the pool, the first one released.
+  VideoFramePool::Frame* kept = first.get();
+  first.reset();
+  second.reset();
+  std::shared_ptr<VideoFramePool::Frame> reused = pool->Acquire();
+  EXPECT_EQ(reused.get(), kept);
+  EXPECT_EQ(reused->generation, 1);
+  std::shared_ptr<VideoFramePool::Frame> allocated = pool->Acquire();
+  EXPECT_EQ(allocated->generation, 0);
+}
+
+TEST(VideoFramePoolTest, FramesOutliveThePoolReference) {
+  std::shared_ptr<VideoFramePool> pool = VideoFramePool::Create(64, 48, 1);
+  std::shared_ptr<VideoFramePool::Frame> frame = pool->Acquire();
+  std::weak_ptr<VideoFramePool> weak_pool = pool;
+  pool.reset();
+  EXPECT_FALSE(weak_pool.expired());
+  frame->buffer.DataY()[0] = 1;
+  frame.reset();
+  EXPECT_TRUE(weak_pool.expired());
+}
+
+}  // namespace cuttlefish
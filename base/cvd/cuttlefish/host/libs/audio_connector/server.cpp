@@ -17,8 +17,10 @@
 
 #include <fcntl.h>
 #include <strings.h>
+#include <sys/socket.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <utility>
 #include <vector>
 
@@ -69,35 +71,165 @@ bool CreateSocketPair(SharedFD* local, SharedFD* remote) {
   return ret;
 }
 
-std::function<void(AudioStatus, uint32_t, uint32_t)> SendStatusCallback(
-    uint32_t buffer_offset, SharedFD socket) {
-  // Consumption of an audio buffer is an asynchronous event, which could
-  // trigger after the client disconnected. A WeakFD ensures that the response
-  // will only be sent if there is still a client available.
-  auto weak_socket = WeakFD(socket);
-  return
-      [buffer_offset, weak_socket](AudioStatus status, uint32_t latency_bytes,
-                                   uint32_t consumed_length) {
-        auto socket = weak_socket.lock();
-        if (!socket->IsOpen()) {
-          return;
-        }
-        IoStatusMsg reply;
-        reply.status.status = Le32(static_cast<uint32_t>(status));
-        reply.status.latency_bytes = Le32(latency_bytes);
-        reply.buffer_offset = buffer_offset;
-        reply.consumed_length = consumed_length;
-        // Send the acknowledgment non-blockingly to avoid a slow client from
-        // blocking the server.
-        auto sent = socket->Send(&reply, sizeof(reply), MSG_DONTWAIT);
-        if (sent < sizeof(reply)) {
-          LOG(ERROR) << "Failed to send entire reply: " << socket->StrError();
-        }
-      };
+// Enough for all the periods queued by every stream in a wakeup.
+constexpr unsigned int kMaxIoBatch = 64;
+
+// The physical width of each of the AudioStreamFormat samples, 0 for those
+// not byte aligned.
+constexpr uint32_t kFormatBytes[] = {
+    0 /* IMA_ADPCM */, 1, 1, 1, 1, 2, 2, 3, 3, 3, 3, 3, 3,
+    4 /* S20 */,       4, 4, 4, 4, 4, 4, 8, 1, 2, 4, 4,
+};
+
+// The frames per second of each of the AudioStreamRate values.
+constexpr uint32_t kRateFrames[] = {
+    5512,  8000,  11025, 16000,  22050,  32000,  44100,
+    48000, 64000, 88200, 96000, 176400, 192000, 384000,
+};
+
+// Returns 0 if unknown.
+uint32_t BytesPerSecond(const virtio_snd_pcm_set_params& params) {
+  if (params.format >= std::size(kFormatBytes) ||
+      params.rate >= std::size(kRateFrames)) {
+    return 0;
+  }
+  return kFormatBytes[params.format] * params.channels *
+         kRateFrames[params.rate];
 }
 
+struct IoStream {
+  AudioStreamStats stats;
+  // When the audio of the buffers received so far runs out.
+  std::chrono::steady_clock::time_point queued_until;
+  uint64_t log_at = 1;
+};
+
 }  // namespace
 
+// The state of one of the IO sockets.
+class AudioIoQueue : public std::enable_shared_from_this<AudioIoQueue> {
+ public:
+  AudioIoQueue(SharedFD socket) : socket_(std::move(socket)) {}
+
+  const SharedFD& socket() const { return socket_; }
+
+  // While the buffers of a batch are handed to the executor, their statuses
+  // are held back to be sent together when the batch ends.
+  void BeginBatch() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    batching_ = true;
+  }
+  void EndBatch() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    batching_ = false;
+    SendStatuses();
+  }
+
+  // bytes_per_second is 0 when unknown, underruns aren't detected then.
+  void OnReceived(uint32_t stream_id, uint32_t len, uint32_t bytes_per_second,
+                  std::chrono::steady_clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    IoStream& stream = streams_[stream_id];
+    if (bytes_per_second > 0) {
+      if (stream.stats.buffers > 0 && now > stream.queued_until) {
+        stream.stats.underruns++;
+      }
+      stream.queued_until = std::max(stream.queued_until, now) +
+                            std::chrono::microseconds(uint64_t{len} * 1000000 /
+                                                      bytes_per_second);
+    }
+    stream.stats.buffers++;
+    stream.stats.bytes += len;
+    if (stream.stats.buffers >= stream.log_at) {
+      VLOG(0) << "Stream id=" << stream_id << ": " << stream.stats.buffers
+              << " buffers, " << stream.stats.underruns << " underruns, "
+              << stream.stats.max_latency.count() << "us max latency";
+      stream.log_at *= 16;
+    }
+  }
+
+  void ResetStream(uint32_t stream_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    streams_.erase(stream_id);
+  }
+
+  void CopyStats(std::map<uint32_t, AudioStreamStats>& stats) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [stream_id, stream] : streams_) {
+      stats[stream_id] = stream.stats;
+    }
+  }
+
+  // Returns the callback that sends the status of a buffer received now.
+  OnConsumedCb StatusCallback(uint32_t stream_id, uint32_t buffer_offset) {
+    // Consumption of an audio buffer is an asynchronous event, which could
+    // trigger after the client disconnected. Only the connection owns the
+    // queue, which ensures that the response will only be sent if there is
+    // still a client available.
+    std::weak_ptr<AudioIoQueue> weak_queue = weak_from_this();
+    const auto received = std::chrono::steady_clock::now();
+    return [stream_id, buffer_offset, weak_queue, received](
+               AudioStatus status, uint32_t latency_bytes,
+               uint32_t consumed_length) {
+      auto queue = weak_queue.lock();
+      if (!queue) {
+        return;
+      }
+      IoStatusMsg reply;
+      reply.status.status = Le32(static_cast<uint32_t>(status));
+      reply.status.latency_bytes = Le32(latency_bytes);
+      reply.buffer_offset = buffer_offset;
+      reply.consumed_length = consumed_length;
+      queue->OnConsumed(stream_id,
+                        std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - received),
+                        reply);
+    };
+  }
+
+ private:
+  void OnConsumed(uint32_t stream_id, std::chrono::microseconds latency,
+                  const IoStatusMsg& status) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    AudioStreamStats& stats = streams_[stream_id].stats;
+    stats.total_latency += latency;
+    stats.max_latency = std::max(stats.max_latency, latency);
+    statuses_.push_back(status);
+    if (!batching_) {
+      SendStatuses();
+    }
+  }
+
+  void SendStatuses() {
+    if (statuses_.empty()) {
+      return;
+    }
+    std::vector<iovec> iovecs(statuses_.size());
+    std::vector<mmsghdr> msgs(statuses_.size());
+    for (size_t i = 0; i < statuses_.size(); i++) {
+      iovecs[i] = {.iov_base = &statuses_[i], .iov_len = sizeof(IoStatusMsg)};
+      msgs[i].msg_hdr.msg_iov = &iovecs[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+    // Send the acknowledgments non-blockingly to avoid a slow client from
+    // blocking the server.
+    const int sent =
+        socket_->SendMMsg(msgs.data(), msgs.size(), MSG_DONTWAIT);
+    if (sent < static_cast<int>(msgs.size())) {
+      LOG(ERROR) << "Failed to send " << msgs.size() - std::max(sent, 0)
+                 << " of " << msgs.size()
+                 << " buffer statuses: " << socket_->StrError();
+    }
+    statuses_.clear();
+  }
+
+  const SharedFD socket_;
+  mutable std::mutex mutex_;
+  bool batching_ = false;
+  std::vector<IoStatusMsg> statuses_;
+  std::map<uint32_t, IoStream> streams_;
+};
+
 std::unique_ptr<AudioClientConnection> AudioServer::AcceptClient(
     uint32_t num_streams, uint32_t num_jacks, uint32_t num_chmaps, uint32_t num_controls,
     size_t tx_shm_len, size_t rx_shm_len) {
@@ -185,6 +317,30 @@ std::unique_ptr<AudioClientConnection> AudioClientConnection::Create(
       tx_socket, rx_socket));
 }
 
+AudioClientConnection::AudioClientConnection(
+    ScopedMMap tx_shm, ScopedMMap rx_shm, SharedFD control_socket,
+    SharedFD event_socket, SharedFD tx_socket, SharedFD rx_socket)
+    : tx_shm_(std::move(tx_shm)),
+      rx_shm_(std::move(rx_shm)),
+      control_socket_(control_socket),
+      event_socket_(event_socket),
+      tx_queue_(std::make_shared<AudioIoQueue>(tx_socket)),
+      rx_queue_(std::make_shared<AudioIoQueue>(rx_socket)) {}
+
+AudioClientConnection::~AudioClientConnection() {
+  for (const auto& [stream_id, stats] : StreamStats()) {
+    std::chrono::microseconds average_latency(0);
+    if (stats.buffers > 0) {
+      average_latency = stats.total_latency / stats.buffers;
+    }
+    LOG(INFO) << "Stream id=" << stream_id << ": " << stats.buffers
+              << " buffers, " << stats.bytes << " bytes, " << stats.underruns
+              << " underruns, " << average_latency.count()
+              << "us average latency, " << stats.max_latency.count()
+              << "us max latency";
+  }
+}
+
 bool AudioClientConnection::ReceiveCommands(AudioServerExecutor& executor) {
   constexpr auto kBufSize = sizeof(virtio_snd_ctl_hdr) + sizeof(virtio_snd_ctl_value);
   alignas(uint64_t) uint8_t recv_buffer[kBufSize];
@@ -231,6 +387,9 @@ bool AudioClientConnection::ReceiveCommands(AudioServerExecutor& executor) {
                                  set_param_msg->channels, set_param_msg->format,
                                  set_param_msg->rate);
       executor.SetStreamParameters(cmd);
+      if (cmd.status() == AudioStatus::VIRTIO_SND_S_OK) {
+        SetStreamRate(*set_param_msg);
+      }
       return CmdReply(cmd.status());
     }
     case AudioCommandType::VIRTIO_SND_R_PCM_PREPARE: {
@@ -269,7 +428,7 @@ bool AudioClientConnection::ReceiveCommands(AudioServerExecutor& executor) {
       StreamControlCommand cmd(AudioCommandType::VIRTIO_SND_R_PCM_START,
                                stream_id);
       VLOG(0) << "VRTIO_SND_R_PCM_START: stream_id=" << stream_id;
-      frame_counters_[stream_id] = {0, 1};
+      ResetStreamStats(stream_id);
       executor.StartStream(cmd);
       return CmdReply(cmd.status());
     }
@@ -372,58 +531,96 @@ bool AudioClientConnection::ReceiveCommands(AudioServerExecutor& executor) {
 }
 
 bool AudioClientConnection::ReceivePlayback(AudioServerExecutor& executor) {
-  // The largest msg the client will send is 12 bytes long, using uint32_t
-  // guarantees it's aligned to 32 bits.
-  uint32_t recv_buffer[3];
-  auto recv_size = ReceiveMsg(tx_socket_, &recv_buffer, sizeof(recv_buffer));
-  if (recv_size <= 0) {
-    return false;
-  }
-  const auto msg_hdr = reinterpret_cast<const IoTransferMsg*>(&recv_buffer[0]);
-
-  if (recv_size < sizeof(IoTransferMsg)) {
-    LOG(ERROR) << "Received PCM_XFER message is too small: " << recv_size;
-    return false;
-  }
-  const uint32_t stream_id = msg_hdr->io_xfer.stream_id.as_uint32_t();
-  auto& [frame_count, log_at] = frame_counters_[stream_id];
-  if (++frame_count >= log_at) {
-    VLOG(0) << "Stream id=" << stream_id << ": " << frame_count << " frames";
-    log_at *= 16;
-  }
-  TxBuffer buffer(
-      msg_hdr->io_xfer,
-      BufferAt(tx_shm_, msg_hdr->buffer_offset, msg_hdr->buffer_len),
-      msg_hdr->buffer_len,
-      SendStatusCallback(msg_hdr->buffer_offset, tx_socket_));
-  executor.OnPlaybackBuffer(std::move(buffer));
-  return true;
+  return ReceiveIo(*tx_queue_, tx_shm_, /* capture */ false, executor);
 }
 
 bool AudioClientConnection::ReceiveCapture(AudioServerExecutor& executor) {
-  uint32_t recv_buffer[3];
-  auto recv_size = ReceiveMsg(rx_socket_, &recv_buffer, sizeof(recv_buffer));
-  if (recv_size <= 0) {
-    return false;
+  return ReceiveIo(*rx_queue_, rx_shm_, /* capture */ true, executor);
+}
+
+bool AudioClientConnection::ReceiveIo(AudioIoQueue& queue, ScopedMMap& shm,
+                                      bool capture,
+                                      AudioServerExecutor& executor) {
+  // The client sends the buffers of all its streams on the same socket, often
+  // several at once. They are all received with a single call.
+  std::array<IoTransferMsg, kMaxIoBatch> recv_msgs;
+  std::array<iovec, kMaxIoBatch> iovecs;
+  std::array<mmsghdr, kMaxIoBatch> headers = {};
+  for (size_t i = 0; i < kMaxIoBatch; i++) {
+    iovecs[i] = {.iov_base = &recv_msgs[i], .iov_len = sizeof(IoTransferMsg)};
+    headers[i].msg_hdr.msg_iov = &iovecs[i];
+    headers[i].msg_hdr.msg_iovlen = 1;
   }
-  const auto msg_hdr = reinterpret_cast<const IoTransferMsg*>(&recv_buffer[0]);
-  if (recv_size < sizeof(IoTransferMsg)) {
-    LOG(ERROR) << "Received PCM_XFER message is too small: " << recv_size;
+  // Blocks for the first message only.
+  const int received =
+      queue.socket()->RecvMMsg(headers.data(), kMaxIoBatch, MSG_WAITFORONE);
+  if (received < 0) {
+    LOG(ERROR) << "Error receiving messages from client: "
+               << queue.socket()->StrError();
     return false;
   }
-  const uint32_t stream_id = msg_hdr->io_xfer.stream_id.as_uint32_t();
-  auto& [frame_count, log_at] = frame_counters_[stream_id];
-  if (++frame_count >= log_at) {
-    VLOG(0) << "Stream id=" << stream_id << ": " << frame_count << " frames";
-    log_at *= 16;
+  const auto now = std::chrono::steady_clock::now();
+
+  bool connected = true;
+  queue.BeginBatch();
+  for (int i = 0; i < received; i++) {
+    CHECK(!(headers[i].msg_hdr.msg_flags & MSG_TRUNC))
+        << "Received a msg bigger than the buffer, msg was truncated";
+    if (headers[i].msg_len == 0) {
+      LOG(ERROR) << "Client closed the connection";
+      connected = false;
+      break;
+    }
+    if (headers[i].msg_len < sizeof(IoTransferMsg)) {
+      LOG(ERROR) << "Received PCM_XFER message is too small: "
+                 << headers[i].msg_len;
+      connected = false;
+      break;
+    }
+    const IoTransferMsg& msg = recv_msgs[i];
+    const uint32_t stream_id = msg.io_xfer.stream_id.as_uint32_t();
+    uint32_t bytes_per_second = 0;
+    {
+      std::lock_guard<std::mutex> lock(stream_rates_mutex_);
+      auto it = stream_rates_.find(stream_id);
+      if (it != stream_rates_.end()) {
+        bytes_per_second = it->second;
+      }
+    }
+    queue.OnReceived(stream_id, msg.buffer_len, bytes_per_second, now);
+    auto buffer_ptr = BufferAt(shm, msg.buffer_offset, msg.buffer_len);
+    auto on_consumed = queue.StatusCallback(stream_id, msg.buffer_offset);
+    if (capture) {
+      executor.OnCaptureBuffer(RxBuffer(msg.io_xfer, buffer_ptr,
+                                        msg.buffer_len,
+                                        std::move(on_consumed)));
+    } else {
+      executor.OnPlaybackBuffer(TxBuffer(msg.io_xfer, buffer_ptr,
+                                         msg.buffer_len,
+                                         std::move(on_consumed)));
+    }
   }
-  RxBuffer buffer(
-      msg_hdr->io_xfer,
-      BufferAt(rx_shm_, msg_hdr->buffer_offset, msg_hdr->buffer_len),
-      msg_hdr->buffer_len,
-      SendStatusCallback(msg_hdr->buffer_offset, rx_socket_));
-  executor.OnCaptureBuffer(std::move(buffer));
-  return true;
+  queue.EndBatch();
+  return connected;
+}
+
+void AudioClientConnection::SetStreamRate(
+    const virtio_snd_pcm_set_params& params) {
+  std::lock_guard<std::mutex> lock(stream_rates_mutex_);
+  stream_rates_[params.hdr.stream_id.as_uint32_t()] = BytesPerSecond(params);
+}
+
+void AudioClientConnection::ResetStreamStats(uint32_t stream_id) {
+  tx_queue_->ResetStream(stream_id);
+  rx_queue_->ResetStream(stream_id);
+}
+
+std::map<uint32_t, AudioStreamStats> AudioClientConnection::StreamStats()
+    const {
+  std::map<uint32_t, AudioStreamStats> stats;
+  tx_queue_->CopyStats(stats);
+  rx_queue_->CopyStats(stats);
+  return stats;
 }
 
 bool AudioClientConnection::CmdReply(AudioStatus status, const void* data,
@@ -14,9 +14,12 @@
 // limitations under the License.
 #pragma once
 
+#include <stdint.h>
+
+#include <chrono>
 #include <map>
 #include <memory>
-#include <utility>
+#include <mutex>
 
 #include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/host/libs/audio_connector/buffers.h"
@@ -52,6 +55,20 @@ class AudioServerExecutor {
   virtual void OnCaptureBuffer(RxBuffer buffer) = 0;
 };
 
+// Counters of the IO buffers of a stream since it was last started.
+struct AudioStreamStats {
+  uint64_t buffers = 0;
+  uint64_t bytes = 0;
+  // Buffers received after the audio of the previous ones had already been
+  // played or recorded, that is the times the stream wasn't kept fed.
+  uint64_t underruns = 0;
+  // How long the buffers were held before their status was sent back.
+  std::chrono::microseconds total_latency{0};
+  std::chrono::microseconds max_latency{0};
+};
+
+class AudioIoQueue;
+
 class AudioClientConnection {
  public:
   static std::unique_ptr<AudioClientConnection> Create(
@@ -60,6 +77,8 @@ class AudioClientConnection {
 
   AudioClientConnection() = delete;
   AudioClientConnection(const AudioClientConnection&) = delete;
+  // Logs the counters of the streams.
+  ~AudioClientConnection();
 
   AudioClientConnection& operator=(const AudioClientConnection&) = delete;
 
@@ -71,32 +90,39 @@ class AudioClientConnection {
 
   bool SendEvent(/*TODO*/);
 
+  // The counters of every stream that received IO buffers since its start.
+  std::map<uint32_t, AudioStreamStats> StreamStats() const;
+
  private:
   AudioClientConnection(ScopedMMap tx_shm, ScopedMMap rx_shm,
                         SharedFD control_socket, SharedFD event_socket,
-                        SharedFD tx_socket, SharedFD rx_socket)
-      : tx_shm_(std::move(tx_shm)),
-        rx_shm_(std::move(rx_shm)),
-        control_socket_(control_socket),
-        event_socket_(event_socket),
-        tx_socket_(tx_socket),
-        rx_socket_(rx_socket) {}
+                        SharedFD tx_socket, SharedFD rx_socket);
 
   bool CmdReply(AudioStatus status, const void* data = nullptr,
                 size_t size = 0);
   bool WithCommand(const virtio_snd_hdr* msg, size_t msg_len,
                    AudioServerExecutor& executor);
 
+  // Receives all the pending IO messages of the queue and hands their buffers
+  // to the executor, then sends their statuses together.
+  bool ReceiveIo(AudioIoQueue& queue, ScopedMMap& shm, bool capture,
+                 AudioServerExecutor& executor);
+  void SetStreamRate(const virtio_snd_pcm_set_params& params);
+  void ResetStreamStats(uint32_t stream_id);
+
   ssize_t ReceiveMsg(SharedFD socket, void* buffer, size_t size);
 
   ScopedMMap tx_shm_;
   ScopedMMap rx_shm_;
   SharedFD control_socket_;
   SharedFD event_socket_;
-  SharedFD tx_socket_;
-  SharedFD rx_socket_;
-  // Hold the number of frames since START and when to log it for each stream.
-  std::map<uint32_t, std::pair<uint64_t, uint64_t>> frame_counters_;
+  // Shared with the status callbacks of the buffers, which may outlive the
+  // connection.
+  std::shared_ptr<AudioIoQueue> tx_queue_;
+  std::shared_ptr<AudioIoQueue> rx_queue_;
+  // The bytes per second of each stream, set by the SET_PARAMS commands.
+  std::mutex stream_rates_mutex_;
+  std::map<uint32_t, uint32_t> stream_rates_;
 };
 
 class AudioServer {
@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/libs/audio_connector/server.h"
+
+#include <errno.h>
+#include <sys/socket.h>
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <android-base/cmsg.h>
+#include <android-base/unique_fd.h>
+#include "absl/log/check.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr size_t kShmLen = 4096;
+constexpr uint32_t kPeriodLen = 256;
+
+// Records the IO buffers, optionally replying to them as they arrive.
+class FakeExecutor : public AudioServerExecutor {
+ public:
+  void StreamsInfo(StreamInfoCommand&) override {}
+  void SetStreamParameters(StreamSetParamsCommand&) override {}
+  void PrepareStream(StreamControlCommand&) override {}
+  void ReleaseStream(StreamControlCommand&) override {}
+  void StartStream(StreamControlCommand&) override {}
+  void StopStream(StreamControlCommand&) override {}
+  void ChmapsInfo(ChmapInfoCommand&) override {}
+  void JacksInfo(JackInfoCommand&) override {}
+  void ControlsInfo(ControlInfoCommand&) override {}
+  void OnControlCommand(ControlCommand&) override {}
+
+  void OnPlaybackBuffer(TxBuffer buffer) override {
+    if (on_buffer) {
+      on_buffer(buffer);
+    }
+    buffers.push_back(std::move(buffer));
+  }
+  void OnCaptureBuffer(RxBuffer buffer) override {
+    OnPlaybackBuffer(std::move(buffer));
+  }
+
+  // Sends the statuses of the buffers still held.
+  void ReleaseAll() {
+    for (auto& buffer : buffers) {
+      buffer.SendStatus(AudioStatus::VIRTIO_SND_S_OK, 0, buffer.len());
+    }
+    buffers.clear();
+  }
+
+  std::function<void(TxBuffer&)> on_buffer;
+  std::vector<TxBuffer> buffers;
+};
+
+// The client side of a connection, as a VMM would see it.
+struct Client {
+  SharedFD tx;
+  SharedFD rx;
+};
+
+std::pair<std::unique_ptr<AudioClientConnection>, Client> Connect() {
+  SharedFD server_end;
+  SharedFD client_end;
+  CHECK(SharedFD::SocketPair(AF_UNIX, SOCK_SEQPACKET, 0, &server_end,
+                             &client_end));
+  auto connection =
+      AudioClientConnection::Create(server_end, /* num_streams */ 2,
+                                    /* num_jacks */ 0, /* num_chmaps */ 0,
+                                    /* num_controls */ 1, kShmLen, kShmLen);
+  CHECK(connection);
+
+  android::base::unique_fd socket(client_end->UNMANAGED_Dup());
+  VioSConfig welcome;
+  android::base::unique_fd event, tx, rx, tx_shm, rx_shm;
+  const ssize_t received = android::base::ReceiveFileDescriptors(
+      socket, &welcome, sizeof(welcome), &event, &tx, &rx, &tx_shm, &rx_shm);
+  CHECK(received == sizeof(welcome));
+  return {std::move(connection),
+          Client{.tx = SharedFD::Dup(tx.get()), .rx = SharedFD::Dup(rx.get())}};
+}
+
+void SendTransfers(const SharedFD& socket, uint32_t stream_id, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    IoTransferMsg msg = {
+        .io_xfer = {.stream_id = Le32(stream_id)},
+        .buffer_offset = static_cast<uint32_t>(i * kPeriodLen),
+        .buffer_len = kPeriodLen,
+    };
+    CHECK(socket->Send(&msg, sizeof(msg), 0) == sizeof(msg))
+        << socket->StrError();
+  }
+}
+
+// Returns the statuses that are already waiting on the socket.
+std::vector<IoStatusMsg> PendingStatuses(const SharedFD& socket) {
+  std::array<IoStatusMsg, 16> statuses;
+  std::array<iovec, 16> iovecs;
+  std::array<mmsghdr, 16> headers = {};
+  for (size_t i = 0; i < statuses.size(); i++) {
+    iovecs[i] = {.iov_base = &statuses[i], .iov_len = sizeof(IoStatusMsg)};
+    headers[i].msg_hdr.msg_iov = &iovecs[i];
+    headers[i].msg_hdr.msg_iovlen = 1;
+  }
+  const int received =
+      socket->RecvMMsg(headers.data(), headers.size(), MSG_DONTWAIT);
+  if (received < 0) {
+    CHECK(socket->GetErrno() == EAGAIN) << socket->StrError();
+    return {};
+  }
+  return std::vector<IoStatusMsg>(statuses.begin(),
+                                  statuses.begin() + received);
+}
+
+TEST(AudioClientConnection, ReceivesAllPendingBuffersAtOnce) {
+  auto [connection, client] = Connect();
+  FakeExecutor executor;
+  SendTransfers(client.tx, 0, 5);
+
+  ASSERT_TRUE(connection->ReceivePlayback(executor));
+
+  ASSERT_EQ(executor.buffers.size(), 5);
+  for (size_t i = 0; i < executor.buffers.size(); i++) {
+    EXPECT_EQ(executor.buffers[i].stream_id(), 0);
+    EXPECT_EQ(executor.buffers[i].len(), kPeriodLen);
+  }
+  executor.ReleaseAll();
+}
+
+TEST(AudioClientConnection, SendsTheStatusesOfABatchWhenItEnds) {
+  auto [connection, client] = Connect();
+  FakeExecutor executor;
+  size_t sent_early = 0;
+  executor.on_buffer = [&client, &sent_early](TxBuffer& buffer) {
+    buffer.SendStatus(AudioStatus::VIRTIO_SND_S_OK, 0, buffer.len());
+    sent_early += PendingStatuses(client.tx).size();
+  };
+  SendTransfers(client.tx, 0, 4);
+
+  ASSERT_TRUE(connection->ReceivePlayback(executor));
+
+  EXPECT_EQ(sent_early, 0);
+  const auto statuses = PendingStatuses(client.tx);
+  ASSERT_EQ(statuses.size(), 4);
+  for (size_t i = 0; i < statuses.size(); i++) {
+    EXPECT_EQ(statuses[i].status.status.as_uint32_t(),
+              static_cast<uint32_t>(AudioStatus::VIRTIO_SND_S_OK));
+    EXPECT_EQ(statuses[i].buffer_offset, i * kPeriodLen);
+    EXPECT_EQ(statuses[i].consumed_length, kPeriodLen);
+  }
+}
+
+TEST(AudioClientConnection, SendsLaterStatusesRightAway) {
+  auto [connection, client] = Connect();
+  FakeExecutor executor;
+  SendTransfers(client.tx, 0, 2);
+  ASSERT_TRUE(connection->ReceivePlayback(executor));
+  ASSERT_EQ(executor.buffers.size(), 2);
+
+  executor.buffers[1].SendStatus(AudioStatus::VIRTIO_SND_S_OK, 0, kPeriodLen);
+
+  const auto statuses = PendingStatuses(client.tx);
+  ASSERT_EQ(statuses.size(), 1);
+  EXPECT_EQ(statuses[0].buffer_offset, kPeriodLen);
+  executor.buffers[0].SendStatus(AudioStatus::VIRTIO_SND_S_OK, 0, kPeriodLen);
+  EXPECT_EQ(PendingStatuses(client.tx).size(), 1);
+}
+
+TEST(AudioClientConnection, CountsTheBuffersOfEachStream) {
+  auto [connection, client] = Connect();
+  FakeExecutor executor;
+  SendTransfers(client.tx, 0, 3);
+  SendTransfers(client.rx, 1, 2);
+
+  ASSERT_TRUE(connection->ReceivePlayback(executor));
+  ASSERT_TRUE(connection->ReceiveCapture(executor));
+  executor.ReleaseAll();
+
+  const auto stats = connection->StreamStats();
+  ASSERT_EQ(stats.size(), 2);
+  EXPECT_EQ(stats.at(0).buffers, 3);
+  EXPECT_EQ(stats.at(0).bytes, 3 * kPeriodLen);
+  EXPECT_EQ(stats.at(1).buffers, 2);
+  EXPECT_EQ(stats.at(1).bytes, 2 * kPeriodLen);
+}
+
+TEST(AudioClientConnection, StopsWhenTheClientDisconnects) {
+  auto [connection, client] = Connect();
+  FakeExecutor executor;
+  client.tx->Close();
+
+  EXPECT_FALSE(connection->ReceivePlayback(executor));
+  EXPECT_TRUE(executor.buffers.empty());
+}
+
+}  // namespace
+}  // namespace cuttlefish
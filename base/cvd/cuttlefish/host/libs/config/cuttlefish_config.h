@@ -504,6 +504,10 @@ class CuttlefishConfig {
     // The range of UDP ports available for webrtc sessions.
     std::pair<uint16_t, uint16_t> webrtc_udp_port_range() const;
 
+    // The video codecs offered to webrtc clients, most preferred first. Only
+    // VP8 if the config doesn't list them.
+    std::vector<std::string> webrtc_video_codecs() const;
+
     bool smt() const;
     std::string crosvm_binary() const;
     std::string seccomp_policy_dir() const;
@@ -727,6 +731,10 @@ class CuttlefishConfig {
     // The range of UDP ports available for webrtc sessions.
     void set_webrtc_udp_port_range(std::pair<uint16_t, uint16_t> range);
 
+    // The video codecs offered to webrtc clients, most preferred first. Only
+    // VP8 if the config doesn't list them.
+    void set_webrtc_video_codecs(const std::vector<std::string>& codecs);
+
     void set_smt(bool smt);
     void set_crosvm_binary(const std::string& crosvm_binary);
     void set_seccomp_policy_dir(const std::string& seccomp_policy_dir);
@@ -1077,6 +1077,28 @@ std::pair<uint16_t, uint16_t> CuttlefishConfig::InstanceSpecific::webrtc_udp_por
   return ret;
 }
 
+static constexpr char kWebrtcVideoCodecs[] = "webrtc_video_codecs";
+void CuttlefishConfig::MutableInstanceSpecific::set_webrtc_video_codecs(
+    const std::vector<std::string>& codecs) {
+  Json::Value arr(Json::ValueType::arrayValue);
+  for (const std::string& codec : codecs) {
+    arr.append(codec);
+  }
+  (*Dictionary())[kWebrtcVideoCodecs] = arr;
+}
+std::vector<std::string>
+CuttlefishConfig::InstanceSpecific::webrtc_video_codecs() const {
+  // Configs from before the codecs were configurable only offered VP8.
+  if (!Dictionary()->isMember(kWebrtcVideoCodecs)) {
+    return {"VP8"};
+  }
+  std::vector<std::string> codecs;
+  for (const Json::Value& codec : (*Dictionary())[kWebrtcVideoCodecs]) {
+    codecs.push_back(codec.asString());
+  }
+  return codecs;
+}
+
 static constexpr char kGrpcConfig[] = "grpc_config";
 std::string CuttlefishConfig::InstanceSpecific::grpc_socket_path() const {
   return (*Dictionary())[kGrpcConfig].asString();
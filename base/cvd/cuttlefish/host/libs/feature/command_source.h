@@ -15,6 +15,9 @@
 
 #pragma once
 
+#include <functional>
+#include <set>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -29,9 +32,31 @@ namespace cuttlefish {
 struct MonitorCommand {
   Command command;
   bool is_critical;
+  // Returns once the started command can serve the commands started after it,
+  // e.g. when it listens on its socket. Ready as soon as started if empty.
+  std::function<Result<void>()> readiness;
+  // Names of the commands that must be ready before this one starts. The
+  // others start concurrently.
+  std::set<std::string> start_after;
+  // What the commands starting after this one name it, the executable name if
+  // empty.
+  std::string name;
 
   MonitorCommand(Command command, bool is_critical = true)
       : command(std::move(command)), is_critical(is_critical) {}
+
+  MonitorCommand& ReadyWhen(std::function<Result<void>()> check) & {
+    readiness = std::move(check);
+    return *this;
+  }
+  MonitorCommand& StartAfter(std::string command_name) & {
+    start_after.insert(std::move(command_name));
+    return *this;
+  }
+  MonitorCommand& Named(std::string command_name) & {
+    name = std::move(command_name);
+    return *this;
+  }
 };
 
 class CommandSource : public virtual SetupFeature {
@@ -16,21 +16,100 @@
 
 #include "cuttlefish/host/libs/feature/feature.h"
 
+#include <stdint.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <fstream>
+#include <mutex>
 #include <ostream>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "absl/log/log.h"
+#include "json/json.h"
 
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
+namespace {
+
+// Records when each feature was set up, and on which thread.
+class SetupTrace {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  SetupTrace() : start_(Clock::now()) {}
+
+  void Add(std::string name, Clock::time_point start, Clock::time_point end) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto [thread, inserted] =
+        threads_.emplace(std::this_thread::get_id(), threads_.size());
+    events_.push_back(Event{
+        .name = std::move(name),
+        .start = start,
+        .end = end,
+        .thread = thread->second,
+    });
+  }
+
+  // In the Chrome trace event format, which Perfetto and chrome://tracing
+  // display as a timeline.
+  Result<void> Write(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Json::Value events(Json::arrayValue);
+    for (const Event& event : events_) {
+      Json::Value json;
+      json["name"] = event.name;
+      json["cat"] = "setup";
+      json["ph"] = "X";
+      json["ts"] = Json::Int64(Microseconds(event.start - start_));
+      json["dur"] = Json::Int64(Microseconds(event.end - event.start));
+      json["pid"] = getpid();
+      json["tid"] = Json::UInt64(event.thread);
+      events.append(json);
+    }
+    Json::Value trace;
+    trace["traceEvents"] = events;
+    trace["displayTimeUnit"] = "ms";
+
+    std::ofstream out(path, std::ios::trunc);
+    Json::StreamWriterBuilder factory;
+    out << Json::writeString(factory, trace);
+    CF_EXPECTF(out.good(), "Failed to write the setup trace to '{}'", path);
+    return {};
+  }
+
+ private:
+  struct Event {
+    std::string name;
+    Clock::time_point start;
+    Clock::time_point end;
+    size_t thread;
+  };
+
+  static int64_t Microseconds(Clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration)
+        .count();
+  }
+
+  const Clock::time_point start_;
+  std::mutex mutex_;
+  std::unordered_map<std::thread::id, size_t> threads_;
+  std::vector<Event> events_;
+};
+
+}  // namespace
 
 SetupFeature::~SetupFeature() {}
 
 /* static */ Result<void> SetupFeature::RunSetup(
-    const std::vector<SetupFeature*>& features) {
+    const std::vector<SetupFeature*>& features,
+    const SetupFeatureOptions& options) {
   std::unordered_set<SetupFeature*> enabled;
   for (const auto& feature : features) {
     CF_EXPECT(feature != nullptr, "Received null feature");
@@ -38,20 +117,27 @@ SetupFeature::~SetupFeature() {}
       enabled.insert(feature);
     }
   }
-  // Collect these in a vector first to trigger any obvious dependency issues.
-  std::vector<SetupFeature*> ordered_features;
-  auto add_feature =
-      [&ordered_features](SetupFeature* feature) -> Result<void> {
-    ordered_features.push_back(feature);
+  SetupTrace trace;
+  auto setup = [&trace](SetupFeature* feature) -> Result<void> {
+    VLOG(0) << "Running setup for " << feature->Name();
+    const auto start = SetupTrace::Clock::now();
+    Result<void> result = feature->ResultSetup();
+    trace.Add(feature->Name(), start, SetupTrace::Clock::now());
+    CF_EXPECT(std::move(result), "Setup failed for " << feature->Name());
     return {};
   };
-  CF_EXPECT(Feature<SetupFeature>::TopologicalVisit(enabled, add_feature),
-            "Dependency issue detected, not performing any setup.");
-  // TODO(b/189153501): This can potentially be parallelized.
-  for (auto& feature : ordered_features) {
-    VLOG(0) << "Running setup for " << feature->Name();
-    CF_EXPECT(feature->ResultSetup(), "Setup failed for " << feature->Name());
+  auto runs_alone = [](SetupFeature* feature) { return feature->RunsAlone(); };
+  // Independent features are set up concurrently, so the slowest chain of
+  // dependencies bounds the setup time rather than their sum.
+  Result<void> result = Feature<SetupFeature>::ParallelTopologicalVisit(
+      enabled, setup, runs_alone, options.max_threads);
+  if (!options.trace_path.empty()) {
+    Result<void> written = trace.Write(options.trace_path);
+    if (!written.ok()) {
+      LOG(WARNING) << written.error();
+    }
   }
+  CF_EXPECT(std::move(result));
   return {};
 }
 
@@ -15,8 +15,15 @@
  */
 #pragma once
 
+#include <stddef.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
 #include <ostream>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
@@ -41,18 +48,40 @@ class Feature {
       const std::unordered_set<Subclass*>& features,
       const std::function<Result<void>(Subclass*)>& callback);
 
+  // Like TopologicalVisit, but calls `callback` on up to `max_threads` threads
+  // at once, on each feature as soon as it returned for all its dependencies.
+  // The `exclusive` features are visited on the calling thread while no other
+  // thread exists. Stops visiting on the first error.
+  static Result<void> ParallelTopologicalVisit(
+      const std::unordered_set<Subclass*>& features,
+      const std::function<Result<void>(Subclass*)>& callback,
+      const std::function<bool(Subclass*)>& exclusive, size_t max_threads);
+
  private:
   virtual std::unordered_set<Subclass*> Dependencies() const = 0;
 };
 
+struct SetupFeatureOptions {
+  // How many features are set up at once.
+  size_t max_threads = 1;
+  // Where to write when each feature was set up, in the Chrome trace event
+  // format. Nowhere if empty.
+  std::string trace_path;
+};
+
 class SetupFeature : public virtual Feature<SetupFeature> {
  public:
   virtual ~SetupFeature();
 
-  static Result<void> RunSetup(const std::vector<SetupFeature*>& features);
+  static Result<void> RunSetup(const std::vector<SetupFeature*>& features,
+                               const SetupFeatureOptions& options = {});
 
   virtual bool Enabled() const { return true; }
 
+  // Whether the setup must run on the thread calling RunSetup, while no other
+  // setup runs, e.g. because it forks the process.
+  virtual bool RunsAlone() const { return false; }
+
  private:
   virtual Result<void> ResultSetup() = 0;
 };
@@ -170,6 +199,115 @@ Result<void> Feature<Subclass>::TopologicalVisit(
   return {};
 }
 
+template <typename Subclass>
+Result<void> Feature<Subclass>::ParallelTopologicalVisit(
+    const std::unordered_set<Subclass*>& features,
+    const std::function<Result<void>(Subclass*)>& callback,
+    const std::function<bool(Subclass*)>& exclusive, size_t max_threads) {
+  // Also checks the graph before visiting anything. Features ready at the
+  // same time are visited in this order.
+  std::vector<Subclass*> ordered;
+  auto add_feature = [&ordered](Subclass* feature) -> Result<void> {
+    ordered.push_back(feature);
+    return {};
+  };
+  CF_EXPECT(TopologicalVisit(features, add_feature),
+            "Dependency issue detected, not visiting any feature.");
+
+  std::mutex mutex;
+  std::condition_variable visited_cv;
+  std::unordered_map<Subclass*, size_t> pending_dependencies;
+  std::unordered_map<Subclass*, std::vector<Subclass*>> dependents;
+  std::deque<Subclass*> ready;
+  std::deque<Subclass*> exclusive_ready;
+  size_t running = 0;
+  Result<void> result;
+  bool failed = false;
+
+  auto make_ready = [&](Subclass* feature) {
+    if (exclusive(feature)) {
+      exclusive_ready.push_back(feature);
+    } else {
+      ready.push_back(feature);
+    }
+  };
+  for (Subclass* feature : ordered) {
+    const std::unordered_set<Subclass*> dependencies = feature->Dependencies();
+    pending_dependencies[feature] = dependencies.size();
+    for (Subclass* dependency : dependencies) {
+      dependents[dependency].push_back(feature);
+    }
+    if (dependencies.empty()) {
+      make_ready(feature);
+    }
+  }
+
+  auto visit = [&callback](Subclass* feature) -> Result<void> {
+    CF_EXPECT(callback(feature), "Callback error on " << feature->Name());
+    return {};
+  };
+  // Called with `mutex` held, after `feature` was visited.
+  auto finish = [&](Subclass* feature, Result<void> feature_result) {
+    running--;
+    if (!feature_result.ok()) {
+      if (!failed) {
+        failed = true;
+        result = std::move(feature_result);
+      }
+      return;
+    }
+    for (Subclass* dependent : dependents[feature]) {
+      if (--pending_dependencies[dependent] == 0) {
+        make_ready(dependent);
+      }
+    }
+  };
+  // Visits the features that are not exclusive until an error, until an
+  // exclusive one is ready, or until none can become ready.
+  auto work = [&]() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!failed && exclusive_ready.empty()) {
+      if (ready.empty()) {
+        if (running == 0) {
+          return;
+        }
+        visited_cv.wait(lock);
+        continue;
+      }
+      Subclass* feature = ready.front();
+      ready.pop_front();
+      running++;
+      lock.unlock();
+      Result<void> feature_result = visit(feature);
+      lock.lock();
+      finish(feature, std::move(feature_result));
+      visited_cv.notify_all();
+    }
+  };
+
+  while (true) {
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < max_threads && i < ordered.size(); i++) {
+      workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+      worker.join();
+    }
+    // Only this thread remains.
+    if (failed) {
+      return result;
+    }
+    if (exclusive_ready.empty()) {
+      return {};
+    }
+    Subclass* feature = exclusive_ready.front();
+    exclusive_ready.pop_front();
+    running++;
+    finish(feature, visit(feature));
+  }
+}
+
 template <typename... Args>
 std::unordered_set<SetupFeature*> SetupFeatureDeps(
     const std::tuple<Args...>& args) {
@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/libs/feature/feature.h"
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+class TestFeature : public Feature<TestFeature> {
+ public:
+  TestFeature(std::string name, std::unordered_set<TestFeature*> dependencies,
+              bool runs_alone = false)
+      : name_(std::move(name)),
+        dependencies_(std::move(dependencies)),
+        runs_alone_(runs_alone) {}
+
+  std::string Name() const override { return name_; }
+  std::unordered_set<TestFeature*> Dependencies() const override {
+    return dependencies_;
+  }
+  bool RunsAlone() const { return runs_alone_; }
+
+  void AddDependency(TestFeature* dependency) {
+    dependencies_.insert(dependency);
+  }
+
+ private:
+  std::string name_;
+  std::unordered_set<TestFeature*> dependencies_;
+  bool runs_alone_;
+};
+
+bool RunsAlone(TestFeature* feature) { return feature->RunsAlone(); }
+
+// Records the features in the order they were visited, from any thread.
+class VisitLog {
+ public:
+  void Add(TestFeature* feature) {
+    std::lock_guard lock(mutex_);
+    visited_.push_back(feature);
+  }
+
+  // Where `feature` was visited, or -1 if it wasn't.
+  int Position(TestFeature* feature) {
+    std::lock_guard lock(mutex_);
+    auto it = std::find(visited_.begin(), visited_.end(), feature);
+    return it == visited_.end() ? -1 : it - visited_.begin();
+  }
+
+  size_t Size() {
+    std::lock_guard lock(mutex_);
+    return visited_.size();
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<TestFeature*> visited_;
+};
+
+TEST(FeatureTest, ParallelVisitFollowsDependencies) {
+  // A diamond next to an independent chain.
+  TestFeature a("a", {});
+  TestFeature b("b", {&a});
+  TestFeature c("c", {&a});
+  TestFeature d("d", {&b, &c});
+  TestFeature e("e", {});
+  TestFeature f("f", {&e});
+  std::unordered_set<TestFeature*> features = {&a, &b, &c, &d, &e, &f};
+  VisitLog log;
+  auto visit = [&log](TestFeature* feature) -> Result<void> {
+    // Gives the other threads time to run ahead if they are allowed to.
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    log.Add(feature);
+    return {};
+  };
+
+  ASSERT_THAT(Feature<TestFeature>::ParallelTopologicalVisit(features, visit,
+                                                             RunsAlone, 4),
+              IsOk());
+
+  EXPECT_EQ(log.Size(), features.size());
+  for (TestFeature* feature : features) {
+    for (TestFeature* dependency : feature->Dependencies()) {
+      EXPECT_LT(log.Position(dependency), log.Position(feature))
+          << dependency->Name() << " after " << feature->Name();
+    }
+  }
+}
+
+TEST(FeatureTest, ParallelVisitRunsExclusiveFeaturesAlone) {
+  TestFeature a("a", {});
+  TestFeature b("b", {});
+  TestFeature alone("alone", {&a}, /* runs_alone= */ true);
+  TestFeature c("c", {&alone});
+  TestFeature d("d", {});
+  std::unordered_set<TestFeature*> features = {&a, &b, &alone, &c, &d};
+  std::mutex mutex;
+  size_t running = 0;
+  size_t max_running = 0;
+  size_t running_with_alone = 0;
+  std::thread::id alone_thread;
+  auto visit = [&](TestFeature* feature) -> Result<void> {
+    {
+      std::lock_guard lock(mutex);
+      running++;
+      max_running = std::max(max_running, running);
+      if (feature == &alone) {
+        running_with_alone = running;
+        alone_thread = std::this_thread::get_id();
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::lock_guard lock(mutex);
+    running--;
+    return {};
+  };
+
+  ASSERT_THAT(Feature<TestFeature>::ParallelTopologicalVisit(features, visit,
+                                                             RunsAlone, 4),
+              IsOk());
+
+  EXPECT_GT(max_running, 1);
+  EXPECT_EQ(running_with_alone, 1);
+  EXPECT_EQ(alone_thread, std::this_thread::get_id());
+}
+
+TEST(FeatureTest, ParallelVisitStopsOnError) {
+  TestFeature a("a", {});
+  TestFeature failing("failing", {&a});
+  TestFeature b("b", {&failing});
+  TestFeature c("c", {&b});
+  std::unordered_set<TestFeature*> features = {&a, &failing, &b, &c};
+  VisitLog log;
+  auto visit = [&](TestFeature* feature) -> Result<void> {
+    log.Add(feature);
+    CF_EXPECT(feature != &failing, "expected failure");
+    return {};
+  };
+
+  Result<void> result = Feature<TestFeature>::ParallelTopologicalVisit(
+      features, visit, RunsAlone, 4);
+
+  EXPECT_THAT(result, IsError());
+  EXPECT_THAT(result.error().Trace(), testing::HasSubstr("failing"));
+  EXPECT_NE(log.Position(&a), -1);
+  EXPECT_EQ(log.Position(&b), -1);
+  EXPECT_EQ(log.Position(&c), -1);
+}
+
+TEST(FeatureTest, ParallelVisitDetectsCycles) {
+  TestFeature a("a", {});
+  TestFeature b("b", {&a});
+  TestFeature c("c", {&b});
+  a.AddDependency(&c);
+  TestFeature d("d", {});
+  std::unordered_set<TestFeature*> features = {&a, &b, &c, &d};
+  VisitLog log;
+  auto visit = [&log](TestFeature* feature) -> Result<void> {
+    log.Add(feature);
+    return {};
+  };
+
+  Result<void> result = Feature<TestFeature>::ParallelTopologicalVisit(
+      features, visit, RunsAlone, 4);
+
+  EXPECT_THAT(result, IsError());
+  EXPECT_EQ(log.Size(), 0);
+}
+
+}  // namespace
+}  // namespace cuttlefish
@@ -290,9 +290,11 @@ Result<void> WriteEnd(SharedFD out, const GptEnd& end) {
  * support them.
  */
 Result<void> DeAndroidSparse(const std::vector<ImagePartition>& partitions) {
+  std::vector<std::string> image_paths;
   for (const auto& partition : partitions) {
-    CF_EXPECT(ForceRawImage(partition.image_file_path));
+    image_paths.emplace_back(partition.image_file_path);
   }
+  CF_EXPECT(ForceRawImages(image_paths));
   return {};
 }
 
@@ -19,9 +19,11 @@
 #include <sys/file.h>
 
 #include <fstream>
+#include <future>
 #include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 #include <android-base/unique_fd.h>
 #include <sparse/sparse.h>
@@ -29,8 +31,8 @@
 
 #include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/common/libs/utils/files.h"
-#include "cuttlefish/common/libs/utils/subprocess.h"
-#include "cuttlefish/host/libs/config/known_paths.h"
+#include "cuttlefish/io/android_sparse.h"
+#include "cuttlefish/io/shared_fd.h"
 #include "cuttlefish/posix/rename.h"
 #include "cuttlefish/result/result.h"
 
@@ -75,18 +77,45 @@ Result<void> ForceRawImage(const std::string& image_path) {
     return {};
   }
   SharedFD fd = CF_EXPECT(AcquireLockForImage(image_path));
-  if (!CF_EXPECT(IsSparseImage(image_path))) {
-    return {};
+  CF_EXPECT(ConvertToRawImage(image_path));
+  return {};
+}
+
+Result<void> ForceRawImages(const std::vector<std::string>& image_paths) {
+  std::vector<std::future<Result<void>>> conversions;
+  for (const std::string& image_path : image_paths) {
+    conversions.emplace_back(
+        std::async(std::launch::async, ForceRawImage, image_path));
+  }
+  for (std::future<Result<void>>& conversion : conversions) {
+    CF_EXPECT(conversion.get());
   }
+  return {};
+}
 
-  std::string tmp_raw_image_path = image_path + ".raw";
-  // Use simg2img to convert sparse image to raw images.
-  int simg2img_status =
-      Execute({Simg2ImgBinary(), image_path, tmp_raw_image_path});
+Result<bool> ConvertToRawImage(const std::string& image_path) {
+  SharedFD sparse_fd = SharedFD::Open(image_path, O_RDONLY | O_CLOEXEC);
+  CF_EXPECTF(sparse_fd->IsOpen(), "Failed to open '{}': '{}'", image_path,
+             sparse_fd->StrError());
+  SharedFdIo sparse(sparse_fd);
+  if (!CF_EXPECT(IsAndroidSparse(sparse))) {
+    return false;
+  }
 
-  CF_EXPECT_EQ(simg2img_status, 0,
-               "Unable to convert Android sparse image '"
-                   << image_path << "' to raw image: " << simg2img_status);
+  std::string tmp_raw_image_path = image_path + ".raw";
+  SharedFD raw_fd = SharedFD::Open(tmp_raw_image_path,
+                                   O_CREAT | O_TRUNC | O_RDWR | O_CLOEXEC, 0664);
+  CF_EXPECTF(raw_fd->IsOpen(), "Failed to open '{}': '{}'", tmp_raw_image_path,
+             raw_fd->StrError());
+  SharedFdIo raw(raw_fd);
+  Result<void> expanded = ExpandAndroidSparse(sparse, raw);
+  if (!expanded.ok()) {
+    // Best effort, the expansion error is the one to report.
+    Result<void> unused = RemoveFile(tmp_raw_image_path);
+    CF_EXPECTF(std::move(expanded),
+               "Unable to convert Android sparse image '{}' to raw image",
+               image_path);
+  }
 
   // Replace the original sparse image with the raw image.
   // `rename` can fail if these are on different mounts, but they are files
@@ -94,7 +123,7 @@ Result<void> ForceRawImage(const std::string& image_path) {
   // is a bind mount, in which case `rename` won't work anyway.
   CF_EXPECT(Rename(tmp_raw_image_path, image_path));
 
-  return {};
+  return true;
 }
 
 struct AndroidSparseImage::Impl {
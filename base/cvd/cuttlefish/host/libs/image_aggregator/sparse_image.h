@@ -15,13 +15,22 @@
  */
 
 #include <string>
+#include <vector>
 
 #include "cuttlefish/host/libs/image_aggregator/disk_image.h"
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
 
+/** Replaces `image_path` with a raw image if it is an Android-Sparse image.
+ *
+ * Other processes converting the same image wait for this one to finish. */
 Result<void> ForceRawImage(const std::string& image_path);
+/** Same as `ForceRawImage`, converting the images concurrently. */
+Result<void> ForceRawImages(const std::vector<std::string>& image_paths);
+/** Same as `ForceRawImage` without coordinating with other processes, for
+ * files no other process uses yet. Returns whether the image was converted. */
+Result<bool> ConvertToRawImage(const std::string& image_path);
 Result<bool> IsSparseImage(const std::string& image_path);
 
 /** Image file format comprised of a list of chunks of "raw data" and "fill
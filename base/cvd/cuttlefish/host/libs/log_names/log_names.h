@@ -22,6 +22,7 @@ inline constexpr char kLogNameAssembleCvd[] = "assemble_cvd.log";
 inline constexpr char kLogNameBuildInfo[] = "build_info.log";
 inline constexpr char kLogNameCrosvmOpenWrt[] = "crosvm_openwrt.log";
 inline constexpr char kLogNameCrosvmOpenWrtBoot[] = "crosvm_openwrt_boot.log";
+inline constexpr char kLogNameDisplayStats[] = "display_stats.json";
 inline constexpr char kLogNameFetch[] = "fetch.log";
 inline constexpr char kLogNameKernel[] = "kernel.log";
 inline constexpr char kLogNameLauncher[] = "launcher.log";
@@ -29,5 +30,7 @@ inline constexpr char kLogNameLogcat[] = "logcat";
 inline constexpr char kLogNameMetrics[] = "metrics.log";
 inline constexpr char kLogNameMetricsV2[] = "metrics_v2.log";
 inline constexpr char kLogNameModemSimulator[] = "modem_simulator.log";
+inline constexpr char kLogNameProcessStatus[] = "process_status.json";
+inline constexpr char kLogNameSetupTrace[] = "setup_trace.json";
 
 }  // namespace cuttlefish
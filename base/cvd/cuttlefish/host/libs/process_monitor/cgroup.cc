@@ -0,0 +1,281 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/libs/process_monitor/cgroup.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/magic.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <cmath>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+#include "absl/log/log.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+
+#include "cuttlefish/common/libs/fs/shared_buf.h"
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/common/libs/utils/files.h"
+#include "cuttlefish/posix/strerror.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr char kCgroupMount[] = "/sys/fs/cgroup";
+constexpr char kLauncherLeaf[] = "launcher";
+// cpu.max takes a quota of runtime per period, both in microseconds.
+constexpr uint64_t kCpuPeriodUsec = 100000;
+
+Result<void> WriteFile(const std::string& path, const std::string& value) {
+  SharedFD fd = SharedFD::Open(path, O_WRONLY);
+  CF_EXPECTF(fd->IsOpen(), "Failed to open '{}': {}", path, fd->StrError());
+  CF_EXPECTF(WriteAll(fd, value) == static_cast<ssize_t>(value.size()),
+             "Failed to write '{}' to '{}': {}", value, path, fd->StrError());
+  return {};
+}
+
+Result<void> MakeDirectory(const std::string& path) {
+  if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+    return CF_ERRF("Failed to create '{}': {}", path, StrError(errno));
+  }
+  return {};
+}
+
+std::set<std::string> Words(std::string_view text) {
+  return absl::StrSplit(text, absl::ByAnyChar(" \n"), absl::SkipEmpty());
+}
+
+// Enables the controllers for the children of the cgroup, those that are
+// available to it and not enabled yet.
+Result<void> EnableControllers(const std::string& path) {
+  const std::set<std::string> available =
+      Words(CF_EXPECT(ReadFileContents(path + "/cgroup.controllers")));
+  const std::set<std::string> enabled =
+      Words(CF_EXPECT(ReadFileContents(path + "/cgroup.subtree_control")));
+  std::vector<std::string> to_enable;
+  for (const char* controller : {"cpu", "memory", "io"}) {
+    if (!available.count(controller)) {
+      LOG(WARNING) << "The " << controller
+                   << " controller is not delegated to '" << path << "'";
+    } else if (!enabled.count(controller)) {
+      to_enable.emplace_back(std::string("+") + controller);
+    }
+  }
+  if (to_enable.empty()) {
+    return {};
+  }
+  // A cgroup with processes of its own can't enable controllers.
+  const std::set<std::string> pids =
+      Words(CF_EXPECT(ReadFileContents(path + "/cgroup.procs")));
+  const std::string leaf = path + "/" + kLauncherLeaf;
+  if (!pids.empty()) {
+    CF_EXPECT(MakeDirectory(leaf));
+  }
+  for (const std::string& pid : pids) {
+    Result<void> moved = WriteFile(leaf + "/cgroup.procs", pid);
+    if (!moved.ok()) {
+      // The process may have exited since.
+      VLOG(0) << moved.error().FormatForEnv();
+    }
+  }
+  CF_EXPECT(WriteFile(path + "/cgroup.subtree_control",
+                      absl::StrJoin(to_enable, " ")));
+  return {};
+}
+
+}  // namespace
+
+uint64_t LineValue(std::string_view content, std::string_view key) {
+  for (std::string_view line : absl::StrSplit(content, '\n')) {
+    if (!absl::ConsumePrefix(&line, key)) {
+      continue;
+    }
+    std::vector<std::string_view> words =
+        absl::StrSplit(line, absl::ByAnyChar(" \t"), absl::SkipEmpty());
+    uint64_t value;
+    if (!words.empty() && absl::SimpleAtoi(words[0], &value)) {
+      return value;
+    }
+  }
+  return 0;
+}
+
+uint64_t SumFields(std::string_view content, std::string_view key) {
+  uint64_t sum = 0;
+  for (std::string_view field :
+       absl::StrSplit(content, absl::ByAnyChar(" \n"), absl::SkipEmpty())) {
+    uint64_t value;
+    if (absl::ConsumePrefix(&field, key) && absl::SimpleAtoi(field, &value)) {
+      sum += value;
+    }
+  }
+  return sum;
+}
+
+Result<std::map<std::string, ResourceLimits>> ParseResourceLimits(
+    std::string_view limits) {
+  std::map<std::string, ResourceLimits> by_executable;
+  for (std::string_view entry :
+       absl::StrSplit(limits, ',', absl::SkipEmpty())) {
+    std::vector<std::string_view> parts = absl::StrSplit(entry, ':');
+    CF_EXPECTF(parts.size() > 1 && !parts[0].empty(),
+               "Expected '<executable>:<limit>...', got '{}'", entry);
+    ResourceLimits& parsed = by_executable[std::string(parts[0])];
+    for (size_t i = 1; i < parts.size(); i++) {
+      std::string_view limit = parts[i];
+      if (absl::ConsumePrefix(&limit, "cpu=")) {
+        double cpus;
+        CF_EXPECTF(absl::SimpleAtod(limit, &cpus) && cpus > 0,
+                   "Invalid cpu limit in '{}'", entry);
+        parsed.cpus = cpus;
+      } else if (absl::ConsumePrefix(&limit, "memory=")) {
+        uint64_t mib;
+        CF_EXPECTF(absl::SimpleAtoi(limit, &mib) && mib > 0,
+                   "Invalid memory limit in '{}'", entry);
+        parsed.memory_bytes = mib << 20;
+      } else {
+        return CF_ERRF("Unknown limit '{}' in '{}'", parts[i], entry);
+      }
+    }
+  }
+  return by_executable;
+}
+
+Result<ResourceUsage> ProcessUsage(pid_t pid) {
+  const std::string proc = "/proc/" + std::to_string(pid);
+  ResourceUsage usage;
+
+  // The command name may contain spaces, the fields start after it.
+  const std::string stat = CF_EXPECT(ReadFileContents(proc + "/stat"));
+  const size_t comm_end = stat.rfind(')');
+  CF_EXPECTF(comm_end != std::string::npos, "Unexpected '{}/stat'", proc);
+  std::vector<std::string_view> fields = absl::StrSplit(
+      std::string_view(stat).substr(comm_end + 1), ' ', absl::SkipEmpty());
+  // utime and stime, the 14th and 15th fields, in clock ticks.
+  CF_EXPECTF(fields.size() > 12, "Unexpected '{}/stat'", proc);
+  uint64_t utime;
+  uint64_t stime;
+  CF_EXPECT(absl::SimpleAtoi(fields[11], &utime));
+  CF_EXPECT(absl::SimpleAtoi(fields[12], &stime));
+  usage.cpu_usec = (utime + stime) * 1000000 / sysconf(_SC_CLK_TCK);
+
+  const std::string status = CF_EXPECT(ReadFileContents(proc + "/status"));
+  usage.memory_bytes = LineValue(status, "VmRSS:") << 10;
+
+  // Only readable with ptrace access to the process.
+  Result<std::string> io = ReadFileContents(proc + "/io");
+  if (io.ok()) {
+    usage.io_read_bytes = LineValue(*io, "read_bytes:");
+    usage.io_write_bytes = LineValue(*io, "write_bytes:");
+  }
+  return usage;
+}
+
+Cgroup::Cgroup(std::string path) : path_(std::move(path)) {}
+
+Result<Cgroup> Cgroup::CreateUnderCurrent(const std::string& name) {
+  struct statfs mount;
+  CF_EXPECTF(statfs(kCgroupMount, &mount) == 0, "Failed to stat '{}': {}",
+             kCgroupMount, StrError(errno));
+  CF_EXPECTF(mount.f_type == CGROUP2_SUPER_MAGIC,
+             "No cgroup v2 hierarchy mounted at '{}'", kCgroupMount);
+
+  // The cgroup v2 line has the form "0::<path>".
+  const std::string cgroups = CF_EXPECT(ReadFileContents("/proc/self/cgroup"));
+  std::string current;
+  for (std::string_view line : absl::StrSplit(cgroups, '\n')) {
+    if (absl::ConsumePrefix(&line, "0::")) {
+      absl::ConsumeSuffix(&line, "/");
+      current = std::string(kCgroupMount) + std::string(line);
+    }
+  }
+  CF_EXPECT(!current.empty(), "Not in a cgroup v2 hierarchy");
+  CF_EXPECTF(access((current + "/cgroup.procs").c_str(), W_OK) == 0,
+             "The cgroup '{}' is not delegated to this user", current);
+
+  CF_EXPECT(EnableControllers(current));
+  Cgroup cgroup(current + "/" + name);
+  CF_EXPECT(MakeDirectory(cgroup.path_));
+  CF_EXPECT(EnableControllers(cgroup.path_));
+  return cgroup;
+}
+
+Result<Cgroup> Cgroup::CreateLeaf(const std::string& name) const {
+  Cgroup leaf(path_ + "/" + name);
+  CF_EXPECT(MakeDirectory(leaf.path_));
+  return leaf;
+}
+
+Result<void> Cgroup::Limit(const ResourceLimits& limits) const {
+  if (limits.cpus) {
+    const uint64_t quota = std::llround(*limits.cpus * kCpuPeriodUsec);
+    CF_EXPECT(WriteFile(path_ + "/cpu.max",
+                        fmt::format("{} {}", quota, kCpuPeriodUsec)));
+  }
+  if (limits.memory_bytes) {
+    CF_EXPECT(WriteFile(path_ + "/memory.max",
+                        std::to_string(*limits.memory_bytes)));
+  }
+  return {};
+}
+
+Result<SharedFD> Cgroup::OpenProcs() const {
+  const std::string path = path_ + "/cgroup.procs";
+  SharedFD procs = SharedFD::Open(path, O_WRONLY);
+  CF_EXPECTF(procs->IsOpen(), "Failed to open '{}': {}", path,
+             procs->StrError());
+  return procs;
+}
+
+Result<ResourceUsage> Cgroup::Usage() const {
+  ResourceUsage usage;
+  // cpu.stat has usage_usec even without the cpu controller.
+  const std::string cpu_stat = CF_EXPECT(ReadFileContents(path_ + "/cpu.stat"));
+  usage.cpu_usec = LineValue(cpu_stat, "usage_usec");
+  Result<std::string> memory = ReadFileContents(path_ + "/memory.current");
+  if (memory.ok()) {
+    absl::SimpleAtoi(*memory, &usage.memory_bytes);
+  }
+  Result<std::string> io = ReadFileContents(path_ + "/io.stat");
+  if (io.ok()) {
+    usage.io_read_bytes = SumFields(*io, "rbytes=");
+    usage.io_write_bytes = SumFields(*io, "wbytes=");
+  }
+  return usage;
+}
+
+Result<void> Cgroup::Remove() const {
+  CF_EXPECTF(rmdir(path_.c_str()) == 0, "Failed to remove '{}': {}", path_,
+             StrError(errno));
+  return {};
+}
+
+}  // namespace cuttlefish
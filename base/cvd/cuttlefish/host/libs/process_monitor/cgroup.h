@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+
+struct ResourceUsage {
+  uint64_t cpu_usec = 0;
+  // memory.current for a cgroup, the resident set size for a process.
+  uint64_t memory_bytes = 0;
+  uint64_t io_read_bytes = 0;
+  uint64_t io_write_bytes = 0;
+};
+
+struct ResourceLimits {
+  std::optional<double> cpus;
+  std::optional<uint64_t> memory_bytes;
+};
+
+/**
+ * Parses limits by executable name, in the form
+ * "<executable>:cpu=<cores>:memory=<MiB>[,<executable>:...]", where both
+ * limits are optional.
+ */
+Result<std::map<std::string, ResourceLimits>> ParseResourceLimits(
+    std::string_view limits);
+
+/**
+ * The number after `key` on the first line that starts with it and has one, as
+ * in cpu.stat or /proc/<pid>/status. 0 if there is none.
+ */
+uint64_t LineValue(std::string_view content, std::string_view key);
+
+/** Sums the "<key><value>" fields, which io.stat has once per device. */
+uint64_t SumFields(std::string_view content, std::string_view key);
+
+/** Usage of a single process, without its children, from /proc. */
+Result<ResourceUsage> ProcessUsage(pid_t pid);
+
+/** A cgroup v2 directory. */
+class Cgroup {
+ public:
+  /**
+   * Creates `name` under the cgroup of the calling process, with the cpu,
+   * memory and io controllers enabled for its children as far as they are
+   * delegated.
+   *
+   * Enabling controllers requires the cgroup of the calling process to have
+   * no processes of its own, so they are all moved to a "launcher" leaf. This
+   * only works in a delegated cgroup, such as the one of
+   * `systemd-run --user --scope -p Delegate=yes`.
+   */
+  static Result<Cgroup> CreateUnderCurrent(const std::string& name);
+
+  /** Creates a leaf for processes, or returns the existing one. */
+  Result<Cgroup> CreateLeaf(const std::string& name) const;
+
+  Result<void> Limit(const ResourceLimits& limits) const;
+  /** Opens cgroup.procs for SubprocessOptions::InCgroup. */
+  Result<SharedFD> OpenProcs() const;
+  Result<ResourceUsage> Usage() const;
+  /** Only succeeds once the cgroup has no processes left. */
+  Result<void> Remove() const;
+
+  const std::string& Path() const { return path_; }
+
+ private:
+  explicit Cgroup(std::string path);
+
+  std::string path_;
+};
+
+}  // namespace cuttlefish
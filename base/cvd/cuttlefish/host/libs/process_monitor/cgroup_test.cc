@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/libs/process_monitor/cgroup.h"
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <map>
+#include <string>
+
+#include "gtest/gtest.h"
+
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+
+TEST(ParseResourceLimitsTest, Empty) {
+  Result<std::map<std::string, ResourceLimits>> limits =
+      ParseResourceLimits("");
+  ASSERT_THAT(limits, IsOk());
+  EXPECT_TRUE(limits->empty());
+}
+
+TEST(ParseResourceLimitsTest, BothLimits) {
+  Result<std::map<std::string, ResourceLimits>> limits =
+      ParseResourceLimits("crosvm:cpu=1.5:memory=2048");
+  ASSERT_THAT(limits, IsOk());
+  ASSERT_EQ(limits->size(), 1);
+  const ResourceLimits& crosvm = limits->at("crosvm");
+  EXPECT_EQ(crosvm.cpus, 1.5);
+  EXPECT_EQ(crosvm.memory_bytes, uint64_t{2048} << 20);
+}
+
+TEST(ParseResourceLimitsTest, SeveralExecutablesWithOptionalLimits) {
+  Result<std::map<std::string, ResourceLimits>> limits =
+      ParseResourceLimits("crosvm:memory=512,webRTC:cpu=2");
+  ASSERT_THAT(limits, IsOk());
+  ASSERT_EQ(limits->size(), 2);
+  EXPECT_FALSE(limits->at("crosvm").cpus.has_value());
+  EXPECT_EQ(limits->at("crosvm").memory_bytes, uint64_t{512} << 20);
+  EXPECT_EQ(limits->at("webRTC").cpus, 2.0);
+  EXPECT_FALSE(limits->at("webRTC").memory_bytes.has_value());
+}
+
+TEST(ParseResourceLimitsTest, LaterEntriesAddToEarlierOnes) {
+  Result<std::map<std::string, ResourceLimits>> limits =
+      ParseResourceLimits("crosvm:cpu=1,crosvm:memory=64");
+  ASSERT_THAT(limits, IsOk());
+  EXPECT_EQ(limits->at("crosvm").cpus, 1.0);
+  EXPECT_EQ(limits->at("crosvm").memory_bytes, uint64_t{64} << 20);
+}
+
+TEST(ParseResourceLimitsTest, Invalid) {
+  EXPECT_THAT(ParseResourceLimits("crosvm"), IsError());
+  EXPECT_THAT(ParseResourceLimits(":cpu=1"), IsError());
+  EXPECT_THAT(ParseResourceLimits("crosvm:"), IsError());
+  EXPECT_THAT(ParseResourceLimits("crosvm:cpu=0"), IsError());
+  EXPECT_THAT(ParseResourceLimits("crosvm:cpu=-1"), IsError());
+  EXPECT_THAT(ParseResourceLimits("crosvm:cpu=many"), IsError());
+  EXPECT_THAT(ParseResourceLimits("crosvm:memory=0"), IsError());
+  EXPECT_THAT(ParseResourceLimits("crosvm:memory=1.5"), IsError());
+  EXPECT_THAT(ParseResourceLimits("crosvm:disk=1"), IsError());
+}
+
+TEST(LineValueTest, FindsTheLineWithTheKey) {
+  const std::string status =
+      "Name:\tcat\nVmPeak:\t  5000 kB\nVmRSS:\t    1234 kB\nThreads:\t1\n";
+  EXPECT_EQ(LineValue(status, "VmRSS:"), 1234);
+  EXPECT_EQ(LineValue(status, "Threads:"), 1);
+  EXPECT_EQ(LineValue(status, "VmSwap:"), 0);
+}
+
+TEST(LineValueTest, OnlyMatchesAtTheStartOfLines) {
+  const std::string cpu_stat =
+      "usage_usec 900\nuser_usec 600\nsystem_usec 300\n";
+  EXPECT_EQ(LineValue(cpu_stat, "usage_usec"), 900);
+  EXPECT_EQ(LineValue(cpu_stat, "user_usec"), 600);
+  EXPECT_EQ(LineValue(cpu_stat, "usec"), 0);
+}
+
+TEST(LineValueTest, SkipsLinesWithoutANumber) {
+  EXPECT_EQ(LineValue("key: none\nkey: 7\n", "key:"), 7);
+  EXPECT_EQ(LineValue("key:", "key:"), 0);
+  EXPECT_EQ(LineValue("", "key:"), 0);
+}
+
+TEST(SumFieldsTest, SumsEveryDevice) {
+  const std::string io_stat =
+      "8:0 rbytes=1000 wbytes=200 rios=3 wios=1\n"
+      "253:0 rbytes=24 wbytes=0 rios=1 wios=0\n";
+  EXPECT_EQ(SumFields(io_stat, "rbytes="), 1024);
+  EXPECT_EQ(SumFields(io_stat, "wbytes="), 200);
+  EXPECT_EQ(SumFields(io_stat, "dbytes="), 0);
+  EXPECT_EQ(SumFields("", "rbytes="), 0);
+}
+
+TEST(ProcessUsageTest, OwnProcess) {
+  // Spends some CPU time first, so it shows up in the clock ticks.
+  const clock_t start = clock();
+  while (clock() - start < CLOCKS_PER_SEC / 20) {
+  }
+  Result<ResourceUsage> usage = ProcessUsage(getpid());
+  ASSERT_THAT(usage, IsOk());
+  EXPECT_GT(usage->cpu_usec, 0);
+  EXPECT_GT(usage->memory_bytes, 0);
+}
+
+TEST(ProcessUsageTest, ExitedProcess) {
+  const pid_t pid = fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    _exit(0);
+  }
+  ASSERT_EQ(waitpid(pid, nullptr, 0), pid);
+  EXPECT_THAT(ProcessUsage(pid), IsError());
+}
+
+}  // namespace cuttlefish
@@ -18,31 +18,48 @@
 
 #include <errno.h>
 #include <signal.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #ifdef __linux__
 #include <sys/prctl.h>
 #endif
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <future>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include <json/json.h>
 #include "absl/log/log.h"
 #include "absl/strings/match.h"
 #include "android-base/file.h"
 
+#include "cuttlefish/common/libs/fs/epoll.h"
+#include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/common/libs/transport/channel.h"
 #include "cuttlefish/common/libs/transport/channel_sharedfd.h"
 #include "cuttlefish/common/libs/utils/contains.h"
+#include "cuttlefish/common/libs/utils/json.h"
 #include "cuttlefish/common/libs/utils/subprocess.h"
 #include "cuttlefish/host/libs/command_util/util.h"
 #include "cuttlefish/host/libs/config/known_paths.h"
+#include "cuttlefish/host/libs/process_monitor/cgroup.h"
+#include "cuttlefish/host/libs/process_monitor/start_dependencies.h"
 #include "cuttlefish/posix/strerror.h"
 #include "cuttlefish/result/result.h"
 
@@ -58,6 +75,7 @@ enum ParentToChildMessageType : uint8_t {
   kHostResume = 2,
   kHostSuspend = 3,
   kError = 4,
+  kStatus = 5,
 };
 
 enum ChildToParentResponseType : uint8_t {
@@ -77,22 +95,6 @@ Result<void> SendEmptyResponse(Channel& channel, uint32_t type) {
   return {};
 }
 
-void LogSubprocessExit(const std::string& name, pid_t pid, int wstatus) {
-  LOG(INFO) << "Detected unexpected exit of monitored subprocess " << name;
-  if (WIFEXITED(wstatus)) {
-    LOG(INFO) << "Subprocess " << name << " (" << pid
-              << ") has exited with exit code " << WEXITSTATUS(wstatus);
-  } else if (WIFSIGNALED(wstatus)) {
-    int sig_num = WTERMSIG(wstatus);
-    LOG(ERROR) << "Subprocess " << name << " (" << pid
-               << ") was interrupted by a signal '" << strsignal(sig_num)
-               << "' (" << sig_num << ")";
-  } else {
-    LOG(INFO) << "subprocess " << name << " (" << pid
-              << ") has exited for unknown reasons";
-  }
-}
-
 void LogSubprocessExit(const std::string& name, const siginfo_t& infop) {
   LOG(INFO) << "Detected unexpected exit of monitored subprocess " << name;
   if (infop.si_code == CLD_EXITED) {
@@ -109,44 +111,180 @@ void LogSubprocessExit(const std::string& name, const siginfo_t& infop) {
   }
 }
 
+using Clock = std::chrono::steady_clock;
+
+// Orphans reparented to the monitor don't wake it up when they exit, so it
+// collects them this often.
+constexpr auto kReapInterval = std::chrono::seconds(10);
+// Without pidfds the monitored processes don't wake it up either, so it looks
+// for their exits this often instead.
+constexpr auto kExitPollInterval = std::chrono::milliseconds(100);
+// Exiting sooner than this after starting counts as a quick exit, and delays
+// the restart by twice as long as the previous one, up to a maximum.
+constexpr auto kStableRunTime = std::chrono::seconds(30);
+constexpr auto kFirstRestartDelay = std::chrono::milliseconds(250);
+constexpr auto kMaxRestartDelay = std::chrono::seconds(30);
+
+SubprocessOptions MonitoredOptions(const MonitorEntry& entry) {
+  return SubprocessOptions().InGroup(true).InCgroup(entry.cgroup_procs);
+}
+
+Result<void> WatchExit(Epoll& epoll, MonitorEntry& entry) {
+  entry.pidfd = SharedFD::PidFdOpen(entry.proc->pid());
+  if (!entry.pidfd->IsOpen()) {
+    // Not available before Linux 5.3, or denied by a seccomp policy. The exit
+    // is then found by polling, see WaitTimeout.
+    const int error = entry.pidfd->GetErrno();
+    CF_EXPECTF(error == ENOSYS || error == EPERM,
+               "pidfd_open failed for {}: {}", entry.cmd->GetShortName(),
+               entry.pidfd->StrError());
+    VLOG(0) << "Polling for the exit of " << entry.cmd->GetShortName()
+            << ", pidfd_open failed: " << entry.pidfd->StrError();
+    return {};
+  }
+  CF_EXPECT(epoll.Add(entry.pidfd, EPOLLIN));
+  return {};
+}
+
+Clock::duration RestartDelay(MonitorEntry& entry, Clock::time_point now) {
+  if (now - entry.started_at >= kStableRunTime) {
+    entry.quick_exits = 0;
+    return Clock::duration::zero();
+  }
+  Clock::duration delay = kFirstRestartDelay;
+  for (int i = 0; i < entry.quick_exits && delay < kMaxRestartDelay; i++) {
+    delay *= 2;
+  }
+  entry.quick_exits++;
+  return std::min<Clock::duration>(delay, kMaxRestartDelay);
+}
+
+std::chrono::milliseconds WaitTimeout(
+    const std::vector<MonitorEntry>& monitored, Clock::time_point now) {
+  Clock::duration timeout = kReapInterval;
+  for (const auto& entry : monitored) {
+    if (entry.restart_at) {
+      timeout = std::min(timeout, *entry.restart_at - now);
+    }
+    if (entry.proc && !entry.pidfd->IsOpen()) {
+      timeout = std::min<Clock::duration>(timeout, kExitPollInterval);
+    }
+  }
+  // Rounded up, to not wake up just before the restart is due.
+  return std::max(std::chrono::ceil<std::chrono::milliseconds>(timeout),
+                  std::chrono::milliseconds::zero());
+}
+
+void RemoveCgroup(const MonitorEntry& entry) {
+  if (!entry.cgroup) {
+    return;
+  }
+  // Fails while descendants that escaped the process group keep running.
+  Result<void> removed = entry.cgroup->Remove();
+  if (!removed.ok()) {
+    VLOG(0) << removed.error().FormatForEnv();
+  }
+}
+
+// Waits for subprocesses to exit on their pidfds, or polls for their exits
+// without pidfds, and restarts them, after a delay when they keep exiting soon
+// after starting.
 Result<void> MonitorLoop(std::atomic_bool& running,
                          std::mutex& properties_mutex,
                          const bool restart_subprocesses,
-                         std::vector<MonitorEntry>& monitored) {
+                         std::vector<MonitorEntry>& monitored,
+                         SharedFD wakeup) {
+  Epoll epoll = CF_EXPECT(Epoll::Create());
+  CF_EXPECT(epoll.Add(wakeup, EPOLLIN));
+  {
+    std::lock_guard lock(properties_mutex);
+    for (auto& entry : monitored) {
+      CF_EXPECT(WatchExit(epoll, entry));
+    }
+  }
   while (running.load()) {
-    int wstatus;
-    pid_t pid = wait(&wstatus);
-    CF_EXPECTF(pid != -1, "Wait failed: {}", StrError(errno));
-    if (!WIFSIGNALED(wstatus) && !WIFEXITED(wstatus)) {
-      VLOG(0) << "Unexpected status from wait: " << wstatus << " for pid "
-              << pid;
-      continue;
+    std::optional<EpollEvent> event;
+    {
+      std::unique_lock lock(properties_mutex);
+      const std::chrono::milliseconds timeout =
+          WaitTimeout(monitored, Clock::now());
+      lock.unlock();
+      event = CF_EXPECT(epoll.Wait(timeout));
+    }
+    if (event && event->fd == wakeup) {
+      eventfd_t value;
+      wakeup->EventfdRead(&value);
     }
     if (!running.load()) {  // Avoid extra restarts near the end
       break;
     }
-    auto matches = [pid](const auto& it) { return it.proc->pid() == pid; };
     std::unique_lock lock(properties_mutex);
-    auto it = std::find_if(monitored.begin(), monitored.end(), matches);
-    if (it == monitored.end()) {
-      LogSubprocessExit("(unknown)", pid, wstatus);
-    } else {
-      LogSubprocessExit(it->cmd->GetShortName(), it->proc->pid(), wstatus);
+    const Clock::time_point now = Clock::now();
+    // The pidfds only wake the loop up, the exits are collected here along
+    // with those of orphans.
+    while (running.load()) {
+      siginfo_t infop{};
+      if (waitid(P_ALL, 0, &infop, WEXITED | WNOHANG) != 0) {
+        CF_EXPECTF(errno == ECHILD, "Wait failed: {}", StrError(errno));
+        break;
+      }
+      const pid_t pid = infop.si_pid;
+      if (pid == 0) {
+        break;
+      }
+      auto matches = [pid](const auto& it) {
+        return it.proc && it.proc->pid() == pid;
+      };
+      auto it = std::find_if(monitored.begin(), monitored.end(), matches);
+      if (it == monitored.end()) {
+        LogSubprocessExit("(unknown)", infop);
+        continue;
+      }
+      LogSubprocessExit(it->cmd->GetShortName(), infop);
+      if (it->pidfd->IsOpen()) {
+        CF_EXPECT(epoll.Delete(it->pidfd));
+        it->pidfd = SharedFD();
+      }
+      // The pid may be reused by the time it would be stopped.
+      it->proc.reset();
       if (restart_subprocesses) {
-        auto options = SubprocessOptions().InGroup(true);
-        // in the future, cmd->Start might not run exec()
-        it->proc.reset(new Subprocess(it->cmd->Start(std::move(options))));
+        const Clock::duration delay = RestartDelay(*it, now);
+        if (delay > Clock::duration::zero()) {
+          LOG(INFO) << "Restarting " << it->cmd->GetShortName() << " in "
+                    << std::chrono::duration_cast<std::chrono::milliseconds>(
+                           delay)
+                           .count()
+                    << "ms";
+        }
+        it->restart_at = now + delay;
       } else {
         bool is_critical = it->is_critical;
+        RemoveCgroup(*it);
         monitored.erase(it);
         if (running.load() && is_critical) {
           LOG(ERROR) << "Stopping all monitored processes due to unexpected "
                         "exit of critical process";
           running.store(false);
-          break;
         }
       }
     }
+    for (auto& entry : monitored) {
+      if (!running.load() || !entry.restart_at || *entry.restart_at > now) {
+        continue;
+      }
+      entry.restart_at.reset();
+      entry.started_at = now;
+      entry.restarts++;
+      // in the future, cmd->Start might not run exec()
+      Subprocess proc = entry.cmd->Start(MonitoredOptions(entry));
+      if (proc.Started()) {
+        entry.proc.reset(new Subprocess(std::move(proc)));
+        CF_EXPECT(WatchExit(epoll, entry));
+      } else {
+        LOG(ERROR) << "Failed to restart " << entry.cmd->GetShortName();
+        entry.restart_at = now + RestartDelay(entry, now);
+      }
+    }
   }
   return {};
 }
@@ -154,6 +292,9 @@ Result<void> MonitorLoop(std::atomic_bool& running,
 Result<void> StopSubprocesses(std::vector<MonitorEntry>& monitored) {
   VLOG(0) << "Stopping monitored subprocesses";
   auto stop = [](const auto& it) {
+    if (!it.proc) {  // Exited, waiting to be restarted
+      return true;
+    }
     auto stop_result = it.proc->Stop();
     if (stop_result == StopperResult::kStopFailure) {
       LOG(WARNING) << "Error in stopping \"" << it.cmd->GetShortName() << "\"";
@@ -206,6 +347,9 @@ Result<void> SuspendResumeImpl(std::vector<MonitorEntry>& monitor_entries,
       LOG(ERROR) << "Monitor Entry has a nullptr for cmd.";
       continue;
     }
+    if (entry.restart_at) {  // Exited, waiting to be restarted
+      continue;
+    }
     if (!entry.proc) {
       LOG(ERROR) << "Monitor Entry has a nullptr for proc.";
       continue;
@@ -251,27 +395,182 @@ Result<void> SuspendResumeImpl(std::vector<MonitorEntry>& monitor_entries,
   return {};
 }
 
+struct StartTiming {
+  Clock::time_point dependencies_ready;
+  Clock::time_point prerequisites_passed;
+  Clock::time_point started;
+  Clock::time_point ready;
+};
+
+// What the entries starting after this one name it.
+std::string StartName(const MonitorEntry& entry) {
+  if (!entry.name.empty()) {
+    return entry.name;
+  }
+  return android::base::Basename(entry.cmd->Executable());
+}
+
+int64_t Milliseconds(Clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(duration)
+      .count();
+}
+
+// Logs the chain of entries that delayed the last one to become ready.
+void LogCriticalPath(const std::vector<MonitorEntry>& entries,
+                     const std::vector<std::vector<size_t>>& dependencies,
+                     const std::vector<StartTiming>& timings,
+                     Clock::time_point start) {
+  auto later_ready = [&timings](size_t a, size_t b) {
+    return timings[a].ready < timings[b].ready;
+  };
+  std::vector<size_t> all(entries.size());
+  for (size_t i = 0; i < all.size(); i++) {
+    all[i] = i;
+  }
+  auto last = std::max_element(all.begin(), all.end(), later_ready);
+  if (last == all.end()) {
+    return;
+  }
+  std::deque<size_t> path = {*last};
+  while (!dependencies[path.front()].empty()) {
+    const auto& path_dependencies = dependencies[path.front()];
+    path.push_front(*std::max_element(path_dependencies.begin(),
+                                      path_dependencies.end(), later_ready));
+  }
+  LOG(INFO) << "Monitored subprocesses ready after "
+            << Milliseconds(timings[*last].ready - start)
+            << "ms, critical path:";
+  for (size_t i : path) {
+    const StartTiming& timing = timings[i];
+    LOG(INFO) << "  " << entries[i].cmd->GetShortName()
+              << ": prerequisites passed after "
+              << Milliseconds(timing.prerequisites_passed -
+                              timing.dependencies_ready)
+              << "ms, started after "
+              << Milliseconds(timing.started - timing.prerequisites_passed)
+              << "ms, ready after "
+              << Milliseconds(timing.ready - timing.started) << "ms";
+  }
+}
+
 }  // namespace
 
 Result<void> ProcessMonitor::StartSubprocesses(
     ProcessMonitor::Properties& properties) {
   VLOG(0) << "Starting monitored subprocesses";
-  for (auto& monitored : properties.entries_) {
+  std::vector<MonitorEntry>& entries = properties.entries_;
+  std::vector<std::string> names;
+  std::vector<std::set<std::string>> start_after;
+  for (const MonitorEntry& entry : entries) {
+    names.push_back(StartName(entry));
+    start_after.push_back(entry.start_after);
+  }
+  const std::vector<std::vector<size_t>> dependencies =
+      CF_EXPECT(StartDependencies(names, start_after));
+
+  const Clock::time_point start_time = Clock::now();
+  std::vector<StartTiming> timings(entries.size());
+  std::vector<std::promise<bool>> ready(entries.size());
+  std::vector<std::shared_future<bool>> ready_futures;
+  for (auto& promise : ready) {
+    ready_futures.emplace_back(promise.get_future().share());
+  }
+  // Subprocesses get SIGHUP when the thread forking them exits, so they are
+  // all forked by this thread. One thread per entry waits for what the entry
+  // needs, so that waiting for one delays only the entries depending on it.
+  std::mutex fork_mutex;
+  std::condition_variable fork_cv;
+  std::deque<size_t> to_fork;
+  size_t unforked = entries.size();
+  std::vector<std::promise<Result<void>>> forked(entries.size());
+
+  auto prepare = [](MonitorEntry& monitored,
+                    bool dependencies_failed) -> Result<void> {
+    CF_EXPECTF(!dependencies_failed,
+               "Not starting {}, a command it starts after failed",
+               monitored.cmd->GetShortName());
+    CF_EXPECTF(monitored.cmd->CheckPrerequisites(),
+               "Prerequisites of {} failed", monitored.cmd->GetShortName());
+    return {};
+  };
+  auto start = [&properties](MonitorEntry& monitored) -> Result<void> {
     LOG(INFO) << "Starting monitored subprocess: "
               << monitored.cmd->GetShortName();
-    auto options = SubprocessOptions().InGroup(true);
+    // The prerequisites already passed on the thread of the entry.
+    auto options = MonitoredOptions(monitored).CheckPrerequisites(false);
     std::string short_name = monitored.cmd->GetShortName();
     auto last_slash = short_name.find_last_of('/');
     if (last_slash != std::string::npos) {
       short_name = short_name.substr(last_slash + 1);
     }
-    if (Contains(properties_.strace_commands_, short_name)) {
+    if (Contains(properties.strace_commands_, short_name)) {
       options.Strace(properties.strace_log_dir_ + "/strace-" + short_name);
     }
+    monitored.started_at = Clock::now();
     monitored.proc.reset(
         new Subprocess(monitored.cmd->Start(std::move(options))));
     CF_EXPECT(monitored.proc->Started(), "Failed to start subprocess");
+    return {};
+  };
+  auto wait_ready = [](MonitorEntry& monitored) -> Result<void> {
+    if (monitored.readiness) {
+      CF_EXPECTF(monitored.readiness(), "{} did not become ready",
+                 monitored.cmd->GetShortName());
+    }
+    return {};
+  };
+  auto start_when_ready = [&](size_t i) -> Result<void> {
+    MonitorEntry& monitored = entries[i];
+    bool dependencies_failed = false;
+    for (size_t dependency : dependencies[i]) {
+      if (!ready_futures[dependency].get()) {
+        dependencies_failed = true;
+      }
+    }
+    timings[i].dependencies_ready = Clock::now();
+    Result<void> result = prepare(monitored, dependencies_failed);
+    timings[i].prerequisites_passed = Clock::now();
+    std::future<Result<void>> forked_future = forked[i].get_future();
+    {
+      std::lock_guard<std::mutex> lock(fork_mutex);
+      if (result.ok()) {
+        to_fork.push_back(i);
+      } else {
+        unforked--;
+      }
+    }
+    fork_cv.notify_one();
+    if (result.ok()) {
+      result = forked_future.get();
+    }
+    timings[i].started = Clock::now();
+    if (result.ok()) {
+      result = wait_ready(monitored);
+    }
+    timings[i].ready = Clock::now();
+    ready[i].set_value(result.ok());
+    return result;
+  };
+  std::vector<std::future<Result<void>>> starts;
+  for (size_t i = 0; i < entries.size(); i++) {
+    starts.emplace_back(std::async(std::launch::async, start_when_ready, i));
+  }
+  while (true) {
+    std::unique_lock<std::mutex> lock(fork_mutex);
+    fork_cv.wait(lock, [&] { return !to_fork.empty() || unforked == 0; });
+    if (to_fork.empty()) {
+      break;
+    }
+    const size_t i = to_fork.front();
+    to_fork.pop_front();
+    unforked--;
+    lock.unlock();
+    forked[i].set_value(start(entries[i]));
   }
+  for (auto& started : starts) {
+    CF_EXPECT(started.get());
+  }
+  LogCriticalPath(entries, dependencies, timings, start_time);
   return {};
 }
 
@@ -289,13 +588,16 @@ Result<void> ProcessMonitor::ReadMonitorSocketLoop(std::atomic_bool& running) {
     auto message = std::move(*message_res);
     if (message->command == ParentToChildMessageType::kStop) {
       running.store(false);
-      // Wake up the wait() loop by giving it an exited child process
-      if (fork() == 0) {
-        std::exit(0);
-      }
+      // Wake up the monitor loop, it stops as running is now false
+      CF_EXPECTF(wakeup_->EventfdWrite(1) == 0,
+                 "Failed to wake up the monitor loop: {}", wakeup_->StrError());
       // will break the for-loop as running is now false
       continue;
     }
+    if (message->command == ParentToChildMessageType::kStatus) {
+      CF_EXPECT(SendStatus());
+      continue;
+    }
     if (message->command == ParentToChildMessageType::kHostSuspend) {
       CF_EXPECT(SuspendHostProcessesImpl());
       continue;
@@ -326,6 +628,115 @@ Result<void> ProcessMonitor::ResumeHostProcessesImpl() {
   return {};
 }
 
+Result<void> ProcessMonitor::SendStatus() {
+  Json::Value status(Json::arrayValue);
+  {
+    std::lock_guard lock(properties_mutex_);
+    for (const auto& entry : properties_.entries_) {
+      Json::Value process;
+      process["name"] = entry.cmd->GetShortName();
+      process["running"] = entry.proc != nullptr;
+      process["restarts"] = entry.restarts;
+      if (entry.proc) {
+        process["pid"] = entry.proc->pid();
+      }
+      if (entry.cgroup) {
+        process["cgroup"] = entry.cgroup->Path();
+      }
+      if (entry.cgroup || entry.proc) {
+        Result<ResourceUsage> usage = entry.cgroup
+                                          ? entry.cgroup->Usage()
+                                          : ProcessUsage(entry.proc->pid());
+        if (usage.ok()) {
+          process["cpu_usec"] = Json::UInt64(usage->cpu_usec);
+          process["memory_bytes"] = Json::UInt64(usage->memory_bytes);
+          process["io_read_bytes"] = Json::UInt64(usage->io_read_bytes);
+          process["io_write_bytes"] = Json::UInt64(usage->io_write_bytes);
+        } else {
+          VLOG(0) << usage.error().FormatForEnv();
+        }
+      }
+      status.append(process);
+    }
+  }
+  Json::StreamWriterBuilder builder;
+  builder["indentation"] = "";
+  const std::string serialized = Json::writeString(builder, status);
+  ManagedMessage response = CF_EXPECT(CreateMessage(
+      ChildToParentResponseType::kSuccess, true, serialized.size()));
+  std::copy(serialized.begin(), serialized.end(), response->payload);
+  CF_EXPECT(child_channel_->SendResponse(*response));
+  return {};
+}
+
+Result<void> ProcessMonitor::SetUpCgroups() {
+  Cgroup group =
+      CF_EXPECT(Cgroup::CreateUnderCurrent(properties_.cgroup_name_));
+  // The entries only get their leaves once all of them are ready, so a failure
+  // leaves every subprocess in the monitor's cgroup and no cgroup behind.
+  std::vector<Cgroup> leaves;
+  std::vector<SharedFD> leaf_procs;
+  auto create_leaves = [this, &group, &leaves, &leaf_procs]() -> Result<void> {
+    // Duplicate executables get numbered leaves.
+    std::map<std::string, int> counts;
+    for (const auto& entry : properties_.entries_) {
+      std::string name = android::base::Basename(entry.cmd->Executable());
+      std::string leaf_name = name;
+      if (int count = counts[name]++; count > 0) {
+        leaf_name += "-" + std::to_string(count);
+      }
+      leaves.emplace_back(CF_EXPECT(group.CreateLeaf(leaf_name)));
+      auto limits = properties_.limits_.find(name);
+      if (limits != properties_.limits_.end()) {
+        Result<void> limited = leaves.back().Limit(limits->second);
+        if (!limited.ok()) {
+          LOG(WARNING) << "Failed to limit " << name << ":\n"
+                       << limited.error().FormatForEnv();
+        }
+      }
+      leaf_procs.emplace_back(CF_EXPECT(leaves.back().OpenProcs()));
+    }
+    for (const auto& [name, limits] : properties_.limits_) {
+      if (!counts.count(name)) {
+        LOG(WARNING) << "Not limiting " << name << ", it is not monitored";
+      }
+    }
+    return {};
+  };
+  if (Result<void> created = create_leaves(); !created.ok()) {
+    for (const Cgroup& leaf : leaves) {
+      Result<void> removed = leaf.Remove();
+      if (!removed.ok()) {
+        VLOG(0) << removed.error().FormatForEnv();
+      }
+    }
+    Result<void> removed = group.Remove();
+    if (!removed.ok()) {
+      VLOG(0) << removed.error().FormatForEnv();
+    }
+    CF_EXPECT(std::move(created));
+  }
+
+  for (size_t i = 0; i < properties_.entries_.size(); i++) {
+    properties_.entries_[i].cgroup = std::move(leaves[i]);
+    properties_.entries_[i].cgroup_procs = std::move(leaf_procs[i]);
+  }
+  cgroup_ = std::move(group);
+  return {};
+}
+
+void ProcessMonitor::RemoveCgroups() {
+  for (const auto& entry : properties_.entries_) {
+    RemoveCgroup(entry);
+  }
+  if (cgroup_) {
+    Result<void> removed = cgroup_->Remove();
+    if (!removed.ok()) {
+      VLOG(0) << removed.error().FormatForEnv();
+    }
+  }
+}
+
 ProcessMonitor::Properties& ProcessMonitor::Properties::RestartSubprocesses(
     bool r) & {
   restart_subprocesses_ = r;
@@ -334,7 +745,7 @@ ProcessMonitor::Properties& ProcessMonitor::Properties::RestartSubprocesses(
 
 ProcessMonitor::Properties& ProcessMonitor::Properties::AddCommand(
     MonitorCommand cmd) & {
-  entries_.emplace_back(std::move(cmd.command), cmd.is_critical);
+  entries_.emplace_back(std::move(cmd));
   return *this;
 }
 
@@ -350,6 +761,18 @@ ProcessMonitor::Properties& ProcessMonitor::Properties::StraceLogDir(
   return *this;
 }
 
+ProcessMonitor::Properties& ProcessMonitor::Properties::CgroupName(
+    std::string name) & {
+  cgroup_name_ = std::move(name);
+  return *this;
+}
+
+ProcessMonitor::Properties& ProcessMonitor::Properties::Limits(
+    std::map<std::string, ResourceLimits> limits) & {
+  limits_ = std::move(limits);
+  return *this;
+}
+
 ProcessMonitor::ProcessMonitor(ProcessMonitor::Properties&& properties,
                                const SharedFD& secure_env_fd)
     : properties_(std::move(properties)),
@@ -400,6 +823,20 @@ Result<void> ProcessMonitor::ResumeMonitoredProcesses() {
   return {};
 }
 
+Result<Json::Value> ProcessMonitor::MonitoredProcessesStatus() {
+  CF_EXPECT(monitor_ != -1, "The monitor process has already exited.");
+  CF_EXPECT(parent_channel_.has_value());
+  CF_EXPECT(
+      SendEmptyRequest(*parent_channel_, ParentToChildMessageType::kStatus));
+
+  ManagedMessage response = CF_EXPECT(parent_channel_->ReceiveMessage());
+  CF_EXPECT(response->command == ChildToParentResponseType::kSuccess,
+            "On kStatus, the child run_cvd returned kFailure.");
+  const char* payload = reinterpret_cast<const char*>(response->payload);
+  return CF_EXPECT(
+      ParseJson(std::string_view(payload, response->payload_size)));
+}
+
 Result<void> ProcessMonitor::StartAndMonitorProcesses() {
   CF_EXPECT(monitor_ == -1, "The monitor process was already started");
   CF_EXPECT(!parent_channel_.has_value(),
@@ -438,6 +875,15 @@ Result<void> ProcessMonitor::MonitorRoutine() {
 #endif
 
   VLOG(0) << "Monitoring subprocesses";
+  wakeup_ = SharedFD::Event(0, EFD_CLOEXEC);
+  CF_EXPECTF(wakeup_->IsOpen(), "eventfd failed: {}", wakeup_->StrError());
+  if (!properties_.cgroup_name_.empty()) {
+    Result<void> cgroups = SetUpCgroups();
+    if (!cgroups.ok()) {
+      LOG(WARNING) << "Monitored subprocesses stay in the monitor's cgroup:\n"
+                   << cgroups.error().FormatForEnv();
+    }
+  }
   CF_EXPECT(StartSubprocesses(properties_));
 
   std::atomic_bool running(true);
@@ -452,13 +898,14 @@ Result<void> ProcessMonitor::MonitorRoutine() {
 
   CF_EXPECT(MonitorLoop(running, properties_mutex_,
                         properties_.restart_subprocesses_,
-                        properties_.entries_));
+                        properties_.entries_, wakeup_));
   if (child_sock_->IsOpen()) {
     child_sock_->Shutdown(SHUT_RDWR);
   }
   CF_EXPECT(parent_comms.get(), "Should have exited if monitoring stopped");
 
   CF_EXPECT(StopSubprocesses(properties_.entries_));
+  RemoveCgroups();
   VLOG(0) << "Done monitoring subprocesses";
   return {};
 }
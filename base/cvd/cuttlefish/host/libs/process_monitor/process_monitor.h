@@ -16,16 +16,24 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <set>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <json/json.h>
+
+#include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/common/libs/transport/channel_sharedfd.h"
 #include "cuttlefish/common/libs/utils/subprocess.h"
 #include "cuttlefish/host/libs/feature/command_source.h"
+#include "cuttlefish/host/libs/process_monitor/cgroup.h"
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
@@ -34,9 +42,26 @@ struct MonitorEntry {
   std::unique_ptr<Command> cmd;
   std::unique_ptr<Subprocess> proc;
   bool is_critical;
+  std::function<Result<void>()> readiness;
+  std::set<std::string> start_after;
+  std::string name;
+
+  // Readable once the process exits.
+  SharedFD pidfd;
+  std::optional<Cgroup> cgroup;
+  SharedFD cgroup_procs;
+  std::chrono::steady_clock::time_point started_at;
+  std::optional<std::chrono::steady_clock::time_point> restart_at;
+  // Exits soon after starting in a row, which delay the next restart.
+  int quick_exits = 0;
+  int restarts = 0;
 
-  MonitorEntry(Command command, bool is_critical)
-      : cmd(new Command(std::move(command))), is_critical(is_critical) {}
+  MonitorEntry(MonitorCommand command)
+      : cmd(new Command(std::move(command.command))),
+        is_critical(command.is_critical),
+        readiness(std::move(command.readiness)),
+        start_after(std::move(command.start_after)),
+        name(std::move(command.name)) {}
 };
 
 // Launches and keeps track of subprocesses, decides response if they
@@ -49,12 +74,19 @@ class ProcessMonitor {
     Properties& AddCommand(MonitorCommand) &;
     Properties& StraceCommands(std::set<std::string>) &;
     Properties& StraceLogDir(std::string) &;
+    // Runs each subprocess in its own leaf of a cgroup with this name, under
+    // the cgroup of the monitor. Empty to leave them in the monitor's.
+    Properties& CgroupName(std::string) &;
+    // Limits by executable name, which need the subprocesses in cgroups.
+    Properties& Limits(std::map<std::string, ResourceLimits>) &;
 
    private:
     bool restart_subprocesses_;
     std::vector<MonitorEntry> entries_;
     std::set<std::string> strace_commands_;
     std::string strace_log_dir_;
+    std::string cgroup_name_;
+    std::map<std::string, ResourceLimits> limits_;
 
     friend class ProcessMonitor;
   };
@@ -63,7 +95,8 @@ class ProcessMonitor {
    */
   ProcessMonitor(Properties&&, const SharedFD& secure_env_fd);
 
-  // Start all processes given by AddCommand.
+  // Start all processes given by AddCommand. Each starts as soon as those it
+  // starts after are ready.
   Result<void> StartAndMonitorProcesses();
   // Stops all monitored subprocesses.
   Result<void> StopMonitoredProcesses();
@@ -71,6 +104,13 @@ class ProcessMonitor {
   Result<void> SuspendMonitoredProcesses();
   // Resume all host subprocesses
   Result<void> ResumeMonitoredProcesses();
+  /*
+   * One object per subprocess with its "name", "pid", whether it is
+   * "running", its "restarts", and its "cpu_usec", "memory_bytes",
+   * "io_read_bytes" and "io_write_bytes". These cover its whole "cgroup" if
+   * it has one, and only the process itself otherwise.
+   */
+  Result<Json::Value> MonitoredProcessesStatus();
 
   /* Reads on this SharedFD will block while subprocesses are running, */
   SharedFD status() { return status_; };
@@ -79,6 +119,9 @@ class ProcessMonitor {
   Result<void> StartSubprocesses(Properties& properties);
   Result<void> MonitorRoutine();
   Result<void> ReadMonitorSocketLoop(std::atomic_bool&);
+  Result<void> SetUpCgroups();
+  void RemoveCgroups();
+  Result<void> SendStatus();
   /*
    * The child run_cvd process suspends the host processes
    */
@@ -95,6 +138,9 @@ class ProcessMonitor {
   std::optional<transport::SharedFdChannel> parent_channel_;
   std::optional<transport::SharedFdChannel> child_channel_;
   SharedFD child_sock_;
+  // Wakes up the monitor loop of the child run_cvd process.
+  SharedFD wakeup_;
+  std::optional<Cgroup> cgroup_;
 
   /*
    * The lock that should be acquired when multiple threads
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/libs/process_monitor/start_dependencies.h"
+
+#include <stddef.h>
+
+#include <deque>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/log/log.h"
+
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+
+Result<std::vector<std::vector<size_t>>> StartDependencies(
+    const std::vector<std::string>& names,
+    const std::vector<std::set<std::string>>& start_after) {
+  CF_EXPECT_EQ(names.size(), start_after.size());
+  std::unordered_map<std::string, std::vector<size_t>> by_name;
+  for (size_t i = 0; i < names.size(); i++) {
+    by_name[names[i]].push_back(i);
+  }
+  std::vector<std::vector<size_t>> dependencies(names.size());
+  std::vector<std::vector<size_t>> dependents(names.size());
+  for (size_t i = 0; i < names.size(); i++) {
+    for (const std::string& name : start_after[i]) {
+      auto it = by_name.find(name);
+      if (it == by_name.end()) {
+        VLOG(0) << name << " is not monitored, " << names[i]
+                << " does not wait for it";
+        continue;
+      }
+      for (size_t dependency : it->second) {
+        dependencies[i].push_back(dependency);
+        dependents[dependency].push_back(i);
+      }
+    }
+  }
+  // Entries waiting on each other would never start.
+  std::vector<size_t> pending(names.size());
+  std::deque<size_t> startable;
+  for (size_t i = 0; i < names.size(); i++) {
+    pending[i] = dependencies[i].size();
+    if (pending[i] == 0) {
+      startable.push_back(i);
+    }
+  }
+  size_t started = 0;
+  for (; !startable.empty(); started++) {
+    for (size_t dependent : dependents[startable.front()]) {
+      if (--pending[dependent] == 0) {
+        startable.push_back(dependent);
+      }
+    }
+    startable.pop_front();
+  }
+  CF_EXPECT_EQ(started, names.size(),
+               "Monitored subprocesses start after each other in a cycle");
+  return dependencies;
+}
+
+}  // namespace cuttlefish
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+
+// For each command, the indices of the commands that must be ready before it
+// starts. Commands start after every command of each name in `start_after`,
+// ignoring the names that no command has. Fails when commands start after each
+// other in a cycle, as none of them would ever start.
+Result<std::vector<std::vector<size_t>>> StartDependencies(
+    const std::vector<std::string>& names,
+    const std::vector<std::set<std::string>>& start_after);
+
+}  // namespace cuttlefish
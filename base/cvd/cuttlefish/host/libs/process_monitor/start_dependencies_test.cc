@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/libs/process_monitor/start_dependencies.h"
+
+#include <stddef.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+using testing::UnorderedElementsAre;
+
+TEST(StartDependenciesTest, NoDependencies) {
+  Result<std::vector<std::vector<size_t>>> dependencies =
+      StartDependencies({"a", "b"}, {{}, {}});
+  ASSERT_THAT(dependencies, IsOk());
+  EXPECT_THAT(*dependencies, ElementsAre(IsEmpty(), IsEmpty()));
+}
+
+TEST(StartDependenciesTest, Chain) {
+  // Registered in the reverse of the order they start in.
+  Result<std::vector<std::vector<size_t>>> dependencies =
+      StartDependencies({"openwrt", "wmediumd", "log_tee"},
+                        {{"wmediumd"}, {"log_tee"}, {}});
+  ASSERT_THAT(dependencies, IsOk());
+  EXPECT_THAT(*dependencies,
+              ElementsAre(ElementsAre(1), ElementsAre(2), IsEmpty()));
+}
+
+TEST(StartDependenciesTest, SeveralDependencies) {
+  Result<std::vector<std::vector<size_t>>> dependencies =
+      StartDependencies({"a", "b", "c", "d"}, {{}, {"a"}, {"a"}, {"b", "c"}});
+  ASSERT_THAT(dependencies, IsOk());
+  EXPECT_THAT(*dependencies,
+              ElementsAre(IsEmpty(), ElementsAre(0), ElementsAre(0),
+                          UnorderedElementsAre(1, 2)));
+}
+
+TEST(StartDependenciesTest, WaitsForEveryCommandOfAnExecutable) {
+  Result<std::vector<std::vector<size_t>>> dependencies =
+      StartDependencies({"log_tee", "crosvm", "log_tee"},
+                        {{}, {"log_tee"}, {}});
+  ASSERT_THAT(dependencies, IsOk());
+  EXPECT_THAT(*dependencies,
+              ElementsAre(IsEmpty(), UnorderedElementsAre(0, 2), IsEmpty()));
+}
+
+TEST(StartDependenciesTest, IgnoresUnmonitoredExecutables) {
+  Result<std::vector<std::vector<size_t>>> dependencies =
+      StartDependencies({"openwrt"}, {{"wmediumd"}});
+  ASSERT_THAT(dependencies, IsOk());
+  EXPECT_THAT(*dependencies, ElementsAre(IsEmpty()));
+}
+
+TEST(StartDependenciesTest, Cycle) {
+  EXPECT_THAT(StartDependencies({"a", "b", "c"}, {{"c"}, {"a"}, {"b"}}),
+              IsError());
+}
+
+TEST(StartDependenciesTest, CycleAfterIndependentCommands) {
+  EXPECT_THAT(
+      StartDependencies({"a", "b", "c", "d"}, {{}, {"a", "c"}, {"b"}, {"a"}}),
+      IsError());
+}
+
+TEST(StartDependenciesTest, StartsAfterItself) {
+  EXPECT_THAT(StartDependencies({"a"}, {{"a"}}), IsError());
+}
+
+TEST(StartDependenciesTest, MismatchedSizes) {
+  EXPECT_THAT(StartDependencies({"a", "b"}, {{}}), IsError());
+}
+
+}  // namespace cuttlefish
@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/libs/screen_connector/alpha_blend.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include <algorithm>
+#include <vector>
+
+#include <drm/drm_fourcc.h>
+#include "libyuv.h"
+
+#include "cuttlefish/host/libs/screen_connector/video_frame_buffer.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr int kAlphaIdx = 3;
+constexpr int kBytesPerPixel = 4;
+
+// Rows blended before each conversion. Even, so every step but the last covers
+// whole chroma rows, and few enough for the blended rows of a 4K frame to stay
+// in the L2 cache until they are converted.
+constexpr int kStripRows = 8;
+
+using AlphaBlendKernel = void (*)(const uint8_t*, const uint8_t*, uint8_t*,
+                                  size_t);
+
+// x / 255, rounded, for x <= 255 * 255. The vector kernels compute the same.
+inline uint8_t Div255(uint32_t x) {
+  x += 128;
+  return (x + (x >> 8)) >> 8;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// Blends 16 bit channels: (src * alpha + below * (255 - alpha)) / 255.
+__attribute__((target("sse4.1"))) inline __m128i Blend16Sse41(
+    __m128i src, __m128i below, __m128i alpha) {
+  const __m128i alpha_inv = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+  __m128i x = _mm_add_epi16(_mm_mullo_epi16(src, alpha),
+                            _mm_mullo_epi16(below, alpha_inv));
+  x = _mm_add_epi16(x, _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+__attribute__((target("sse4.1"))) void AlphaBlendPixelsSse41(
+    const uint8_t* base, const uint8_t* overlay, uint8_t* dst,
+    size_t num_pixels) {
+  // Copies every pixel's alpha to its 4 bytes.
+  const __m128i alpha_shuffle = _mm_setr_epi8(3, 3, 3, 3, 7, 7, 7, 7, 11, 11,
+                                              11, 11, 15, 15, 15, 15);
+  const __m128i opaque = _mm_set1_epi32(static_cast<int>(0xff000000));
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 4 <= num_pixels; i += 4) {
+    const size_t offset = i * kBytesPerPixel;
+    __m128i src = _mm_loadu_si128((const __m128i*)(overlay + offset));
+    __m128i below = _mm_loadu_si128((const __m128i*)(base + offset));
+    __m128i alpha = _mm_shuffle_epi8(src, alpha_shuffle);
+    __m128i lo = Blend16Sse41(_mm_unpacklo_epi8(src, zero),
+                              _mm_unpacklo_epi8(below, zero),
+                              _mm_unpacklo_epi8(alpha, zero));
+    __m128i hi = Blend16Sse41(_mm_unpackhi_epi8(src, zero),
+                              _mm_unpackhi_epi8(below, zero),
+                              _mm_unpackhi_epi8(alpha, zero));
+    __m128i out = _mm_or_si128(_mm_packus_epi16(lo, hi), opaque);
+    _mm_storeu_si128((__m128i*)(dst + offset), out);
+  }
+  const size_t offset = i * kBytesPerPixel;
+  AlphaBlendPixelsScalar(base + offset, overlay + offset, dst + offset,
+                         num_pixels - i);
+}
+
+__attribute__((target("avx2"))) inline __m256i Blend16Avx2(__m256i src,
+                                                          __m256i below,
+                                                          __m256i alpha) {
+  const __m256i alpha_inv = _mm256_sub_epi16(_mm256_set1_epi16(255), alpha);
+  __m256i x = _mm256_add_epi16(_mm256_mullo_epi16(src, alpha),
+                               _mm256_mullo_epi16(below, alpha_inv));
+  x = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+  return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+// Same as the SSE4.1 kernel. The unpack, shuffle and pack instructions work
+// within 128 bit lanes, which never split a pixel, so the order is kept.
+__attribute__((target("avx2"))) void AlphaBlendPixelsAvx2(
+    const uint8_t* base, const uint8_t* overlay, uint8_t* dst,
+    size_t num_pixels) {
+  const __m256i alpha_shuffle = _mm256_setr_epi8(
+      3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15, 3, 3, 3, 3, 7, 7,
+      7, 7, 11, 11, 11, 11, 15, 15, 15, 15);
+  const __m256i opaque = _mm256_set1_epi32(static_cast<int>(0xff000000));
+  const __m256i zero = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 8 <= num_pixels; i += 8) {
+    const size_t offset = i * kBytesPerPixel;
+    __m256i src = _mm256_loadu_si256((const __m256i*)(overlay + offset));
+    __m256i below = _mm256_loadu_si256((const __m256i*)(base + offset));
+    __m256i alpha = _mm256_shuffle_epi8(src, alpha_shuffle);
+    __m256i lo = Blend16Avx2(_mm256_unpacklo_epi8(src, zero),
+                             _mm256_unpacklo_epi8(below, zero),
+                             _mm256_unpacklo_epi8(alpha, zero));
+    __m256i hi = Blend16Avx2(_mm256_unpackhi_epi8(src, zero),
+                             _mm256_unpackhi_epi8(below, zero),
+                             _mm256_unpackhi_epi8(alpha, zero));
+    __m256i out = _mm256_or_si256(_mm256_packus_epi16(lo, hi), opaque);
+    _mm256_storeu_si256((__m256i*)(dst + offset), out);
+  }
+  const size_t offset = i * kBytesPerPixel;
+  AlphaBlendPixelsSse41(base + offset, overlay + offset, dst + offset,
+                        num_pixels - i);
+}
+
+#elif defined(__aarch64__)
+
+// Blends 16 channel values, rounding like Div255: vrshrq_n_u16 adds
+// (x + 128) >> 8 and vraddhn_u16 rounds the sum's high byte.
+inline uint8x16_t BlendNeon(uint8x16_t src, uint8x16_t below,
+                            uint8x16_t alpha, uint8x16_t alpha_inv) {
+  uint16x8_t lo = vmull_u8(vget_low_u8(src), vget_low_u8(alpha));
+  lo = vmlal_u8(lo, vget_low_u8(below), vget_low_u8(alpha_inv));
+  uint16x8_t hi = vmull_high_u8(src, alpha);
+  hi = vmlal_high_u8(hi, below, alpha_inv);
+  return vcombine_u8(vraddhn_u16(lo, vrshrq_n_u16(lo, 8)),
+                     vraddhn_u16(hi, vrshrq_n_u16(hi, 8)));
+}
+
+void AlphaBlendPixelsNeon(const uint8_t* base, const uint8_t* overlay,
+                          uint8_t* dst, size_t num_pixels) {
+  size_t i = 0;
+  for (; i + 16 <= num_pixels; i += 16) {
+    const size_t offset = i * kBytesPerPixel;
+    // Loads 16 pixels split by channel.
+    uint8x16x4_t src = vld4q_u8(overlay + offset);
+    uint8x16x4_t below = vld4q_u8(base + offset);
+    uint8x16_t alpha = src.val[kAlphaIdx];
+    uint8x16_t alpha_inv = vmvnq_u8(alpha);
+    uint8x16x4_t out;
+    for (int c = 0; c < kAlphaIdx; c++) {
+      out.val[c] = BlendNeon(src.val[c], below.val[c], alpha, alpha_inv);
+    }
+    out.val[kAlphaIdx] = vdupq_n_u8(255);
+    vst4q_u8(dst + offset, out);
+  }
+  const size_t offset = i * kBytesPerPixel;
+  AlphaBlendPixelsScalar(base + offset, overlay + offset, dst + offset,
+                         num_pixels - i);
+}
+
+#endif
+
+AlphaBlendKernel SelectAlphaBlendKernel() {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return AlphaBlendPixelsAvx2;
+  }
+  if (__builtin_cpu_supports("sse4.1")) {
+    return AlphaBlendPixelsSse41;
+  }
+#elif defined(__aarch64__)
+  return AlphaBlendPixelsNeon;
+#endif
+  return AlphaBlendPixelsScalar;
+}
+
+}  // namespace
+
+void AlphaBlendPixelsScalar(const uint8_t* base, const uint8_t* overlay,
+                            uint8_t* dst, size_t num_pixels) {
+  for (size_t i = 0; i < num_pixels; i++) {
+    const uint32_t alpha = overlay[kAlphaIdx];
+    const uint32_t alpha_inv = 255 - alpha;
+    for (int c = 0; c < kAlphaIdx; c++) {
+      dst[c] = Div255(overlay[c] * alpha + base[c] * alpha_inv);
+    }
+    dst[kAlphaIdx] = 255;
+    base += kBytesPerPixel;
+    overlay += kBytesPerPixel;
+    dst += kBytesPerPixel;
+  }
+}
+
+void AlphaBlendPixels(const uint8_t* base, const uint8_t* overlay,
+                      uint8_t* dst, size_t num_pixels) {
+  static const AlphaBlendKernel kernel = SelectAlphaBlendKernel();
+  kernel(base, overlay, dst, num_pixels);
+}
+
+bool BlendAndConvertToI420(const uint8_t* base,
+                           const std::vector<const uint8_t*>& overlays,
+                           uint32_t fourcc_format, int width, int height,
+                           VideoFrameBuffer& buffer) {
+  decltype(&libyuv::ARGBToI420) to_i420 = nullptr;
+  if (fourcc_format == DRM_FORMAT_ARGB8888 ||
+      fourcc_format == DRM_FORMAT_XRGB8888) {
+    to_i420 = libyuv::ARGBToI420;
+  } else if (fourcc_format == DRM_FORMAT_ABGR8888 ||
+             fourcc_format == DRM_FORMAT_XBGR8888) {
+    to_i420 = libyuv::ABGRToI420;
+  } else {
+    return false;
+  }
+
+  const size_t row_bytes = static_cast<size_t>(width) * kBytesPerPixel;
+  if (overlays.empty()) {
+    to_i420(base, row_bytes, buffer.DataY(), buffer.StrideY(), buffer.DataU(),
+            buffer.StrideU(), buffer.DataV(), buffer.StrideV(), width, height);
+    return true;
+  }
+
+  std::vector<uint8_t> strip(row_bytes * kStripRows);
+  for (int y = 0; y < height; y += kStripRows) {
+    const int rows = std::min(kStripRows, height - y);
+    for (int row = 0; row < rows; row++) {
+      const size_t offset = (y + row) * row_bytes;
+      uint8_t* blended = strip.data() + row * row_bytes;
+      const uint8_t* below = base + offset;
+      for (const uint8_t* overlay : overlays) {
+        AlphaBlendPixels(below, overlay + offset, blended, width);
+        below = blended;
+      }
+    }
+    to_i420(strip.data(), row_bytes, buffer.DataY() + y * buffer.StrideY(),
+            buffer.StrideY(), buffer.DataU() + (y / 2) * buffer.StrideU(),
+            buffer.StrideU(), buffer.DataV() + (y / 2) * buffer.StrideV(),
+            buffer.StrideV(), width, rows);
+  }
+  return true;
+}
+
+}  // namespace cuttlefish
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "cuttlefish/host/libs/screen_connector/video_frame_buffer.h"
+
+namespace cuttlefish {
+
+// Blends `overlay` over `base` into `dst` using the overlay's alpha. Pixels
+// are 4 bytes with the alpha last, as in DRM's [AX]RGB8888 and [AX]BGR8888
+// formats, and the result is opaque. `dst` may be `base`.
+//
+// Picks the widest vector kernel the CPU supports at runtime.
+void AlphaBlendPixels(const uint8_t* base, const uint8_t* overlay,
+                      uint8_t* dst, size_t num_pixels);
+
+// The portable kernel, producing the same values as the vector ones.
+void AlphaBlendPixelsScalar(const uint8_t* base, const uint8_t* overlay,
+                            uint8_t* dst, size_t num_pixels);
+
+// Blends the overlays, bottom one first, over `base` and converts the result
+// to I420 in `buffer`. All frames have `width` * 4 bytes per row and the given
+// DRM format. The blend goes through a few rows at a time so every pixel is
+// only read from memory once. Returns false if the format isn't supported.
+bool BlendAndConvertToI420(const uint8_t* base,
+                           const std::vector<const uint8_t*>& overlays,
+                           uint32_t fourcc_format, int width, int height,
+                           VideoFrameBuffer& buffer);
+
+}  // namespace cuttlefish
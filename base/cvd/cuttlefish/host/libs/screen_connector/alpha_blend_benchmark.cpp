@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the overlay blending kernels, and blending all overlays before
+// converting the frame to I420 against the fused path, at display sizes from
+// 720p to 4K with 1 to 4 overlays.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <drm/drm_fourcc.h>
+#include "benchmark/benchmark.h"
+#include "libyuv.h"
+
+#include "cuttlefish/host/libs/screen_connector/alpha_blend.h"
+#include "cuttlefish/host/libs/screen_connector/video_frame_buffer.h"
+
+namespace cuttlefish {
+namespace {
+
+class I420Buffer : public VideoFrameBuffer {
+ public:
+  I420Buffer(int width, int height)
+      : width_(width),
+        height_(height),
+        y_(static_cast<size_t>(width) * height),
+        u_(static_cast<size_t>(StrideU()) * ((height + 1) / 2)),
+        v_(u_.size()) {}
+
+  int width() const override { return width_; }
+  int height() const override { return height_; }
+  int StrideY() const override { return width_; }
+  int StrideU() const override { return (width_ + 1) / 2; }
+  int StrideV() const override { return (width_ + 1) / 2; }
+  uint8_t* DataY() override { return y_.data(); }
+  uint8_t* DataU() override { return u_.data(); }
+  uint8_t* DataV() override { return v_.data(); }
+  size_t DataSizeY() const override { return y_.size(); }
+  size_t DataSizeU() const override { return u_.size(); }
+  size_t DataSizeV() const override { return v_.size(); }
+
+ private:
+  int width_;
+  int height_;
+  std::vector<uint8_t> y_;
+  std::vector<uint8_t> u_;
+  std::vector<uint8_t> v_;
+};
+
+std::vector<uint8_t> RandomFrame(int width, int height, std::mt19937& rng) {
+  std::vector<uint8_t> frame(static_cast<size_t>(width) * height * 4);
+  std::uniform_int_distribution<int> byte(0, 255);
+  for (uint8_t& value : frame) {
+    value = byte(rng);
+  }
+  return frame;
+}
+
+void Resolutions(benchmark::internal::Benchmark* benchmark) {
+  for (auto [width, height] : {std::pair{1280, 720}, std::pair{1920, 1080},
+                               std::pair{2560, 1440}, std::pair{3840, 2160}}) {
+    benchmark->Args({width, height});
+  }
+}
+
+void ResolutionsAndOverlays(benchmark::internal::Benchmark* benchmark) {
+  for (auto [width, height] : {std::pair{1280, 720}, std::pair{1920, 1080},
+                               std::pair{2560, 1440}, std::pair{3840, 2160}}) {
+    for (int overlays = 1; overlays <= 4; overlays++) {
+      benchmark->Args({width, height, overlays});
+    }
+  }
+}
+
+template <void (*Kernel)(const uint8_t*, const uint8_t*, uint8_t*, size_t)>
+void BM_AlphaBlend(benchmark::State& state) {
+  const int width = state.range(0);
+  const int height = state.range(1);
+  std::mt19937 rng(1);
+  std::vector<uint8_t> base = RandomFrame(width, height, rng);
+  std::vector<uint8_t> overlay = RandomFrame(width, height, rng);
+  std::vector<uint8_t> dst(base.size());
+  for (auto _ : state) {
+    Kernel(base.data(), overlay.data(), dst.data(), width * height);
+    benchmark::DoNotOptimize(dst.data());
+  }
+  state.SetBytesProcessed(state.iterations() * base.size());
+}
+BENCHMARK(BM_AlphaBlend<AlphaBlendPixelsScalar>)->Apply(Resolutions);
+BENCHMARK(BM_AlphaBlend<AlphaBlendPixels>)->Apply(Resolutions);
+
+struct ComposeInputs {
+  ComposeInputs(int width, int height, int num_overlays)
+      : buffer(width, height) {
+    std::mt19937 rng(1);
+    base = RandomFrame(width, height, rng);
+    for (int i = 0; i < num_overlays; i++) {
+      overlays.push_back(RandomFrame(width, height, rng));
+      overlay_pixels.push_back(overlays.back().data());
+    }
+  }
+
+  std::vector<uint8_t> base;
+  std::vector<std::vector<uint8_t>> overlays;
+  std::vector<const uint8_t*> overlay_pixels;
+  I420Buffer buffer;
+};
+
+// Blends every overlay over the whole frame in a work buffer, then converts.
+void BM_BlendThenConvert(benchmark::State& state) {
+  const int width = state.range(0);
+  const int height = state.range(1);
+  ComposeInputs inputs(width, height, state.range(2));
+  std::vector<uint8_t> work(inputs.base.size());
+  for (auto _ : state) {
+    const uint8_t* below = inputs.base.data();
+    for (const uint8_t* overlay : inputs.overlay_pixels) {
+      AlphaBlendPixels(below, overlay, work.data(), width * height);
+      below = work.data();
+    }
+    libyuv::ARGBToI420(work.data(), width * 4, inputs.buffer.DataY(),
+                       inputs.buffer.StrideY(), inputs.buffer.DataU(),
+                       inputs.buffer.StrideU(), inputs.buffer.DataV(),
+                       inputs.buffer.StrideV(), width, height);
+    benchmark::DoNotOptimize(inputs.buffer.DataY());
+  }
+}
+BENCHMARK(BM_BlendThenConvert)->Apply(ResolutionsAndOverlays);
+
+void BM_BlendAndConvertToI420(benchmark::State& state) {
+  const int width = state.range(0);
+  const int height = state.range(1);
+  ComposeInputs inputs(width, height, state.range(2));
+  for (auto _ : state) {
+    BlendAndConvertToI420(inputs.base.data(), inputs.overlay_pixels,
+                          DRM_FORMAT_ARGB8888, width, height, inputs.buffer);
+    benchmark::DoNotOptimize(inputs.buffer.DataY());
+  }
+}
+BENCHMARK(BM_BlendAndConvertToI420)->Apply(ResolutionsAndOverlays);
+
+}  // namespace
+}  // namespace cuttlefish
@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/libs/screen_connector/alpha_blend.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr size_t kBytesPerPixel = 4;
+// More than a few vectors of the widest kernel, 16 pixels, and not a multiple
+// of any vector width.
+constexpr size_t kMaxPixels = 67;
+
+std::vector<uint8_t> RandomPixels(size_t num_pixels, std::mt19937& rng) {
+  std::vector<uint8_t> pixels(num_pixels * kBytesPerPixel);
+  for (uint8_t& byte : pixels) {
+    byte = rng();
+  }
+  return pixels;
+}
+
+void SetAlpha(std::vector<uint8_t>& pixels, uint8_t alpha) {
+  for (size_t i = 3; i < pixels.size(); i += kBytesPerPixel) {
+    pixels[i] = alpha;
+  }
+}
+
+// The exact blend, rounded to the nearest value.
+std::vector<uint8_t> Reference(const std::vector<uint8_t>& base,
+                               const std::vector<uint8_t>& overlay) {
+  std::vector<uint8_t> dst(base.size());
+  for (size_t p = 0; p < base.size(); p += kBytesPerPixel) {
+    const double alpha = overlay[p + 3];
+    for (size_t c = 0; c < 3; c++) {
+      dst[p + c] = std::lround(
+          (overlay[p + c] * alpha + base[p + c] * (255 - alpha)) / 255);
+    }
+    dst[p + 3] = 255;
+  }
+  return dst;
+}
+
+std::vector<uint8_t> Blend(const std::vector<uint8_t>& base,
+                           const std::vector<uint8_t>& overlay) {
+  std::vector<uint8_t> dst(base.size());
+  AlphaBlendPixels(base.data(), overlay.data(), dst.data(),
+                   base.size() / kBytesPerPixel);
+  return dst;
+}
+
+TEST(AlphaBlendTest, TransparentOverlayKeepsTheBase) {
+  std::mt19937 rng(1);
+  for (size_t num_pixels = 0; num_pixels <= kMaxPixels; num_pixels++) {
+    std::vector<uint8_t> base = RandomPixels(num_pixels, rng);
+    std::vector<uint8_t> overlay = RandomPixels(num_pixels, rng);
+    SetAlpha(overlay, 0);
+
+    std::vector<uint8_t> expected = base;
+    SetAlpha(expected, 255);
+    EXPECT_EQ(Blend(base, overlay), expected) << num_pixels << " pixels";
+  }
+}
+
+TEST(AlphaBlendTest, OpaqueOverlayReplacesTheBase) {
+  std::mt19937 rng(2);
+  for (size_t num_pixels = 0; num_pixels <= kMaxPixels; num_pixels++) {
+    std::vector<uint8_t> base = RandomPixels(num_pixels, rng);
+    std::vector<uint8_t> overlay = RandomPixels(num_pixels, rng);
+    SetAlpha(overlay, 255);
+
+    EXPECT_EQ(Blend(base, overlay), overlay) << num_pixels << " pixels";
+  }
+}
+
+TEST(AlphaBlendTest, PartialAlphaMatchesTheExactBlend) {
+  std::mt19937 rng(3);
+  for (size_t num_pixels = 0; num_pixels <= kMaxPixels; num_pixels++) {
+    const std::vector<uint8_t> base = RandomPixels(num_pixels, rng);
+    const std::vector<uint8_t> overlay = RandomPixels(num_pixels, rng);
+
+    const std::vector<uint8_t> expected = Reference(base, overlay);
+    EXPECT_EQ(Blend(base, overlay), expected) << num_pixels << " pixels";
+    std::vector<uint8_t> scalar(base.size());
+    AlphaBlendPixelsScalar(base.data(), overlay.data(), scalar.data(),
+                           num_pixels);
+    EXPECT_EQ(scalar, expected) << num_pixels << " pixels";
+  }
+}
+
+TEST(AlphaBlendTest, EveryAlphaAndChannelValue) {
+  // All the combinations of overlay alpha, overlay value and base value that
+  // the rounding depends on, 16 values of each.
+  std::vector<uint8_t> base;
+  std::vector<uint8_t> overlay;
+  for (int alpha = 0; alpha < 256; alpha += 17) {
+    for (int src = 0; src < 256; src += 17) {
+      for (int below = 0; below < 256; below += 17) {
+        base.insert(base.end(), {static_cast<uint8_t>(below), 0, 255, 0});
+        overlay.insert(overlay.end(),
+                       {static_cast<uint8_t>(src), 255, 0,
+                        static_cast<uint8_t>(alpha)});
+      }
+    }
+  }
+
+  EXPECT_EQ(Blend(base, overlay), Reference(base, overlay));
+}
+
+TEST(AlphaBlendTest, BlendsInPlaceAtUnalignedAddresses) {
+  std::mt19937 rng(4);
+  const std::vector<uint8_t> base = RandomPixels(kMaxPixels, rng);
+  const std::vector<uint8_t> overlay = RandomPixels(kMaxPixels, rng);
+  // One byte in, so that no load or store is aligned.
+  std::vector<uint8_t> shifted_base(1);
+  shifted_base.insert(shifted_base.end(), base.begin(), base.end());
+  std::vector<uint8_t> shifted_overlay(1);
+  shifted_overlay.insert(shifted_overlay.end(), overlay.begin(), overlay.end());
+
+  AlphaBlendPixels(shifted_base.data() + 1, shifted_overlay.data() + 1,
+                   shifted_base.data() + 1, kMaxPixels);
+
+  EXPECT_EQ(std::vector<uint8_t>(shifted_base.begin() + 1, shifted_base.end()),
+            Reference(base, overlay));
+}
+
+}  // namespace
+}  // namespace cuttlefish
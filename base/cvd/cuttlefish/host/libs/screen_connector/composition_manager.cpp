@@ -14,61 +14,37 @@
  * limitations under the License.
  */
 
-/*
- * TODO(b/384939093): PLEASE NOTE: The implemented here is in a WIP status.
- *
- * Currently the Composition algorithm implemented in
- * this module has a known limitation.  It uses IPC buffers in such a way where
- * it is currently possible for frames to be simultaneously
- * read and written from the same memory lcoation.  It's therefore possible to
- * have some display artifacts as partial frames are read.  To remedy there is
- * follow-up work (documented in b/384939093) planned.
- */
-
 #include "cuttlefish/host/libs/screen_connector/composition_manager.h"
 
 #include <stdint.h>
 
 #include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include "absl/strings/ascii.h"
 #include "absl/strings/str_split.h"
 #include "absl/log/log.h"
 #include "absl/strings/numbers.h"
-#include "libyuv.h"
 
-#include <drm/drm_fourcc.h>
 #include "cuttlefish/host/libs/config/cuttlefish_config.h"
+#include "cuttlefish/host/libs/screen_connector/alpha_blend.h"
+#include "cuttlefish/host/libs/screen_connector/frame_damage.h"
 #include "cuttlefish/host/libs/screen_connector/ring_buffer_manager.h"
 #include "cuttlefish/host/libs/wayland/wayland_server_callbacks.h"
 
-static const int kRedIdx = 0;
-static const int kGreenIdx = 1;
-static const int kBlueIdx = 2;
-static const int kAlphaIdx = 3;
+// Overlays are read in place from other processes' ring buffers. A blend that
+// read a frame while it was being overwritten is redone this many times at
+// most before the torn result is used anyway.
+static const int kMaxBlendAttempts = 3;
 
 namespace cuttlefish {
 
-void alpha_blend_layer(uint8_t* frame_pixels, uint32_t h, uint32_t w,
-                       uint8_t* overlay) {
-  uint8_t* dst = frame_pixels;
-  uint8_t* src = overlay;
-  int max = w * h;
-  for (int idx = 0; idx < max; idx++) {
-    float a = ((float)src[kAlphaIdx]) / 255.0f;
-    float a_inv = 1.0f - a;
-    dst[kRedIdx] = (uint8_t)((src[kRedIdx] * a) + (dst[kRedIdx] * a_inv));
-    dst[kBlueIdx] = (uint8_t)((src[kBlueIdx] * a) + (dst[kBlueIdx] * a_inv));
-    dst[kGreenIdx] = (uint8_t)((src[kGreenIdx] * a) + (dst[kGreenIdx] * a_inv));
-    dst[kAlphaIdx] = 255;
-    dst += 4;
-    src += 4;
-  }
-}
-
 std::map<int, std::vector<CompositionManager::DisplayOverlay>>
 CompositionManager::ParseOverlays(std::vector<std::string> overlay_items) {
   std::map<int, std::vector<DisplayOverlay>> overlays;
@@ -169,10 +145,14 @@ Result<std::unique_ptr<CompositionManager>> CompositionManager::Create() {
 
   CF_EXPECT(!group_uuid.empty(), "Invalid group UUID");
 
-  std::unique_ptr<CompositionManager> mgr(
-      new CompositionManager(instance_index + 1, group_uuid, domap));
+  return Create(instance_index, std::move(group_uuid), std::move(domap));
+}
 
-  return mgr;
+std::unique_ptr<CompositionManager> CompositionManager::Create(
+    int vm_index, std::string group_uuid,
+    std::map<int, std::vector<DisplayOverlay>> overlays) {
+  return std::unique_ptr<CompositionManager>(
+      new CompositionManager(vm_index + 1, group_uuid, overlays));
 }
 
 // Whenever a display is created, a shared memory IPC ringbuffer
@@ -188,104 +168,162 @@ void CompositionManager::OnDisplayCreated(const DisplayCreatedEvent& e) {
 }
 
 // Called every frame.
-void CompositionManager::OnFrame(uint32_t display_number, uint32_t frame_width,
-                                 uint32_t frame_height,
-                                 uint32_t frame_fourcc_format,
-                                 uint32_t frame_stride_bytes,
-                                 uint8_t* frame_pixels) {
+FrameDamage CompositionManager::OnFrame(uint32_t display_number,
+                                        uint32_t frame_width,
+                                        uint32_t frame_height,
+                                        uint32_t frame_fourcc_format,
+                                        uint32_t frame_stride_bytes,
+                                        uint8_t* frame_pixels,
+                                        const FrameDamage& damage) {
   // First step is to push the local display pixels to the shared memory region
   // ringbuffer
-  uint8_t* shmem_local_display = display_ring_buffer_manager_.WriteFrame(
-      cluster_index_, display_number, frame_pixels,
-      frame_width * frame_height * 4);
+  std::optional<DisplayRingBufferFrame> local_frame =
+      display_ring_buffer_manager_.WriteFrame(cluster_index_, display_number,
+                                              frame_pixels,
+                                              frame_width * frame_height * 4);
 
   // Next some upkeep, the format of the frame is needed for blending
   // computations.
-  LastFrameInfo last_frame_info = LastFrameInfo(
-      display_number, frame_width, frame_height, frame_fourcc_format,
-      frame_stride_bytes, (uint8_t*)shmem_local_display);
-
-  last_frame_info_map_[display_number] = last_frame_info;
+  {
+    std::lock_guard lock(last_frame_info_mutex_);
+    last_frame_info_map_[display_number] =
+        LastFrameInfo(display_number, frame_width, frame_height,
+                      frame_fourcc_format, frame_stride_bytes);
+  }
 
   // Lastly, the pixels of the current frame are modified by blending any
-  // configured layers over the top of the current 'base layer'
-  AlphaBlendLayers(frame_pixels, display_number, frame_width, frame_height);
+  // configured layers over the top of the current 'base layer'. Only this
+  // thread writes the local ring buffer, so the unblended copy in there stays
+  // put and torn blends can be redone from it.
+  const uint8_t* base_pixels =
+      local_frame ? local_frame->Pixels() : frame_pixels;
+  for (int attempt = 1; attempt <= kMaxBlendAttempts; attempt++) {
+    BlendResult result =
+        AlphaBlendLayers(base_pixels, frame_pixels, frame_width, frame_height,
+                         ReadOverlays(display_number, frame_width,
+                                      frame_height));
+    if (result != BlendResult::kTorn || !local_frame) {
+      break;
+    }
+  }
+
+  // The guest only reports its own changes, the overlays and the pixels they
+  // were blended over last time may differ anywhere.
+  if (cfg_overlays_.count(display_number) > 0) {
+    return FrameDamage();
+  }
+  return damage;
 }
 
 // This is called to 'Force a Display Composition Refresh' on a display.  It is
 // triggered by a thread to force displays to constantly update so that when
 // layers are updated, the user will see the blended result.
-void CompositionManager::ComposeFrame(
+bool CompositionManager::ComposeFrame(
     int display_index, std::shared_ptr<VideoFrameBuffer> buffer) {
-  if (!last_frame_info_map_.count(display_index)) {
-    return;
+  LastFrameInfo last_frame_info;
+  {
+    std::lock_guard lock(last_frame_info_mutex_);
+    auto it = last_frame_info_map_.find(display_index);
+    if (it == last_frame_info_map_.end()) {
+      return false;
+    }
+    last_frame_info = it->second;
   }
-  LastFrameInfo& last_frame_info = last_frame_info_map_[display_index];
 
-  ComposeFrame(display_index, last_frame_info.frame_width_,
-               last_frame_info.frame_height_,
-               last_frame_info.frame_fourcc_format_,
-               last_frame_info.frame_stride_bytes_, buffer);
+  return ComposeFrame(display_index, last_frame_info.frame_width_,
+                      last_frame_info.frame_height_,
+                      last_frame_info.frame_fourcc_format_, buffer);
 }
 
-uint8_t* CompositionManager::AlphaBlendLayers(uint8_t* frame_pixels,
-                                              int display_number,
-                                              int frame_width,
-                                              int frame_height) {
-  if (cfg_overlays_.count(display_number) == 0) {
-    return frame_pixels;
+std::vector<std::optional<DisplayRingBufferFrame>>
+CompositionManager::ReadOverlays(int display_number, int frame_width,
+                                 int frame_height) {
+  std::vector<std::optional<DisplayRingBufferFrame>> overlays;
+  auto it = cfg_overlays_.find(display_number);
+  if (it == cfg_overlays_.end()) {
+    return overlays;
   }
+  for (const DisplayOverlay& layer : it->second) {
+    overlays.push_back(display_ring_buffer_manager_.ReadFrame(
+        layer.src_vm_index, layer.src_display_index, frame_width,
+        frame_height));
+  }
+  return overlays;
+}
 
-  std::vector<DisplayOverlay>& cfg_overlays = cfg_overlays_[display_number];
-  int num_overlays = cfg_overlays.size();
-
-  std::vector<void*> overlays;
-  overlays.resize(num_overlays, nullptr);
-
-  for (int i = 0; i < num_overlays; i++) {
-    if (overlays[i] != nullptr) {
+// Blends the overlays over base_pixels into frame_pixels, which may be the
+// same memory. The overlay pixels are used in place in the shared memory.
+CompositionManager::BlendResult CompositionManager::AlphaBlendLayers(
+    const uint8_t* base_pixels, uint8_t* frame_pixels, int frame_width,
+    int frame_height,
+    const std::vector<std::optional<DisplayRingBufferFrame>>& overlays) {
+  BlendResult result = BlendResult::kNothingBlended;
+  const uint8_t* below = base_pixels;
+  for (const std::optional<DisplayRingBufferFrame>& overlay : overlays) {
+    if (!overlay) {
       continue;
     }
-
-    DisplayOverlay& layer = cfg_overlays[i];
-
-    overlays[i] = display_ring_buffer_manager_.ReadFrame(
-        layer.src_vm_index, layer.src_display_index, frame_width, frame_height);
-  }
-
-  for (auto i : overlays) {
-    if (i) {
-      alpha_blend_layer(frame_pixels, frame_height, frame_width, (uint8_t*)i);
+    AlphaBlendPixels(below, overlay->Pixels(), frame_pixels,
+                     frame_width * frame_height);
+    if (!overlay->IsIntact()) {
+      return BlendResult::kTorn;
     }
+    below = frame_pixels;
+    result = BlendResult::kBlended;
   }
-  return (uint8_t*)frame_pixels;
+  return result;
 }
 
-void CompositionManager::ComposeFrame(
+bool CompositionManager::ComposeFrame(
     int display, int width, int height, uint32_t frame_fourcc_format,
-    uint32_t frame_stride_bytes, std::shared_ptr<VideoFrameBuffer> buffer) {
-  uint8_t* shmem_local_display = display_ring_buffer_manager_.ReadFrame(
-      cluster_index_, display, width, height);
-
-  if (frame_work_buffer_.find(display) == frame_work_buffer_.end()) {
-    frame_work_buffer_[display] = std::vector<uint8_t>(width * height * 4);
+    std::shared_ptr<VideoFrameBuffer> buffer) {
+  // Without overlays the local frame is the display's frame.
+  if (cfg_overlays_.count(display) == 0) {
+    return false;
   }
-  uint8_t* tmp_buffer = frame_work_buffer_[display].data();
-  memcpy(tmp_buffer, shmem_local_display, width * height * 4);
-
-  AlphaBlendLayers(tmp_buffer, display, width, height);
-
-  if (frame_fourcc_format == DRM_FORMAT_ARGB8888 ||
-      frame_fourcc_format == DRM_FORMAT_XRGB8888) {
-    libyuv::ARGBToI420(tmp_buffer, frame_stride_bytes, buffer->DataY(),
-                       buffer->StrideY(), buffer->DataU(), buffer->StrideU(),
-                       buffer->DataV(), buffer->StrideV(), width, height);
-  } else if (frame_fourcc_format == DRM_FORMAT_ABGR8888 ||
-             frame_fourcc_format == DRM_FORMAT_XBGR8888) {
-    libyuv::ABGRToI420(tmp_buffer, frame_stride_bytes, buffer->DataY(),
-                       buffer->StrideY(), buffer->DataU(), buffer->StrideU(),
-                       buffer->DataV(), buffer->StrideV(), width, height);
+  for (int attempt = 1; attempt <= kMaxBlendAttempts; attempt++) {
+    std::optional<DisplayRingBufferFrame> base =
+        display_ring_buffer_manager_.ReadFrame(cluster_index_, display, width,
+                                               height);
+    if (!base) {
+      return false;
+    }
+    std::vector<std::optional<DisplayRingBufferFrame>> overlays =
+        ReadOverlays(display, width, height);
+
+    std::vector<uint64_t> sequences = {base->Sequence()};
+    for (const std::optional<DisplayRingBufferFrame>& overlay : overlays) {
+      sequences.push_back(overlay ? overlay->Sequence() : 0);
+    }
+    ComposedFrameInfo& composed = composed_frame_info_map_[display];
+    if (composed.buffer.lock() == buffer && composed.sequences == sequences) {
+      // Nothing changed since this buffer was composed.
+      return true;
+    }
+
+    // The frames are read in place, and blended a few rows at a time right
+    // before those rows are converted.
+    std::vector<const uint8_t*> overlay_pixels;
+    for (const std::optional<DisplayRingBufferFrame>& overlay : overlays) {
+      if (overlay) {
+        overlay_pixels.push_back(overlay->Pixels());
+      }
+    }
+    BlendAndConvertToI420(base->Pixels(), overlay_pixels, frame_fourcc_format,
+                          width, height, *buffer);
+
+    bool intact = base->IsIntact();
+    for (const std::optional<DisplayRingBufferFrame>& overlay : overlays) {
+      intact = intact && (!overlay || overlay->IsIntact());
+    }
+    if (intact) {
+      composed.buffer = buffer;
+      composed.sequences = std::move(sequences);
+      return true;
+    }
   }
+  // Overlays kept changing while being read, the last attempt is sent anyway.
+  return true;
 }
 
 }  // namespace cuttlefish
@@ -18,9 +18,13 @@
 #include <stdint.h>
 
 #include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <vector>
 
+#include "cuttlefish/host/libs/screen_connector/frame_damage.h"
 #include "cuttlefish/host/libs/screen_connector/ring_buffer_manager.h"
 #include "cuttlefish/host/libs/screen_connector/video_frame_buffer.h"
 #include "cuttlefish/host/libs/wayland/wayland_server_callbacks.h"
@@ -38,13 +42,25 @@ class CompositionManager {
 
   ~CompositionManager();
   static Result<std::unique_ptr<CompositionManager>> Create();
+  // Composes the displays of the VM at `vm_index` of the cluster identified by
+  // `group_uuid`, with the overlays configured for each of them.
+  static std::unique_ptr<CompositionManager> Create(
+      int vm_index, std::string group_uuid,
+      std::map<int, std::vector<DisplayOverlay>> overlays);
 
   void OnDisplayCreated(const DisplayCreatedEvent& event);
-  void OnFrame(uint32_t display_number, uint32_t frame_width,
-               uint32_t frame_height, uint32_t frame_fourcc_format,
-               uint32_t frame_stride_bytes, uint8_t* frame_pixels);
+  // Blends the overlays of the display into `frame_pixels` and returns the
+  // damage of the result. Overlays may change anywhere, so that is the whole
+  // frame for a display with overlays, and `damage` otherwise.
+  FrameDamage OnFrame(uint32_t display_number, uint32_t frame_width,
+                      uint32_t frame_height, uint32_t frame_fourcc_format,
+                      uint32_t frame_stride_bytes, uint8_t* frame_pixels,
+                      const FrameDamage& damage);
 
-  void ComposeFrame(int display_index,
+  // Blends the overlays of the display over its last local frame into
+  // `buffer`. Returns false, leaving `buffer` alone, when the display has
+  // nothing to compose, such as no overlays or no frame yet.
+  bool ComposeFrame(int display_index,
                     std::shared_ptr<VideoFrameBuffer> buffer);
 
  private:
@@ -57,34 +73,51 @@ class CompositionManager {
     LastFrameInfo() {}
     LastFrameInfo(uint32_t display_number, uint32_t frame_width,
                   uint32_t frame_height, uint32_t frame_fourcc_format,
-                  uint32_t frame_stride_bytes, uint8_t* frame_pixels) {
+                  uint32_t frame_stride_bytes) {
       display_number_ = display_number;
       frame_width_ = frame_width;
       frame_height_ = frame_height;
       frame_fourcc_format_ = frame_fourcc_format;
       frame_stride_bytes_ = frame_stride_bytes;
-      frame_pixels_ = frame_pixels;
     }
     uint32_t display_number_;
     uint32_t frame_width_;
     uint32_t frame_height_;
     uint32_t frame_fourcc_format_;
     uint32_t frame_stride_bytes_;
-    uint8_t* frame_pixels_;
   };
+  // What was last composed into a display's buffer, identified by the
+  // sequence numbers of the base frame and of every overlay (0 if missing).
+  struct ComposedFrameInfo {
+    std::weak_ptr<VideoFrameBuffer> buffer;
+    std::vector<uint64_t> sequences;
+  };
+  enum class BlendResult {
+    kNothingBlended,
+    kBlended,
+    kTorn,
+  };
+
   static std::map<int, std::vector<CompositionManager::DisplayOverlay>>
   ParseOverlays(std::vector<std::string> overlay_items);
-  uint8_t* AlphaBlendLayers(uint8_t* frame_pixels, int display, int frame_width,
-                            int frame_height);
-  void ComposeFrame(int display, int width, int height,
-                    uint32_t frame_fourcc_format, uint32_t frame_stride_bytes,
+  std::vector<std::optional<DisplayRingBufferFrame>> ReadOverlays(
+      int display, int frame_width, int frame_height);
+  BlendResult AlphaBlendLayers(
+      const uint8_t* base_pixels, uint8_t* frame_pixels, int frame_width,
+      int frame_height,
+      const std::vector<std::optional<DisplayRingBufferFrame>>& overlays);
+  bool ComposeFrame(int display, int width, int height,
+                    uint32_t frame_fourcc_format,
                     std::shared_ptr<VideoFrameBuffer> buffer);
   DisplayRingBufferManager display_ring_buffer_manager_;
   int cluster_index_;
   std::string group_uuid_;
   std::map<int, std::vector<DisplayOverlay>> cfg_overlays_;
+  // OnFrame and ComposeFrame run on different threads.
+  std::mutex last_frame_info_mutex_;
   std::map<int, LastFrameInfo> last_frame_info_map_;
-  std::map<int, std::vector<uint8_t>> frame_work_buffer_;
+  // Only used by ComposeFrame.
+  std::map<int, ComposedFrameInfo> composed_frame_info_map_;
 };
 
 }  // namespace cuttlefish
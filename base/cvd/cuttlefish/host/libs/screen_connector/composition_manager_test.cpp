@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/libs/screen_connector/composition_manager.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include <map>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <drm/drm_fourcc.h>
+#include <fmt/format.h>
+#include "gtest/gtest.h"
+
+#include "cuttlefish/host/libs/screen_connector/frame_damage.h"
+#include "cuttlefish/host/libs/screen_connector/ring_buffer_manager.h"
+#include "cuttlefish/host/libs/screen_connector/video_frame_buffer.h"
+#include "cuttlefish/host/libs/wayland/wayland_server_callbacks.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr uint32_t kWidth = 16;
+constexpr uint32_t kHeight = 16;
+constexpr uint32_t kStride = kWidth * 4;
+
+std::string GroupUuid(const std::string& test) {
+  return fmt::format("composition_manager_test_{}_{}", getpid(), test);
+}
+
+// An opaque frame of a single color.
+std::vector<uint8_t> Frame(uint8_t value) {
+  std::vector<uint8_t> pixels(kStride * kHeight, value);
+  for (size_t i = 3; i < pixels.size(); i += 4) {
+    pixels[i] = 0xff;
+  }
+  return pixels;
+}
+
+const uint8_t* PixelAt(const std::vector<uint8_t>& pixels, uint32_t x,
+                       uint32_t y) {
+  return &pixels[y * kStride + x * 4];
+}
+
+class I420Buffer : public VideoFrameBuffer {
+ public:
+  I420Buffer(int width, int height)
+      : width_(width),
+        height_(height),
+        y_(static_cast<size_t>(width) * height),
+        u_(static_cast<size_t>(StrideU()) * ((height + 1) / 2)),
+        v_(u_.size()) {}
+
+  int width() const override { return width_; }
+  int height() const override { return height_; }
+  int StrideY() const override { return width_; }
+  int StrideU() const override { return (width_ + 1) / 2; }
+  int StrideV() const override { return (width_ + 1) / 2; }
+  uint8_t* DataY() override { return y_.data(); }
+  uint8_t* DataU() override { return u_.data(); }
+  uint8_t* DataV() override { return v_.data(); }
+  size_t DataSizeY() const override { return y_.size(); }
+  size_t DataSizeU() const override { return u_.size(); }
+  size_t DataSizeV() const override { return v_.size(); }
+
+ private:
+  int width_;
+  int height_;
+  std::vector<uint8_t> y_;
+  std::vector<uint8_t> u_;
+  std::vector<uint8_t> v_;
+};
+
+TEST(CompositionManagerTest, OverlayChangesOutsideTheDamageAreReported) {
+  const std::string group_uuid = GroupUuid("overlay");
+  // The VM at index 1 shows its display 0 over display 0 of the VM at 0.
+  DisplayRingBufferManager overlay_vm(1, group_uuid);
+  ASSERT_THAT(overlay_vm.CreateLocalDisplayBuffer(1, 0, kWidth, kHeight),
+              IsOk());
+  std::unique_ptr<CompositionManager> manager = CompositionManager::Create(
+      0, group_uuid, {{0, {{.src_vm_index = 1, .src_display_index = 0}}}});
+  manager->OnDisplayCreated(DisplayCreatedEvent{
+      .display_number = 0, .display_width = kWidth, .display_height = kHeight});
+
+  // Transparent but for one opaque pixel far from what the guest changes.
+  std::vector<uint8_t> overlay(kStride * kHeight, 0);
+  uint8_t* overlay_pixel = &overlay[12 * kStride + 12 * 4];
+  overlay_pixel[0] = 0x80;
+  overlay_pixel[3] = 0xff;
+  overlay_vm.WriteFrame(1, 0, overlay.data(), overlay.size());
+
+  std::vector<uint8_t> frame = Frame(0x10);
+  const FrameDamage guest_damage = {{.x = 0, .y = 0, .width = 4, .height = 4}};
+  FrameDamage damage =
+      manager->OnFrame(0, kWidth, kHeight, DRM_FORMAT_ARGB8888, kStride,
+                       frame.data(), guest_damage);
+
+  EXPECT_EQ(PixelAt(frame, 12, 12)[0], 0x80);
+  EXPECT_EQ(PixelAt(frame, 0, 0)[0], 0x10);
+  // Empty, for the whole frame, as the overlay is outside the guest's damage.
+  EXPECT_TRUE(damage.empty());
+}
+
+TEST(CompositionManagerTest, DamageOfDisplaysWithoutOverlaysIsKept) {
+  const std::string group_uuid = GroupUuid("no_overlay");
+  std::unique_ptr<CompositionManager> manager =
+      CompositionManager::Create(0, group_uuid, {});
+  manager->OnDisplayCreated(DisplayCreatedEvent{
+      .display_number = 0, .display_width = kWidth, .display_height = kHeight});
+
+  std::vector<uint8_t> frame = Frame(0x10);
+  const FrameDamage guest_damage = {{.x = 1, .y = 2, .width = 3, .height = 4}};
+  FrameDamage damage =
+      manager->OnFrame(0, kWidth, kHeight, DRM_FORMAT_ARGB8888, kStride,
+                       frame.data(), guest_damage);
+
+  ASSERT_EQ(damage.size(), 1);
+  EXPECT_EQ(damage[0].x, 1);
+  EXPECT_EQ(damage[0].y, 2);
+  EXPECT_EQ(damage[0].width, 3);
+  EXPECT_EQ(damage[0].height, 4);
+  EXPECT_EQ(frame, Frame(0x10));
+}
+
+TEST(CompositionManagerTest, ComposeFrameSkipsUnchangedFrames) {
+  const std::string group_uuid = GroupUuid("compose");
+  DisplayRingBufferManager overlay_vm(1, group_uuid);
+  ASSERT_THAT(overlay_vm.CreateLocalDisplayBuffer(1, 0, kWidth, kHeight),
+              IsOk());
+  std::unique_ptr<CompositionManager> manager = CompositionManager::Create(
+      0, group_uuid, {{0, {{.src_vm_index = 1, .src_display_index = 0}}}});
+  manager->OnDisplayCreated(DisplayCreatedEvent{
+      .display_number = 0, .display_width = kWidth, .display_height = kHeight});
+  std::vector<uint8_t> overlay = Frame(0x80);
+  overlay_vm.WriteFrame(1, 0, overlay.data(), overlay.size());
+  std::vector<uint8_t> frame = Frame(0x10);
+  manager->OnFrame(0, kWidth, kHeight, DRM_FORMAT_ARGB8888, kStride,
+                   frame.data(), FrameDamage());
+
+  auto buffer = std::make_shared<I420Buffer>(kWidth, kHeight);
+  ASSERT_TRUE(manager->ComposeFrame(0, buffer));
+  const uint8_t composed = buffer->DataY()[0];
+  ASSERT_NE(composed, 0);
+
+  // Cleared to tell whether the next calls compose into the buffer again.
+  std::fill_n(buffer->DataY(), buffer->DataSizeY(), 0);
+  EXPECT_TRUE(manager->ComposeFrame(0, buffer));
+  EXPECT_EQ(buffer->DataY()[0], 0);
+
+  overlay_vm.WriteFrame(1, 0, overlay.data(), overlay.size());
+  EXPECT_TRUE(manager->ComposeFrame(0, buffer));
+  EXPECT_EQ(buffer->DataY()[0], composed);
+
+  auto other_buffer = std::make_shared<I420Buffer>(kWidth, kHeight);
+  EXPECT_TRUE(manager->ComposeFrame(0, other_buffer));
+  EXPECT_EQ(other_buffer->DataY()[0], composed);
+}
+
+}  // namespace
+}  // namespace cuttlefish
@@ -16,12 +16,15 @@
 
 #include "cuttlefish/host/libs/screen_connector/ring_buffer_manager.h"
 
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 
+#include <atomic>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 
@@ -32,7 +35,10 @@
 namespace cuttlefish {
 
 namespace {
-constexpr int kNumberOfRingBufferFrames = 3;
+// Attempts at finding a stable newest frame before the reader gives up on a
+// writer that keeps lapping it.
+constexpr int kMaxCurrentFrameAttempts = 3;
+
 inline int RingBufferMemorySize(int w, int h) {
   return sizeof(DisplayRingBufferHeader) +
          ((w * h * 4) * kNumberOfRingBufferFrames);
@@ -91,34 +97,76 @@ DisplayRingBuffer::DisplayRingBuffer(void* addr, std::string name, bool owned,
   header_ = (DisplayRingBufferHeader*)addr;
 }
 
-uint8_t* DisplayRingBuffer::WriteNextFrame(uint8_t* frame_data, int size) {
-  int new_frame_index =
-      (header_->last_valid_frame_index_ + 1) % kNumberOfRingBufferFrames;
+DisplayRingBufferFrame DisplayRingBuffer::WriteNextFrame(
+    const uint8_t* frame_data, int size) {
+  uint64_t sequence =
+      header_->last_frame_sequence_.load(std::memory_order_relaxed) + 1;
+  uint32_t slot = sequence % kNumberOfRingBufferFrames;
+  std::atomic<uint64_t>& stamp = header_->slot_stamps_[slot];
+
+  // An odd stamp tells readers of the frame being replaced that it's gone.
+  stamp.store(2 * sequence - 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
 
-  uint8_t* frame_memory_address = ComputeFrameAddressForIndex(new_frame_index);
+  uint8_t* frame_memory_address = ComputeFrameAddressForIndex(slot);
   memcpy(frame_memory_address, frame_data, size);
 
-  header_->last_valid_frame_index_ = new_frame_index;
-  return frame_memory_address;
+  stamp.store(2 * sequence, std::memory_order_release);
+  header_->last_frame_sequence_.store(sequence, std::memory_order_release);
+  return DisplayRingBufferFrame(this, frame_memory_address, sequence, slot);
 }
 
-uint8_t* DisplayRingBuffer::CurrentFrame() {
-  return ComputeFrameAddressForIndex(header_->last_valid_frame_index_);
+std::optional<DisplayRingBufferFrame> DisplayRingBuffer::CurrentFrame() const {
+  for (int attempt = 0; attempt < kMaxCurrentFrameAttempts; attempt++) {
+    uint64_t sequence =
+        header_->last_frame_sequence_.load(std::memory_order_acquire);
+    if (sequence == 0) {
+      return std::nullopt;
+    }
+    uint32_t slot = sequence % kNumberOfRingBufferFrames;
+    // The writer may have lapped the reader since the sequence was loaded.
+    if (header_->slot_stamps_[slot].load(std::memory_order_acquire) ==
+        2 * sequence) {
+      return DisplayRingBufferFrame(this, ComputeFrameAddressForIndex(slot),
+                                    sequence, slot);
+    }
+  }
+  return std::nullopt;
 }
 
-uint8_t* DisplayRingBuffer::ComputeFrameAddressForIndex(uint32_t index) {
-  int frame_memory_index = (index * (header_->display_width_ *
-                                     header_->display_height_ * header_->bpp_));
+uint8_t* DisplayRingBuffer::ComputeFrameAddressForIndex(uint32_t index) const {
+  size_t frame_memory_index =
+      index * (size_t{header_->display_width_} * header_->display_height_ *
+               header_->bpp_);
   return ((uint8_t*)addr_) + sizeof(DisplayRingBufferHeader) +
          frame_memory_index;
 }
 
-void DisplayRingBufferHeader::set(uint32_t w, uint32_t h, uint32_t bpp,
-                                  uint32_t index) {
+bool DisplayRingBuffer::IsSlotStamped(uint32_t slot, uint64_t sequence) const {
+  // Orders the reader's earlier reads of the pixels before the stamp check.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return header_->slot_stamps_[slot].load(std::memory_order_relaxed) ==
+         2 * sequence;
+}
+
+DisplayRingBufferFrame::DisplayRingBufferFrame(const DisplayRingBuffer* buffer,
+                                               const uint8_t* pixels,
+                                               uint64_t sequence,
+                                               uint32_t slot)
+    : buffer_(buffer), pixels_(pixels), sequence_(sequence), slot_(slot) {}
+
+bool DisplayRingBufferFrame::IsIntact() const {
+  return buffer_->IsSlotStamped(slot_, sequence_);
+}
+
+void DisplayRingBufferHeader::set(uint32_t w, uint32_t h, uint32_t bpp) {
   display_width_ = w;
   display_height_ = h;
   bpp_ = bpp;
-  last_valid_frame_index_.store(index);
+  for (std::atomic<uint64_t>& stamp : slot_stamps_) {
+    stamp.store(0, std::memory_order_relaxed);
+  }
+  last_frame_sequence_.store(0, std::memory_order_release);
 }
 
 DisplayRingBufferManager::DisplayRingBufferManager(int vm_index,
@@ -129,6 +177,7 @@ Result<void> DisplayRingBufferManager::CreateLocalDisplayBuffer(
     int vm_index, int display_index, int display_width, int display_height) {
   auto buffer_key = std::make_pair(vm_index, display_index);
 
+  std::lock_guard lock(display_buffer_cache_mutex_);
   if (!display_buffer_cache_.count(buffer_key)) {
     std::string shmem_name = MakeLayerName(display_index);
 
@@ -143,50 +192,59 @@ Result<void> DisplayRingBufferManager::CreateLocalDisplayBuffer(
     // and compute valid frame addresses for reading / writing frame data.
     DisplayRingBufferHeader* dbi =
         (DisplayRingBufferHeader*)shmem_local_display;
-    dbi->set(display_width, display_height, 4, 0);
+    dbi->set(display_width, display_height, 4);
 
     display_buffer_cache_[buffer_key] = std::move(shm_buffer);
   }
   return {};
 }
 
-uint8_t* DisplayRingBufferManager::WriteFrame(int vm_index, int display_index,
-                                              uint8_t* frame_data, int size) {
+std::optional<DisplayRingBufferFrame> DisplayRingBufferManager::WriteFrame(
+    int vm_index, int display_index, const uint8_t* frame_data, int size) {
   auto buffer_key = std::make_pair(vm_index, display_index);
-  if (display_buffer_cache_.count(buffer_key)) {
-    return display_buffer_cache_[buffer_key]->WriteNextFrame(frame_data, size);
+  DisplayRingBuffer* buffer = nullptr;
+  {
+    std::lock_guard lock(display_buffer_cache_mutex_);
+    auto it = display_buffer_cache_.find(buffer_key);
+    if (it == display_buffer_cache_.end()) {
+      // It's possible to request a write to buffer that doesn't yet exist.
+      return std::nullopt;
+    }
+    buffer = it->second.get();
   }
-  // It's possible to request a write to buffer that doesn't yet exist.
-  return nullptr;
+  return buffer->WriteNextFrame(frame_data, size);
 }
 
-uint8_t* DisplayRingBufferManager::ReadFrame(int vm_index, int display_index,
-                                             int frame_width,
-                                             int frame_height) {
+std::optional<DisplayRingBufferFrame> DisplayRingBufferManager::ReadFrame(
+    int vm_index, int display_index, int frame_width, int frame_height) {
   auto buffer_key = std::make_pair(vm_index, display_index);
-
-  // If this buffer was read successfully in the past, that valid pointer is
-  // returned from the cache
-  if (!display_buffer_cache_.count(buffer_key)) {
-    // Since no cache found, next step is to request from OS to map a new IPC
-    // buffer. It may not yet exist so we want this method to only cache if it
-    // is a non-null pointer, to retrigger this logic continually every request.
-    // Once the buffer exists the pointer would become non-null
-
-    std::string shmem_name = MakeLayerName(display_index, vm_index);
-    std::optional<std::unique_ptr<DisplayRingBuffer>> shmem_buffer =
-        DisplayRingBuffer::ShmemGet(
-            shmem_name.c_str(),
-            RingBufferMemorySize(frame_width, frame_height));
-
-    if (shmem_buffer.has_value() && shmem_buffer.value()->GetAddress()) {
-      display_buffer_cache_[buffer_key] = std::move(shmem_buffer.value());
-    } else {
-      return nullptr;
+  DisplayRingBuffer* buffer = nullptr;
+  {
+    std::lock_guard lock(display_buffer_cache_mutex_);
+    // If this buffer was read successfully in the past, the mapping is reused
+    // from the cache
+    if (!display_buffer_cache_.count(buffer_key)) {
+      // Since no cache found, next step is to request from OS to map a new IPC
+      // buffer. It may not yet exist so we want this method to only cache if
+      // it is a non-null pointer, to retrigger this logic continually every
+      // request. Once the buffer exists the pointer would become non-null
+
+      std::string shmem_name = MakeLayerName(display_index, vm_index);
+      std::optional<std::unique_ptr<DisplayRingBuffer>> shmem_buffer =
+          DisplayRingBuffer::ShmemGet(
+              shmem_name.c_str(),
+              RingBufferMemorySize(frame_width, frame_height));
+
+      if (shmem_buffer.has_value() && shmem_buffer.value()->GetAddress()) {
+        display_buffer_cache_[buffer_key] = std::move(shmem_buffer.value());
+      } else {
+        return std::nullopt;
+      }
     }
+    buffer = display_buffer_cache_[buffer_key].get();
   }
 
-  return display_buffer_cache_[buffer_key]->CurrentFrame();
+  return buffer->CurrentFrame();
 }
 
 std::string DisplayRingBufferManager::MakeLayerName(int display_index,
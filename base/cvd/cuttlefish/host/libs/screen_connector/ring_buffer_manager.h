@@ -21,6 +21,7 @@
 #include <atomic>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <utility>
@@ -30,16 +31,53 @@
 
 namespace cuttlefish {
 
+inline constexpr uint32_t kNumberOfRingBufferFrames = 4;
+
 // This header is allocated / placed at start of IPC ringbuffer. Intention of
 // elements here is to allow to compute the valid read/write address for
 // current frame from an external process.
+//
+// Every slot is guarded by a seqlock: the writer makes the slot's stamp odd
+// before overwriting its pixels and sets it to twice the sequence number of
+// the new frame once done. Readers use the pixels in place and check
+// afterwards that the stamp didn't change, which tells them whether the writer
+// lapped them while they were reading.
 struct DisplayRingBufferHeader {
   volatile uint32_t display_width_;
   volatile uint32_t display_height_;
   volatile uint32_t bpp_;
-  std::atomic<uint32_t> last_valid_frame_index_;
+  // Sequence number of the newest complete frame, 0 until one is written.
+  std::atomic<uint64_t> last_frame_sequence_;
+  std::atomic<uint64_t> slot_stamps_[kNumberOfRingBufferFrames];
 
-  void set(uint32_t w, uint32_t h, uint32_t bpp, uint32_t index);
+  void set(uint32_t w, uint32_t h, uint32_t bpp);
+};
+
+// The header is shared with other processes, so its atomics can't use locks.
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+class DisplayRingBuffer;
+
+// A frame used in place in a ring buffer. The writer may start overwriting it
+// at any time, so the reader must check IsIntact() once done with the pixels.
+class DisplayRingBufferFrame {
+ public:
+  const uint8_t* Pixels() const { return pixels_; }
+  // Starts at 1 and grows by one with every frame written to the buffer.
+  uint64_t Sequence() const { return sequence_; }
+  // Whether the pixels weren't overwritten since the frame was obtained.
+  bool IsIntact() const;
+
+ private:
+  friend class DisplayRingBuffer;
+  DisplayRingBufferFrame(const DisplayRingBuffer* buffer,
+                         const uint8_t* pixels, uint64_t sequence,
+                         uint32_t slot);
+
+  const DisplayRingBuffer* buffer_;
+  const uint8_t* pixels_;
+  uint64_t sequence_;
+  uint32_t slot_;
 };
 
 class DisplayRingBuffer {
@@ -53,13 +91,20 @@ class DisplayRingBuffer {
 
   void* GetAddress();
 
-  uint8_t* WriteNextFrame(uint8_t* frame_data, int size);
-  uint8_t* CurrentFrame();
-  uint8_t* ComputeFrameAddressForIndex(uint32_t index);
+  // Only the process that created the buffer may write to it, from one thread
+  // at a time.
+  DisplayRingBufferFrame WriteNextFrame(const uint8_t* frame_data, int size);
+  // Returns the newest complete frame, if one was written yet.
+  std::optional<DisplayRingBufferFrame> CurrentFrame() const;
 
  private:
+  friend class DisplayRingBufferFrame;
+
   DisplayRingBuffer(void* addr, std::string name, bool owned, ScopedMMap shm);
 
+  uint8_t* ComputeFrameAddressForIndex(uint32_t index) const;
+  bool IsSlotStamped(uint32_t slot, uint64_t sequence) const;
+
   DisplayRingBufferHeader* header_;
   void* addr_;
   std::string name_;
@@ -72,17 +117,23 @@ class DisplayRingBufferManager {
   DisplayRingBufferManager(int vm_index, std::string group_uuid);
   Result<void> CreateLocalDisplayBuffer(int vm_index, int display_index,
                                         int display_width, int display_height);
-  uint8_t* WriteFrame(int vm_index, int display_index, uint8_t* frame_data,
-                      int size);
-  uint8_t* ReadFrame(int vm_index, int display_index, int frame_width,
-                     int frame_height);
+  std::optional<DisplayRingBufferFrame> WriteFrame(int vm_index,
+                                                  int display_index,
+                                                  const uint8_t* frame_data,
+                                                  int size);
+  std::optional<DisplayRingBufferFrame> ReadFrame(int vm_index,
+                                                 int display_index,
+                                                 int frame_width,
+                                                 int frame_height);
 
  private:
   std::string MakeLayerName(int display_index, int vm_index = -1);
   int local_group_index_;  // Index of the current process in the cluster of VMs
   std::string group_uuid_;  // Unique identifier for entire VM cluster
   // All IPC buffers are cached here for speed, to prevent OS from
-  // continually remapping RAM every read/write request.
+  // continually remapping RAM every read/write request. Buffers are never
+  // removed, so pointers to them stay valid without holding the mutex.
+  std::mutex display_buffer_cache_mutex_;
   std::map<std::pair<int, int>, std::unique_ptr<DisplayRingBuffer>>
       display_buffer_cache_;
 };
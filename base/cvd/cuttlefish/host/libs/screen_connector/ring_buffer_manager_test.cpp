@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "cuttlefish/host/libs/screen_connector/ring_buffer_manager.h"
+
+#include <stdint.h>
+#include <unistd.h>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+#include "gtest/gtest.h"
+
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr int kWidth = 8;
+constexpr int kHeight = 8;
+constexpr int kFrameSize = kWidth * kHeight * 4;
+
+std::string GroupUuid(const std::string& test) {
+  return fmt::format("ring_buffer_manager_test_{}_{}", getpid(), test);
+}
+
+std::vector<uint8_t> Frame(uint8_t value) {
+  return std::vector<uint8_t>(kFrameSize, value);
+}
+
+// The display 0 of the VM at index 0, written by its own process and read by
+// another VM of the cluster.
+class RingBufferManagerTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_THAT(writer_.CreateLocalDisplayBuffer(0, 0, kWidth, kHeight),
+                IsOk());
+  }
+
+  std::optional<DisplayRingBufferFrame> Write(uint8_t value) {
+    std::vector<uint8_t> frame = Frame(value);
+    return writer_.WriteFrame(0, 0, frame.data(), frame.size());
+  }
+  std::optional<DisplayRingBufferFrame> Read() {
+    return reader_.ReadFrame(0, 0, kWidth, kHeight);
+  }
+
+  std::string group_uuid_ = GroupUuid(
+      testing::UnitTest::GetInstance()->current_test_info()->name());
+  DisplayRingBufferManager writer_{0, group_uuid_};
+  DisplayRingBufferManager reader_{1, group_uuid_};
+};
+
+TEST_F(RingBufferManagerTest, NoFrameBeforeTheFirstWrite) {
+  EXPECT_FALSE(Read().has_value());
+}
+
+TEST_F(RingBufferManagerTest, ReadsTheNewestFrame) {
+  Write(1);
+  Write(2);
+
+  std::optional<DisplayRingBufferFrame> frame = Read();
+
+  ASSERT_TRUE(frame.has_value());
+  EXPECT_EQ(frame->Sequence(), 2);
+  EXPECT_EQ(frame->Pixels()[0], 2);
+  EXPECT_TRUE(frame->IsIntact());
+}
+
+TEST_F(RingBufferManagerTest, UnchangedSequenceWithoutNewFrames) {
+  Write(1);
+  std::optional<DisplayRingBufferFrame> first = Read();
+  std::optional<DisplayRingBufferFrame> second = Read();
+
+  ASSERT_TRUE(first.has_value());
+  ASSERT_TRUE(second.has_value());
+  EXPECT_EQ(first->Sequence(), second->Sequence());
+  EXPECT_EQ(first->Pixels(), second->Pixels());
+  EXPECT_TRUE(first->IsIntact());
+
+  Write(2);
+  std::optional<DisplayRingBufferFrame> third = Read();
+
+  ASSERT_TRUE(third.has_value());
+  EXPECT_EQ(third->Sequence(), first->Sequence() + 1);
+}
+
+TEST_F(RingBufferManagerTest, FrameStaysIntactUntilItsSlotIsReused) {
+  Write(1);
+  std::optional<DisplayRingBufferFrame> frame = Read();
+  ASSERT_TRUE(frame.has_value());
+
+  for (uint32_t i = 1; i < kNumberOfRingBufferFrames; i++) {
+    Write(1 + i);
+    EXPECT_TRUE(frame->IsIntact());
+  }
+}
+
+TEST_F(RingBufferManagerTest, LappedFrameIsNotIntact) {
+  Write(1);
+  std::optional<DisplayRingBufferFrame> frame = Read();
+  ASSERT_TRUE(frame.has_value());
+
+  for (uint32_t i = 1; i <= kNumberOfRingBufferFrames; i++) {
+    Write(1 + i);
+  }
+
+  EXPECT_FALSE(frame->IsIntact());
+  std::optional<DisplayRingBufferFrame> newest = Read();
+  ASSERT_TRUE(newest.has_value());
+  EXPECT_EQ(newest->Sequence(), kNumberOfRingBufferFrames + 1);
+  EXPECT_EQ(newest->Pixels(), frame->Pixels());
+  EXPECT_TRUE(newest->IsIntact());
+}
+
+TEST(DisplayRingBufferTest, FrameBeingOverwrittenIsNotIntact) {
+  Result<std::unique_ptr<DisplayRingBuffer>> buffer = DisplayRingBuffer::Create(
+      fmt::format("/ring_buffer_manager_test_{}_torn", getpid()),
+      sizeof(DisplayRingBufferHeader) + kNumberOfRingBufferFrames * kFrameSize);
+  ASSERT_THAT(buffer, IsOk());
+  auto* header =
+      static_cast<DisplayRingBufferHeader*>((*buffer)->GetAddress());
+  header->set(kWidth, kHeight, 4);
+  std::vector<uint8_t> pixels = Frame(1);
+  (*buffer)->WriteNextFrame(pixels.data(), pixels.size());
+  std::optional<DisplayRingBufferFrame> frame = (*buffer)->CurrentFrame();
+  ASSERT_TRUE(frame.has_value());
+
+  // The writer marks the slot this way before it starts copying the frame
+  // that replaces this one, and stops here if it is interrupted.
+  uint64_t replacement = frame->Sequence() + kNumberOfRingBufferFrames;
+  uint32_t slot = frame->Sequence() % kNumberOfRingBufferFrames;
+  header->slot_stamps_[slot].store(2 * replacement - 1);
+
+  EXPECT_FALSE(frame->IsIntact());
+}
+
+}  // namespace
+}  // namespace cuttlefish
@@ -24,6 +24,7 @@
 #include <string_view>
 #include <type_traits>
 #include <unordered_set>
+#include <utility>
 
 #include <fruit/fruit.h>
 #include "absl/log/log.h"
@@ -35,6 +36,7 @@
 #include "cuttlefish/host/libs/config/gpu_mode.h"
 #include "cuttlefish/host/libs/confui/host_mode_ctrl.h"
 #include "cuttlefish/host/libs/confui/host_utils.h"
+#include "cuttlefish/host/libs/screen_connector/frame_damage.h"
 #include "cuttlefish/host/libs/screen_connector/screen_connector_common.h"
 #include "cuttlefish/host/libs/screen_connector/screen_connector_multiplexer.h"
 #include "cuttlefish/host/libs/screen_connector/screen_connector_queue.h"
@@ -86,11 +88,15 @@ class ScreenConnector : public ScreenConnectorFrameRenderer {
    * The callback function is how a raw bytes frame should be processed for
    * WebRTC
    *
+   * The damage lists the areas that changed since the previous frame passed
+   * to the callback for the same display. It is empty when unknown.
+   *
    */
   using GenerateProcessedFrameCallback = std::function<void(
       uint32_t /*display_number*/, uint32_t /*frame_width*/,
       uint32_t /*frame_height*/, uint32_t /*frame_fourcc_format*/,
       uint32_t /*frame_stride_bytes*/, uint8_t* /*frame_bytes*/,
+      const FrameDamage& /*damage*/,
       /* ScImpl enqueues this type into the Q */
       ProcessedFrameType& msg)>;
 
@@ -109,27 +115,33 @@ class ScreenConnector : public ScreenConnectorFrameRenderer {
     sc_android_src_.SetFrameCallback(
         [this](uint32_t display_number, uint32_t frame_w, uint32_t frame_h,
                uint32_t frame_fourcc_format, uint32_t frame_stride_bytes,
-               uint8_t* frame_bytes) {
+               uint8_t* frame_bytes, const FrameDamage& damage) {
           InjectFrame(display_number, frame_w, frame_h, frame_fourcc_format,
-                      frame_stride_bytes, frame_bytes);
+                      frame_stride_bytes, frame_bytes, damage);
         });
   }
 
   void InjectFrame(uint32_t display_number, uint32_t frame_w, uint32_t frame_h,
                    uint32_t frame_fourcc_format, uint32_t frame_stride_bytes,
-                   uint8_t* frame_bytes) {
+                   uint8_t* frame_bytes, const FrameDamage& damage) {
     const bool is_confui_mode = host_mode_ctrl_.IsConfirmatioUiMode();
-    if (is_confui_mode) {
-      return;
-    }
 
     ProcessedFrameType processed_frame;
 
     {
       std::lock_guard<std::mutex> lock(streamer_callback_mutex_);
+      if (is_confui_mode) {
+        // The damage of dropped frames is lost.
+        displays_without_damage_.insert(display_number);
+        return;
+      }
+      // The streamer last saw a confirmation UI frame or missed some damage.
+      const bool full_frame =
+          displays_without_damage_.erase(display_number) > 0;
       callback_from_streamer_(display_number, frame_w, frame_h,
                               frame_fourcc_format, frame_stride_bytes,
-                              frame_bytes, processed_frame);
+                              frame_bytes, full_frame ? FrameDamage{} : damage,
+                              processed_frame);
     }
 
     sc_frame_multiplexer_.PushToAndroidQueue(std::move(processed_frame));
@@ -176,9 +188,13 @@ class ScreenConnector : public ScreenConnectorFrameRenderer {
     ConfUiLogDebug << this_thread_name
                    << "is sending a #" + std::to_string(render_confui_cnt_)
                    << "Conf UI frame";
-    callback_from_streamer_(display_number, frame_width, frame_height,
-                            frame_fourcc_format, frame_stride_bytes,
-                            frame_bytes, processed_frame);
+    {
+      std::lock_guard<std::mutex> lock(streamer_callback_mutex_);
+      displays_without_damage_.insert(display_number);
+      callback_from_streamer_(display_number, frame_width, frame_height,
+                              frame_fourcc_format, frame_stride_bytes,
+                              frame_bytes, FrameDamage{}, processed_frame);
+    }
     // now add processed_frame to the queue
     sc_frame_multiplexer_.PushToConfUiQueue(std::move(processed_frame));
     return true;
@@ -202,6 +218,9 @@ class ScreenConnector : public ScreenConnectorFrameRenderer {
   GenerateProcessedFrameCallback callback_from_streamer_;
   std::mutex
       streamer_callback_mutex_;  // mutex to set & read callback_from_streamer_
+  // Displays whose next Android frame has to be treated as fully changed.
+  // Guarded by streamer_callback_mutex_.
+  std::unordered_set<uint32_t> displays_without_damage_;
   std::condition_variable streamer_callback_set_cv_;
 };
 
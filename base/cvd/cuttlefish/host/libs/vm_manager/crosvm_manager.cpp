@@ -514,16 +514,8 @@ Result<std::vector<MonitorCommand>> CrosvmManager::StartCommands(
   std::vector<MonitorCommand> commands;
 
   CrosvmBuilder crosvm_cmd;
-  crosvm_cmd.Cmd().AddPrerequisite([&dependencyCommands]() -> Result<void> {
-    for (auto dependencyCommand : dependencyCommands) {
-      if (!dependencyCommand->Enabled()) {
-        continue;
-      }
-      CF_EXPECT(dependencyCommand->WaitForAvailability());
-    }
-
-    return {};
-  });
+  // The vhost user devices crosvm connects to once they listen.
+  std::vector<std::string> vhost_user_devices;
 
   // Add "--restore_path=<guest snapshot directory>" if there is a snapshot
   // path supplied.
@@ -640,17 +632,21 @@ Result<std::vector<MonitorCommand>> CrosvmManager::StartCommands(
     if (instance.vhost_user_block() && disk_i == 2) {
       // TODO: b/346855591 - Run on all devices
       auto block = CF_EXPECT(VhostUserBlockDevice(config, disk_i, disk));
-      commands.emplace_back(std::move(block.device_cmd));
-      commands.emplace_back(std::move(block.device_logs_cmd));
       auto socket_path = std::move(block.socket_path);
-      crosvm_cmd.Cmd().AddPrerequisite([socket_path]() -> Result<void> {
+      const std::string device_name =
+          fmt::format("vhost_user_block_{}", disk_i);
+      commands.emplace_back(std::move(block.device_cmd))
+          .Named(device_name)
+          .ReadyWhen([socket_path]() -> Result<void> {
 #ifdef __linux__
-        return WaitForUnixSocketListeningWithoutConnect(socket_path,
-                                                        /*timeoutSec=*/30);
+            return WaitForUnixSocketListeningWithoutConnect(socket_path,
+                                                            /*timeoutSec=*/30);
 #else
-        return CF_ERR("Unhandled check if vhost user block ready.");
+            return CF_ERR("Unhandled check if vhost user block ready.");
 #endif
-      });
+          });
+      commands.emplace_back(std::move(block.device_logs_cmd));
+      vhost_user_devices.push_back(device_name);
       auto pci_addr = fmt::format("00:{:0>2x}.0", 0x13 + disk_i);
       crosvm_cmd.Cmd().AddParameter("--vhost-user=block,socket=", socket_path,
                                     ",pci-address=", pci_addr);
@@ -976,6 +972,8 @@ Result<std::vector<MonitorCommand>> CrosvmManager::StartCommands(
   // captured during shutdown. Processes are stopped in reverse order.
   commands.emplace_back(std::move(crosvm_log_tee_cmd));
 
+  // The command starting crosvm.
+  MonitorCommand* vmm = nullptr;
   if (gpu_capture_enabled) {
     const std::string gpu_capture_basename =
         android::base::Basename(instance.gpu_capture_binary());
@@ -1021,13 +1019,17 @@ Result<std::vector<MonitorCommand>> CrosvmManager::StartCommands(
                                       gpu_capture_logs);
 
     commands.emplace_back(std::move(gpu_capture_log_tee_cmd));
-    commands.emplace_back(std::move(gpu_capture_command));
+    vmm = &commands.emplace_back(std::move(gpu_capture_command));
   } else {
     crosvm_cmd.Cmd().RedirectStdIO(Subprocess::StdIOChannel::kStdOut,
                                    crosvm_logs);
     crosvm_cmd.Cmd().RedirectStdIO(Subprocess::StdIOChannel::kStdErr,
                                    crosvm_logs);
-    commands.emplace_back(std::move(crosvm_cmd.Cmd()), true);
+    vmm = &commands.emplace_back(std::move(crosvm_cmd.Cmd()), true);
+  }
+  StartAfterDependencies(*vmm, dependencyCommands);
+  for (const std::string& device : vhost_user_devices) {
+    vmm->StartAfter(device);
   }
 
   return commands;
@@ -245,17 +245,8 @@ Result<std::vector<MonitorCommand>> QemuManager::StartCommands(
 
   auto qemu_version = CF_EXPECT(GetQemuVersion(qemu_binary));
   Command qemu_cmd(qemu_binary, KillSubprocessFallback(Stop));
-
-  qemu_cmd.AddPrerequisite([&dependency_commands]() -> Result<void> {
-    for (auto dependencyCommand : dependency_commands) {
-      if (!dependencyCommand->Enabled()) {
-        continue;
-      }
-      CF_EXPECT(dependencyCommand->WaitForAvailability());
-    }
-
-    return {};
-  });
+  // The vhost user devices qemu connects to once they listen.
+  std::vector<std::string> vhost_user_devices;
 
   int hvc_num = 0;
   int serial_num = 0;
@@ -677,17 +668,20 @@ Result<std::vector<MonitorCommand>> QemuManager::StartCommands(
   for (const auto& disk : instance.virtual_disk_paths()) {
     if (instance.vhost_user_block()) {
       auto block = CF_EXPECT(VhostUserBlockDevice(config, i, disk));
-      commands.emplace_back(std::move(block.device_cmd));
-      commands.emplace_back(std::move(block.device_logs_cmd));
       auto socket_path = std::move(block.socket_path);
-      qemu_cmd.AddPrerequisite([socket_path]() -> Result<void> {
+      const std::string device_name = fmt::format("vhost_user_block_{}", i);
+      commands.emplace_back(std::move(block.device_cmd))
+          .Named(device_name)
+          .ReadyWhen([socket_path]() -> Result<void> {
 #ifdef __linux__
-        return WaitForUnixSocketListeningWithoutConnect(socket_path,
-                                                        /*timeoutSec=*/30);
+            return WaitForUnixSocketListeningWithoutConnect(socket_path,
+                                                            /*timeoutSec=*/30);
 #else
-        return CF_ERR("Unhandled check if vhost user block ready.");
+            return CF_ERR("Unhandled check if vhost user block ready.");
 #endif
-      });
+          });
+      commands.emplace_back(std::move(block.device_logs_cmd));
+      vhost_user_devices.push_back(device_name);
 
       qemu_cmd.AddParameter("-chardev");
       qemu_cmd.AddParameter("socket,id=vhost-user-block-", i,
@@ -908,7 +902,11 @@ Result<std::vector<MonitorCommand>> QemuManager::StartCommands(
     add_hvc_sink();
   }
 
-  commands.emplace_back(std::move(qemu_cmd), true);
+  MonitorCommand& vmm = commands.emplace_back(std::move(qemu_cmd), true);
+  StartAfterDependencies(vmm, dependency_commands);
+  for (const std::string& device : vhost_user_devices) {
+    vmm.StartAfter(device);
+  }
   return commands;
 }
 
@@ -62,6 +62,31 @@ std::unique_ptr<VmManager> GetVmManager(VmmMode vmm_mode, Arch arch) {
   return vmm;
 }
 
+void StartAfterDependencies(
+    MonitorCommand& vmm,
+    const std::vector<VmmDependencyCommand*>& dependency_commands) {
+  std::vector<VmmDependencyCommand*> launched_elsewhere;
+  for (VmmDependencyCommand* dependency : dependency_commands) {
+    if (!dependency->Enabled()) {
+      continue;
+    }
+    if (dependency->LaunchedHere()) {
+      vmm.StartAfter(dependency->Name());
+    } else {
+      launched_elsewhere.push_back(dependency);
+    }
+  }
+  if (launched_elsewhere.empty()) {
+    return;
+  }
+  vmm.command.AddPrerequisite([launched_elsewhere]() -> Result<void> {
+    for (VmmDependencyCommand* dependency : launched_elsewhere) {
+      CF_EXPECT(dependency->WaitForAvailability());
+    }
+    return {};
+  });
+}
+
 Result<std::unordered_map<std::string, std::string>>
 ConfigureMultipleBootDevices(const std::string& pci_path, int pci_offset,
                              int num_disks) {
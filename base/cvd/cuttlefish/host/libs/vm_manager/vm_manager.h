@@ -32,8 +32,14 @@ namespace cuttlefish {
 namespace vm_manager {
 
 // Class for tagging that the CommandSource is a dependency command for the
-// VmManager.
-class VmmDependencyCommand : public virtual StatusCheckCommandSource {};
+// VmManager. The command the VMM needs is named after the feature, and ready
+// once WaitForAvailability returns.
+class VmmDependencyCommand : public virtual StatusCheckCommandSource {
+ public:
+  // Whether this launcher runs the command, rather than the launcher of
+  // another instance.
+  virtual bool LaunchedHere() const { return Enabled(); }
+};
 
 // Superclass of every guest VM manager.
 class VmManager {
@@ -128,6 +134,12 @@ VmManagerComponent();
 
 std::unique_ptr<VmManager> GetVmManager(VmmMode vmm, Arch arch);
 
+// Starts the VMM once its enabled dependencies are available: after those this
+// launcher runs, and waiting for the others before starting.
+void StartAfterDependencies(
+    MonitorCommand& vmm,
+    const std::vector<VmmDependencyCommand*>& dependency_commands);
+
 Result<std::unordered_map<std::string, std::string>>
 ConfigureMultipleBootDevices(const std::string& pci_path, int pci_offset,
                              int num_disks);
@@ -90,6 +90,15 @@ void surface_damage(wl_client*,
                     int32_t h) {
   VLOG(1) << __FUNCTION__ << " surface=" << surface_resource << " x=" << x
           << " y=" << y << " w=" << w << " h=" << h;
+
+  // Buffers are never scaled or transformed, so surface coordinates are
+  // buffer coordinates.
+  GetUserData<Surface>(surface_resource)->AddDamage(Surface::Region{
+      .x = x,
+      .y = y,
+      .w = w,
+      .h = h,
+  });
 }
 
 void surface_frame(wl_client*, wl_resource* surface, uint32_t) {
@@ -143,6 +152,13 @@ void surface_damage_buffer(wl_client*,
                            int32_t h) {
   VLOG(1) << __FUNCTION__ << " surface=" << surface_resource << " x=" << x
           << " y=" << y << " w=" << w << " h=" << h;
+
+  GetUserData<Surface>(surface_resource)->AddDamage(Surface::Region{
+      .x = x,
+      .y = y,
+      .w = w,
+      .h = h,
+  });
 }
 
 const struct wl_surface_interface surface_implementation = {
@@ -19,6 +19,7 @@
 #include "absl/log/log.h"
 
 #include <drm/drm_fourcc.h>
+#include <sys/mman.h>
 
 #include <linux-dmabuf-unstable-v1-server-protocol.h>
 #include <wayland-server-core.h>
@@ -193,4 +194,25 @@ bool IsDmabufResource(struct wl_resource* resource) {
                                  &buffer_implementation);
 }
 
+Dmabuf::~Dmabuf() {
+  if (mapped_pixels != nullptr) {
+    munmap(mapped_pixels, mapped_size);
+  }
+}
+
+uint8_t* GetDmabufPixels(Dmabuf& dmabuf) {
+  if (dmabuf.mapped_pixels == nullptr) {
+    const DmabufPlane& plane = dmabuf.params.planes.begin()->second;
+    const size_t size = static_cast<size_t>(dmabuf.height) * plane.stride;
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, plane.fd, 0);
+    if (mapped == MAP_FAILED) {
+      PLOG(ERROR) << "Failed to mmap dmabuf.";
+      return nullptr;
+    }
+    dmabuf.mapped_pixels = mapped;
+    dmabuf.mapped_size = size;
+  }
+  return reinterpret_cast<uint8_t*>(dmabuf.mapped_pixels);
+}
+
 }  // namespace wayland
\ No newline at end of file
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 #include <map>
 
@@ -48,13 +49,28 @@ struct DmabufParams {
 };
 
 struct Dmabuf {
+  Dmabuf() = default;
+  ~Dmabuf();
+
+  Dmabuf(const Dmabuf& rhs) = delete;
+  Dmabuf& operator=(const Dmabuf& rhs) = delete;
+
   uint32_t width = 0;
   uint32_t height = 0;
   uint32_t format = 0;
   uint32_t flags = 0;
   DmabufParams params;
+
+  // Mapping of the first plane. Clients commit the same few buffers over and
+  // over, so it's kept for the life of the buffer.
+  void* mapped_pixels = nullptr;
+  size_t mapped_size = 0;
 };
 
+// Returns the pixels of the dmabuf's first plane, mapping them on first use.
+// Returns nullptr if the plane can't be mapped.
+uint8_t* GetDmabufPixels(Dmabuf& dmabuf);
+
 // Binds the dmabuf interface to the given wayland server.
 void BindDmabufInterface(wl_display* display);
 
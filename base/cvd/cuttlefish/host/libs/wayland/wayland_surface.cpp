@@ -18,10 +18,12 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <mutex>
+#include <utility>
+#include <vector>
 
 #include <drm/drm_fourcc.h>
-#include <sys/mman.h>
 #include <wayland-server-protocol.h>
 
 #include "absl/log/check.h"
@@ -45,6 +47,30 @@ uint32_t GetDrmFormat(uint32_t wl_shm_format) {
   }
 }
 
+// Clips the client provided damage to the buffer, dropping empty areas.
+FrameDamage ToFrameDamage(const std::vector<Surface::Region>& regions,
+                          uint32_t buffer_w, uint32_t buffer_h) {
+  FrameDamage damage;
+  for (const Surface::Region& region : regions) {
+    const int64_t left = std::max<int64_t>(region.x, 0);
+    const int64_t top = std::max<int64_t>(region.y, 0);
+    const int64_t right =
+        std::min<int64_t>(int64_t{region.x} + region.w, buffer_w);
+    const int64_t bottom =
+        std::min<int64_t>(int64_t{region.y} + region.h, buffer_h);
+    if (right <= left || bottom <= top) {
+      continue;
+    }
+    damage.emplace_back(FrameDamageRect{
+        .x = static_cast<uint32_t>(left),
+        .y = static_cast<uint32_t>(top),
+        .width = static_cast<uint32_t>(right - left),
+        .height = static_cast<uint32_t>(bottom - top),
+    });
+  }
+  return damage;
+}
+
 }  // namespace
 
 Surface::Surface(Surfaces& surfaces) : surfaces_(surfaces) {}
@@ -66,12 +92,21 @@ void Surface::Attach(struct wl_resource* buffer) {
   state_.pending_buffer = buffer;
 }
 
+void Surface::AddDamage(const Region& region) {
+  std::unique_lock<std::mutex> lock(state_mutex_);
+  state_.pending_damage.push_back(region);
+}
+
 void Surface::Commit() {
   std::unique_lock<std::mutex> lock(state_mutex_);
   state_.current_buffer = state_.pending_buffer;
   state_.pending_buffer = nullptr;
+  std::vector<Region> damage = std::move(state_.pending_damage);
+  state_.pending_damage.clear();
 
   if (state_.current_buffer == nullptr) {
+    // Applies to the contents of the next buffer.
+    state_.pending_damage = std::move(damage);
     return;
   }
 
@@ -85,7 +120,6 @@ void Surface::Commit() {
     uint32_t buffer_drm_format = 0;
     uint32_t buffer_stride_bytes = 0;
     uint8_t* buffer_pixels = nullptr;
-    uint32_t buffer_size = 0;
 
     if (shm_buffer != nullptr) {
       wl_shm_buffer_begin_access(shm_buffer);
@@ -110,17 +144,8 @@ void Surface::Commit() {
       if (dmabuf_plane.fd.ok()) {
         buffer_drm_format = dmabuf->format;
         buffer_stride_bytes = dmabuf_plane.stride;
-        buffer_size = buffer_h * buffer_stride_bytes;
-        // TODO: Refactor to not have `PROT_WRITE`.
-        auto mapped = mmap(nullptr, buffer_size, PROT_READ,
-                            MAP_SHARED, dmabuf_plane.fd, 0);
-        if (mapped != MAP_FAILED) {
-          buffer_pixels = reinterpret_cast<uint8_t*>(mapped);
-        } else {
-          PLOG(ERROR) << "Failed to mmap dmabuf.";
-        }
+        buffer_pixels = GetDmabufPixels(*dmabuf);
       }
-
     }
 
     if (!state_.has_notified_surface_create) {
@@ -129,17 +154,21 @@ void Surface::Commit() {
     }
 
     if (buffer_pixels != nullptr) {
+      // Without any damage the client didn't say what changed.
+      FrameDamage frame_damage;
+      if (!state_.pending_full_damage && !damage.empty()) {
+        frame_damage = ToFrameDamage(damage, buffer_w, buffer_h);
+      }
       surfaces_.HandleSurfaceFrame(display_number, buffer_w, buffer_h,
                                    buffer_drm_format, buffer_stride_bytes,
-                                   buffer_pixels);
+                                   buffer_pixels, frame_damage);
+      state_.pending_full_damage = false;
+    } else {
+      state_.pending_full_damage = true;
     }
 
     if (shm_buffer != nullptr) {
       wl_shm_buffer_end_access(shm_buffer);
-    } else {
-      if (buffer_pixels != nullptr) {
-        munmap(buffer_pixels, buffer_size);
-      }
     }
   }
 
@@ -20,6 +20,7 @@
 #include <stdint.h>
 #include <mutex>
 #include <optional>
+#include <vector>
 
 #include <wayland-server-core.h>
 
@@ -51,6 +52,9 @@ class Surface {
   // Sets the buffer of the pending frame.
   void Attach(struct wl_resource* buffer);
 
+  // Marks an area of the pending frame as changed.
+  void AddDamage(const Region& region);
+
   // Commits the pending frame state.
   void Commit();
 
@@ -72,6 +76,13 @@ class Surface {
     // The buffer for the next frame.
     struct wl_resource* pending_buffer = nullptr;
 
+    // The areas changed in the next frame.
+    std::vector<Region> pending_damage;
+
+    // Whether the next frame has to be treated as fully changed, because no
+    // frame was delivered yet or a previous frame's damage was lost.
+    bool pending_full_damage = true;
+
     // The buffers expected dimensions.
     Region region;
 
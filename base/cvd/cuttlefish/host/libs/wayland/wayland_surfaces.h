@@ -25,10 +25,14 @@
 #include <thread>
 #include <unordered_map>
 
+#include "cuttlefish/host/libs/screen_connector/frame_damage.h"
 #include "cuttlefish/host/libs/wayland/wayland_server_callbacks.h"
 
 namespace wayland {
 
+using cuttlefish::FrameDamage;
+using cuttlefish::FrameDamageRect;
+
 class Surface;
 
 class Surfaces {
@@ -47,7 +51,8 @@ class Surfaces {
                                            uint32_t /*frame_height*/,         //
                                            uint32_t /*frame_fourcc_format*/,  //
                                            uint32_t /*frame_stride_bytes*/,   //
-                                           uint8_t* /*frame_bytes*/)>;
+                                           uint8_t* /*frame_bytes*/,          //
+                                           const FrameDamage& /*damage*/)>;
 
   void SetFrameCallback(FrameCallback callback);
 
@@ -62,7 +67,8 @@ class Surfaces {
                           uint32_t frame_height,         //
                           uint32_t frame_fourcc_format,  //
                           uint32_t frame_stride_bytes,   //
-                          uint8_t* frame_bytes);
+                          uint8_t* frame_bytes,          //
+                          const FrameDamage& damage);
 
   void HandleSurfaceCreated(uint32_t display_number, uint32_t display_width,
                             uint32_t display_height);
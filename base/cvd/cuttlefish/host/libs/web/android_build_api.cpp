@@ -141,11 +141,19 @@ Result<Build> AndroidBuildApi::GetBuild(const BuildString& build_string) {
 Result<std::string> AndroidBuildApi::DownloadFile(
     const Build& build, const std::string& target_directory,
     const std::string& artifact_name) {
+  return DownloadFileWithObserver(build, target_directory, artifact_name,
+                                  nullptr);
+}
+
+Result<std::string> AndroidBuildApi::DownloadFileWithObserver(
+    const Build& build, const std::string& target_directory,
+    const std::string& artifact_name,
+    const HttpClient::DataCallback& observer) {
   std::unordered_set<std::string> artifacts =
       CF_EXPECT(Artifacts(build, {artifact_name}));
   CF_EXPECT(Contains(artifacts, artifact_name),
             "Target " << build << " did not contain " << artifact_name);
-  return DownloadTargetFile(build, target_directory, artifact_name);
+  return DownloadTargetFile(build, target_directory, artifact_name, observer);
 }
 
 
@@ -360,11 +368,12 @@ Result<std::string> AndroidBuildApi::GetArtifactDownloadUrl(
   return CF_EXPECT(GetValue<std::string>(json, { "signedUrl" }));
 }
 
-Result<void> AndroidBuildApi::ArtifactToFile(const DeviceBuild& build,
-                                             const std::string& artifact,
-                                             const std::string& path) {
+Result<void> AndroidBuildApi::ArtifactToFile(
+    const DeviceBuild& build, const std::string& artifact,
+    const std::string& path, const HttpClient::DataCallback& observer) {
   const auto url = CF_EXPECT(GetArtifactDownloadUrl(build, artifact));
-  auto response = CF_EXPECT(HttpGetToFile(http_client_, url, path));
+  auto response =
+      CF_EXPECT(HttpGetToFile(http_client_, url, path, {}, observer));
   CF_EXPECTF(response.HttpSuccess(), "Failed to download file: {}",
              response.StatusDescription());
   return {};
@@ -372,7 +381,8 @@ Result<void> AndroidBuildApi::ArtifactToFile(const DeviceBuild& build,
 
 Result<void> AndroidBuildApi::ArtifactToFile(const DirectoryBuild& build,
                                              const std::string& artifact,
-                                             const std::string& path) {
+                                             const std::string& path,
+                                             const HttpClient::DataCallback&) {
   for (const auto& path : build.paths) {
     auto source = path + "/" + artifact;
     if (!FileExists(source)) {
@@ -386,12 +396,12 @@ Result<void> AndroidBuildApi::ArtifactToFile(const DirectoryBuild& build,
                                              << build << "\"");
 }
 
-Result<void> AndroidBuildApi::ArtifactToFile(const Build& build,
-                                             const std::string& artifact,
-                                             const std::string& path) {
+Result<void> AndroidBuildApi::ArtifactToFile(
+    const Build& build, const std::string& artifact, const std::string& path,
+    const HttpClient::DataCallback& observer) {
   auto res = std::visit(
-      [this, &artifact, &path](auto&& arg) {
-        return ArtifactToFile(arg, artifact, path);
+      [this, &artifact, &path, &observer](auto&& arg) {
+        return ArtifactToFile(arg, artifact, path, observer);
       },
       build);
   CF_EXPECT(std::move(res));
@@ -423,7 +433,8 @@ Result<std::string> AndroidBuildApi::DownloadTargetFileFromCas(
 
 Result<std::string> AndroidBuildApi::DownloadTargetFile(
     const Build& build, const std::string& target_directory,
-    const std::string& artifact_name) {
+    const std::string& artifact_name,
+    const HttpClient::DataCallback& observer) {
   std::string target_filepath =
       ConstructTargetFilepath(target_directory, artifact_name);
   if (cas_downloader_ != nullptr &&
@@ -438,7 +449,7 @@ Result<std::string> AndroidBuildApi::DownloadTargetFile(
   }
   CF_EXPECT(EnsureDirectoryExists(
       std::string(android::base::Dirname(target_filepath))));
-  CF_EXPECT(ArtifactToFile(build, artifact_name, target_filepath),
+  CF_EXPECT(ArtifactToFile(build, artifact_name, target_filepath, observer),
             "Unable to download " << build << ":" << artifact_name << " to "
                                   << target_filepath);
   return {target_filepath};
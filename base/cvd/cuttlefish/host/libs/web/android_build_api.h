@@ -51,6 +51,10 @@ class AndroidBuildApi : public BuildApi {
   Result<std::string> DownloadFile(const Build& build,
                                    const std::string& target_directory,
                                    const std::string& artifact_name) override;
+  Result<std::string> DownloadFileWithObserver(
+      const Build& build, const std::string& target_directory,
+      const std::string& artifact_name,
+      const HttpClient::DataCallback& observer) override;
 
 
   Result<SeekableZipSource> FileReader(
@@ -89,18 +93,22 @@ class AndroidBuildApi : public BuildApi {
                                              const std::string& artifact);
   Result<void> ArtifactToFile(const DeviceBuild& build,
                               const std::string& artifact,
-                              const std::string& path);
+                              const std::string& path,
+                              const HttpClient::DataCallback& observer);
 
   Result<void> ArtifactToFile(const DirectoryBuild& build,
                               const std::string& artifact,
-                              const std::string& path);
+                              const std::string& path,
+                              const HttpClient::DataCallback& observer);
 
   Result<void> ArtifactToFile(const Build& build, const std::string& artifact,
-                              const std::string& path);
+                              const std::string& path,
+                              const HttpClient::DataCallback& observer);
 
-  Result<std::string> DownloadTargetFile(const Build& build,
-                                         const std::string& target_directory,
-                                         const std::string& artifact_name);
+  Result<std::string> DownloadTargetFile(
+      const Build& build, const std::string& target_directory,
+      const std::string& artifact_name,
+      const HttpClient::DataCallback& observer);
   Result<std::string> DownloadTargetFileFromCas(
       const Build& build, const std::string& target_directory,
       const std::string& artifact_name);
@@ -18,10 +18,17 @@
 #include <string>
 
 #include "cuttlefish/host/libs/web/android_build.h"
+#include "cuttlefish/host/libs/web/http_client/http_client.h"
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
 
+Result<std::string> BuildApi::DownloadFileWithObserver(
+    const Build& build, const std::string& target_directory,
+    const std::string& artifact_name, const HttpClient::DataCallback&) {
+  return CF_EXPECT(DownloadFile(build, target_directory, artifact_name));
+}
+
 Result<std::string> DownloadFileWithBackup(
     BuildApi& build_api, const Build& build,
     const std::string& target_directory, const std::string& artifact_name,
@@ -19,6 +19,7 @@
 
 #include "cuttlefish/host/libs/web/android_build.h"
 #include "cuttlefish/host/libs/web/android_build_string.h"
+#include "cuttlefish/host/libs/web/http_client/http_client.h"
 #include "cuttlefish/host/libs/zip/libzip_cc/seekable_source.h"
 #include "cuttlefish/result/result.h"
 
@@ -33,6 +34,15 @@ class BuildApi {
       const Build& build, const std::string& target_directory,
       const std::string& artifact_name) = 0;
 
+  /* Like `DownloadFile`, also passing the contents to `observer` while they
+   * are transferred, following the `HttpClient::DataCallback` protocol.
+   * `observer` may not be called at all, for example when the file is already
+   * in a local cache. */
+  virtual Result<std::string> DownloadFileWithObserver(
+      const Build& build, const std::string& target_directory,
+      const std::string& artifact_name,
+      const HttpClient::DataCallback& observer);
+
   virtual Result<SeekableZipSource> FileReader(
       const Build&, const std::string& artifact_name) = 0;
 };
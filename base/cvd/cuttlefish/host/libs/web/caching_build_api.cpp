@@ -15,8 +15,11 @@
 
 #include "cuttlefish/host/libs/web/caching_build_api.h"
 
+#include <algorithm>
+#include <mutex>
 #include <string>
 #include <utility>
+#include <variant>
 
 #include <android-base/file.h>
 #include <fmt/core.h>
@@ -109,10 +112,22 @@ Result<Build> CachingBuildApi::GetBuild(const BuildString& build_string) {
 Result<std::string> CachingBuildApi::DownloadFile(
     const Build& build, const std::string& target_directory,
     const std::string& artifact_name) {
+  return CF_EXPECT(
+      DownloadFileWithObserver(build, target_directory, artifact_name, nullptr));
+}
+
+Result<std::string> CachingBuildApi::DownloadFileWithObserver(
+    const Build& build, const std::string& target_directory,
+    const std::string& artifact_name,
+    const HttpClient::DataCallback& observer) {
   const auto paths = CF_EXPECT(ConstructCachePaths(cache_base_path_, build,
                                                    target_directory, artifact_name));
+  // Targets fetched concurrently can share a build. Only one of them downloads
+  // each artifact while the others wait for it to be in the cache.
+  std::lock_guard lock(ArtifactMutex(paths.cache_artifact));
   if (!IsInCache(paths.cache_artifact)) {
-    CF_EXPECT(build_api_.DownloadFile(build, paths.build_cache, artifact_name));
+    CF_EXPECT(build_api_.DownloadFileWithObserver(build, paths.build_cache,
+                                                  artifact_name, observer));
   }
   return CF_EXPECT(CreateHardLink(paths.cache_artifact, paths.target_artifact,
                                   kOverwriteExistingFile));
@@ -122,8 +137,23 @@ Result<std::string> CachingBuildApi::DownloadFile(
 Result<SeekableZipSource> CachingBuildApi::FileReader(
     const Build& build, const std::string& artifact) {
   SeekableZipSource source = CF_EXPECT(build_api_.FileReader(build, artifact));
-  std::string cache_path = fmt::format("{}/{}", cache_base_path_, artifact);
-  return CF_EXPECT(CacheZipSource(std::move(source), cache_path));
+  // Local builds are already on disk, and their id doesn't change when they
+  // are rebuilt, so it can't identify their content.
+  if (std::holds_alternative<DirectoryBuild>(build)) {
+    return source;
+  }
+  // Artifacts of a remote build never change, so the build identifies the
+  // content. The blocks of every artifact are a top-level entry of the cache,
+  // shared by every target directory and pruned on their own.
+  const auto [id, target] = GetBuildIdAndTarget(build);
+  std::string key = fmt::format("blocks-{}-{}-{}", id, target, artifact);
+  std::replace(key.begin(), key.end(), '/', '_');
+  return CF_EXPECT(CacheZipSource(std::move(source), cache_base_path_, key));
+}
+
+std::mutex& CachingBuildApi::ArtifactMutex(const std::string& cache_artifact) {
+  std::lock_guard lock(artifact_mutexes_mutex_);
+  return artifact_mutexes_[cache_artifact];
 }
 
 }  // namespace cuttlefish
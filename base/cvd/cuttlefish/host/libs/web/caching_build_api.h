@@ -15,10 +15,13 @@
 
 #pragma once
 
+#include <map>
+#include <mutex>
 #include <string>
 
 #include "cuttlefish/host/libs/web/android_build.h"
 #include "cuttlefish/host/libs/web/build_api.h"
+#include "cuttlefish/host/libs/web/http_client/http_client.h"
 #include "cuttlefish/host/libs/zip/libzip_cc/seekable_source.h"
 #include "cuttlefish/result/result.h"
 
@@ -35,13 +38,21 @@ class CachingBuildApi : public BuildApi {
   Result<std::string> DownloadFile(const Build& build,
                                    const std::string& target_directory,
                                    const std::string& artifact_name) override;
+  Result<std::string> DownloadFileWithObserver(
+      const Build& build, const std::string& target_directory,
+      const std::string& artifact_name,
+      const HttpClient::DataCallback& observer) override;
 
   Result<SeekableZipSource> FileReader(const Build&,
                                        const std::string& artifact) override;
 
  private:
+  std::mutex& ArtifactMutex(const std::string& cache_artifact);
+
   BuildApi& build_api_;
   std::string cache_base_path_;
+  std::mutex artifact_mutexes_mutex_;
+  std::map<std::string, std::mutex> artifact_mutexes_;
 };
 
 }  // namespace cuttlefish
@@ -17,19 +17,26 @@
 
 #include <stdio.h>
 
+#include <array>
+#include <condition_variable>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <optional>
+#include <set>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#include "absl/cleanup/cleanup.h"
 #include "absl/log/log.h"
 #include "absl/strings/ascii.h"
 #include "curl/curl.h"
 #include "curl/easy.h"
 #include "curl/header.h"
+#include "curl/multi.h"
 
 #include "cuttlefish/host/libs/web/http_client/http_client.h"
 #include "cuttlefish/host/libs/web/http_client/scrub_secrets.h"
@@ -101,72 +108,353 @@ Result<ManagedCurlSlist> SlistFromStrings(
   return curl_headers;
 }
 
-class CurlClient : public HttpClient {
+/* Shares the DNS cache and TLS sessions between all easy handles of a client,
+ * so a new handle doesn't have to resolve and do a full handshake again.
+ * Connections are not shared, as libcurl doesn't support using a shared
+ * connection cache from concurrent threads. */
+class CurlShare {
  public:
-  CurlClient(const bool use_logging_debug_function)
-      : use_logging_debug_function_(use_logging_debug_function) {
-    curl_ = curl_easy_init();
-    if (!curl_) {
-      LOG(ERROR) << "failed to initialize curl";
+  CurlShare() : share_(curl_share_init()) {
+    if (!share_) {
+      LOG(ERROR) << "failed to initialize curl share";
       return;
     }
+    curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, Lock);
+    curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, Unlock);
+    curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+  }
+  ~CurlShare() {
+    if (share_) {
+      curl_share_cleanup(share_);
+    }
+  }
+
+  CURLSH* Get() { return share_; }
+
+ private:
+  static void Lock(CURL*, curl_lock_data data, curl_lock_access, void* ptr) {
+    static_cast<CurlShare*>(ptr)->mutexes_[data].lock();
+  }
+  static void Unlock(CURL*, curl_lock_data data, void* ptr) {
+    static_cast<CurlShare*>(ptr)->mutexes_[data].unlock();
+  }
+
+  CURLSH* share_;
+  std::array<std::mutex, CURL_LOCK_DATA_LAST> mutexes_;
+};
+
+/* Runs transfers on a multi handle from a dedicated thread. Its connection
+ * cache is shared by all transfers, so concurrent requests to the same HTTP/2
+ * server are multiplexed on one connection. The data of each transfer is
+ * passed to the thread waiting for it, so a slow consumer pauses its own
+ * transfer rather than the thread running all of them. */
+class CurlMulti {
+ public:
+  CurlMulti() : multi_(curl_multi_init()) {
+    if (!multi_) {
+      LOG(ERROR) << "failed to initialize curl multi";
+      return;
+    }
+    curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    thread_ = std::thread([this]() { Run(); });
+  }
+  ~CurlMulti() {
+    if (!multi_) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    curl_multi_wakeup(multi_);
+    thread_.join();
+    curl_multi_cleanup(multi_);
+  }
+
+  // Blocks until the transfer completes, calling `callback` with the data it
+  // receives on the calling thread.
+  CURLcode Perform(CURL* curl, HttpClient::DataCallback& callback) {
+    if (!multi_) {
+      return CURLE_FAILED_INIT;
+    }
+    Transfer transfer{.curl = curl};
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, &transfer);
+    curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, Receive);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stop_) {
+        return CURLE_FAILED_INIT;
+      }
+      pending_.push_back(&transfer);
+    }
+    curl_multi_wakeup(multi_);
+
+    std::string data;
+    std::unique_lock<std::mutex> lock(transfer.mutex);
+    while (true) {
+      transfer.cv.wait(lock, [&transfer]() {
+        return !transfer.data.empty() || transfer.result.has_value();
+      });
+      if (transfer.data.empty()) {
+        break;
+      }
+      data.clear();
+      std::swap(data, transfer.data);
+      const bool resume = transfer.paused;
+      transfer.paused = false;
+      transfer.resume = resume;
+      lock.unlock();
+      if (resume) {
+        curl_multi_wakeup(multi_);
+      }
+      const bool consumed = callback(data.data(), data.size());
+      lock.lock();
+      if (!consumed) {
+        // The next write fails the transfer, the data until then is dropped.
+        transfer.failed = true;
+        transfer.data.clear();
+      }
+    }
+    if (transfer.failed && *transfer.result == CURLE_OK) {
+      return CURLE_WRITE_ERROR;
+    }
+    return *transfer.result;
+  }
+
+ private:
+  // Data received and not consumed yet beyond which a transfer pauses.
+  static constexpr size_t kMaxBuffered = 1 << 20;
+
+  struct Transfer {
+    CURL* curl;
+    // Guards the members below, shared with the multi thread.
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::string data;
+    // The multi thread paused the transfer, waiting for `data` to be consumed.
+    bool paused = false;
+    // The consumer asks the multi thread to continue the paused transfer.
+    bool resume = false;
+    // The consumer failed, the transfer stops at the next write.
+    bool failed = false;
+    std::optional<CURLcode> result;
+  };
+
+  static size_t Receive(char* ptr, size_t, size_t nmemb, void* userdata) {
+    Transfer* transfer = static_cast<Transfer*>(userdata);
+    std::lock_guard<std::mutex> lock(transfer->mutex);
+    if (transfer->failed) {
+      return 0;  // Signals error to curl
+    }
+    if (transfer->data.size() >= kMaxBuffered) {
+      // Curl passes the same data again once the transfer continues.
+      transfer->paused = true;
+      return CURL_WRITEFUNC_PAUSE;
+    }
+    transfer->data.append(ptr, nmemb);
+    transfer->cv.notify_one();
+    return nmemb;
+  }
+
+  static void Finish(Transfer& transfer, CURLcode result) {
+    std::lock_guard<std::mutex> lock(transfer.mutex);
+    transfer.result = result;
+    transfer.cv.notify_one();
+  }
+
+  void Run() {
+    while (true) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_) {
+          break;
+        }
+        for (Transfer* transfer : pending_) {
+          CURLMcode res = curl_multi_add_handle(multi_, transfer->curl);
+          if (res != CURLM_OK) {
+            LOG(ERROR) << "curl_multi_add_handle: " << curl_multi_strerror(res);
+            Finish(*transfer, CURLE_FAILED_INIT);
+            continue;
+          }
+          running_.insert(transfer);
+        }
+        pending_.clear();
+      }
+      for (Transfer* transfer : running_) {
+        bool resume = false;
+        {
+          std::lock_guard<std::mutex> lock(transfer->mutex);
+          std::swap(resume, transfer->resume);
+        }
+        if (resume) {
+          curl_easy_pause(transfer->curl, CURLPAUSE_CONT);
+        }
+      }
+      int running = 0;
+      curl_multi_perform(multi_, &running);
+      int queued = 0;
+      while (CURLMsg* msg = curl_multi_info_read(multi_, &queued)) {
+        if (msg->msg != CURLMSG_DONE) {
+          continue;
+        }
+        char* transfer_ptr = nullptr;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &transfer_ptr);
+        Transfer* transfer = reinterpret_cast<Transfer*>(transfer_ptr);
+        CURLcode res = msg->data.result;
+        curl_multi_remove_handle(multi_, msg->easy_handle);
+        running_.erase(transfer);
+        Finish(*transfer, res);
+      }
+      curl_multi_poll(multi_, nullptr, 0, 1000, nullptr);
+    }
+    // Nothing completes the transfers left once the thread stops.
+    for (Transfer* transfer : running_) {
+      curl_multi_remove_handle(multi_, transfer->curl);
+      Finish(*transfer, CURLE_ABORTED_BY_CALLBACK);
+    }
+    running_.clear();
+    for (Transfer* transfer : pending_) {
+      Finish(*transfer, CURLE_ABORTED_BY_CALLBACK);
+    }
+    pending_.clear();
+  }
+
+  CURLM* multi_;
+  std::mutex mutex_;
+  bool stop_ = false;
+  std::vector<Transfer*> pending_;
+  // Only used by the multi thread.
+  std::set<Transfer*> running_;
+  std::thread thread_;
+};
+
+/* Keeps idle easy handles so concurrent requests each get their own handle,
+ * while sequential requests still reuse the connections of a previous one.
+ * At most kMaxIdle handles are kept, so that a burst of concurrent requests
+ * doesn't keep its handles and their connections open for the lifetime of
+ * the client. */
+class CurlHandlePool {
+ public:
+  // As many as the concurrent requests of a remote zip reader: the chunks it
+  // prefetches and the read it is waiting for.
+  static constexpr size_t kMaxIdle = 5;
+
+
+  ~CurlHandlePool() {
+    for (CURL* curl : idle_) {
+      curl_easy_cleanup(curl);
+    }
+  }
+
+  CURL* Acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (idle_.empty()) {
+      return curl_easy_init();
+    }
+    CURL* curl = idle_.back();
+    idle_.pop_back();
+    return curl;
+  }
+
+  void Release(CURL* curl) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (idle_.size() < kMaxIdle) {
+        idle_.push_back(curl);
+        return;
+      }
+    }
+    curl_easy_cleanup(curl);
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<CURL*> idle_;
+};
+
+class CurlClient : public HttpClient {
+ public:
+  CurlClient(const bool use_logging_debug_function,
+             const bool http2_multiplexing)
+      : use_logging_debug_function_(use_logging_debug_function),
+        http2_multiplexing_(http2_multiplexing) {
+    if (http2_multiplexing_) {
+      multi_ = std::make_unique<CurlMulti>();
+    }
   }
-  ~CurlClient() { curl_easy_cleanup(curl_); }
 
   Result<HttpResponse<void>> DownloadToCallback(
       HttpRequest request, DataCallback callback) override {
-    std::lock_guard<std::mutex> lock(mutex_);
     VLOG(0) << "Downloading '" << request.url << "'";
     CF_EXPECT(
         request.data_to_write.empty() || request.method == HttpMethod::kPost,
         "data must be empty for non POST requests");
-    CF_EXPECT(curl_ != nullptr, "curl was not initialized");
+    CURL* curl = handles_.Acquire();
+    CF_EXPECT(curl != nullptr, "failed to initialize curl");
+    absl::Cleanup release = [this, curl]() { handles_.Release(curl); };
+    return CF_EXPECT(Perform(curl, request, callback));
+  }
+
+ private:
+  Result<HttpResponse<void>> Perform(CURL* curl, const HttpRequest& request,
+                                     DataCallback& callback) {
     CF_EXPECT(callback(nullptr, 0) /* Signal start of data */,
               "callback failure");
     auto curl_headers = CF_EXPECT(SlistFromStrings(request.headers));
 
-    curl_easy_reset(curl_);
+    curl_easy_reset(curl);
     switch (request.method) {
       case HttpMethod::kDelete:
-        curl_easy_setopt(curl_, CURLOPT_CUSTOMREQUEST, "DELETE");
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
         break;
       case HttpMethod::kPost:
-        curl_easy_setopt(curl_, CURLOPT_POSTFIELDSIZE,
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE,
                          request.data_to_write.size());
-        curl_easy_setopt(curl_, CURLOPT_POSTFIELDS,
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS,
                          request.data_to_write.c_str());
         break;
       case HttpMethod::kHead:
-        curl_easy_setopt(curl_, CURLOPT_NOBODY, 1L);
+        curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
         break;
       default:
         break;
     }
-    curl_easy_setopt(curl_, CURLOPT_CAINFO,
+    curl_easy_setopt(curl, CURLOPT_CAINFO,
                      "/etc/ssl/certs/ca-certificates.crt");
-    curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, curl_headers.get());
-    curl_easy_setopt(curl_, CURLOPT_URL, request.url.c_str());
-    curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, curl_to_function_cb);
-    curl_easy_setopt(curl_, CURLOPT_WRITEDATA, &callback);
+    if (share_.Get()) {
+      curl_easy_setopt(curl, CURLOPT_SHARE, share_.Get());
+    }
+    if (http2_multiplexing_) {
+      curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+    }
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, curl_headers.get());
+    curl_easy_setopt(curl, CURLOPT_URL, request.url.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, curl_to_function_cb);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &callback);
     char error_buf[CURL_ERROR_SIZE];
-    curl_easy_setopt(curl_, CURLOPT_ERRORBUFFER, error_buf);
-    curl_easy_setopt(curl_, CURLOPT_VERBOSE, 1L);
+    curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, error_buf);
+    curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
     // CURLOPT_VERBOSE must be set for CURLOPT_DEBUGFUNCTION be utilized
     if (use_logging_debug_function_) {
-      curl_easy_setopt(curl_, CURLOPT_DEBUGFUNCTION, LoggingCurlDebugFunction);
+      curl_easy_setopt(curl, CURLOPT_DEBUGFUNCTION, LoggingCurlDebugFunction);
     }
-    CURLcode res = curl_easy_perform(curl_);
+    CURLcode res = multi_ ? multi_->Perform(curl, callback)
+                          : curl_easy_perform(curl);
     CF_EXPECT(res == CURLE_OK,
               "curl_easy_perform() failed. "
                   << "Code was \"" << res << "\". "
                   << "Strerror was \"" << curl_easy_strerror(res) << "\". "
                   << "Error buffer was \"" << error_buf << "\".");
     long http_code = 0;
-    curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &http_code);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
 
     std::vector<HttpHeader> headers;
     curl_header* raw_header = nullptr;
-    while ((raw_header = curl_easy_nextheader(curl_, CURLH_HEADER, 0,
+    while ((raw_header = curl_easy_nextheader(curl, CURLH_HEADER, 0,
                                               raw_header)) != nullptr) {
       headers.emplace_back(HttpHeader{
           .name = raw_header->name,
@@ -178,16 +466,20 @@ class CurlClient : public HttpClient {
         .data = {}, .http_code = http_code, .headers = std::move(headers)};
   }
 
- private:
-  CURL* curl_;
-  std::mutex mutex_;
   bool use_logging_debug_function_;
+  bool http2_multiplexing_;
+  // Destroyed after the handles that use it.
+  CurlShare share_;
+  std::unique_ptr<CurlMulti> multi_;
+  CurlHandlePool handles_;
 };
 
 }  // namespace
 
-std::unique_ptr<HttpClient> CurlHttpClient(bool use_logging_debug_function) {
-  return std::make_unique<CurlClient>(use_logging_debug_function);
+std::unique_ptr<HttpClient> CurlHttpClient(bool use_logging_debug_function,
+                                           bool http2_multiplexing) {
+  return std::make_unique<CurlClient>(use_logging_debug_function,
+                                      http2_multiplexing);
 }
 
 }  // namespace cuttlefish
@@ -21,7 +21,11 @@
 
 namespace cuttlefish {
 
+/* Concurrent requests use separate connections, which share DNS results and
+ * TLS sessions. With `http2_multiplexing`, requests are instead performed from
+ * a single thread and multiplexed over shared HTTP/2 connections when the
+ * server supports it. The data callbacks still run on the calling threads. */
 std::unique_ptr<HttpClient> CurlHttpClient(
-    bool use_logging_debug_function = false);
+    bool use_logging_debug_function = false, bool http2_multiplexing = false);
 
 }  // namespace cuttlefish
@@ -0,0 +1,196 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Measures requests per second through `CurlHttpClient` as the number of
+// concurrent callers grows, against a local server that adds a fixed delay to
+// every response to stand in for a distant build server.
+
+#include <netinet/in.h>
+#include <stddef.h>
+#include <sys/socket.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "benchmark/benchmark.h"
+#include "fmt/format.h"
+
+#include "cuttlefish/common/libs/fs/shared_buf.h"
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/host/libs/web/http_client/curl_global_init.h"
+#include "cuttlefish/host/libs/web/http_client/curl_http_client.h"
+#include "cuttlefish/host/libs/web/http_client/http_client.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr std::chrono::milliseconds kServerLatency(5);
+constexpr int kRequestsPerCaller = 8;
+constexpr std::string_view kBody = "benchmark response body";
+
+class DelayingServer {
+ public:
+  DelayingServer() : listener_(SharedFD::Socket(AF_INET, SOCK_STREAM, 0)) {
+    CHECK(listener_->IsOpen()) << listener_->StrError();
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    sockaddr* addr_ptr = reinterpret_cast<sockaddr*>(&addr);
+    CHECK_EQ(listener_->Bind(addr_ptr, addr_len), 0) << listener_->StrError();
+    // Every caller may connect at once.
+    CHECK_EQ(listener_->Listen(SOMAXCONN), 0) << listener_->StrError();
+    CHECK_EQ(listener_->GetSockName(addr_ptr, &addr_len), 0);
+    port_ = ntohs(addr.sin_port);
+    accept_thread_ = std::thread([this]() { AcceptLoop(); });
+  }
+
+  ~DelayingServer() {
+    listener_->Shutdown(SHUT_RDWR);
+    accept_thread_.join();
+    for (std::thread& connection : connections_) {
+      connection.join();
+    }
+  }
+
+  std::string Url() const {
+    return fmt::format("http://127.0.0.1:{}/", port_);
+  }
+
+ private:
+  void AcceptLoop() {
+    while (true) {
+      SharedFD connection = SharedFD::Accept(*listener_);
+      if (!connection->IsOpen()) {
+        return;
+      }
+      connections_.emplace_back([connection]() { Serve(connection); });
+    }
+  }
+
+  static void Serve(SharedFD connection) {
+    std::string buffer;
+    char data[4096];
+    while (true) {
+      size_t end;
+      while ((end = buffer.find("\r\n\r\n")) == std::string::npos) {
+        ssize_t read = connection->Read(data, sizeof(data));
+        if (read <= 0) {
+          return;
+        }
+        buffer.append(data, read);
+      }
+      buffer.erase(0, end + 4);
+      std::this_thread::sleep_for(kServerLatency);
+      std::string response = fmt::format(
+          "HTTP/1.1 200 OK\r\nContent-Length: {}\r\n\r\n{}", kBody.size(),
+          kBody);
+      ssize_t written = WriteAll(connection, response);
+      if (written != static_cast<ssize_t>(response.size())) {
+        return;
+      }
+    }
+  }
+
+  SharedFD listener_;
+  int port_;
+  std::thread accept_thread_;
+  std::vector<std::thread> connections_;
+};
+
+// Forwards to another client one request at a time, like the client did before
+// it kept a pool of handles.
+class SerializedHttpClient : public HttpClient {
+ public:
+  explicit SerializedHttpClient(std::unique_ptr<HttpClient> inner)
+      : inner_(std::move(inner)) {}
+
+  Result<HttpResponse<void>> DownloadToCallback(
+      HttpRequest request, DataCallback callback) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return CF_EXPECT(inner_->DownloadToCallback(std::move(request), callback));
+  }
+
+ private:
+  std::unique_ptr<HttpClient> inner_;
+  std::mutex mutex_;
+};
+
+void RunCallers(benchmark::State& state, HttpClient& client,
+                const std::string& url) {
+  const int callers = state.range(0);
+  std::atomic_bool failed = false;
+  for (auto _ : state) {
+    std::vector<std::thread> threads;
+    for (int i = 0; i < callers; i++) {
+      threads.emplace_back([&client, &url, &failed]() {
+        for (int request = 0; request < kRequestsPerCaller; request++) {
+          HttpRequest http_request = {
+              .method = HttpMethod::kGet,
+              .url = url,
+          };
+          auto ignore_data = [](char*, size_t) { return true; };
+          Result<HttpResponse<void>> response =
+              client.DownloadToCallback(http_request, ignore_data);
+          if (!response.ok() || !response->HttpSuccess()) {
+            failed = true;
+            return;
+          }
+        }
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    if (failed) {
+      state.SkipWithError("request failed");
+      return;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * callers * kRequestsPerCaller);
+}
+
+void BM_PooledClient(benchmark::State& state) {
+  CurlGlobalInit curl_init;
+  DelayingServer server;
+  std::unique_ptr<HttpClient> client = CurlHttpClient();
+  RunCallers(state, *client, server.Url());
+}
+
+void BM_SerializedClient(benchmark::State& state) {
+  CurlGlobalInit curl_init;
+  DelayingServer server;
+  std::unique_ptr<HttpClient> client =
+      std::make_unique<SerializedHttpClient>(CurlHttpClient());
+  RunCallers(state, *client, server.Url());
+}
+
+BENCHMARK(BM_PooledClient)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+BENCHMARK(BM_SerializedClient)
+    ->RangeMultiplier(2)
+    ->Range(1, 16)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace cuttlefish
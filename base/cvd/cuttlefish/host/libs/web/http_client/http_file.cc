@@ -35,15 +35,16 @@ namespace cuttlefish {
 
 Result<HttpResponse<std::string>> HttpGetToFile(
     HttpClient& http_client, const std::string& url, const std::string& path,
-    const std::vector<std::string>& headers) {
+    const std::vector<std::string>& headers,
+    const HttpClient::DataCallback& observer) {
   VLOG(0) << "Saving '" << url << "' to '" << path << "'";
 
   std::string temp_path;
   std::unique_ptr<SharedFDOstream> stream;
   uint64_t total_dl = 0;
   uint64_t last_log = 0;
-  auto callback = [path, &temp_path, &stream, &total_dl, &last_log](
-                      char* data, size_t size) -> bool {
+  auto callback = [path, &temp_path, &stream, &total_dl, &last_log,
+                   &observer](char* data, size_t size) -> bool {
     // On a retry due to a server error, the download will be called from the
     // beginning. The download should be initialized / reset at the nullptr /
     // "beginning of download" case, which can come multiple times.
@@ -62,6 +63,9 @@ Result<HttpResponse<std::string>> HttpGetToFile(
       }
       temp_path = res->second;
       stream = std::make_unique<SharedFDOstream>(res->first);
+      if (observer && !observer(nullptr, 0)) {
+        return false;
+      }
       return !stream->fail();
     }
     total_dl += size;
@@ -70,6 +74,9 @@ Result<HttpResponse<std::string>> HttpGetToFile(
       last_log = total_dl;
     }
     stream->write(data, size);
+    if (observer && !observer(data, size)) {
+      return false;
+    }
     return !stream->fail();
   };
 
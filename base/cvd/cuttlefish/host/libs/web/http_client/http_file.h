@@ -23,8 +23,11 @@
 
 namespace cuttlefish {
 
+/* Downloads `url` to `path`. If provided, `observer` also receives the data as
+ * it is written, with the same semantics as `HttpClient::DataCallback`. */
 Result<HttpResponse<std::string>> HttpGetToFile(
     HttpClient&, const std::string& url, const std::string& path,
-    const std::vector<std::string>& headers = {});
+    const std::vector<std::string>& headers = {},
+    const HttpClient::DataCallback& observer = nullptr);
 
 }  // namespace cuttlefish
@@ -20,6 +20,7 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 
 #include "absl/log/log.h"
@@ -27,8 +28,8 @@
 #include "cuttlefish/host/libs/zip/libzip_cc/seekable_source.h"
 #include "cuttlefish/host/libs/zip/libzip_cc/source_callback.h"
 #include "cuttlefish/host/libs/zip/libzip_cc/stat.h"
+#include "cuttlefish/io/block_cache.h"
 #include "cuttlefish/io/io.h"
-#include "cuttlefish/io/lazily_loaded_file.h"
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
@@ -36,7 +37,7 @@ namespace {
 
 class CachedZipSourceCallbacks : public SeekableZipSourceCallback {
  public:
-  CachedZipSourceCallbacks(LazilyLoadedFile source, size_t size)
+  CachedZipSourceCallbacks(std::unique_ptr<ReaderSeeker> source, size_t size)
       : source_(std::move(source)), size_(size) {}
 
   bool Close() override {
@@ -51,11 +52,7 @@ class CachedZipSourceCallbacks : public SeekableZipSourceCallback {
 
   int64_t Read(char* data, uint64_t len) override {
     VLOG(1) << "Reading " << len;
-    if (Result<void> res = source_.Seek(offset_); !res.ok()) {
-      LOG(ERROR) << res.error();
-      return -1;
-    }
-    Result<size_t> res = source_.Read(data, len);
+    Result<uint64_t> res = source_->PRead(data, len, offset_);
     if (res.ok()) {
       offset_ += *res;
       return *res;
@@ -76,7 +73,7 @@ class CachedZipSourceCallbacks : public SeekableZipSourceCallback {
   int64_t Offset() override { return offset_; }
 
  private:
-  LazilyLoadedFile source_;
+  std::unique_ptr<ReaderSeeker> source_;
   size_t offset_ = 0;
   const size_t size_;
 };
@@ -84,22 +81,21 @@ class CachedZipSourceCallbacks : public SeekableZipSourceCallback {
 }  // namespace
 
 Result<SeekableZipSource> CacheZipSource(SeekableZipSource inner,
-                                         std::string file_path) {
+                                         const std::string& directory,
+                                         std::string_view key) {
   ZipStat zip_stat = CF_EXPECT(inner.Stat());
   size_t size = CF_EXPECT(std::move(zip_stat.size));
 
   std::unique_ptr<ReaderSeeker> reader =
       CF_EXPECT(ZipSourceAsReaderSeeker(std::move(inner)));
 
-  LazilyLoadedFile file = CF_EXPECT(
-      LazilyLoadedFile::Create(std::move(file_path), size, std::move(reader)));
-
-  CachedZipSourceCallbacks callbacks(std::move(file), size);
+  std::unique_ptr<ReaderSeeker> cached =
+      CF_EXPECT(BlockCache(std::move(reader), size, directory, key));
 
-  std::unique_ptr<SeekableZipSourceCallback> callbacks_ptr =
-      std::make_unique<CachedZipSourceCallbacks>(std::move(callbacks));
+  std::unique_ptr<SeekableZipSourceCallback> callbacks =
+      std::make_unique<CachedZipSourceCallbacks>(std::move(cached), size);
 
-  return CF_EXPECT(SeekableZipSource::FromCallbacks(std::move(callbacks_ptr)));
+  return CF_EXPECT(SeekableZipSource::FromCallbacks(std::move(callbacks)));
 }
 
 }  // namespace cuttlefish
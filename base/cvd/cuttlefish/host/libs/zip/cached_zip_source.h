@@ -16,13 +16,17 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 
 #include "cuttlefish/host/libs/zip/libzip_cc/seekable_source.h"
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
 
+/* Caches reads from `inner` as blocks under `directory`. `key` must identify
+ * the contents of `inner`, see `BlockCache`. */
 Result<SeekableZipSource> CacheZipSource(SeekableZipSource inner,
-                                         std::string file_path);
+                                         const std::string& directory,
+                                         std::string_view key);
 
 }  // namespace cuttlefish
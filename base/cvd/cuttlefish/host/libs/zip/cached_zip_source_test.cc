@@ -38,7 +38,7 @@ TEST(CachedZipSourceTest, DataInCache) {
   ASSERT_THAT(inner, IsOk());
 
   Result<SeekableZipSource> cached =
-      CacheZipSource(std::move(*inner), "temp_file");
+      CacheZipSource(std::move(*inner), testing::TempDir(), "temp_file");
   ASSERT_THAT(cached, IsOk());
 
   Result<std::string> data_out = ReadToString(*cached);
@@ -146,6 +146,32 @@ Result<uint32_t> ReadableZip::FileAttributes(std::string_view path) const {
   return mode;
 }
 
+Result<ZipStat> ReadableZip::FileStat(std::string_view path) const {
+  zip_t* raw_zip = CF_EXPECT(raw_.get());
+
+  // Stat through the archive rather than through `GetFile`, as the
+  // decompressing source layer reports the uncompressed size for both sizes.
+  zip_stat_t raw_stat;
+  zip_stat_init(&raw_stat);
+  CF_EXPECT_EQ(zip_stat(raw_zip, std::string(path).c_str(), 0, &raw_stat), 0,
+               ZipErrorString(raw_zip));
+
+  ZipStat ret;
+  if (raw_stat.valid & ZIP_STAT_NAME) {
+    ret.name = std::string(raw_stat.name);
+  }
+  if (raw_stat.valid & ZIP_STAT_INDEX) {
+    ret.index = raw_stat.index;
+  }
+  if (raw_stat.valid & ZIP_STAT_SIZE) {
+    ret.size = raw_stat.size;
+  }
+  if (raw_stat.valid & ZIP_STAT_COMP_SIZE) {
+    ret.compressed_size = raw_stat.comp_size;
+  }
+  return ret;
+}
+
 ReadableZip::ReadableZip(ManagedZip raw, WritableZipSource source)
     : raw_(std::move(raw)), source_(std::move(source)) {}
 
@@ -25,6 +25,7 @@
 #include "cuttlefish/host/libs/zip/libzip_cc/managed.h"
 #include "cuttlefish/host/libs/zip/libzip_cc/readable_source.h"
 #include "cuttlefish/host/libs/zip/libzip_cc/seekable_source.h"
+#include "cuttlefish/host/libs/zip/libzip_cc/stat.h"
 #include "cuttlefish/host/libs/zip/libzip_cc/writable_source.h"
 #include "cuttlefish/io/filesystem.h"
 #include "cuttlefish/io/io.h"
@@ -58,6 +59,9 @@ class ReadableZip : public ReadFilesystem {
 
   Result<uint32_t> FileAttributes(std::string_view path) const override;
 
+  /* Size and compression information for a member, without decompressing. */
+  Result<ZipStat> FileStat(std::string_view path) const;
+
  protected:
   ReadableZip(ManagedZip, WritableZipSource);
 
@@ -0,0 +1,138 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/host/libs/zip/parallel_extract.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/log/log.h"
+
+#include "cuttlefish/host/libs/zip/libzip_cc/archive.h"
+#include "cuttlefish/host/libs/zip/libzip_cc/stat.h"
+#include "cuttlefish/host/libs/zip/zip_file.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+namespace {
+
+class ExtractionQueue {
+ public:
+  ExtractionQueue(const std::vector<ZipExtraction>& extractions,
+                  std::vector<uint64_t> sizes, std::vector<size_t> order)
+      : extractions_(extractions),
+        sizes_(std::move(sizes)),
+        order_(std::move(order)),
+        results_(extractions.size()) {}
+
+  Result<void> Work(ReadableZip& zip) {
+    while (!failed_) {
+      size_t next = next_.fetch_add(1);
+      if (next >= order_.size()) {
+        return {};
+      }
+      const ZipExtraction& extraction = extractions_[order_[next]];
+      auto start = std::chrono::steady_clock::now();
+      Result<void> res =
+          ExtractFile(zip, extraction.zip_path, extraction.host_path);
+      if (!res.ok()) {
+        failed_ = true;
+      }
+      CF_EXPECTF(std::move(res), "Failed to extract '{}' to '{}'",
+                 extraction.zip_path, extraction.host_path);
+      auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - start);
+      VLOG(1) << "Extracted '" << extraction.zip_path << "' in "
+              << duration.count() << " ms";
+      // Every index is written by exactly one worker.
+      results_[order_[next]] = ZipExtractionResult{
+          .zip_path = extraction.zip_path,
+          .host_path = extraction.host_path,
+          .size = sizes_[order_[next]],
+          .duration = duration,
+      };
+    }
+    return {};
+  }
+
+  std::vector<ZipExtractionResult> TakeResults() { return std::move(results_); }
+
+ private:
+  const std::vector<ZipExtraction>& extractions_;
+  const std::vector<uint64_t> sizes_;
+  const std::vector<size_t> order_;
+  std::vector<ZipExtractionResult> results_;
+  std::atomic<size_t> next_ = 0;
+  std::atomic_bool failed_ = false;
+};
+
+}  // namespace
+
+Result<std::vector<ZipExtractionResult>> ExtractFilesParallel(
+    ReadableZip& zip, const ZipOpener& open_more,
+    const std::vector<ZipExtraction>& extractions, size_t num_workers) {
+  if (extractions.empty()) {
+    return {};
+  }
+  if (!open_more) {
+    num_workers = 1;
+  } else if (num_workers == 0) {
+    num_workers = std::max(1u, std::thread::hardware_concurrency());
+  }
+  num_workers = std::min(num_workers, extractions.size());
+
+  std::vector<uint64_t> sizes;
+  for (const ZipExtraction& extraction : extractions) {
+    Result<ZipStat> stat = zip.FileStat(extraction.zip_path);
+    sizes.emplace_back(stat.ok() ? stat->size.value_or(0) : 0);
+  }
+  std::vector<size_t> order(extractions.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&sizes](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+  ExtractionQueue queue(extractions, std::move(sizes), std::move(order));
+
+  std::vector<Result<void>> worker_results(num_workers);
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < num_workers; i++) {
+    workers.emplace_back([&open_more, &queue, &result = worker_results[i]]() {
+      result = [&open_more, &queue]() -> Result<void> {
+        ReadableZip worker_zip = CF_EXPECT(open_more());
+        CF_EXPECT(queue.Work(worker_zip));
+        return {};
+      }();
+    });
+  }
+  worker_results[0] = queue.Work(zip);
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+
+  for (Result<void>& worker_result : worker_results) {
+    CF_EXPECT(std::move(worker_result));
+  }
+  return queue.TakeResults();
+}
+
+}  // namespace cuttlefish
@@ -0,0 +1,59 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "cuttlefish/host/libs/zip/libzip_cc/archive.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+
+struct ZipExtraction {
+  std::string zip_path;
+  std::string host_path;
+};
+
+struct ZipExtractionResult {
+  std::string zip_path;
+  std::string host_path;
+  uint64_t size;
+  std::chrono::milliseconds duration;
+};
+
+/* Produces a new, independent instance of the same archive. */
+using ZipOpener = std::function<Result<ReadableZip>()>;
+
+/* Extracts members from an archive with up to `num_workers` threads. A libzip
+ * archive is not safe to read from multiple threads, so `zip` is only read by
+ * the calling thread and every other worker calls `open_more` for its own
+ * instance. Without `open_more`, such as when every instance would be another
+ * reader of a remote file, the calling thread extracts all the members. Larger
+ * members are started first to keep the workers busy until the end.
+ *
+ * Results are returned in the same order as `extractions`. A `num_workers` of
+ * zero uses one worker per CPU. */
+Result<std::vector<ZipExtractionResult>> ExtractFilesParallel(
+    ReadableZip& zip, const ZipOpener& open_more,
+    const std::vector<ZipExtraction>& extractions, size_t num_workers);
+
+}  // namespace cuttlefish
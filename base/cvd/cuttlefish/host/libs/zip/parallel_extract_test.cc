@@ -0,0 +1,188 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/host/libs/zip/parallel_extract.h"
+
+#include <stddef.h>
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "android-base/file.h"
+#include "fmt/format.h"
+#include "gmock/gmock-matchers.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/host/libs/zip/libzip_cc/archive.h"
+#include "cuttlefish/host/libs/zip/libzip_cc/writable_source.h"
+#include "cuttlefish/host/libs/zip/zip_string.h"
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+Result<std::string> ZipContents(
+    const std::map<std::string, std::string>& contents) {
+  std::string data(4096, '\0');
+
+  WritableZipSource source =
+      CF_EXPECT(WritableZipSource::BorrowData(data.data(), data.size()));
+  WritableZip zip = CF_EXPECT(WritableZip::FromSource(std::move(source)));
+
+  for (const auto& [path, member_data] : contents) {
+    CF_EXPECT(AddStringAt(zip, member_data, path));
+  }
+
+  source = CF_EXPECT(WritableZipSource::FromZip(std::move(zip)));
+
+  return CF_EXPECT(ReadToString(source));
+}
+
+class ParallelExtractTest : public testing::TestWithParam<size_t> {};
+
+TEST_P(ParallelExtractTest, ExtractsAllMembers) {
+  std::map<std::string, std::string> contents;
+  for (size_t i = 0; i < 16; i++) {
+    contents[fmt::format("member_{}", i)] = std::string(i * 1000, 'a' + i);
+  }
+  Result<std::string> zip_data = ZipContents(contents);
+  ASSERT_THAT(zip_data, IsOk());
+
+  ZipOpener open_zip = [&zip_data]() -> Result<ReadableZip> {
+    WritableZipSource source = CF_EXPECT(
+        WritableZipSource::BorrowData(zip_data->data(), zip_data->size()));
+    return CF_EXPECT(ReadableZip::FromSource(std::move(source)));
+  };
+
+  const std::string dir = testing::TempDir();
+  std::vector<ZipExtraction> extractions;
+  for (const auto& [name, _] : contents) {
+    extractions.emplace_back(ZipExtraction{
+        .zip_path = name,
+        .host_path = fmt::format("{}/{}_{}", dir, GetParam(), name),
+    });
+  }
+
+  Result<ReadableZip> zip = open_zip();
+  ASSERT_THAT(zip, IsOk());
+  Result<std::vector<ZipExtractionResult>> results =
+      ExtractFilesParallel(*zip, open_zip, extractions, GetParam());
+  ASSERT_THAT(results, IsOk());
+  ASSERT_EQ(results->size(), extractions.size());
+
+  for (size_t i = 0; i < extractions.size(); i++) {
+    const ZipExtractionResult& result = (*results)[i];
+    EXPECT_EQ(result.zip_path, extractions[i].zip_path);
+    EXPECT_EQ(result.host_path, extractions[i].host_path);
+    EXPECT_EQ(result.size, contents[result.zip_path].size());
+
+    std::string extracted;
+    ASSERT_TRUE(android::base::ReadFileToString(result.host_path, &extracted));
+    EXPECT_EQ(extracted, contents[result.zip_path]);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(WorkerCounts, ParallelExtractTest,
+                         testing::Values(0, 1, 4, 64));
+
+TEST(ParallelExtractOpenerTest, OpensOneArchivePerAdditionalWorker) {
+  std::map<std::string, std::string> contents;
+  for (size_t i = 0; i < 8; i++) {
+    contents[fmt::format("member_{}", i)] = std::string(1000, 'a' + i);
+  }
+  Result<std::string> zip_data = ZipContents(contents);
+  ASSERT_THAT(zip_data, IsOk());
+
+  std::atomic<size_t> opened = 0;
+  ZipOpener open_zip = [&zip_data, &opened]() -> Result<ReadableZip> {
+    opened++;
+    WritableZipSource source = CF_EXPECT(
+        WritableZipSource::BorrowData(zip_data->data(), zip_data->size()));
+    return CF_EXPECT(ReadableZip::FromSource(std::move(source)));
+  };
+  Result<ReadableZip> zip = open_zip();
+  ASSERT_THAT(zip, IsOk());
+  opened = 0;
+
+  std::vector<ZipExtraction> extractions;
+  for (const auto& [name, _] : contents) {
+    extractions.emplace_back(ZipExtraction{
+        .zip_path = name,
+        .host_path = fmt::format("{}/opener_{}", testing::TempDir(), name),
+    });
+  }
+
+  EXPECT_THAT(ExtractFilesParallel(*zip, open_zip, extractions, 4), IsOk());
+  EXPECT_EQ(opened, 3);
+}
+
+TEST(ParallelExtractOpenerTest, WithoutOpenerUsesTheGivenArchive) {
+  std::map<std::string, std::string> contents;
+  for (size_t i = 0; i < 8; i++) {
+    contents[fmt::format("member_{}", i)] = std::string(1000, 'a' + i);
+  }
+  Result<std::string> zip_data = ZipContents(contents);
+  ASSERT_THAT(zip_data, IsOk());
+  Result<WritableZipSource> source =
+      WritableZipSource::BorrowData(zip_data->data(), zip_data->size());
+  ASSERT_THAT(source, IsOk());
+  Result<ReadableZip> zip = ReadableZip::FromSource(std::move(*source));
+  ASSERT_THAT(zip, IsOk());
+
+  std::vector<ZipExtraction> extractions;
+  for (const auto& [name, _] : contents) {
+    extractions.emplace_back(ZipExtraction{
+        .zip_path = name,
+        .host_path = fmt::format("{}/no_opener_{}", testing::TempDir(), name),
+    });
+  }
+
+  Result<std::vector<ZipExtractionResult>> results =
+      ExtractFilesParallel(*zip, ZipOpener(), extractions, 4);
+  ASSERT_THAT(results, IsOk());
+  ASSERT_EQ(results->size(), extractions.size());
+  for (const ZipExtractionResult& result : *results) {
+    std::string extracted;
+    ASSERT_TRUE(android::base::ReadFileToString(result.host_path, &extracted));
+    EXPECT_EQ(extracted, contents[result.zip_path]);
+  }
+}
+
+TEST(ParallelExtractErrorTest, MissingMemberFails) {
+  Result<std::string> zip_data = ZipContents({{"present", "data"}});
+  ASSERT_THAT(zip_data, IsOk());
+
+  ZipOpener open_zip = [&zip_data]() -> Result<ReadableZip> {
+    WritableZipSource source = CF_EXPECT(
+        WritableZipSource::BorrowData(zip_data->data(), zip_data->size()));
+    return CF_EXPECT(ReadableZip::FromSource(std::move(source)));
+  };
+
+  std::vector<ZipExtraction> extractions = {
+      {.zip_path = "absent",
+       .host_path = testing::TempDir() + "/parallel_extract_absent"},
+  };
+
+  Result<ReadableZip> zip = open_zip();
+  ASSERT_THAT(zip, IsOk());
+  EXPECT_THAT(ExtractFilesParallel(*zip, open_zip, extractions, 2), IsError());
+}
+
+}  // namespace
+}  // namespace cuttlefish
@@ -16,10 +16,18 @@
 #include "cuttlefish/host/libs/zip/remote_zip.h"
 
 #include <errno.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <utility>
@@ -38,6 +46,159 @@
 namespace cuttlefish {
 namespace {
 
+// Once a reader is sequential, ranges ahead of it are fetched starting at this
+// size, doubling up to `kMaxPrefetchChunkSize` while it stays sequential. Small
+// members are not over-fetched, and the first read of a member only waits for
+// a small range.
+constexpr uint64_t kMinPrefetchChunkSize = 1 << 16;
+constexpr uint64_t kMaxPrefetchChunkSize = 1 << 22;
+// Number of chunks requested concurrently ahead of a sequential reader.
+constexpr uint64_t kPrefetchChunks = 4;
+
+// The end of central directory record, and the zip64 records it can refer to.
+constexpr std::string_view kEndOfCentralDirectorySignature = "PK\x05\x06";
+constexpr uint64_t kEndOfCentralDirectorySize = 22;
+constexpr uint64_t kMaxArchiveCommentSize = 0xffff;
+constexpr uint32_t kZip64LocatorSignature = 0x07064b50;
+constexpr uint64_t kZip64LocatorSize = 20;
+constexpr uint32_t kZip64EndOfCentralDirectorySignature = 0x06064b50;
+constexpr uint64_t kZip64EndOfCentralDirectorySize = 56;
+constexpr uint32_t kCentralDirectoryHeaderSignature = 0x02014b50;
+constexpr uint64_t kCentralDirectoryHeaderSize = 46;
+constexpr uint16_t kZip64ExtraFieldId = 0x0001;
+constexpr uint32_t kZip64Marker = 0xffffffff;
+
+Result<std::string> FetchRange(HttpClient& http_client, const std::string& url,
+                               std::vector<std::string> headers,
+                               uint64_t start, uint64_t length) {
+  std::string data;
+  data.reserve(length);
+  auto cb = [&data, length](char* http_data, size_t http_len) -> bool {
+    if (http_data == nullptr) {
+      data.clear();
+      return true;
+    }
+    if (http_len + data.size() > length) {
+      return false;
+    }
+    data.append(http_data, http_len);
+    return true;
+  };
+  headers.push_back(
+      fmt::format("Range: bytes={}-{}", start, start + length - 1));
+  VLOG(1) << "Requesting " << headers.back();
+  HttpRequest request = {
+      .method = HttpMethod::kGet,
+      .url = url,
+      .headers = std::move(headers),
+  };
+  HttpResponse<void> res =
+      CF_EXPECT(http_client.DownloadToCallback(request, cb));
+  CF_EXPECTF(res.HttpSuccess(), "HTTP code: {}", res.http_code);
+  CF_EXPECT_EQ(data.size(), length);
+  return data;
+}
+
+uint64_t LittleEndian(std::string_view data, size_t offset, size_t width) {
+  uint64_t value = 0;
+  for (size_t i = width; i > 0; i--) {
+    value = (value << 8) | static_cast<uint8_t>(data[offset + i - 1]);
+  }
+  return value;
+}
+
+// Returns the offset of the local header of the central directory entry at
+// `entry` of `central_directory`.
+Result<uint64_t> LocalHeaderOffset(std::string_view central_directory,
+                                   size_t entry) {
+  uint64_t offset = LittleEndian(central_directory, entry + 42, 4);
+  if (offset != kZip64Marker) {
+    return offset;
+  }
+  uint64_t name_size = LittleEndian(central_directory, entry + 28, 2);
+  uint64_t extra_size = LittleEndian(central_directory, entry + 30, 2);
+  uint64_t extra = entry + kCentralDirectoryHeaderSize + name_size;
+  uint64_t extra_end = extra + extra_size;
+  CF_EXPECT_LE(extra_end, central_directory.size());
+  while (extra + 4 <= extra_end) {
+    uint64_t id = LittleEndian(central_directory, extra, 2);
+    uint64_t field_end =
+        extra + 4 + LittleEndian(central_directory, extra + 2, 2);
+    if (id == kZip64ExtraFieldId) {
+      // The 64-bit values are only present for the fields that overflowed.
+      uint64_t field = extra + 4;
+      if (LittleEndian(central_directory, entry + 24, 4) == kZip64Marker) {
+        field += 8;
+      }
+      if (LittleEndian(central_directory, entry + 20, 4) == kZip64Marker) {
+        field += 8;
+      }
+      CF_EXPECT_LE(field + 8, std::min(field_end, extra_end));
+      return LittleEndian(central_directory, field, 8);
+    }
+    extra = field_end;
+  }
+  return CF_ERR("No zip64 extra field for an entry at " << entry);
+}
+
+/* Returns the sorted offsets where the members of the archive start, and where
+ * the central directory starts, which is where the last member ends. */
+Result<std::vector<uint64_t>> MemberBoundaries(
+    HttpClient& http_client, const std::string& url,
+    const std::vector<std::string>& headers, uint64_t size) {
+  uint64_t tail_size =
+      std::min(size, kZip64LocatorSize + kEndOfCentralDirectorySize +
+                         kMaxArchiveCommentSize);
+  CF_EXPECT_GE(tail_size, kEndOfCentralDirectorySize);
+  uint64_t tail_start = size - tail_size;
+  std::string tail = CF_EXPECT(
+      FetchRange(http_client, url, headers, tail_start, tail_size));
+
+  size_t end = tail.rfind(kEndOfCentralDirectorySignature,
+                          tail.size() - kEndOfCentralDirectorySize);
+  CF_EXPECT(end != std::string::npos, "No end of central directory record");
+  uint64_t directory_size = LittleEndian(tail, end + 12, 4);
+  uint64_t directory_start = LittleEndian(tail, end + 16, 4);
+  if (directory_size == kZip64Marker || directory_start == kZip64Marker) {
+    CF_EXPECT_GE(end, kZip64LocatorSize);
+    size_t locator = end - kZip64LocatorSize;
+    CF_EXPECT_EQ(LittleEndian(tail, locator, 4), kZip64LocatorSignature);
+    uint64_t record_start = LittleEndian(tail, locator + 8, 8);
+    CF_EXPECT_LE(record_start + kZip64EndOfCentralDirectorySize, size);
+    std::string record =
+        CF_EXPECT(FetchRange(http_client, url, headers, record_start,
+                             kZip64EndOfCentralDirectorySize));
+    CF_EXPECT_EQ(LittleEndian(record, 0, 4),
+                 kZip64EndOfCentralDirectorySignature);
+    directory_size = LittleEndian(record, 40, 8);
+    directory_start = LittleEndian(record, 48, 8);
+  }
+  CF_EXPECT_LE(directory_start, size);
+  CF_EXPECT_LE(directory_size, size - directory_start);
+
+  std::string directory;
+  if (directory_start >= tail_start) {
+    directory = tail.substr(directory_start - tail_start, directory_size);
+  } else if (directory_size > 0) {
+    directory = CF_EXPECT(FetchRange(http_client, url, headers,
+                                     directory_start, directory_size));
+  }
+
+  std::vector<uint64_t> boundaries = {directory_start};
+  size_t entry = 0;
+  while (entry + kCentralDirectoryHeaderSize <= directory.size()) {
+    CF_EXPECT_EQ(LittleEndian(directory, entry, 4),
+                 kCentralDirectoryHeaderSignature);
+    boundaries.push_back(CF_EXPECT(LocalHeaderOffset(directory, entry)));
+    entry += kCentralDirectoryHeaderSize +
+             LittleEndian(directory, entry + 28, 2) +
+             LittleEndian(directory, entry + 30, 2) +
+             LittleEndian(directory, entry + 32, 2);
+  }
+  std::sort(boundaries.begin(), boundaries.end());
+  return boundaries;
+}
+
 class RemoteZip : public SeekableZipSourceCallback {
  public:
   RemoteZip(HttpClient& http_client, std::string url, uint64_t size,
@@ -53,44 +214,57 @@ class RemoteZip : public SeekableZipSourceCallback {
     return true;
   }
   int64_t Read(char* zip_data, uint64_t zip_len) override {
+    zip_len = std::min(zip_len, size_ - std::min(offset_, size_));
+    if (zip_len == 0) {
+      return 0;
+    }
+    // libzip reads members in small pieces. Once two reads in a row are
+    // contiguous, switch to fetching growing chunks with several requests in
+    // flight, so throughput is not bound by the round trip time.
+    if (offset_ == last_read_end_) {
+      SchedulePrefetch();
+    } else {
+      next_chunk_size_ = kMinPrefetchChunkSize;
+    }
     uint64_t already_read = 0;
-
-    auto cb = [&already_read, &zip_data, &zip_len](char* http_data,
-                                                   size_t http_len) -> bool {
-      if (http_data == nullptr) {
-        already_read = 0;
-        return true;
+    while (already_read < zip_len) {
+      uint64_t position = offset_ + already_read;
+      auto it = chunks_.upper_bound(position);
+      if (it == chunks_.begin()) {
+        break;
       }
-      if (http_len + already_read > zip_len) {
-        return false;
+      it--;
+      uint64_t chunk_offset = position - it->first;
+      if (chunk_offset >= it->second.length) {
+        break;
       }
-      memcpy(zip_data + already_read, http_data, http_len);
-      already_read += http_len;
-      return true;
-    };
-    std::vector<std::string> headers = headers_;
-    headers.push_back(
-        fmt::format("Range: bytes={}-{}", offset_, offset_ + zip_len - 1));
-    VLOG(1) << "Requesting " << headers.back();
-    HttpRequest request = {
-        .method = HttpMethod::kGet,
-        .url = url_,
-        .headers = headers,
-    };
-    Result<HttpResponse<void>> res =
-        http_client_.DownloadToCallback(request, cb);
-    if (!res.ok() || !res->HttpSuccess() || already_read != zip_len) {
+      const Result<std::string>& chunk_data = it->second.data.get();
+      if (!chunk_data.ok()) {
+        LOG(ERROR) << chunk_data.error();
+        chunks_.erase(it);
+        break;
+      }
+      uint64_t length =
+          std::min(zip_len - already_read, chunk_data->size() - chunk_offset);
+      memcpy(zip_data + already_read, chunk_data->data() + chunk_offset,
+             length);
+      already_read += length;
+    }
+    if (already_read < zip_len) {
+      Result<std::string> res =
+          FetchRange(http_client_, url_, headers_, offset_ + already_read,
+                     zip_len - already_read);
       if (!res.ok()) {
         LOG(ERROR) << res.error();
-      } else if (!res->HttpSuccess()) {
-        LOG(ERROR) << "HTTP code: " << res->http_code;
-      } else {
-        LOG(ERROR) << already_read << " != " << zip_len;
+        errno = EIO;
+        return -1;
       }
-      errno = EIO;
-      return -1;
+      memcpy(zip_data + already_read, res->data(), res->size());
+      already_read += res->size();
     }
     offset_ += already_read;
+    last_read_end_ = offset_;
+    DropChunksBefore(offset_);
     return already_read;
   }
   bool SetOffset(int64_t offset) override {
@@ -101,11 +275,86 @@ class RemoteZip : public SeekableZipSourceCallback {
   uint64_t Size() override { return size_; }
 
  private:
+  struct Chunk {
+    uint64_t length;
+    std::shared_future<Result<std::string>> data;
+  };
+
+  // Requests the next `kPrefetchChunks` chunks from `offset_` that are not
+  // already in flight, without going past the end of the current member.
+  void SchedulePrefetch() {
+    uint64_t end = MemberEnd(offset_);
+    uint64_t start = offset_;
+    for (uint64_t i = 0; i < kPrefetchChunks && start < end; i++) {
+      auto next = chunks_.upper_bound(start);
+      if (next != chunks_.begin()) {
+        const auto& [previous_start, previous] = *std::prev(next);
+        if (start < previous_start + previous.length) {
+          start = previous_start + previous.length;
+          continue;
+        }
+      }
+      uint64_t length = std::min(next_chunk_size_, end - start);
+      if (next != chunks_.end()) {
+        length = std::min(length, next->first - start);
+      }
+      chunks_[start] = Chunk{
+          .length = length,
+          .data = std::async(std::launch::async, FetchRange,
+                             std::ref(http_client_), url_, headers_, start,
+                             length)
+                      .share(),
+      };
+      next_chunk_size_ = std::min(next_chunk_size_ * 2, kMaxPrefetchChunkSize);
+      start += length;
+    }
+  }
+
+  // Returns where the member containing `position` ends, or the end of the
+  // archive when the central directory can't be read.
+  uint64_t MemberEnd(uint64_t position) {
+    if (!member_boundaries_) {
+      Result<std::vector<uint64_t>> boundaries =
+          MemberBoundaries(http_client_, url_, headers_, size_);
+      if (!boundaries.ok()) {
+        LOG(WARNING) << "Prefetching without member bounds: "
+                     << boundaries.error();
+      }
+      member_boundaries_ =
+          boundaries.ok() ? std::move(*boundaries) : std::vector<uint64_t>();
+    }
+    auto it = std::upper_bound(member_boundaries_->begin(),
+                               member_boundaries_->end(), position);
+    return it == member_boundaries_->end() ? size_ : *it;
+  }
+
+  // Destroying the last future of a std::async call waits for the call to
+  // return, so only the chunks whose request is done are dropped. After a
+  // seek past chunks still in flight, those are dropped by a later read.
+  void DropChunksBefore(uint64_t offset) {
+    for (auto it = chunks_.begin();
+         it != chunks_.end() && it->first + it->second.length <= offset;) {
+      if (it->second.data.wait_for(std::chrono::seconds(0)) ==
+          std::future_status::ready) {
+        it = chunks_.erase(it);
+      } else {
+        it++;
+      }
+    }
+  }
+
   HttpClient& http_client_;
   std::string url_;
   uint64_t offset_ = 0;
   uint64_t size_ = 0;
   std::vector<std::string> headers_;
+  std::optional<uint64_t> last_read_end_;
+  uint64_t next_chunk_size_ = kMinPrefetchChunkSize;
+  // Loaded from the central directory on the first sequential read.
+  std::optional<std::vector<uint64_t>> member_boundaries_;
+  // By the offset they start at. Destroying them waits for the requests in
+  // flight to finish.
+  std::map<uint64_t, Chunk> chunks_;
 };
 
 Result<uint64_t> GetSizeIfSupportsRangeRequests(
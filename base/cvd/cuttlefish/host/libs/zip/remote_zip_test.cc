@@ -15,8 +15,11 @@
 
 #include "cuttlefish/host/libs/zip/remote_zip.h"
 
+#include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <string>
@@ -110,6 +113,16 @@ class HttpCallback {
   std::string data_;
 };
 
+std::string Incompressible(size_t size, uint32_t seed) {
+  std::string data(size, '\0');
+  uint32_t state = seed;
+  for (char& c : data) {
+    state = state * 1103515245 + 12345;
+    c = static_cast<char>(state >> 24);
+  }
+  return data;
+}
+
 TEST(RemoteZipTest, TwoFiles) {
   FakeHttpClient http_client;
 
@@ -139,5 +152,71 @@ TEST(RemoteZipTest, TwoFiles) {
   ASSERT_THAT(ReadToString(**file_b), IsOkAndValue("def"));
 }
 
+TEST(RemoteZipTest, SequentialReadsArePrefetched) {
+  FakeHttpClient http_client;
+
+  // Incompressible, so the member spans several prefetch chunks.
+  std::string large = Incompressible(9 << 20, 1);
+  Result<HttpCallback> callback = HttpCallback::Create({{"large", large}});
+  ASSERT_THAT(callback, IsOk());
+
+  std::atomic<size_t> requests = 0;
+  http_client.SetResponse(
+      [&requests, callback = std::move(*callback)](
+          const HttpRequest& request) mutable -> HttpResponse<std::string> {
+        requests++;
+        return callback(request);
+      });
+
+  Result<SeekableZipSource> source = ZipSourceFromUrl(http_client, "url", {});
+  ASSERT_THAT(source, IsOk());
+  Result<ReadableZip> remote_zip = ReadableZip::FromSource(std::move(*source));
+  ASSERT_THAT(remote_zip, IsOk());
+
+  Result<std::unique_ptr<ReaderSeeker>> file =
+      remote_zip->OpenReadOnly("large");
+  ASSERT_THAT(file, IsOk());
+  ASSERT_NE(file->get(), nullptr);
+  ASSERT_THAT(ReadToString(**file), IsOkAndValue(large));
+
+  // Without prefetching, every small read libzip makes is a request.
+  EXPECT_LT(requests, 16);
+}
+
+TEST(RemoteZipTest, PrefetchStopsAtTheEndOfTheMember) {
+  FakeHttpClient http_client;
+
+  std::string first = Incompressible(3 << 20, 1);
+  std::string second = Incompressible(3 << 20, 2);
+  Result<HttpCallback> callback =
+      HttpCallback::Create({{"a", first}, {"b", second}});
+  ASSERT_THAT(callback, IsOk());
+
+  std::atomic<size_t> bytes_requested = 0;
+  http_client.SetResponse(
+      [&bytes_requested, callback = std::move(*callback)](
+          const HttpRequest& request) mutable -> HttpResponse<std::string> {
+        HttpResponse<std::string> response = callback(request);
+        if (request.method == HttpMethod::kGet) {
+          bytes_requested += response.data.size();
+        }
+        return response;
+      });
+
+  Result<SeekableZipSource> source = ZipSourceFromUrl(http_client, "url", {});
+  ASSERT_THAT(source, IsOk());
+  Result<ReadableZip> remote_zip = ReadableZip::FromSource(std::move(*source));
+  ASSERT_THAT(remote_zip, IsOk());
+
+  Result<std::unique_ptr<ReaderSeeker>> file = remote_zip->OpenReadOnly("a");
+  ASSERT_THAT(file, IsOk());
+  ASSERT_NE(file->get(), nullptr);
+  ASSERT_THAT(ReadToString(**file), IsOkAndValue(first));
+
+  // Reading the central directory costs less than 1 MiB, while prefetching
+  // into "b" would cost more.
+  EXPECT_LT(bytes_requested, first.size() + (1 << 20));
+}
+
 }  // namespace
 }  // namespace cuttlefish
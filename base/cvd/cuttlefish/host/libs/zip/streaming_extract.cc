@@ -0,0 +1,471 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/host/libs/zip/streaming_extract.h"
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "absl/strings/match.h"
+#include "zlib.h"
+
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+
+namespace cuttlefish {
+namespace {
+
+// https://pkware.cachefly.net/webdocs/casestudies/APPNOTE.TXT
+constexpr uint32_t kLocalFileHeaderSignature = 0x04034b50;
+constexpr uint32_t kCentralDirectorySignature = 0x02014b50;
+constexpr uint32_t kDataDescriptorSignature = 0x08074b50;
+constexpr size_t kLocalFileHeaderSize = 30;
+constexpr uint16_t kZip64ExtraFieldId = 0x0001;
+constexpr uint32_t kZip64Marker = 0xffffffff;
+
+constexpr uint16_t kFlagEncrypted = 1 << 0;
+constexpr uint16_t kFlagDataDescriptor = 1 << 3;
+
+constexpr uint16_t kMethodStore = 0;
+constexpr uint16_t kMethodDeflate = 8;
+
+// Bounds the memory used when the download is faster than inflating.
+constexpr size_t kMaxQueuedBytes = 1 << 26;
+constexpr size_t kOutputBufferSize = 1 << 20;
+
+uint16_t ReadLe16(const char* data) {
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+  return bytes[0] | (bytes[1] << 8);
+}
+
+uint32_t ReadLe32(const char* data) {
+  return ReadLe16(data) | (static_cast<uint32_t>(ReadLe16(data + 2)) << 16);
+}
+
+uint64_t ReadLe64(const char* data) {
+  return ReadLe32(data) | (static_cast<uint64_t>(ReadLe32(data + 4)) << 32);
+}
+
+bool IsAllZeroes(const char* data, size_t size) {
+  return size > 0 && data[0] == '\0' && memcmp(data, data + 1, size - 1) == 0;
+}
+
+/* Incremental parser over the archive bytes, in the order they are stored. */
+class LocalHeaderParser {
+ public:
+  explicit LocalHeaderParser(StreamingZipExtractor::Destination destination)
+      : destination_(std::move(destination)),
+        output_buffer_(kOutputBufferSize) {}
+
+  ~LocalHeaderParser() { AbandonMember(); }
+
+  void Append(std::string_view data) {
+    if (state_ == State::kStopped) {
+      return;
+    }
+    buffer_.append(data);
+    while (Step()) {
+    }
+    buffer_.erase(0, position_);
+    position_ = 0;
+  }
+
+  void Restart() {
+    AbandonMember();
+    buffer_.clear();
+    position_ = 0;
+    state_ = State::kHeader;
+    extracted_.clear();
+  }
+
+  std::vector<StreamedZipMember> TakeExtracted() {
+    AbandonMember();
+    return std::move(extracted_);
+  }
+
+ private:
+  enum class State {
+    kHeader,
+    kData,
+    kDescriptor,
+    kStopped,
+  };
+
+  struct Member {
+    std::string name;
+    uint16_t method;
+    uint16_t flags;
+    uint32_t expected_crc;
+    uint64_t compressed_size;
+    uint64_t size;
+    bool zip64;
+    std::optional<std::string> host_path;
+    SharedFD output;
+    uint64_t written = 0;
+    uint32_t crc = crc32(0, nullptr, 0);
+    std::optional<z_stream> inflater;
+    std::chrono::steady_clock::time_point start;
+  };
+
+  std::string_view Available() const {
+    return std::string_view(buffer_).substr(position_);
+  }
+
+  // Returns true while progress is being made on the buffered data.
+  bool Step() {
+    switch (state_) {
+      case State::kHeader:
+        return ParseHeader();
+      case State::kData:
+        return member_->method == kMethodStore ? CopyStored() : Inflate();
+      case State::kDescriptor:
+        return ParseDescriptor();
+      case State::kStopped:
+        return false;
+    }
+    return false;
+  }
+
+  void Stop(std::string_view reason) {
+    if (!reason.empty()) {
+      VLOG(0) << "Stopped streaming zip extraction: " << reason;
+    }
+    AbandonMember();
+    buffer_.clear();
+    position_ = 0;
+    state_ = State::kStopped;
+  }
+
+  void AbandonMember() {
+    if (member_ && member_->inflater) {
+      inflateEnd(&*member_->inflater);
+    }
+    member_.reset();
+  }
+
+  bool ParseHeader() {
+    std::string_view available = Available();
+    if (available.size() < 4) {
+      return false;
+    }
+    uint32_t signature = ReadLe32(available.data());
+    if (signature == kCentralDirectorySignature) {
+      Stop("");  // Reached the end of the file data.
+      return false;
+    } else if (signature != kLocalFileHeaderSignature) {
+      Stop("unexpected signature");
+      return false;
+    }
+    if (available.size() < kLocalFileHeaderSize) {
+      return false;
+    }
+    const char* header = available.data();
+    uint16_t name_length = ReadLe16(header + 26);
+    uint16_t extra_length = ReadLe16(header + 28);
+    size_t header_length = kLocalFileHeaderSize + name_length + extra_length;
+    if (available.size() < header_length) {
+      return false;
+    }
+
+    Member member{
+        .name = std::string(available.substr(kLocalFileHeaderSize, name_length)),
+        .method = ReadLe16(header + 8),
+        .flags = ReadLe16(header + 6),
+        .expected_crc = ReadLe32(header + 14),
+        .compressed_size = ReadLe32(header + 18),
+        .size = ReadLe32(header + 22),
+        .zip64 = false,
+    };
+    std::string_view extra = available.substr(
+        kLocalFileHeaderSize + name_length, extra_length);
+    ParseZip64Extra(extra, member);
+
+    if (member.flags & kFlagEncrypted) {
+      Stop("encrypted member");
+      return false;
+    } else if (member.method == kMethodStore &&
+               (member.flags & kFlagDataDescriptor)) {
+      Stop("stored member with unknown size");
+      return false;
+    } else if (member.method != kMethodStore &&
+               member.method != kMethodDeflate) {
+      Stop("unsupported compression method");
+      return false;
+    }
+
+    if (!absl::EndsWith(member.name, "/")) {
+      member.host_path = destination_(member.name);
+    }
+    if (member.host_path) {
+      member.output = SharedFD::Open(*member.host_path,
+                                     O_CLOEXEC | O_CREAT | O_TRUNC | O_WRONLY,
+                                     0644);
+      if (!member.output->IsOpen()) {
+        Stop(member.output->StrError());
+        return false;
+      }
+    }
+    member.start = std::chrono::steady_clock::now();
+    member_ = std::move(member);
+    if (member_->method == kMethodDeflate) {
+      // zlib keeps a pointer back to the `z_stream`, so it can't be moved after
+      // initialization.
+      z_stream& inflater = member_->inflater.emplace();
+      memset(&inflater, 0, sizeof(z_stream));
+      if (inflateInit2(&inflater, -MAX_WBITS) != Z_OK) {
+        member_->inflater.reset();
+        Stop("inflateInit2 failed");
+        return false;
+      }
+    }
+    position_ += header_length;
+    state_ = State::kData;
+    return true;
+  }
+
+  void ParseZip64Extra(std::string_view extra, Member& member) {
+    while (extra.size() >= 4) {
+      uint16_t id = ReadLe16(extra.data());
+      uint16_t size = ReadLe16(extra.data() + 2);
+      std::string_view field = extra.substr(4, size);
+      extra.remove_prefix(std::min<size_t>(extra.size(), 4 + size));
+      if (id != kZip64ExtraFieldId) {
+        continue;
+      }
+      member.zip64 = true;
+      if (member.size == kZip64Marker && field.size() >= 8) {
+        member.size = ReadLe64(field.data());
+        field.remove_prefix(8);
+      }
+      if (member.compressed_size == kZip64Marker && field.size() >= 8) {
+        member.compressed_size = ReadLe64(field.data());
+      }
+    }
+  }
+
+  bool CopyStored() {
+    std::string_view available = Available();
+    uint64_t remaining = member_->compressed_size - member_->written;
+    size_t length = std::min<uint64_t>(available.size(), remaining);
+    if (length > 0 && !Output(available.data(), length)) {
+      return false;
+    }
+    position_ += length;
+    if (member_->written == member_->compressed_size) {
+      return CompleteData();
+    }
+    return length > 0;
+  }
+
+  bool Inflate() {
+    std::string_view available = Available();
+    if (available.empty()) {
+      return false;
+    }
+    z_stream& inflater = *member_->inflater;
+    // zlib doesn't modify the input, the API predates `const`.
+    inflater.next_in =
+        reinterpret_cast<Bytef*>(const_cast<char*>(available.data()));
+    inflater.avail_in = std::min<size_t>(available.size(), UINT32_MAX);
+    int res;
+    do {
+      inflater.next_out = reinterpret_cast<Bytef*>(output_buffer_.data());
+      inflater.avail_out = output_buffer_.size();
+      res = inflate(&inflater, Z_NO_FLUSH);
+      if (res != Z_OK && res != Z_STREAM_END && res != Z_BUF_ERROR) {
+        Stop(inflater.msg ? inflater.msg : "inflate failed");
+        return false;
+      }
+      size_t produced = output_buffer_.size() - inflater.avail_out;
+      if (produced > 0 && !Output(output_buffer_.data(), produced)) {
+        return false;
+      }
+    } while (res == Z_OK && inflater.avail_out == 0);
+
+    position_ += available.size() - inflater.avail_in;
+    if (res == Z_STREAM_END) {
+      inflateEnd(&inflater);
+      member_->inflater.reset();
+      return CompleteData();
+    }
+    return false;  // Needs more input
+  }
+
+  bool Output(const char* data, size_t size) {
+    member_->crc = crc32(member_->crc, reinterpret_cast<const Bytef*>(data),
+                         size);
+    if (member_->output->IsOpen() && !IsAllZeroes(data, size)) {
+      // Runs of zeroes are skipped over to leave holes in the output.
+      ssize_t written = member_->output->PWrite(data, size, member_->written);
+      if (written != static_cast<ssize_t>(size)) {
+        Stop(member_->output->StrError());
+        return false;
+      }
+    }
+    member_->written += size;
+    return true;
+  }
+
+  bool CompleteData() {
+    if (member_->flags & kFlagDataDescriptor) {
+      state_ = State::kDescriptor;
+    } else {
+      CompleteMember();
+    }
+    return true;
+  }
+
+  bool ParseDescriptor() {
+    std::string_view available = Available();
+    if (available.size() < 4) {
+      return false;
+    }
+    size_t offset =
+        ReadLe32(available.data()) == kDataDescriptorSignature ? 4 : 0;
+    size_t length = offset + (member_->zip64 ? 20 : 12);
+    if (available.size() < length) {
+      return false;
+    }
+    member_->expected_crc = ReadLe32(available.data() + offset);
+    member_->size = member_->zip64 ? ReadLe64(available.data() + offset + 12)
+                                   : ReadLe32(available.data() + offset + 8);
+    position_ += length;
+    CompleteMember();
+    return true;
+  }
+
+  void CompleteMember() {
+    Member& member = *member_;
+    bool matches =
+        member.crc == member.expected_crc && member.written == member.size;
+    if (member.output->IsOpen() && matches) {
+      // Extends the file over trailing zeroes that were skipped.
+      if (member.output->Truncate(member.written) != 0) {
+        LOG(WARNING) << "Failed to set size of '" << *member.host_path
+                     << "': " << member.output->StrError();
+        matches = false;
+      }
+    }
+    if (!matches) {
+      LOG(WARNING) << "Streamed member '" << member.name
+                   << "' doesn't match its checksum or size";
+    } else if (member.host_path) {
+      extracted_.emplace_back(StreamedZipMember{
+          .zip_path = member.name,
+          .host_path = *member.host_path,
+          .size = member.written,
+          .duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::steady_clock::now() - member.start),
+      });
+    }
+    member_.reset();
+    state_ = State::kHeader;
+  }
+
+  StreamingZipExtractor::Destination destination_;
+  std::vector<char> output_buffer_;
+  std::string buffer_;
+  size_t position_ = 0;
+  State state_ = State::kHeader;
+  std::optional<Member> member_;
+  std::vector<StreamedZipMember> extracted_;
+};
+
+}  // namespace
+
+struct StreamingZipExtractor::Impl {
+  explicit Impl(Destination destination) : parser(std::move(destination)) {}
+
+  void Run() {
+    std::unique_lock lock(mutex);
+    while (true) {
+      data_available.wait(lock, [this]() { return !queue.empty() || finished; });
+      if (queue.empty()) {
+        return;
+      }
+      std::optional<std::string> chunk = std::move(queue.front());
+      queue.pop_front();
+      queued_bytes -= chunk ? chunk->size() : 0;
+      space_available.notify_all();
+
+      lock.unlock();
+      if (chunk) {
+        parser.Append(*chunk);
+      } else {
+        parser.Restart();
+      }
+      lock.lock();
+    }
+  }
+
+  LocalHeaderParser parser;
+  std::mutex mutex;
+  std::condition_variable data_available;
+  std::condition_variable space_available;
+  // nullopt entries mark a restart of the download.
+  std::deque<std::optional<std::string>> queue;
+  size_t queued_bytes = 0;
+  bool finished = false;
+  std::thread thread;
+};
+
+StreamingZipExtractor::StreamingZipExtractor(Destination destination)
+    : impl_(std::make_unique<Impl>(std::move(destination))) {
+  impl_->thread = std::thread([impl = impl_.get()]() { impl->Run(); });
+}
+
+StreamingZipExtractor::~StreamingZipExtractor() { Finish(); }
+
+bool StreamingZipExtractor::Append(char* data, size_t size) {
+  std::unique_lock lock(impl_->mutex);
+  impl_->space_available.wait(
+      lock, [this]() { return impl_->queued_bytes < kMaxQueuedBytes; });
+  if (data) {
+    impl_->queue.emplace_back(std::string(data, size));
+    impl_->queued_bytes += size;
+  } else {
+    impl_->queue.emplace_back(std::nullopt);
+  }
+  impl_->data_available.notify_one();
+  return true;
+}
+
+std::vector<StreamedZipMember> StreamingZipExtractor::Finish() {
+  {
+    std::lock_guard lock(impl_->mutex);
+    impl_->finished = true;
+    impl_->data_available.notify_one();
+  }
+  if (impl_->thread.joinable()) {
+    impl_->thread.join();
+  }
+  return impl_->parser.TakeExtracted();
+}
+
+}  // namespace cuttlefish
@@ -0,0 +1,76 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cuttlefish {
+
+struct StreamedZipMember {
+  std::string zip_path;
+  std::string host_path;
+  uint64_t size;
+  std::chrono::milliseconds duration;
+};
+
+/* Extracts members of a zip archive while the archive is still being
+ * downloaded, by following the local file headers in the order they appear.
+ *
+ * This is best-effort: the central directory is not available until the end
+ * of the archive, so members that can't be delimited from their local header
+ * alone (stored members with data descriptors, encrypted members, unknown
+ * compression methods) stop the streaming. Only members that were completely
+ * written with a matching CRC-32 are reported, and the caller is expected to
+ * extract the rest from the complete archive. File attributes are only stored
+ * in the central directory and are also left to the caller.
+ *
+ * Inflating happens on an internal thread, so the download is only slowed
+ * down when more than a bounded amount of data is waiting to be processed. */
+class StreamingZipExtractor {
+ public:
+  /* Returns the host path to write a member to, or nullopt to skip it. Called
+   * from the internal thread. */
+  using Destination =
+      std::function<std::optional<std::string>(std::string_view zip_path)>;
+
+  explicit StreamingZipExtractor(Destination);
+  ~StreamingZipExtractor();
+
+  /* Follows the `HttpClient::DataCallback` protocol, where a null `data`
+   * restarts the download from the beginning. Always returns true, as
+   * failing to stream should not fail the download. */
+  bool Append(char* data, size_t size);
+
+  /* Waits for appended data to be processed and returns the members that were
+   * completely extracted. */
+  std::vector<StreamedZipMember> Finish();
+
+ private:
+  struct Impl;
+
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace cuttlefish
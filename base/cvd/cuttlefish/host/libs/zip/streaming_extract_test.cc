@@ -0,0 +1,159 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/host/libs/zip/streaming_extract.h"
+
+#include <stddef.h>
+
+#include <algorithm>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "android-base/file.h"
+#include "fmt/format.h"
+#include "gmock/gmock-matchers.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/host/libs/zip/libzip_cc/archive.h"
+#include "cuttlefish/host/libs/zip/libzip_cc/writable_source.h"
+#include "cuttlefish/host/libs/zip/zip_string.h"
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+Result<std::string> ZipContents(
+    const std::map<std::string, std::string>& contents) {
+  std::string data(4096, '\0');
+
+  WritableZipSource source =
+      CF_EXPECT(WritableZipSource::BorrowData(data.data(), data.size()));
+  WritableZip zip = CF_EXPECT(WritableZip::FromSource(std::move(source)));
+
+  for (const auto& [path, member_data] : contents) {
+    CF_EXPECT(AddStringAt(zip, member_data, path));
+  }
+
+  source = CF_EXPECT(WritableZipSource::FromZip(std::move(zip)));
+
+  return CF_EXPECT(ReadToString(source));
+}
+
+std::map<std::string, std::string> TestContents() {
+  return {
+      {"empty", ""},
+      {"small", "hello"},
+      {"repetitive", std::string(1 << 20, 'x')},
+      {"zeroes", std::string(1 << 20, '\0') + "tail"},
+      {"dir/nested", "nested data"},
+  };
+}
+
+std::string HostPath(std::string_view prefix, std::string_view zip_path) {
+  std::string flat(zip_path);
+  std::replace(flat.begin(), flat.end(), '/', '_');
+  return fmt::format("{}/{}_{}", testing::TempDir(), prefix, flat);
+}
+
+class StreamingExtractTest : public testing::TestWithParam<size_t> {};
+
+TEST_P(StreamingExtractTest, ExtractsInChunks) {
+  std::map<std::string, std::string> contents = TestContents();
+  Result<std::string> zip_data = ZipContents(contents);
+  ASSERT_THAT(zip_data, IsOk());
+
+  std::string prefix = fmt::format("chunks_{}", GetParam());
+  StreamingZipExtractor extractor(
+      [&prefix](std::string_view zip_path) -> std::optional<std::string> {
+        return HostPath(prefix, zip_path);
+      });
+  ASSERT_TRUE(extractor.Append(nullptr, 0));
+  for (size_t i = 0; i < zip_data->size(); i += GetParam()) {
+    size_t length = std::min(GetParam(), zip_data->size() - i);
+    ASSERT_TRUE(extractor.Append(zip_data->data() + i, length));
+  }
+  std::vector<StreamedZipMember> members = extractor.Finish();
+
+  ASSERT_EQ(members.size(), contents.size());
+  for (const StreamedZipMember& member : members) {
+    EXPECT_EQ(member.host_path, HostPath(prefix, member.zip_path));
+    EXPECT_EQ(member.size, contents[member.zip_path].size());
+
+    std::string extracted;
+    ASSERT_TRUE(android::base::ReadFileToString(member.host_path, &extracted));
+    EXPECT_EQ(extracted, contents[member.zip_path]);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(ChunkSizes, StreamingExtractTest,
+                         testing::Values(1, 7, 4096, 1 << 20));
+
+TEST(StreamingExtractRestartTest, RestartDiscardsPartialData) {
+  std::map<std::string, std::string> contents = TestContents();
+  Result<std::string> zip_data = ZipContents(contents);
+  ASSERT_THAT(zip_data, IsOk());
+
+  StreamingZipExtractor extractor(
+      [](std::string_view zip_path) -> std::optional<std::string> {
+        return HostPath("restart", zip_path);
+      });
+  ASSERT_TRUE(extractor.Append(nullptr, 0));
+  ASSERT_TRUE(extractor.Append(zip_data->data(), zip_data->size() / 2));
+  ASSERT_TRUE(extractor.Append(nullptr, 0));
+  ASSERT_TRUE(extractor.Append(zip_data->data(), zip_data->size()));
+
+  EXPECT_EQ(extractor.Finish().size(), contents.size());
+}
+
+TEST(StreamingExtractSkipTest, SkippedMembersAreNotReported) {
+  std::map<std::string, std::string> contents = TestContents();
+  Result<std::string> zip_data = ZipContents(contents);
+  ASSERT_THAT(zip_data, IsOk());
+
+  StreamingZipExtractor extractor(
+      [](std::string_view zip_path) -> std::optional<std::string> {
+        if (zip_path == "small") {
+          return HostPath("skip", zip_path);
+        }
+        return std::nullopt;
+      });
+  ASSERT_TRUE(extractor.Append(zip_data->data(), zip_data->size()));
+  std::vector<StreamedZipMember> members = extractor.Finish();
+
+  ASSERT_EQ(members.size(), 1);
+  EXPECT_EQ(members[0].zip_path, "small");
+}
+
+TEST(StreamingExtractTruncatedTest, IncompleteMemberIsNotReported) {
+  Result<std::string> zip_data =
+      ZipContents({{"large", std::string(1 << 20, 'y')}});
+  ASSERT_THAT(zip_data, IsOk());
+
+  StreamingZipExtractor extractor(
+      [](std::string_view zip_path) -> std::optional<std::string> {
+        return HostPath("truncated", zip_path);
+      });
+  ASSERT_TRUE(extractor.Append(zip_data->data(), 100));
+
+  EXPECT_TRUE(extractor.Finish().empty());
+}
+
+}  // namespace
+}  // namespace cuttlefish
@@ -16,6 +16,8 @@
 #include "cuttlefish/host/libs/zip/zip_file.h"
 
 #include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <sys/stat.h>
 
@@ -24,17 +26,50 @@
 #include <string_view>
 #include <utility>
 
+#include "absl/log/log.h"
+
+#include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/common/libs/utils/files.h"
 #include "cuttlefish/host/libs/zip/libzip_cc/archive.h"
 #include "cuttlefish/host/libs/zip/libzip_cc/readable_source.h"
+#include "cuttlefish/host/libs/zip/libzip_cc/stat.h"
 #include "cuttlefish/host/libs/zip/libzip_cc/writable_source.h"
 #include "cuttlefish/io/copy.h"
 #include "cuttlefish/io/io.h"
 #include "cuttlefish/io/native_filesystem.h"
+#include "cuttlefish/io/shared_fd.h"
 #include "cuttlefish/posix/strerror.h"
 #include "cuttlefish/result/result.h"
 
 namespace cuttlefish {
+namespace {
+
+// Members that deflate better than this are assumed to be mostly runs of
+// zeroes, which `SparseCopy` leaves as holes rather than allocating.
+constexpr uint64_t kMaxPreallocateCompressionRatio = 8;
+
+// Extractions run on one thread per core, each with its own copy buffer. A
+// multiple of the 4 KiB zero detection blocks keeps holes aligned.
+constexpr size_t kExtractBufferSize = 1 << 20;
+
+/* Reserves the blocks for a member up front, so concurrent extractions don't
+ * interleave small allocations and fragment each other's output files. This is
+ * only an optimization, failures are ignored. */
+void PreallocateForMember(const ReadableZip& zip, std::string_view zip_path,
+                          SharedFD& fd) {
+  Result<ZipStat> stat = zip.FileStat(zip_path);
+  if (!stat.ok() || !stat->size || !stat->compressed_size || *stat->size == 0) {
+    return;
+  }
+  if (*stat->compressed_size * kMaxPreallocateCompressionRatio < *stat->size) {
+    return;
+  }
+  if (fd->Fallocate(FALLOC_FL_KEEP_SIZE, 0, *stat->size) < 0) {
+    VLOG(1) << "Not preallocating '" << zip_path << "': " << fd->StrError();
+  }
+}
+
+}  // namespace
 
 Result<ReadableZip> ZipOpenRead(const std::string& fs_path) {
   return CF_EXPECT(ZipOpenReadWrite(fs_path));
@@ -66,11 +101,22 @@ Result<void> ExtractFile(ReadableZip& zip, std::string_view zip_path,
 
   NativeFilesystem fs;
   (void)fs.DeleteFile(host_path);
-  std::unique_ptr<WriterSeeker> writer = CF_EXPECT(fs.CreateFile(host_path));
-  CF_EXPECT(writer.get());
+  SharedFD fd = SharedFD::Open(host_path,
+                               O_CLOEXEC | O_CREAT | O_EXCL | O_RDWR, 0644);
+  CF_EXPECTF(fd->IsOpen(), "Failed to create '{}': '{}'", host_path,
+             fd->StrError());
+  PreallocateForMember(zip, zip_path, fd);
+  SharedFdIo writer(fd);
 
-  CF_EXPECT(SparseCopy(*reader, *writer));
+  CF_EXPECT(SparseCopy(*reader, writer, kExtractBufferSize));
+
+  CF_EXPECT(ApplyFileAttributes(zip, zip_path, host_path));
+  return {};
+}
 
+Result<void> ApplyFileAttributes(const ReadableZip& zip,
+                                 std::string_view zip_path,
+                                 const std::string& host_path) {
   if (Result<uint32_t> attr = zip.FileAttributes(zip_path); attr.ok()) {
     // The fetcher must occasionally download archives from Android 10 or 11
     // which incorrectly had the file attributes set to 0. To remedy this
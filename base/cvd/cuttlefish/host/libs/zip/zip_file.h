@@ -33,4 +33,10 @@ Result<void> AddFileAt(WritableZip& zip, const std::string& fs_path,
 Result<void> ExtractFile(ReadableZip& zip, std::string_view zip_path,
                          const std::string& host_path);
 
+/* Sets the permissions of an extracted file from the archive's metadata. Does
+ * nothing if the archive doesn't have usable attributes for the member. */
+Result<void> ApplyFileAttributes(const ReadableZip& zip,
+                                 std::string_view zip_path,
+                                 const std::string& host_path);
+
 }  // namespace cuttlefish
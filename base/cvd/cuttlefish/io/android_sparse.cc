@@ -0,0 +1,215 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/io/android_sparse.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <algorithm>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/io/find_shared_fd.h"
+#include "cuttlefish/io/io.h"
+#include "cuttlefish/io/read_exact.h"
+#include "cuttlefish/io/write_exact.h"
+#include "cuttlefish/result/expect.h"
+#include "cuttlefish/result/result_type.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr uint32_t kSparseHeaderMagic = 0xed26ff3a;
+constexpr uint16_t kMajorVersion = 1;
+
+constexpr uint16_t kChunkTypeRaw = 0xcac1;
+constexpr uint16_t kChunkTypeFill = 0xcac2;
+constexpr uint16_t kChunkTypeDontCare = 0xcac3;
+constexpr uint16_t kChunkTypeCrc32 = 0xcac4;
+
+constexpr uint64_t kBufferSize = 1 << 20;
+
+struct SparseHeader {
+  uint32_t magic;
+  uint16_t major_version;
+  uint16_t minor_version;
+  uint16_t file_header_size;
+  uint16_t chunk_header_size;
+  uint32_t block_size;
+  uint32_t total_blocks;
+  uint32_t total_chunks;
+  uint32_t image_checksum;
+};
+static_assert(sizeof(SparseHeader) == 28);
+
+struct ChunkHeader {
+  uint16_t chunk_type;
+  uint16_t reserved;
+  uint32_t chunk_blocks;
+  uint32_t total_size;
+};
+static_assert(sizeof(ChunkHeader) == 12);
+
+class SparseExpander {
+ public:
+  SparseExpander(ReaderSeeker& sparse, WriterSeeker& raw,
+                 std::optional<SharedFD> sparse_fd,
+                 std::optional<SharedFD> raw_fd)
+      : sparse_(sparse),
+        raw_(raw),
+        sparse_fd_(std::move(sparse_fd)),
+        raw_fd_(std::move(raw_fd)) {}
+
+  Result<void> CopyRaw(uint64_t in_offset, uint64_t out_offset,
+                       uint64_t size) {
+    if (sparse_fd_ && raw_fd_) {
+      CF_EXPECT(CopyFileRange(in_offset, out_offset, size));
+      return {};
+    }
+    buffer_.resize(std::min(size, kBufferSize));
+    while (size > 0) {
+      uint64_t to_copy = std::min<uint64_t>(size, buffer_.size());
+      CF_EXPECT(PReadExact(sparse_, buffer_.data(), to_copy, in_offset));
+      CF_EXPECT(PWriteExact(raw_, buffer_.data(), to_copy, out_offset));
+      in_offset += to_copy;
+      out_offset += to_copy;
+      size -= to_copy;
+    }
+    return {};
+  }
+
+  Result<void> Fill(uint32_t value, uint64_t out_offset, uint64_t size) {
+    // The output starts out zeroed.
+    if (value == 0) {
+      return {};
+    }
+    // Block sizes are multiples of 4, so the pattern stays aligned.
+    buffer_.resize(std::min(size, kBufferSize));
+    for (size_t i = 0; i < buffer_.size(); i += sizeof(value)) {
+      memcpy(&buffer_[i], &value, sizeof(value));
+    }
+    while (size > 0) {
+      uint64_t to_write = std::min<uint64_t>(size, buffer_.size());
+      CF_EXPECT(PWriteExact(raw_, buffer_.data(), to_write, out_offset));
+      out_offset += to_write;
+      size -= to_write;
+    }
+    return {};
+  }
+
+ private:
+  Result<void> CopyFileRange(uint64_t in_offset, uint64_t out_offset,
+                             uint64_t size) {
+    off_t in_pos = in_offset;
+    off_t out_pos = out_offset;
+    while (size > 0) {
+      ssize_t copied =
+          (*raw_fd_)->CopyFileRange(**sparse_fd_, &in_pos, &out_pos, size);
+      int error = (*raw_fd_)->GetErrno();
+      if (copied < 0 && (error == EXDEV || error == EINVAL ||
+                         error == ENOSYS || error == EOPNOTSUPP)) {
+        // Not supported between these files, copy through userspace.
+        sparse_fd_.reset();
+        CF_EXPECT(CopyRaw(in_pos, out_pos, size));
+        return {};
+      }
+      CF_EXPECT_GT(copied, 0, "copy_file_range failed: "
+                                  << (*raw_fd_)->StrError());
+      size -= copied;
+    }
+    return {};
+  }
+
+  ReaderSeeker& sparse_;
+  WriterSeeker& raw_;
+  std::optional<SharedFD> sparse_fd_;
+  std::optional<SharedFD> raw_fd_;
+  std::vector<char> buffer_;
+};
+
+}  // namespace
+
+Result<bool> IsAndroidSparse(const ReaderSeeker& reader) {
+  uint32_t magic = 0;
+  uint64_t data_read = CF_EXPECT(reader.PRead(&magic, sizeof(magic), 0));
+  return data_read == sizeof(magic) && magic == kSparseHeaderMagic;
+}
+
+Result<void> ExpandAndroidSparse(ReaderSeeker& sparse, WriterSeeker& raw) {
+  const SparseHeader header =
+      CF_EXPECT(PReadExactBinary<SparseHeader>(sparse, 0));
+  CF_EXPECT_EQ(header.magic, kSparseHeaderMagic, "Not an Android-Sparse image");
+  CF_EXPECT_EQ(header.major_version, kMajorVersion);
+  CF_EXPECT_GE(header.file_header_size, sizeof(SparseHeader));
+  CF_EXPECT_GE(header.chunk_header_size, sizeof(ChunkHeader));
+  CF_EXPECT_GT(header.block_size, 0u);
+  CF_EXPECT_EQ(header.block_size % 4, 0u);
+
+  const uint64_t block_size = header.block_size;
+  CF_EXPECT(raw.Truncate(0));
+  CF_EXPECT(raw.Truncate(block_size * header.total_blocks));
+
+  SparseExpander expander(sparse, raw, CF_EXPECT(FindSharedFd(sparse)),
+                          CF_EXPECT(FindSharedFd(raw)));
+
+  uint64_t in_offset = header.file_header_size;
+  uint64_t block = 0;
+  for (uint32_t i = 0; i < header.total_chunks; i++) {
+    const ChunkHeader chunk =
+        CF_EXPECT(PReadExactBinary<ChunkHeader>(sparse, in_offset));
+    CF_EXPECT_GE(chunk.total_size, header.chunk_header_size);
+    CF_EXPECT_LE(block + chunk.chunk_blocks, header.total_blocks,
+                 "Chunk " << i << " extends past the end of the image");
+
+    const uint64_t data_offset = in_offset + header.chunk_header_size;
+    const uint64_t data_size = chunk.total_size - header.chunk_header_size;
+    const uint64_t out_offset = block * block_size;
+    const uint64_t out_size = chunk.chunk_blocks * block_size;
+    switch (chunk.chunk_type) {
+      case kChunkTypeRaw:
+        CF_EXPECT_EQ(data_size, out_size, "Bad size for RAW chunk " << i);
+        CF_EXPECT(expander.CopyRaw(data_offset, out_offset, out_size));
+        break;
+      case kChunkTypeFill: {
+        CF_EXPECT_EQ(data_size, sizeof(uint32_t),
+                     "Bad size for FILL chunk " << i);
+        uint32_t value =
+            CF_EXPECT(PReadExactBinary<uint32_t>(sparse, data_offset));
+        CF_EXPECT(expander.Fill(value, out_offset, out_size));
+        break;
+      }
+      case kChunkTypeDontCare:
+        break;
+      case kChunkTypeCrc32:
+        // The checksum is optional, and libsparse doesn't verify it either
+        // unless asked to.
+        break;
+      default:
+        return CF_ERRF("Unknown chunk type {:#x} for chunk {}",
+                       chunk.chunk_type, i);
+    }
+    block += chunk.chunk_blocks;
+    in_offset += chunk.total_size;
+  }
+  CF_EXPECT_EQ(block, header.total_blocks, "Chunks don't cover the image");
+  return {};
+}
+
+}  // namespace cuttlefish
@@ -0,0 +1,37 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "cuttlefish/io/io.h"
+#include "cuttlefish/result/result_type.h"
+
+namespace cuttlefish {
+
+// Handles the Android-Sparse image format produced by the Android build.
+//
+// https://android.googlesource.com/platform/system/core/+/refs/heads/main/libsparse/sparse_format.h
+
+Result<bool> IsAndroidSparse(const ReaderSeeker&);
+
+// Writes the raw image described by the Android-Sparse image in `sparse` to
+// `raw`, from offset zero.
+//
+// `raw` is truncated to the expanded size first, so DONT_CARE chunks and
+// zero-filled FILL chunks are left as holes rather than written. When both
+// sides are files, RAW chunks are copied with copy_file_range(2).
+Result<void> ExpandAndroidSparse(ReaderSeeker& sparse, WriterSeeker& raw);
+
+}  // namespace cuttlefish
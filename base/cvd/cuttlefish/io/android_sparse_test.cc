@@ -0,0 +1,129 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/io/android_sparse.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/io/in_memory.h"
+#include "cuttlefish/io/io.h"
+#include "cuttlefish/io/shared_fd.h"
+#include "cuttlefish/io/string.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+constexpr uint32_t kBlockSize = 8;
+
+void AppendLe(std::string& out, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+void AppendChunk(std::string& out, uint16_t type, uint32_t blocks,
+                 const std::string& data) {
+  AppendLe(out, type, 2);
+  AppendLe(out, 0, 2);
+  AppendLe(out, blocks, 4);
+  AppendLe(out, 12 + data.size(), 4);
+  out += data;
+}
+
+// A RAW block, a FILL block, two DONT_CARE blocks, a zero FILL block and a
+// checksum.
+std::string SparseImage() {
+  std::string image;
+  AppendLe(image, 0xed26ff3a, 4);
+  AppendLe(image, 1, 2);
+  AppendLe(image, 0, 2);
+  AppendLe(image, 28, 2);
+  AppendLe(image, 12, 2);
+  AppendLe(image, kBlockSize, 4);
+  AppendLe(image, 5, 4);
+  AppendLe(image, 5, 4);
+  AppendLe(image, 0, 4);
+
+  AppendChunk(image, 0xcac1, 1, "abcdefgh");
+  std::string fill;
+  AppendLe(fill, 0x04030201, 4);
+  AppendChunk(image, 0xcac2, 1, fill);
+  AppendChunk(image, 0xcac3, 2, "");
+  AppendChunk(image, 0xcac2, 1, std::string(4, '\0'));
+  AppendChunk(image, 0xcac4, 0, std::string(4, '\0'));
+  return image;
+}
+
+std::string RawImage() {
+  std::string raw = "abcdefgh";
+  raw += "\x01\x02\x03\x04\x01\x02\x03\x04";
+  raw += std::string(3 * kBlockSize, '\0');
+  return raw;
+}
+
+TEST(AndroidSparseTest, DetectsSparseImages) {
+  EXPECT_THAT(IsAndroidSparse(*InMemoryIo(SparseImage())), IsOkAndValue(true));
+  EXPECT_THAT(IsAndroidSparse(*InMemoryIo(RawImage())), IsOkAndValue(false));
+  EXPECT_THAT(IsAndroidSparse(*InMemoryIo("")), IsOkAndValue(false));
+}
+
+TEST(AndroidSparseTest, ExpandsInMemory) {
+  std::unique_ptr<ReaderWriterSeeker> sparse = InMemoryIo(SparseImage());
+  std::unique_ptr<ReaderWriterSeeker> raw = InMemoryIo("previous contents");
+
+  ASSERT_THAT(ExpandAndroidSparse(*sparse, *raw), IsOk());
+
+  EXPECT_THAT(ReadToString(*raw), IsOkAndValue(RawImage()));
+}
+
+TEST(AndroidSparseTest, ExpandsFiles) {
+  std::string sparse_path = testing::TempDir() + "/android_sparse_in";
+  std::string raw_path = testing::TempDir() + "/android_sparse_out";
+  SharedFD sparse_fd =
+      SharedFD::Open(sparse_path, O_CREAT | O_TRUNC | O_RDWR, 0644);
+  ASSERT_TRUE(sparse_fd->IsOpen()) << sparse_fd->StrError();
+  std::string image = SparseImage();
+  ASSERT_EQ(sparse_fd->Write(image.data(), image.size()), image.size());
+  SharedFD raw_fd = SharedFD::Open(raw_path, O_CREAT | O_TRUNC | O_RDWR, 0644);
+  ASSERT_TRUE(raw_fd->IsOpen()) << raw_fd->StrError();
+
+  SharedFdIo sparse(sparse_fd);
+  SharedFdIo raw(raw_fd);
+  ASSERT_THAT(ExpandAndroidSparse(sparse, raw), IsOk());
+
+  ASSERT_THAT(raw.SeekSet(0), IsOk());
+  EXPECT_THAT(ReadToString(raw), IsOkAndValue(RawImage()));
+}
+
+TEST(AndroidSparseTest, RejectsTruncatedImages) {
+  std::string image = SparseImage();
+  image.resize(image.size() - 20);
+  std::unique_ptr<ReaderWriterSeeker> sparse = InMemoryIo(image);
+  std::unique_ptr<ReaderWriterSeeker> raw = InMemoryIo();
+
+  EXPECT_THAT(ExpandAndroidSparse(*sparse, *raw), IsError());
+}
+
+}  // namespace
+}  // namespace cuttlefish
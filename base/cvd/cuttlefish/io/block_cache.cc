@@ -0,0 +1,240 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/io/block_cache.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/types.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "absl/log/log.h"
+#include "fmt/format.h"
+
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/common/libs/utils/files.h"
+#include "cuttlefish/io/fake_seek.h"
+#include "cuttlefish/io/io.h"
+#include "cuttlefish/io/read_exact.h"
+#include "cuttlefish/io/shared_fd.h"
+#include "cuttlefish/io/write_exact.h"
+#include "cuttlefish/result/result.h"
+
+namespace cuttlefish {
+namespace {
+
+// Missing blocks after a read are fetched along with it, up to this many
+// blocks in total. This trades some bandwidth for fewer round trips.
+constexpr uint64_t kMinFetchBlocks = 16;
+
+constexpr char kPresent = 1;
+
+Result<SharedFD> OpenCacheFile(const std::string& path) {
+  SharedFD fd = SharedFD::Open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  CF_EXPECTF(fd->IsOpen(), "Failed to open '{}': {}", path, fd->StrError());
+  return fd;
+}
+
+// Files of other sizes are left over from a different upstream under the
+// same key, or damaged, and start over empty.
+Result<void> PrepareCacheFiles(const SharedFD& blocks, const SharedFD& present,
+                               uint64_t size, uint64_t num_blocks) {
+  const off_t blocks_size = blocks->LSeek(0, SEEK_END);
+  CF_EXPECT(blocks_size >= 0, blocks->StrError());
+  const off_t present_size = present->LSeek(0, SEEK_END);
+  CF_EXPECT(present_size >= 0, present->StrError());
+  if (static_cast<uint64_t>(blocks_size) == size &&
+      static_cast<uint64_t>(present_size) == num_blocks) {
+    return {};
+  }
+  CF_EXPECT(present->Truncate(0) == 0, present->StrError());
+  CF_EXPECT(blocks->Truncate(0) == 0, blocks->StrError());
+  CF_EXPECT(blocks->Truncate(size) == 0, blocks->StrError());
+  CF_EXPECT(present->Truncate(num_blocks) == 0, present->StrError());
+  return {};
+}
+
+class BlockCacheReader : public ReaderFakeSeeker {
+ public:
+  BlockCacheReader(std::unique_ptr<ReaderSeeker> upstream, uint64_t size,
+                   uint64_t block_size, std::string blocks_dir,
+                   SharedFD blocks, SharedFD present)
+      : ReaderFakeSeeker(size),
+        upstream_(std::move(upstream)),
+        size_(size),
+        block_size_(block_size),
+        num_blocks_((size + block_size - 1) / block_size),
+        blocks_dir_(std::move(blocks_dir)),
+        blocks_(std::make_unique<SharedFdIo>(std::move(blocks))),
+        present_(std::make_unique<SharedFdIo>(std::move(present))),
+        known_present_(num_blocks_) {}
+
+  // No state is shared between reads other than the cache files and what is
+  // known to be present, so concurrent reads fetch in parallel. Two of them
+  // missing the same block both fetch it and write identical contents.
+  Result<uint64_t> PRead(void* buf, uint64_t count,
+                         uint64_t offset) const override {
+    if (offset >= size_ || count == 0) {
+      return 0;
+    }
+    count = std::min(count, size_ - offset);
+
+    const uint64_t first_block = offset / block_size_;
+    const uint64_t last_block = (offset + count - 1) / block_size_ + 1;
+    CF_EXPECT(LoadPresence(
+        first_block,
+        std::min(num_blocks_, last_block + kMinFetchBlocks - 1)));
+    char* out = static_cast<char*>(buf);
+    for (uint64_t block = first_block; block < last_block;) {
+      if (BlockPresent(block)) {
+        uint64_t present_end = block + 1;
+        while (present_end < last_block && BlockPresent(present_end)) {
+          present_end++;
+        }
+        CF_EXPECT(CopyFromBlocks(block, present_end, offset, count, out));
+        block = present_end;
+        continue;
+      }
+      uint64_t fetch_end = block + 1;
+      uint64_t fetch_limit =
+          std::min(num_blocks_, std::max(last_block, block + kMinFetchBlocks));
+      while (fetch_end < fetch_limit && !BlockPresent(fetch_end)) {
+        fetch_end++;
+      }
+      std::vector<char> data = CF_EXPECT(FetchBlocks(block, fetch_end));
+      // Copies the requested part of the fetched range straight from memory.
+      const uint64_t data_start = block * block_size_;
+      const uint64_t copy_start = std::max(offset, data_start);
+      const uint64_t copy_stop =
+          std::min(offset + count, data_start + data.size());
+      if (copy_start < copy_stop) {
+        memcpy(out + (copy_start - offset),
+               data.data() + (copy_start - data_start),
+               copy_stop - copy_start);
+      }
+      block = fetch_end;
+    }
+    return count;
+  }
+
+ private:
+  bool BlockPresent(uint64_t block) const {
+    return known_present_[block].load(std::memory_order_relaxed);
+  }
+
+  // Picks up the blocks in [begin, end) that other readers of the same key
+  // fetched since they were last checked. Blocks never stop being present.
+  Result<void> LoadPresence(uint64_t begin, uint64_t end) const {
+    while (begin < end && BlockPresent(begin)) {
+      begin++;
+    }
+    if (begin == end) {
+      return {};
+    }
+    std::vector<char> flags(end - begin);
+    CF_EXPECT(PReadExact(*present_, flags.data(), flags.size(), begin));
+    for (uint64_t block = begin; block < end; block++) {
+      if (flags[block - begin] == kPresent) {
+        known_present_[block].store(true, std::memory_order_relaxed);
+      }
+    }
+    return {};
+  }
+
+  // Copies the requested part of the present blocks [begin, end).
+  Result<void> CopyFromBlocks(uint64_t begin, uint64_t end, uint64_t offset,
+                              uint64_t count, char* out) const {
+    const uint64_t copy_start = std::max(offset, begin * block_size_);
+    const uint64_t copy_stop =
+        std::min(offset + count, std::min(end * block_size_, size_));
+    CF_EXPECTF(PReadExact(*blocks_, out + (copy_start - offset),
+                          copy_stop - copy_start, copy_start),
+               "Failed to read the blocks of '{}'", blocks_dir_);
+    return {};
+  }
+
+  Result<std::vector<char>> FetchBlocks(uint64_t begin, uint64_t end) const {
+    uint64_t start = begin * block_size_;
+    uint64_t stop = std::min(end * block_size_, size_);
+    VLOG(1) << "Fetching [" << start << ", " << stop << ") for '"
+            << blocks_dir_ << "'";
+
+    std::vector<char> data(stop - start);
+    CF_EXPECT(PReadExact(*upstream_, data.data(), data.size(), start));
+
+    // The blocks are only marked present once on disk, so a present block is
+    // whole even after a crash.
+    CF_EXPECT(PWriteExact(*blocks_, data.data(), data.size(), start));
+    CF_EXPECTF(blocks_->Fd()->Fsync() == 0, "Failed to sync '{}': {}",
+               blocks_dir_, blocks_->Fd()->StrError());
+    std::vector<char> flags(end - begin, kPresent);
+    CF_EXPECT(PWriteExact(*present_, flags.data(), flags.size(), begin));
+    for (uint64_t block = begin; block < end; block++) {
+      known_present_[block].store(true, std::memory_order_relaxed);
+    }
+    return data;
+  }
+
+  const std::unique_ptr<ReaderSeeker> upstream_;
+  const uint64_t size_;
+  const uint64_t block_size_;
+  const uint64_t num_blocks_;
+  const std::string blocks_dir_;
+  const std::unique_ptr<SharedFdIo> blocks_;
+  const std::unique_ptr<SharedFdIo> present_;
+  // Saves reading the presence map again for blocks already seen present.
+  mutable std::vector<std::atomic<bool>> known_present_;
+};
+
+}  // namespace
+
+Result<std::unique_ptr<ReaderSeeker>> BlockCache(
+    std::unique_ptr<ReaderSeeker> upstream, uint64_t size,
+    const std::string& directory, std::string_view key, uint64_t block_size) {
+  CF_EXPECT(upstream.get());
+  CF_EXPECT(block_size > 0);
+  CF_EXPECT(!key.empty());
+  CF_EXPECT_EQ(key.find('/'), std::string_view::npos);
+
+  std::string blocks_dir = fmt::format("{}/{}", directory, key);
+  CF_EXPECT(EnsureDirectoryExists(blocks_dir));
+
+  const std::string blocks_path = blocks_dir + "/blocks";
+  const std::string present_path = blocks_dir + "/present";
+  SharedFD blocks = CF_EXPECT(OpenCacheFile(blocks_path));
+  SharedFD present = CF_EXPECT(OpenCacheFile(present_path));
+  // Other processes opening the same key at once agree on the sizes.
+  CF_EXPECT(present->Flock(LOCK_EX));
+  Result<void> prepared = PrepareCacheFiles(
+      blocks, present, size, (size + block_size - 1) / block_size);
+  CF_EXPECT(present->Flock(LOCK_UN));
+  CF_EXPECTF(std::move(prepared), "Failed to prepare the cache files in '{}'",
+             blocks_dir);
+
+  return std::make_unique<BlockCacheReader>(
+      std::move(upstream), size, block_size, std::move(blocks_dir),
+      std::move(blocks), std::move(present));
+}
+
+}  // namespace cuttlefish
@@ -0,0 +1,51 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "cuttlefish/io/io.h"
+#include "cuttlefish/result/result_type.h"
+
+namespace cuttlefish {
+
+inline constexpr uint64_t kDefaultCacheBlockSize = 1 << 20;
+
+/**
+ * Wraps a slow `ReaderSeeker`, such as a remote file, with a persistent cache
+ * of fixed-size aligned blocks.
+ *
+ * The blocks are stored at their offsets in the sparse file
+ * `<directory>/<key>/blocks`, and `<directory>/<key>/present` holds one byte
+ * per block, set once the block is complete. Both files stay open for the
+ * lifetime of the reader. `key` must identify the content of `upstream` rather
+ * than where it was read from, so any build or process reading the same
+ * content reuses the same blocks. It is used as a directory name.
+ *
+ * Fetched blocks are synced once per fetch before they are marked present,
+ * so a present block is complete also to other processes and after a crash.
+ * Files of the wrong size are left over from a different upstream under the
+ * same key, and are emptied.
+ */
+Result<std::unique_ptr<ReaderSeeker>> BlockCache(
+    std::unique_ptr<ReaderSeeker> upstream, uint64_t size,
+    const std::string& directory, std::string_view key,
+    uint64_t block_size = kDefaultCacheBlockSize);
+
+}  // namespace cuttlefish
@@ -0,0 +1,188 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/io/block_cache.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "android-base/file.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/common/libs/utils/files.h"
+#include "cuttlefish/io/fake_seek.h"
+#include "cuttlefish/io/in_memory.h"
+#include "cuttlefish/io/io.h"
+#include "cuttlefish/io/string.h"
+#include "cuttlefish/result/result.h"
+#include "cuttlefish/result/result_matchers.h"
+
+namespace cuttlefish {
+namespace {
+
+class CountingReader : public ReaderFakeSeeker {
+ public:
+  CountingReader(const std::string& data, int& reads)
+      : ReaderFakeSeeker(data.size()), data_(InMemoryIo(data)), reads_(reads) {}
+
+  Result<uint64_t> PRead(void* buf, uint64_t count,
+                         uint64_t offset) const override {
+    reads_++;
+    return CF_EXPECT(data_->PRead(buf, count, offset));
+  }
+
+ private:
+  std::unique_ptr<ReaderSeeker> data_;
+  int& reads_;
+};
+
+std::string TestData() {
+  std::string data;
+  for (int i = 0; i < 1000; i++) {
+    data.push_back('a' + (i % 26));
+  }
+  return data;
+}
+
+TEST(BlockCacheTest, ReadsMatchUpstream) {
+  std::string data = TestData();
+  int reads = 0;
+  Result<std::unique_ptr<ReaderSeeker>> cache =
+      BlockCache(std::make_unique<CountingReader>(data, reads), data.size(),
+                 testing::TempDir(), "block_cache_reads", 16);
+  ASSERT_THAT(cache, IsOk());
+
+  std::string buf(100, '\0');
+  ASSERT_THAT((*cache)->PRead(buf.data(), buf.size(), 250), IsOkAndValue(100));
+  EXPECT_EQ(buf, data.substr(250, 100));
+
+  EXPECT_THAT(ReadToString(**cache), IsOkAndValue(data));
+}
+
+TEST(BlockCacheTest, FetchesAlignedBlocksAhead) {
+  std::string data = TestData();
+  int reads = 0;
+  Result<std::unique_ptr<ReaderSeeker>> cache =
+      BlockCache(std::make_unique<CountingReader>(data, reads), data.size(),
+                 testing::TempDir(), "block_cache_ahead", 16);
+  ASSERT_THAT(cache, IsOk());
+
+  char c;
+  ASSERT_THAT((*cache)->PRead(&c, 1, 20), IsOkAndValue(1));
+  EXPECT_EQ(reads, 1);
+  // The first read filled blocks [16, 272) in one request.
+  ASSERT_THAT((*cache)->PRead(&c, 1, 271), IsOkAndValue(1));
+  EXPECT_EQ(reads, 1);
+  ASSERT_THAT((*cache)->PRead(&c, 1, 0), IsOkAndValue(1));
+  EXPECT_EQ(reads, 2);
+}
+
+TEST(BlockCacheTest, SharedBetweenInstances) {
+  std::string data = TestData();
+  int first_reads = 0;
+  Result<std::unique_ptr<ReaderSeeker>> first =
+      BlockCache(std::make_unique<CountingReader>(data, first_reads),
+                 data.size(), testing::TempDir(), "block_cache_shared", 16);
+  ASSERT_THAT(first, IsOk());
+  ASSERT_THAT(ReadToString(**first), IsOkAndValue(data));
+  EXPECT_GT(first_reads, 0);
+
+  int second_reads = 0;
+  Result<std::unique_ptr<ReaderSeeker>> second =
+      BlockCache(std::make_unique<CountingReader>(data, second_reads),
+                 data.size(), testing::TempDir(), "block_cache_shared", 16);
+  ASSERT_THAT(second, IsOk());
+  EXPECT_THAT(ReadToString(**second), IsOkAndValue(data));
+  EXPECT_EQ(second_reads, 0);
+}
+
+TEST(BlockCacheTest, RefetchesDamagedBlocks) {
+  std::string data = TestData();
+  const std::string directory = testing::TempDir();
+  int first_reads = 0;
+  Result<std::unique_ptr<ReaderSeeker>> first =
+      BlockCache(std::make_unique<CountingReader>(data, first_reads),
+                 data.size(), directory, "block_cache_damaged", 16);
+  ASSERT_THAT(first, IsOk());
+  ASSERT_THAT(ReadToString(**first), IsOkAndValue(data));
+
+  // As if the fetch of block 3 was interrupted before it was marked present.
+  const std::string present = directory + "/block_cache_damaged/present";
+  SharedFD present_fd = SharedFD::Open(present, O_WRONLY);
+  ASSERT_TRUE(present_fd->IsOpen()) << present_fd->StrError();
+  const char absent = 0;
+  ASSERT_EQ(present_fd->PWrite(&absent, 1, 3), 1);
+
+  int second_reads = 0;
+  Result<std::unique_ptr<ReaderSeeker>> second =
+      BlockCache(std::make_unique<CountingReader>(data, second_reads),
+                 data.size(), directory, "block_cache_damaged", 16);
+  ASSERT_THAT(second, IsOk());
+  EXPECT_THAT(ReadToString(**second), IsOkAndValue(data));
+  EXPECT_EQ(second_reads, 1);
+}
+
+TEST(BlockCacheTest, StartsOverForADifferentSize) {
+  std::string data = TestData();
+  const std::string directory = testing::TempDir();
+  int first_reads = 0;
+  Result<std::unique_ptr<ReaderSeeker>> first =
+      BlockCache(std::make_unique<CountingReader>(data, first_reads),
+                 data.size(), directory, "block_cache_resized", 16);
+  ASSERT_THAT(first, IsOk());
+  ASSERT_THAT(ReadToString(**first), IsOkAndValue(data));
+
+  std::string other_data = data.substr(0, 500);
+  std::reverse(other_data.begin(), other_data.end());
+  int second_reads = 0;
+  Result<std::unique_ptr<ReaderSeeker>> second =
+      BlockCache(std::make_unique<CountingReader>(other_data, second_reads),
+                 other_data.size(), directory, "block_cache_resized", 16);
+  ASSERT_THAT(second, IsOk());
+  EXPECT_THAT(ReadToString(**second), IsOkAndValue(other_data));
+  EXPECT_GT(second_reads, 0);
+}
+
+TEST(BlockCacheTest, KeepsTheBlocksInOneSparseFile) {
+  std::string data = TestData();
+  const std::string directory = testing::TempDir();
+  int reads = 0;
+  Result<std::unique_ptr<ReaderSeeker>> cache =
+      BlockCache(std::make_unique<CountingReader>(data, reads), data.size(),
+                 directory, "block_cache_files", 16);
+  ASSERT_THAT(cache, IsOk());
+  char c;
+  ASSERT_THAT((*cache)->PRead(&c, 1, 500), IsOkAndValue(1));
+
+  EXPECT_THAT(DirectoryContents(directory + "/block_cache_files"),
+              IsOkAndValue(testing::UnorderedElementsAre("blocks", "present")));
+  EXPECT_EQ(FileSize(directory + "/block_cache_files/blocks"), data.size());
+  // 63 blocks of 16 bytes, only the ones read or fetched ahead are present.
+  std::string present;
+  ASSERT_TRUE(android::base::ReadFileToString(
+      directory + "/block_cache_files/present", &present));
+  ASSERT_EQ(present.size(), 63);
+  EXPECT_EQ(std::count(present.begin(), present.end(), '\1'), 16);
+}
+
+}  // namespace
+}  // namespace cuttlefish
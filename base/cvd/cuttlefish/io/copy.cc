@@ -15,68 +15,245 @@
 
 #include "cuttlefish/io/copy.h"
 
+#include <errno.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
 
-#include <array>
+#include <algorithm>
 #include <memory>
+#include <optional>
 
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/io/find_shared_fd.h"
 #include "cuttlefish/io/io.h"
+#include "cuttlefish/io/write_exact.h"
 #include "cuttlefish/result/expect.h"
 #include "cuttlefish/result/result_type.h"
 
 namespace cuttlefish {
+namespace {
 
-static constexpr size_t kBufferSize = 1 << 26;
+// Granularity of zero detection in `SparseCopy`, matching the usual
+// filesystem block size.
+constexpr size_t kZeroBlockSize = 4096;
 
-Result<void> Copy(Reader& reader, Writer& writer, const size_t buffer_size) {
-  std::unique_ptr<std::array<char, kBufferSize>> buf(
-      new std::array<char, kBufferSize>);
-  uint64_t chunk_read;
-  while ((chunk_read = CF_EXPECT(reader.Read(buf.get(), buf->size()))) > 0) {
-    uint64_t chunk_written = 0;
-    while (chunk_written < chunk_read) {
-      uint64_t written = CF_EXPECT(writer.Write(&buf->data()[chunk_written],
-                                                chunk_read - chunk_written));
-      CF_EXPECT_GT(written, 0, "Premature EOF on writer");
-      chunk_written += written;
+bool IsUnsupportedBetween(int error) {
+  return error == EXDEV || error == EINVAL || error == ENOSYS ||
+         error == EOPNOTSUPP || error == EBADF;
+}
+
+bool IsZero(const char* data, size_t size) {
+  // memcmp is vectorized by the C library, unlike a loop over bytes.
+  return size == 0 ||
+         (data[0] == '\0' && memcmp(data, data + 1, size - 1) == 0);
+}
+
+// Moves data between the current positions of `in` and `out` in the kernel
+// until `in` reaches EOF. Returns false without an error if neither
+// copy_file_range(2) nor splice(2) works between these files, in which case
+// the caller should continue with a userspace copy.
+Result<bool> KernelCopy(SharedFD in, SharedFD out, size_t chunk_size) {
+#ifdef __linux__
+  bool use_splice = false;
+  while (true) {
+    ssize_t copied =
+        use_splice ? out->Splice(*in, chunk_size)
+                   : out->CopyFileRange(*in, nullptr, nullptr, chunk_size);
+    if (copied == 0) {
+      return true;
+    } else if (copied > 0) {
+      continue;
+    }
+    int error = out->GetErrno();
+    if (!use_splice && IsUnsupportedBetween(error)) {
+      // One side might be a pipe.
+      use_splice = true;
+      continue;
+    } else if (use_splice && IsUnsupportedBetween(error)) {
+      return false;
     }
+    return CF_ERRF("Failed to copy between files: '{}'", out->StrError());
   }
-  return {};
+#else
+  return false;
+#endif
 }
 
-Result<void> SparseCopy(Reader& reader, WriterSeeker& writer,
-                        size_t buffer_size) {
-  CF_EXPECT(writer.SeekSet(0));
-  std::unique_ptr<std::array<char, kBufferSize>> buf(
-      new std::array<char, kBufferSize>);
-  uint64_t chunk_read;
-  uint64_t total_size = 0;
-  while ((chunk_read = CF_EXPECT(reader.Read(buf.get(), buf->size()))) > 0) {
-    total_size += chunk_read;
-    if ((*buf)[0] == '\0' && (*buf)[chunk_read - 1] == 0) {
-      bool zero_chunk = true;
-      for (const char c : *buf) {
-        if (c != '\0') {
-          zero_chunk = false;
+// Writes to a `WriterSeeker` from offset zero, leaving holes instead of
+// writing ranges of zeroes.
+class SparseWriter {
+ public:
+  explicit SparseWriter(WriterSeeker& writer) : writer_(writer) {}
+
+  Result<void> Start() {
+    CF_EXPECT(writer_.SeekSet(0));
+    return {};
+  }
+
+  // Writes `buf`, skipping over zeroed blocks.
+  Result<void> Data(const char* buf, size_t size) {
+    while (size > 0) {
+      size_t block = std::min(size, kZeroBlockSize);
+      bool zero = IsZero(buf, block);
+      size_t run = block;
+      while (run < size) {
+        size_t next = std::min(size - run, kZeroBlockSize);
+        if (IsZero(buf + run, next) != zero) {
           break;
         }
+        run += next;
+      }
+      if (zero) {
+        CF_EXPECT(Hole(run));
+      } else {
+        CF_EXPECT(WriteExact(writer_, buf, run));
+        DataWritten(run);
       }
-      if (zero_chunk) {
-        CF_EXPECT(writer.Truncate(total_size));
-        CF_EXPECT(writer.SeekCur(chunk_read));
-        continue;
+      buf += run;
+      size -= run;
+    }
+    return {};
+  }
+
+  // Skips `size` bytes, which read back as zero.
+  Result<void> Hole(uint64_t size) {
+    if (!truncated_) {
+      // Drops any previous contents which would otherwise show through the
+      // holes. Later writes only extend the file.
+      CF_EXPECT(writer_.Truncate(offset_));
+      truncated_ = true;
+    }
+    CF_EXPECT(writer_.SeekCur(size));
+    offset_ += size;
+    ends_in_hole_ = true;
+    return {};
+  }
+
+  // For data written to the underlying file at the current position by other
+  // means.
+  void DataWritten(uint64_t size) {
+    offset_ += size;
+    ends_in_hole_ = false;
+  }
+
+  Result<void> Finish() {
+    if (ends_in_hole_) {
+      CF_EXPECT(writer_.Truncate(offset_));
+    }
+    CF_EXPECT(writer_.Write(nullptr, 0));
+    return {};
+  }
+
+ private:
+  WriterSeeker& writer_;
+  uint64_t offset_ = 0;
+  bool truncated_ = false;
+  bool ends_in_hole_ = false;
+};
+
+// Copies from the current position of `in` to its end, following its
+// allocated extents with SEEK_DATA and SEEK_HOLE so unallocated ranges are
+// never read. Returns false without an error if the extents are not
+// available, before changing anything.
+Result<bool> CopyExtents(SharedFD in, std::optional<SharedFD> out,
+                         SparseWriter& writer, char* buf, size_t buf_size) {
+#ifdef __linux__
+  off_t start = in->LSeek(0, SEEK_CUR);
+  if (start < 0) {
+    return false;
+  }
+  off_t end = in->LSeek(0, SEEK_END);
+  CF_EXPECTF(end >= 0, "Failed to find the file end: '{}'", in->StrError());
+
+  off_t pos = start;
+  while (pos < end) {
+    off_t data = in->LSeek(pos, SEEK_DATA);
+    if (data < 0 && in->GetErrno() == ENXIO) {
+      data = end;
+    } else if (data < 0 && pos == start) {
+      CF_EXPECT_EQ(in->LSeek(start, SEEK_SET), start);
+      return false;
+    }
+    CF_EXPECTF(data >= 0, "SEEK_DATA failed: '{}'", in->StrError());
+    if (data > pos) {
+      CF_EXPECT(writer.Hole(data - pos));
+      pos = data;
+    }
+    if (pos >= end) {
+      break;
+    }
+    off_t hole = in->LSeek(pos, SEEK_HOLE);
+    CF_EXPECTF(hole >= 0, "SEEK_HOLE failed: '{}'", in->StrError());
+    hole = std::min(hole, end);
+
+    while (out && pos < hole) {
+      ssize_t copied = (*out)->CopyFileRange(*in, &pos, nullptr, hole - pos);
+      if (copied < 0 && IsUnsupportedBetween((*out)->GetErrno())) {
+        out.reset();
+        break;
       }
+      CF_EXPECTF(copied > 0, "copy_file_range failed: '{}'",
+                 (*out)->StrError());
+      writer.DataWritten(copied);
     }
-    uint64_t chunk_written = 0;
-    while (chunk_written < chunk_read) {
-      uint64_t written = CF_EXPECT(writer.Write(&buf->data()[chunk_written],
-                                                chunk_read - chunk_written));
-      CF_EXPECT_GT(written, 0, "Premature EOF on writer");
-      chunk_written += written;
+    while (pos < hole) {
+      size_t to_read = std::min<uint64_t>(hole - pos, buf_size);
+      ssize_t data_read = in->PRead(buf, to_read, pos);
+      CF_EXPECTF(data_read > 0, "Failed to read: '{}'", in->StrError());
+      CF_EXPECT(writer.Data(buf, data_read));
+      pos += data_read;
+    }
+  }
+  CF_EXPECT_EQ(in->LSeek(end, SEEK_SET), end);
+  return true;
+#else
+  return false;
+#endif
+}
+
+}  // namespace
+
+Result<void> Copy(Reader& reader, Writer& writer, const size_t buffer_size) {
+  std::optional<SharedFD> in = CF_EXPECT(FindSharedFd(reader));
+  std::optional<SharedFD> out = CF_EXPECT(FindSharedFd(writer));
+  if (in && out && CF_EXPECT(KernelCopy(*in, *out, buffer_size))) {
+    return {};
+  }
+
+  const size_t buf_size = std::max<size_t>(buffer_size, 1);
+  std::unique_ptr<char[]> buf(new char[buf_size]);
+  uint64_t chunk_read;
+  while ((chunk_read = CF_EXPECT(reader.Read(buf.get(), buf_size))) > 0) {
+    CF_EXPECT(WriteExact(writer, buf.get(), chunk_read),
+              "Premature EOF on writer");
+  }
+  return {};
+}
+
+Result<void> SparseCopy(Reader& reader, WriterSeeker& writer,
+                        size_t buffer_size) {
+  SparseWriter sparse_writer(writer);
+  CF_EXPECT(sparse_writer.Start());
+  const size_t buf_size = std::max(buffer_size, kZeroBlockSize);
+  std::unique_ptr<char[]> buf(new char[buf_size]);
+
+  std::optional<SharedFD> in = CF_EXPECT(FindSharedFd(reader));
+  if (in) {
+    std::optional<SharedFD> out = CF_EXPECT(FindSharedFd(writer));
+    if (CF_EXPECT(CopyExtents(*in, out, sparse_writer, buf.get(), buf_size))) {
+      CF_EXPECT(sparse_writer.Finish());
+      return {};
     }
   }
-  CF_EXPECT(writer.Write(nullptr, 0));
+
+  uint64_t chunk_read;
+  while ((chunk_read = CF_EXPECT(reader.Read(buf.get(), buf_size))) > 0) {
+    CF_EXPECT(sparse_writer.Data(buf.get(), chunk_read));
+  }
+  CF_EXPECT(sparse_writer.Finish());
   return {};
 }
 
@@ -25,11 +25,15 @@ namespace cuttlefish {
 // Moves data from the Reader to the Writer, without doing additional seeking on
 // either. This means if either has seek pointers set somewhere in the middle of
 // the data, reading and writing starts from that point.
+//
+// Between two `SharedFdIo` instances the data is moved inside the kernel,
+// `buffer_size` bytes at a time.
 Result<void> Copy(Reader&, Writer&, size_t buffer_size = 1 << 26);
 
-// Moves data from the Reader to the WriterSeeker. Uses heuristics to detect
-// large chunks of zeroes, and performs forward seeks on the output rather than
-// writing the zeroes.
+// Moves data from the Reader to the WriterSeeker. Detects zeroed 4 KiB blocks,
+// and performs forward seeks on the output rather than writing the zeroes.
+// When the Reader is a `SharedFdIo`, holes in it are skipped without being
+// read.
 //
 // This is helpful for writing large files to the filesystem, as it can use the
 // linux-sparse mechanism to not fully allocate blocks.
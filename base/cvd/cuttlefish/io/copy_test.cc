@@ -15,15 +15,22 @@
 
 #include "cuttlefish/io/copy.h"
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "gmock/gmock-matchers.h"
 #include "gtest/gtest.h"
 
+#include "cuttlefish/common/libs/fs/shared_fd.h"
 #include "cuttlefish/io/in_memory.h"
 #include "cuttlefish/io/io.h"
 #include "cuttlefish/io/read_exact.h"
+#include "cuttlefish/io/shared_fd.h"
+#include "cuttlefish/io/string.h"
 #include "cuttlefish/result/result_matchers.h"
 
 namespace cuttlefish {
@@ -43,5 +50,77 @@ TEST(CopyTest, CopySmallBuffer) {
   EXPECT_EQ(data, data_out);
 }
 
+// Data, then a zeroed block, more data, and a trailing zeroed block.
+std::string SparseData() {
+  std::string data(4096, 'a');
+  data += std::string(4096, '\0');
+  data += std::string(100, 'b');
+  data += std::string(8192, '\0');
+  return data;
+}
+
+SharedFD TempFile(const std::string& name) {
+  return SharedFD::Open(testing::TempDir() + "/" + name,
+                        O_CREAT | O_TRUNC | O_RDWR, 0644);
+}
+
+TEST(CopyTest, CopyWithSmallBufferSize) {
+  std::unique_ptr<ReaderWriterSeeker> in = InMemoryIo(SparseData());
+  std::unique_ptr<ReaderWriterSeeker> out = InMemoryIo();
+
+  EXPECT_THAT(Copy(*in, *out, 7), IsOk());
+
+  ASSERT_THAT(out->SeekSet(0), IsOk());
+  EXPECT_THAT(ReadToString(*out), IsOkAndValue(SparseData()));
+}
+
+TEST(CopyTest, CopyBetweenFiles) {
+  SharedFD in_fd = TempFile("copy_in");
+  ASSERT_TRUE(in_fd->IsOpen()) << in_fd->StrError();
+  std::string data = SparseData();
+  ASSERT_EQ(in_fd->Write(data.data(), data.size()), data.size());
+  ASSERT_EQ(in_fd->LSeek(0, SEEK_SET), 0);
+  SharedFD out_fd = TempFile("copy_out");
+  ASSERT_TRUE(out_fd->IsOpen()) << out_fd->StrError();
+
+  SharedFdIo in(in_fd);
+  SharedFdIo out(out_fd);
+  EXPECT_THAT(Copy(in, out), IsOk());
+
+  ASSERT_THAT(out.SeekSet(0), IsOk());
+  EXPECT_THAT(ReadToString(out), IsOkAndValue(data));
+}
+
+TEST(CopyTest, SparseCopyReplacesPreviousContents) {
+  std::unique_ptr<ReaderWriterSeeker> in = InMemoryIo(SparseData());
+  std::unique_ptr<ReaderWriterSeeker> out =
+      InMemoryIo(std::string(20000, 'x'));
+
+  EXPECT_THAT(SparseCopy(*in, *out, 4096), IsOk());
+
+  ASSERT_THAT(out->SeekSet(0), IsOk());
+  EXPECT_THAT(ReadToString(*out), IsOkAndValue(SparseData()));
+}
+
+TEST(CopyTest, SparseCopyBetweenFiles) {
+  SharedFD in_fd = TempFile("sparse_copy_in");
+  ASSERT_TRUE(in_fd->IsOpen()) << in_fd->StrError();
+  std::string data = SparseData();
+  ASSERT_EQ(in_fd->Write(data.data(), data.size()), data.size());
+  // Leaves a trailing hole in the source.
+  ASSERT_EQ(in_fd->Truncate(data.size() + 8192), 0);
+  data += std::string(8192, '\0');
+  ASSERT_EQ(in_fd->LSeek(0, SEEK_SET), 0);
+  SharedFD out_fd = TempFile("sparse_copy_out");
+  ASSERT_TRUE(out_fd->IsOpen()) << out_fd->StrError();
+
+  SharedFdIo in(in_fd);
+  SharedFdIo out(out_fd);
+  EXPECT_THAT(SparseCopy(in, out), IsOk());
+
+  ASSERT_THAT(out.SeekSet(0), IsOk());
+  EXPECT_THAT(ReadToString(out), IsOkAndValue(data));
+}
+
 }  // namespace
 }  // namespace cuttlefish
@@ -0,0 +1,53 @@
+//
+// Copyright (C) 2026 The Android Open Source Project
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cuttlefish/io/find_shared_fd.h"
+
+#include <optional>
+
+#include "cuttlefish/common/libs/fs/shared_fd.h"
+#include "cuttlefish/io/default_visitor.h"
+#include "cuttlefish/io/io.h"
+#include "cuttlefish/io/shared_fd.h"
+#include "cuttlefish/result/expect.h"
+#include "cuttlefish/result/result_type.h"
+
+namespace cuttlefish {
+namespace {
+
+class SharedFdFinder : public DefaultIoVisitor {
+ public:
+  using DefaultIoVisitor::Accept;
+
+  Result<void> Accept(Reader&) override { return {}; }
+  Result<void> Accept(Seeker&) override { return {}; }
+  Result<void> Accept(Writer&) override { return {}; }
+  Result<void> Accept(SharedFdIo& io) override {
+    fd = io.Fd();
+    return {};
+  }
+
+  std::optional<SharedFD> fd;
+};
+
+}  // namespace
+
+Result<std::optional<SharedFD>> FindSharedFd(IoVisitable& io) {
+  SharedFdFinder finder;
+  CF_EXPECT(io.Visit(finder));
+  return finder.fd;
+}
+
+}  // namespace cuttlefish
@@ -104,6 +104,12 @@ class InMemoryIo : public ReaderWriterSeeker {
     return count;
   }
 
+  Result<void> Truncate(uint64_t size) override {
+    std::lock_guard lock(mutex_);
+    data_.resize(size, '\0');
+    return {};
+  }
+
  private:
   // Must be called with the lock held for reading or writing
   uint64_t ClampRange(uint64_t begin, uint64_t length) const {
@@ -82,4 +82,6 @@ Result<void> SharedFdIo::Truncate(uint64_t size) {
   return {};
 }
 
+const SharedFD& SharedFdIo::Fd() const { return fd_; }
+
 }  // namespace cuttlefish
@@ -39,6 +39,9 @@ class SharedFdIo : public ReaderWriterSeeker {
                           uint64_t offset) override;
   Result<void> Truncate(uint64_t size) override;
 
+  // For operations that can bypass userspace buffers between files.
+  const SharedFD& Fd() const;
+
  private:
   SharedFD fd_;
 };
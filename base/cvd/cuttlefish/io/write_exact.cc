@@ -16,6 +16,7 @@
 #include "cuttlefish/io/write_exact.h"
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include "cuttlefish/io/io.h"
 #include "cuttlefish/result/expect.h"
@@ -33,4 +34,17 @@ Result<void> WriteExact(Writer& writer, const char* buf, size_t size) {
   return {};
 }
 
+Result<void> PWriteExact(WriterSeeker& writer, const char* buf, size_t size,
+                         uint64_t offset) {
+  while (size > 0) {
+    size_t data_written =
+        CF_EXPECT(writer.PWrite((const void*)buf, size, offset));
+    CF_EXPECT_GT(data_written, 0, "PWrite returned 0 before completing");
+    buf += data_written;
+    size -= data_written;
+    offset += data_written;
+  }
+  return {};
+}
+
 }  // namespace cuttlefish
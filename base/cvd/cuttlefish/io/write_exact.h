@@ -25,6 +25,9 @@ namespace cuttlefish {
 
 Result<void> WriteExact(Writer&, const char* buf, size_t size);
 
+Result<void> PWriteExact(WriterSeeker&, const char* buf, size_t size,
+                         uint64_t offset);
+
 template <typename T>
 Result<void> WriteExactBinary(Writer& writer, const T& data) {
   const char* const data_char = reinterpret_cast<const char*>(&data);